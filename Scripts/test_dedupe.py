@@ -0,0 +1,84 @@
+#!/usr/bin/python
+"""
+Created on October 18th, 2026
+
+@author: Robin T. Miller
+
+Description:
+    Verify the data reduction pattern duplicate ratio at the dedupe unit
+size. The pattern is written to a file backed emulated device, then the
+file is split into dedupe units, and the percentage of units whose content
+occurs more than once must be within the tolerance of dedupe=.
+
+Note: Tools required: spt (expected in PATH, or use --spt_path=).
+
+Example:
+    # ./test_dedupe.py --dedupe=50 --dedupe_unit=4096
+"""
+
+from __future__ import print_function
+
+import argparse
+import collections
+import os
+import subprocess
+import sys
+import tempfile
+
+def run_test(args):
+    """ Write the pattern, then return the duplicate unit percentage. """
+    fd, path = tempfile.mkstemp(prefix='spt_dedupe_', suffix='.img')
+    os.close(fd)
+    os.unlink(path)
+    try:
+        cmd = [args.spt_path,
+               'dsf=emu:size={0},file={1}'.format(args.size, path),
+               'cdb=8a', 'dir=write', 'length=64k', 'starting=0',
+               'limit={0}'.format(args.size),
+               'dedupe={0}'.format(args.dedupe),
+               'dedupe_unit={0}'.format(args.dedupe_unit)]
+        if args.debug:
+            print('Executing: {0}'.format(' '.join(cmd)))
+        status = subprocess.call(cmd)
+        if status != 0:
+            print('spt failed with status {0}!'.format(status))
+            return None
+        with open(path, 'rb') as f:
+            data = f.read()
+    finally:
+        if os.path.exists(path):
+            os.unlink(path)
+    unit = args.dedupe_unit
+    units = collections.Counter(data[offset:offset + unit]
+                                for offset in range(0, len(data), unit))
+    total = len(data) // unit
+    duplicates = sum(count for count in units.values() if count > 1)
+    return (duplicates * 100.0) / total
+
+def main():
+    parser = argparse.ArgumentParser(description='Verify the spt dedupe ratio.')
+    parser.add_argument('--spt_path', default='spt', help='The path to spt.')
+    parser.add_argument('--size', default='256m', help='The emulated device size.')
+    parser.add_argument('--dedupe', type=int, default=50,
+                        help='The duplicate percentage.')
+    parser.add_argument('--dedupe_unit', type=int, default=4096,
+                        help='The dedupe unit size (bytes).')
+    parser.add_argument('--tolerance', type=float, default=3.0,
+                        help='The allowed percentage difference.')
+    parser.add_argument('--debug', action='store_true', help='Enable debug.')
+    args = parser.parse_args()
+
+    percent = run_test(args)
+    if percent is None:
+        return 1
+    print('Dedupe unit {0}: {1:.1f}% duplicate units, expected {2}%'
+          .format(args.dedupe_unit, percent, args.dedupe))
+    if abs(percent - args.dedupe) > args.tolerance:
+        print('FAILED: The duplicate ratio is outside the {0}% tolerance!'
+              .format(args.tolerance))
+        return 1
+    print('PASSED')
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -34,6 +34,21 @@
  * 
  * Modification History:
  * 
+ * October 18th, 2026 by Robin T. Miller
+ *      GetCdbLength() returns 32 for variable length CDB's (Read/Write(32)).
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Added Verify16() with byte check, for target side data compares.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Added CompareWrite16() for CAW contention testing.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Implement GetLogicalBlockProvisioning() to decode VPD page 0xB2.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Added GetLbaStatus() and Unmap() for sparse copy/verify operations.
+ * 
  * January 21st, 2021 by Robin T. Miller
  *      Addeed ReceiveCopyParameters() to acquire copy parameters.
  * 
@@ -1405,6 +1420,60 @@ GetBlockLimits(HANDLE fd, char *dsf, hbool_t debug, hbool_t errlog,
 
 /* ======================================================================== */
 
+/*
+ * GetLogicalBlockProvisioning() - Gets Inquiry Logical Block Provisioning.
+ *
+ * Inputs:
+ *  fd     = The file descriptor.
+ *  dsf    = The device special file (raw or "sg" for Linux).
+ *  debug  = Flag to control debug output.
+ *  errlog = Flag to control error logging. (True logs error)
+ *                                          (False suppesses)
+ *  block_provisioning = Pointer to application block provisioning.
+ *  tsp = The tool specific information.
+ *
+ * Return Value:
+ *    Returns SUCCESS / FAILURE
+ */
+int
+GetLogicalBlockProvisioning(HANDLE fd, char *dsf, hbool_t debug, hbool_t errlog,
+			    inquiry_logical_block_provisioning_t *block_provisioning,
+			    tool_specific_t *tsp)
+{
+    inquiry_page_t inquiry_data;  
+    inquiry_page_t *inquiry_page = &inquiry_data;
+    inquiry_header_t *inqh = &inquiry_page->inquiry_hdr;
+    inquiry_logical_block_provisioning_page_t *lbp;
+    unsigned char page = INQ_LOGICAL_BLOCK_PROVISIONING_PAGE;
+    int status;
+
+    status = Inquiry(fd, dsf, debug, errlog, NULL, NULL,
+		     inquiry_page, sizeof(*inquiry_page), page,	0, 0, tsp);
+
+    if (status != SUCCESS) return(status);
+
+    /*
+     * Note: The extra check is for non-compliant SCSI devices.
+     */
+    if (inqh->inq_page_code != page) {
+	return(FAILURE);
+    }
+
+    lbp = (inquiry_logical_block_provisioning_page_t *)inquiry_page->inquiry_page_data;
+
+    block_provisioning->threshold_exponent = lbp->threshold_exponent;
+    block_provisioning->lbpu = lbp->lbpu;
+    block_provisioning->lbpws = lbp->lbpws;
+    block_provisioning->lbpws10 = lbp->lbpws10;
+    block_provisioning->lbprz = (lbp->lbprz & LBPRZ_UNMAPPED_READ_AS_ZERO_MASK) ? True : False;
+    block_provisioning->anc_sup = lbp->anc_sup;
+    block_provisioning->dp = lbp->dp;
+    block_provisioning->provisioning_type = lbp->provisioning_type;
+    return(status);
+}
+
+/* ======================================================================== */
+
 /*
  * AtaGetDriveFwVersion() - Get the ATA Drive FW Version.
  *
@@ -2109,6 +2178,178 @@ ReceiveRodTokenInfo(scsi_generic_t *sgp, unsigned int listid, void *data, unsign
 
 /* ======================================================================== */
 
+/*
+ * GetLbaStatus() - Send a Get LBA Status(16) CDB.
+ *
+ * Inputs:
+ * 	sgp = The SCSI generic data.
+ * 	lba = The starting logical block address.
+ * 	data = The parameter data buffer.
+ * 	bytes = The parameter data buffer length.
+ *
+ * Return Value:
+ *	Returns the status from the IOCTL request which is:
+ *	    0 = Success, -1 = Failure
+ */
+int
+GetLbaStatus(scsi_generic_t *sgp, uint64_t lba, void *data, unsigned int bytes)
+{
+    get_lba_status_cdb_t *cdb;
+    int error;
+
+    memset(sgp->cdb, 0, sizeof(sgp->cdb));
+    cdb             = (get_lba_status_cdb_t *)sgp->cdb;
+    cdb->opcode     = SOPC_SERVICE_ACTION_IN_16;
+    cdb->service_action = SCSI_SERVICE_ACTION_GET_LBA_STATUS;
+    HtoS(cdb->start_lba, lba);
+    HtoS(cdb->allocation_length, bytes);
+    sgp->cdb_size   = sizeof(*cdb);
+    sgp->cdb_name   = "Get LBA Status(16)";
+    sgp->data_dir   = scsi_data_read;
+    sgp->data_buffer = data;
+    sgp->data_length = bytes;
+    if (!sgp->timeout) {
+	sgp->timeout = ReadTimeout;
+    }
+    
+    error = libExecuteCdb(sgp);
+
+    return(error);
+}
+
+/*
+ * Unmap() - Send an Unmap CDB for a single block range.
+ *
+ * Inputs:
+ * 	sgp = The SCSI generic data.
+ * 	lba = The starting logical block address.
+ * 	blocks = The number of blocks to unmap.
+ *
+ * Return Value:
+ *	Returns the status from the IOCTL request which is:
+ *	    0 = Success, -1 = Failure
+ */
+int
+Unmap(scsi_generic_t *sgp, uint64_t lba, uint32_t blocks)
+{
+    unmap_cdb_t *cdb;
+    struct {
+	unmap_parameter_list_header_t header;
+	unmap_block_descriptor_t descriptor;
+    } unmap_data;
+    int error;
+
+    memset(&unmap_data, 0, sizeof(unmap_data));
+    HtoS(unmap_data.header.data_length, (sizeof(unmap_data) - sizeof(unmap_data.header.data_length)));
+    HtoS(unmap_data.header.block_descriptor_length, sizeof(unmap_data.descriptor));
+    HtoS(unmap_data.descriptor.lba, lba);
+    HtoS(unmap_data.descriptor.length, blocks);
+
+    memset(sgp->cdb, 0, sizeof(sgp->cdb));
+    cdb             = (unmap_cdb_t *)sgp->cdb;
+    cdb->opcode     = SOPC_UNMAP;
+    HtoS(cdb->parameter_list_length, sizeof(unmap_data));
+    sgp->cdb_size   = sizeof(*cdb);
+    sgp->cdb_name   = "Unmap";
+    sgp->data_dir   = scsi_data_write;
+    sgp->data_buffer = &unmap_data;
+    sgp->data_length = sizeof(unmap_data);
+    if (!sgp->timeout) {
+	sgp->timeout = WriteTimeout;
+    }
+    
+    error = libExecuteCdb(sgp);
+
+    return(error);
+}
+
+/*
+ * CompareWrite16() - Send a Compare and Write(16) CDB.
+ *
+ * Inputs:
+ * 	sgp = The SCSI generic data.
+ * 	lba = The starting logical block address.
+ * 	blocks = The number of blocks to compare and write.
+ * 	data = The compare data, followed by the write data.
+ * 	bytes = The data length (twice the blocks size).
+ *
+ * Return Value:
+ *	Returns the status from the IOCTL request which is:
+ *	    0 = Success, -1 = Failure
+ */
+int
+CompareWrite16(scsi_generic_t *sgp, uint64_t lba, uint8_t blocks, void *data, uint32_t bytes)
+{
+    CompareWrite16_CDB_t *cdb;
+    int error;
+
+    memset(sgp->cdb, 0, sizeof(sgp->cdb));
+    cdb             = (CompareWrite16_CDB_t *)sgp->cdb;
+    cdb->opcode     = SOPC_COMPARE_AND_WRITE;
+    HtoS(cdb->lba, lba);
+    cdb->blocks     = blocks;
+    sgp->cdb_size   = sizeof(*cdb);
+    sgp->cdb_name   = "Compare and Write(16)";
+    sgp->data_dir   = scsi_data_write;
+    sgp->data_buffer = data;
+    sgp->data_length = bytes;
+    if (!sgp->timeout) {
+	sgp->timeout = WriteTimeout;
+    }
+    
+    error = libExecuteCdb(sgp);
+
+    return(error);
+}
+
+/*
+ * Verify16() - Send a Verify(16) CDB.
+ *
+ * Inputs:
+ * 	sgp = The SCSI generic data.
+ * 	lba = The starting logical block address.
+ * 	blocks = The number of blocks to verify.
+ * 	bytchk = The byte check (SCSI_VERIFY_BYTCHK_*).
+ * 	data = The expected data (NULL for no byte check).
+ * 	bytes = The data length (one block for BYTCHK=3).
+ *
+ * Return Value:
+ *	Returns the status from the IOCTL request which is:
+ *	    0 = Success, -1 = Failure
+ */
+int
+Verify16(scsi_generic_t *sgp, uint64_t lba, uint32_t blocks, uint8_t bytchk, void *data, uint32_t bytes)
+{
+    DirectRW16_CDB_t *cdb;
+    int error;
+
+    memset(sgp->cdb, 0, sizeof(sgp->cdb));
+    cdb             = (DirectRW16_CDB_t *)sgp->cdb;
+    cdb->opcode     = SOPC_VERIFY_16;
+    cdb->flags      = (uint8_t)(bytchk << SCSI_VERIFY_BYTCHK_SHIFT);
+    HtoS(cdb->lba, lba);
+    HtoS(cdb->length, blocks);
+    sgp->cdb_size   = sizeof(*cdb);
+    sgp->cdb_name   = "Verify(16)";
+    if (bytchk == SCSI_VERIFY_BYTCHK_NONE) {
+	sgp->data_dir = scsi_data_none;
+	sgp->data_length = 0;
+    } else {
+	sgp->data_dir = scsi_data_write;
+	sgp->data_buffer = data;
+	sgp->data_length = bytes;
+    }
+    if (!sgp->timeout) {
+	sgp->timeout = ReadTimeout;
+    }
+    
+    error = libExecuteCdb(sgp);
+
+    return(error);
+}
+
+/* ======================================================================== */
+
 /*
  * Declarations/Definitions for Test Unit Ready Command:
  */
@@ -2401,7 +2642,11 @@ GetCdbLength(unsigned char opcode)
 	    break;
 
 	case SCSI_GROUP_3:
-	    cdb_length = 0;	    /* Reserved group. */
+	    if (opcode == SOPC_VARIABLE_LENGTH) {
+		cdb_length = SOPC_VARIABLE_LENGTH_CDB_SIZE;
+	    } else {
+		cdb_length = 0;	    /* Reserved group. */
+	    }
 	    break;
 
 	case SCSI_GROUP_4:
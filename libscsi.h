@@ -697,7 +697,6 @@ extern int GetThirdPartyCopy(HANDLE fd, char *dsf, hbool_t debug, hbool_t errlog
 			     inquiry_third_party_copy_t *third_party_copy, tool_specific_t *tsp);
 extern int GetBlockLimits(HANDLE fd, char *dsf, hbool_t debug, hbool_t errlog,
 			  inquiry_block_limits_t *block_limits, tool_specific_t *tsp);
-/* TODO: This API is NOT implemented yet! */
 extern int GetLogicalBlockProvisioning(HANDLE fd, char *dsf, hbool_t debug, hbool_t errlog,
 				       inquiry_logical_block_provisioning_t *block_provisioning,
 				       tool_specific_t *tsp);
@@ -728,6 +727,10 @@ extern int Write10(scsi_generic_t *sgp, uint32_t lba, uint16_t length, uint32_t
 extern int Write16(scsi_generic_t *sgp, uint64_t lba, uint32_t length, uint32_t bytes);
 extern int PopulateToken(scsi_generic_t *sgp, unsigned int listid, void *data, unsigned int bytes);
 extern int ReceiveRodTokenInfo(scsi_generic_t *sgp, unsigned int listid, void *data, unsigned int bytes);
+extern int GetLbaStatus(scsi_generic_t *sgp, uint64_t lba, void *data, unsigned int bytes);
+extern int Unmap(scsi_generic_t *sgp, uint64_t lba, uint32_t blocks);
+extern int CompareWrite16(scsi_generic_t *sgp, uint64_t lba, uint8_t blocks, void *data, uint32_t bytes);
+extern int Verify16(scsi_generic_t *sgp, uint64_t lba, uint32_t blocks, uint8_t bytchk, void *data, uint32_t bytes);
 extern int TestUnitReady(HANDLE fd, char *dsf, hbool_t debug, hbool_t errlog,
                          scsi_addr_t *sap, scsi_generic_t **sgpp,
 			 unsigned int timeout, tool_specific_t *tsp) ;
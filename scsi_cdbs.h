@@ -904,6 +904,39 @@ typedef struct DirectRW16_CDB {
 	uint8_t	control;		/* Various control flags.      [15] */
 } DirectRW16_CDB_t;
 
+/*
+ * Read(32) / Write(32) Variable Length CDB: (for Type 2 protection)
+ */
+typedef struct DirectRW32_CDB {
+	uint8_t	opcode;			/* Operation Code (0x7F).	[0] */
+	uint8_t	control;		/* Various control flags.	[1] */
+	uint8_t	reserved_byte2_5[4];	/* Reserved.		      [2-5] */
+	uint8_t	group_number;		/* Group number.		[6] */
+	uint8_t	additional_length;	/* Additional CDB length (0x18).[7] */
+	uint8_t	service_action[2];	/* Service action.	      [8-9] */
+	uint8_t	flags;			/* Protect, DPO, FUA flags.    [10] */
+	uint8_t	reserved_byte11;	/* Reserved.		       [11] */
+	uint8_t	lba[8];			/* Logical block address.   [12-19] */
+	uint8_t	reference_tag[4];	/* Expected initial ref tag.[20-23] */
+	uint8_t	application_tag[2];	/* Expected app tag.	    [24-25] */
+	uint8_t	application_mask[2];	/* Application tag mask.    [26-27] */
+	uint8_t	length[4];		/* Transfer Length.	    [28-31] */
+} DirectRW32_CDB_t;
+
+/*
+ * The RDPROTECT/WRPROTECT/VRPROTECT field, in the read/write flags byte.
+ */
+#define SCSI_PROTECT_SHIFT		5
+#define SCSI_PROTECT_MASK		0xE0
+
+/*
+ * Verify(16) uses the Read(16) layout, with the byte check in flags.
+ */
+#define SCSI_VERIFY_BYTCHK_SHIFT	1
+#define SCSI_VERIFY_BYTCHK_NONE		0	/* Medium verification only.   */
+#define SCSI_VERIFY_BYTCHK_COMPARE	1	/* Compare all blocks sent.    */
+#define SCSI_VERIFY_BYTCHK_SINGLE	3	/* Compare one block to all.   */
+
 /*
  * Read Defect Data Command Descriptor Block:
  */
@@ -1846,7 +1879,8 @@ typedef struct lba_status_descriptor {
 #define SCSI_PROV_STATUS_MAPPED		0x0	/* LBA extent is mapped.      */
 #define SCSI_PROV_STATUS_HOLE		0x1	/* LBA extent is deallocated. */
 #define SCSI_PROV_STATUS_ANCHORED	0x2	/* LBA extent is anchored.    */
-/* Note: Please update with SBC-4 status when time permits or is required! */
+#define SCSI_PROV_STATUS_MAPPED_UNKNOWN	0x3	/* Mapped or unknown (SBC-4). */
+#define SCSI_PROV_STATUS_UNKNOWN	0x4	/* LBA extent unknown (SBC-4).*/
 
 /* ======================================================================== */
 /* Report LUN Definitions: */
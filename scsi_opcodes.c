@@ -32,6 +32,41 @@
  *
  * Modification History:
  * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Generate the data reduction pattern for read/write encoders.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Generate the random pattern for writes, reads recompute to verify.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Set RDPROTECT/WRPROTECT in the read/write encoders, and add the
+ * Read(32) and Write(32) variable length CDB's for T10 PI Type 2.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add enable=bytchk to verify data using Verify(16) BYTCHK=1 (or 3),
+ * reporting host CPU per Gbyte and throughput for host and target compares.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add Compare and Write contention support (caw_locks=value), with
+ * acquire and miscompare rates, and CAW and acquire latency percentiles.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add a thin provisioning first write benchmark (enable=firstwrite).
+ * Each write is classified as a fresh allocation or overwrite using Get LBA
+ * Status, with latency recorded per class. Afterwards the range is unmapped
+ * and rewritten, to report the latency of writes after unmap.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add sparse copy/verify (enable=sparse), which uses Get LBA Status to
+ * skip deallocated source extents. For copy, the destination range is
+ * unmapped, and for verify, a deallocated destination is not read, when
+ * both devices guarantee zeroes are returned (LBPRZ).
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add parallel Get LBA Status scans, where each thread scans a slice,
+ * and the extents are merged into a map with mapped, deallocated, and
+ * anchored totals. The map is optionally written as a run-length file.
+ * 
  * January 27th, 2021 by Robin T. Miller
  *      When creating ODX list ID, add the job ID for uniqueness across jobs.
  * 
@@ -127,6 +162,7 @@ int process_end_of_data(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sg
 int random_rw6_encode(void *arg);
 int random_rw10_encode(void *arg);
 int random_rw16_encode(void *arg);
+int random_rw32_encode(void *arg);
 int random_ws16_encode(void *arg);
 int random_caw16_encode(void *arg);
 int extended_copy_encode(void *arg);
@@ -139,6 +175,11 @@ int read_capacity16_encode(void *arg);
 int read_capacity16_decode(void *arg);
 int get_lba_status_encode(void *arg);
 int get_lba_status_decode(void *arg);
+static int record_lba_extent(scsi_device_t *sdp, io_params_t *iop,
+			     uint64_t starting_lba, uint64_t extent_length, uint8_t provisioning_status);
+static int complete_lba_status_map(scsi_device_t *sdp, io_params_t *iop);
+static int report_lba_status_map(scsi_device_t *sdp, io_params_t *iop, lba_status_map_t *lsmp);
+static int write_lba_status_map(scsi_device_t *sdp, io_params_t *iop, lba_extent_t *extents, uint64_t extent_count);
 
 int report_luns_encode(void *arg);
 int report_luns_decode(void *arg);
@@ -175,6 +216,21 @@ int random_rw_process_data(scsi_device_t *sdp);
 int random_rw_ReadVerifyData(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp,
 			     uint64_t lba, uint32_t bytes);
 void restore_saved_parameters(scsi_device_t *sdp);
+static int sparse_get_extent(scsi_device_t *sdp, io_params_t *iop, uint64_t lba, lba_extent_t *extent);
+static int sparse_process_extents(scsi_device_t *sdp);
+static void sparse_report_totals(scsi_device_t *sdp);
+static int sparse_unmap_blocks(scsi_device_t *sdp, io_params_t *iop, uint64_t lba, uint64_t blocks, latency_stats_t *lsp);
+static int thin_write_setup(scsi_device_t *sdp, io_params_t *iop);
+static int thin_write_classify(scsi_device_t *sdp, io_params_t *iop);
+static int thin_write_end_of_pass(scsi_device_t *sdp, io_params_t *iop, uint64_t max_lba, uint64_t max_blocks);
+static void thin_write_report(scsi_device_t *sdp, io_params_t *iop);
+static hbool_t is_miscompare_error(scsi_generic_t *sgp);
+static int verify_offload_data(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp,
+			       uint64_t lba, uint32_t blocks, uint8_t *buffer, uint32_t bytes,
+			       hbool_t *miscompare);
+static void record_verify_stats(io_params_t *iop, verify_path_t path, uint32_t bytes,
+				uint64_t start_usecs, uint64_t start_cpu_usecs);
+static void verify_report_totals(scsi_device_t *sdp);
 int scsiReadData(io_params_t *iop, scsi_io_type_t read_type, scsi_generic_t *sgp, uint64_t lba, uint32_t blocks, uint32_t bytes);
 int scsiWriteData(io_params_t *iop, scsi_io_type_t write_type, scsi_generic_t *sgp, uint64_t lba, uint32_t blocks, uint32_t bytes);
 
@@ -433,7 +489,7 @@ initialize_slice(scsi_device_t *sdp, scsi_device_t *tsdp, uint32_t slice)
         tsgp = &iop->sg;
 
         tiop->slice = slice;
-	tiop->starting_lba = (iop->slice_length * (slice - 1));
+	tiop->starting_lba = (iop->slice_lba + (iop->slice_length * (slice - 1)));
 	tiop->ending_lba = (tiop->starting_lba + iop->slice_length);
 	tiop->data_limit = 0;
 	if (slice == sdp->slices) {
@@ -1092,7 +1148,9 @@ get_lba_status_encode(void *arg)
 	iop->disable_length_check = True;
 	iop->deallocated_blocks = 0;
 	iop->mapped_blocks = 0;
+	iop->anchored_blocks = 0;
 	iop->total_lba_blocks = 0;
+	iop->lba_extent_count = 0;
 	iop->cdb_blocks = 1; /* Magic to initialize parameters below! */
     }
     cdb = (get_lba_status_cdb_t *)sgp->cdb;
@@ -1109,11 +1167,29 @@ get_lba_status_encode(void *arg)
 
     status = initialize_io_parameters(sdp, iop, max_lba, max_blocks);
     if (status == END_OF_DATA) {
-	PrintHeader(sdp, "Get LBA Status Information");
-	PrintLongDec(sdp, "Mapped Blocks", iop->mapped_blocks,  PNL);
-	PrintLongDec(sdp, "Deallocated Blocks", iop->deallocated_blocks,  PNL);
-	PrintLongDec(sdp, "Total Blocks", (iop->deallocated_blocks + iop->mapped_blocks),  PNL);
-	Printf(sdp, "\n");
+	/* With slices, the merged totals are reported once all slices complete. */
+	if ( (sdp->lba_status_map == NULL) || sdp->DebugFlag) {
+	    if (sdp->lba_status_map) {
+		PrintHeader(sdp, "Get LBA Status Slice Information");
+		PrintDecimal(sdp, "Slice Number", iop->slice, PNL);
+		PrintLongDec(sdp, "Starting LBA", iop->starting_lba,  PNL);
+	    } else {
+		PrintHeader(sdp, "Get LBA Status Information");
+	    }
+	    PrintLongDec(sdp, "Mapped Blocks", iop->mapped_blocks,  PNL);
+	    PrintLongDec(sdp, "Deallocated Blocks", iop->deallocated_blocks,  PNL);
+	    if (iop->anchored_blocks) {
+		PrintLongDec(sdp, "Anchored Blocks", iop->anchored_blocks,  PNL);
+	    }
+	    PrintLongDec(sdp, "Total Blocks",
+			 (iop->deallocated_blocks + iop->mapped_blocks + iop->anchored_blocks),  PNL);
+	    Printf(sdp, "\n");
+	}
+	if (sdp->lba_status_map) {
+	    if (complete_lba_status_map(sdp, iop) == FAILURE) {
+		return(FAILURE);
+	    }
+	}
     }
     if (status != SUCCESS) return(status);
 
@@ -1182,11 +1258,17 @@ get_lba_status_decode(void *arg)
 	total_extents += extent_length;
 	iop->total_lba_blocks += extent_length;
 
-	if (lbasdp->provisioning_status & SCSI_PROV_STATUS_HOLE) {
+	if (lbasdp->provisioning_status == SCSI_PROV_STATUS_ANCHORED) {
+	    iop->anchored_blocks += extent_length;
+	} else if (lbasdp->provisioning_status & SCSI_PROV_STATUS_HOLE) {
 	    iop->deallocated_blocks += extent_length;
 	} else {
 	    iop->mapped_blocks += extent_length;
 	}
+	if (sdp->lba_status_map) {
+	    status = record_lba_extent(sdp, iop, starting_lba, extent_length, lbasdp->provisioning_status);
+	    if (status == FAILURE) return(status);
+	}
 	if (iop->total_lba_blocks >= iop->block_limit) {
 	    break;
 	}
@@ -1196,7 +1278,9 @@ get_lba_status_decode(void *arg)
 	Printf(sdp, "\n");
 	PrintLongDec(sdp, "Deallocated Blocks", iop->deallocated_blocks,  PNL);
 	PrintLongDec(sdp, "Mapped Blocks", iop->mapped_blocks,  PNL);
-	PrintLongDec(sdp, "Total Blocks", (iop->deallocated_blocks + iop->mapped_blocks),  PNL);
+	PrintLongDec(sdp, "Anchored Blocks", iop->anchored_blocks,  PNL);
+	PrintLongDec(sdp, "Total Blocks",
+		     (iop->deallocated_blocks + iop->mapped_blocks + iop->anchored_blocks),  PNL);
 	Printf(sdp, "\n");
     }
     /* Cludge to adjust for CDB blocks we don't have! */
@@ -1208,6 +1292,319 @@ get_lba_status_decode(void *arg)
     return(SUCCESS);
 }
 
+/*
+ * is_get_lba_status() - Check for a Get LBA Status CDB.
+ *
+ * Inputs:
+ *	sgp = The SCSI generic pointer.
+ *
+ * Return Value:
+ *	Returns True / False = Get LBA Status / Another CDB.
+ */
+hbool_t
+is_get_lba_status(scsi_generic_t *sgp)
+{
+    return ( (sgp->cdb[0] == SOPC_SERVICE_ACTION_IN_16) &&
+	     ((sgp->cdb[1] & 0x1F) == SCSI_SERVICE_ACTION_GET_LBA_STATUS) );
+}
+
+/*
+ * create_lba_status_map() - Create the Get LBA Status Map.
+ *
+ * Description:
+ *	The map is shared by all threads, where each thread scans its' own
+ * slice of the LUN. The map is only created for slices, or when the user
+ * requested a map file, otherwise each thread reports its' own totals.
+ *
+ * Inputs:
+ *	sdp = The master SCSI device pointer.
+ *
+ * Return Value:
+ *	Returns SUCCESS / FAILURE.
+ */
+int
+create_lba_status_map(scsi_device_t *sdp)
+{
+    io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
+    scsi_generic_t *sgp = &iop->sg;
+    lba_status_map_t *lsmp;
+    struct tms start_times;
+    int status;
+
+    sdp->lba_status_map = NULL;
+    if ( (sdp->encode_flag == False) || (is_get_lba_status(sgp) == False) ) {
+	return(SUCCESS);
+    }
+    if ( (sdp->slices == 0) && (sdp->lba_map_file == NULL) ) {
+	return(SUCCESS);
+    }
+    lsmp = Malloc(sdp, sizeof(*lsmp));
+    if (lsmp == NULL) return(FAILURE);
+    /* A specific slice is scanned by one thread, so only one map. */
+    if (sdp->slices && (sdp->slice_number == 0)) {
+	lsmp->lsm_slices = sdp->slices;
+    } else {
+	lsmp->lsm_slices = 1;
+    }
+    lsmp->lsm_maps = Malloc(sdp, (sizeof(lba_slice_map_t) * lsmp->lsm_slices));
+    if (lsmp->lsm_maps == NULL) {
+	Free(sdp, lsmp);
+	return(FAILURE);
+    }
+    if ( (status = pthread_mutex_init(&lsmp->lsm_lock, NULL)) != SUCCESS) {
+	tPerror(sdp, status, "pthread_mutex_init() of LBA status map lock failed!");
+	Free(sdp, lsmp->lsm_maps);
+	Free(sdp, lsmp);
+	return(FAILURE);
+    }
+    lsmp->lsm_references = sdp->threads;
+    lsmp->lsm_device_size = iop->device_size;
+    lsmp->lsm_start_ticks = times(&start_times);
+    sdp->lba_status_map = lsmp;
+    return(SUCCESS);
+}
+
+/*
+ * release_lba_status_map() - Release a thread reference to the map.
+ *
+ * Inputs:
+ *	sdp = The thread SCSI device pointer.
+ *
+ * Return Value:
+ *	void
+ */
+void
+release_lba_status_map(scsi_device_t *sdp)
+{
+    lba_status_map_t *lsmp = sdp->lba_status_map;
+    uint32_t slice;
+    int references;
+
+    if (lsmp == NULL) return;
+    sdp->lba_status_map = NULL;
+    (void)pthread_mutex_lock(&lsmp->lsm_lock);
+    references = --lsmp->lsm_references;
+    (void)pthread_mutex_unlock(&lsmp->lsm_lock);
+    if (references) return;
+
+    /* The last thread frees the map. */
+    for (slice = 0; (slice < lsmp->lsm_slices); slice++) {
+	if (lsmp->lsm_maps[slice].lm_extents) {
+	    free(lsmp->lsm_maps[slice].lm_extents);
+	}
+    }
+    (void)pthread_mutex_destroy(&lsmp->lsm_lock);
+    Free(sdp, lsmp->lsm_maps);
+    Free(sdp, lsmp);
+    return;
+}
+
+/*
+ * record_lba_extent() - Record an extent for this slice.
+ *
+ * Description:
+ *	Adjacent extents with the same provisioning status are coalesced,
+ * so the extent list is already run-length encoded.
+ */
+static int
+record_lba_extent(scsi_device_t *sdp, io_params_t *iop,
+		  uint64_t starting_lba, uint64_t extent_length, uint8_t provisioning_status)
+{
+    lba_extent_t *lep;
+
+    if (iop->lba_extent_count) {
+	lep = &iop->lba_extents[iop->lba_extent_count - 1];
+	if ( (lep->provisioning_status == provisioning_status) &&
+	     ((lep->starting_lba + lep->extent_length) == starting_lba) ) {
+	    lep->extent_length += extent_length;
+	    return(SUCCESS);
+	}
+    }
+    if (iop->lba_extent_count == iop->lba_extent_entries) {
+	uint32_t entries = (iop->lba_extent_entries) ? (iop->lba_extent_entries * 2) : MAX_LBA_STATUS_DESC;
+	/* Note: Our Realloc() clears the buffer, so use realloc() directly. */
+	lep = realloc(iop->lba_extents, (sizeof(*lep) * entries));
+	if (lep == NULL) {
+	    report_nomem(sdp, (sizeof(*lep) * entries));
+	    return(FAILURE);
+	}
+	iop->lba_extents = lep;
+	iop->lba_extent_entries = entries;
+    }
+    lep = &iop->lba_extents[iop->lba_extent_count++];
+    lep->starting_lba = starting_lba;
+    lep->extent_length = extent_length;
+    lep->provisioning_status = provisioning_status;
+    return(SUCCESS);
+}
+
+/*
+ * complete_lba_status_map() - Complete this slice of the map.
+ *
+ * Description:
+ *	The slice extents are handed off to the shared map. When all slices
+ * have completed another pass, this thread reports the merged results.
+ */
+static int
+complete_lba_status_map(scsi_device_t *sdp, io_params_t *iop)
+{
+    lba_status_map_t *lsmp = sdp->lba_status_map;
+    lba_slice_map_t *lmp;
+    uint64_t passes;
+    uint32_t slice;
+    int status = SUCCESS;
+
+    if ( (lsmp->lsm_slices == 1) || (iop->slice == 0) ) {
+	slice = 0;
+    } else {
+	slice = (iop->slice - 1);
+    }
+    (void)pthread_mutex_lock(&lsmp->lsm_lock);
+    lmp = &lsmp->lsm_maps[slice];
+    if (lmp->lm_extents) free(lmp->lm_extents);
+    lmp->lm_extents = iop->lba_extents;
+    lmp->lm_extent_count = iop->lba_extent_count;
+    lmp->lm_passes++;
+    iop->lba_extents = NULL;
+    iop->lba_extent_count = iop->lba_extent_entries = 0;
+
+    /* Find the slowest slice, to know if everyone has finished. */
+    passes = lmp->lm_passes;
+    for (slice = 0; (slice < lsmp->lsm_slices); slice++) {
+	passes = min(passes, lsmp->lsm_maps[slice].lm_passes);
+    }
+    if (passes > lsmp->lsm_reported) {
+	lsmp->lsm_reported = passes;
+	status = report_lba_status_map(sdp, iop, lsmp);
+    }
+    (void)pthread_mutex_unlock(&lsmp->lsm_lock);
+    return(status);
+}
+
+/*
+ * report_lba_status_map() - Merge slice extents and report totals.
+ *
+ * Note: The map lock is held by our caller.
+ */
+static int
+report_lba_status_map(scsi_device_t *sdp, io_params_t *iop, lba_status_map_t *lsmp)
+{
+    lba_extent_t *extents, *lep, *mep = NULL;
+    lba_slice_map_t *lmp;
+    uint64_t extent_count = 0, total_extents = 0;
+    uint64_t mapped_blocks = 0, deallocated_blocks = 0, anchored_blocks = 0;
+    uint64_t unknown_blocks = 0;
+    uint32_t slice, extent;
+    struct tms end_times;
+    char buffer[SMALL_BUFFER_SIZE];
+    int status = SUCCESS;
+
+    for (slice = 0; (slice < lsmp->lsm_slices); slice++) {
+	total_extents += lsmp->lsm_maps[slice].lm_extent_count;
+    }
+    extents = malloc((size_t)(sizeof(*extents) * max(total_extents, 1)));
+    if (extents == NULL) {
+	report_nomem(sdp, (size_t)(sizeof(*extents) * total_extents));
+	return(FAILURE);
+    }
+    /* Slices are in LBA order, so coalesce extents across slice boundaries. */
+    for (slice = 0; (slice < lsmp->lsm_slices); slice++) {
+	lmp = &lsmp->lsm_maps[slice];
+	for (extent = 0; (extent < lmp->lm_extent_count); extent++) {
+	    lep = &lmp->lm_extents[extent];
+	    /* Mapped or unknown (0x3) and unknown (0x4) are not deallocated. */
+	    if (lep->provisioning_status == SCSI_PROV_STATUS_MAPPED) {
+		mapped_blocks += lep->extent_length;
+	    } else if (lep->provisioning_status == SCSI_PROV_STATUS_HOLE) {
+		deallocated_blocks += lep->extent_length;
+	    } else if (lep->provisioning_status == SCSI_PROV_STATUS_ANCHORED) {
+		anchored_blocks += lep->extent_length;
+	    } else {
+		unknown_blocks += lep->extent_length;
+	    }
+	    if ( mep && (mep->provisioning_status == lep->provisioning_status) &&
+		 ((mep->starting_lba + mep->extent_length) == lep->starting_lba) ) {
+		mep->extent_length += lep->extent_length;
+	    } else {
+		mep = &extents[extent_count++];
+		*mep = *lep;
+	    }
+	}
+    }
+    PrintHeader(sdp, "Get LBA Status Information");
+    if (lsmp->lsm_slices > 1) {
+	PrintDecimal(sdp, "Number of Slices", lsmp->lsm_slices, PNL);
+    }
+    PrintLongDec(sdp, "Mapped Blocks", mapped_blocks,  PNL);
+    PrintLongDec(sdp, "Deallocated Blocks", deallocated_blocks,  PNL);
+    PrintLongDec(sdp, "Anchored Blocks", anchored_blocks,  PNL);
+    if (unknown_blocks) {
+	PrintLongDec(sdp, "Unknown Status Blocks", unknown_blocks,  PNL);
+    }
+    PrintLongDec(sdp, "Total Blocks",
+		 (mapped_blocks + deallocated_blocks + anchored_blocks + unknown_blocks),  PNL);
+    PrintLongDec(sdp, "Extent Runs", extent_count,  PNL);
+    (void)FormatElapstedTime(buffer, (times(&end_times) - lsmp->lsm_start_ticks));
+    PrintAscii(sdp, "Elapsed Time", buffer, PNL);
+    if (sdp->lba_map_file) {
+	PrintAscii(sdp, "LBA Map File", sdp->lba_map_file, PNL);
+    }
+    Printf(sdp, "\n");
+    if (sdp->lba_map_file) {
+	status = write_lba_status_map(sdp, iop, extents, extent_count);
+    }
+    free(extents);
+    return(status);
+}
+
+/*
+ * write_lba_status_map() - Write the run-length LBA status map file.
+ *
+ * Inputs:
+ *	sdp = The SCSI device pointer.
+ *	iop = The I/O parameters pointer.
+ *	extents = The merged (contiguous) extents.
+ *	extent_count = The number of extents.
+ *
+ * Return Value:
+ *	Returns SUCCESS / FAILURE.
+ */
+static int
+write_lba_status_map(scsi_device_t *sdp, io_params_t *iop, lba_extent_t *extents, uint64_t extent_count)
+{
+    lba_status_map_t *lsmp = sdp->lba_status_map;
+    lba_map_header_t *lmhp;
+    lba_map_run_t *lmrp;
+    uint64_t extent, total_blocks = 0;
+    size_t map_size;
+    HANDLE fd = INVALID_HANDLE_VALUE;
+    int status;
+
+    map_size = (size_t)(sizeof(*lmhp) + (sizeof(*lmrp) * extent_count));
+    lmhp = Malloc(sdp, map_size);
+    if (lmhp == NULL) return(FAILURE);
+    lmrp = (lba_map_run_t *)(lmhp + 1);
+    for (extent = 0; (extent < extent_count); extent++, lmrp++) {
+	lmrp->lmr_status = extents[extent].provisioning_status;
+	HtoS(lmrp->lmr_blocks, extents[extent].extent_length);
+	total_blocks += extents[extent].extent_length;
+    }
+    memcpy(lmhp->lmh_magic, LBA_MAP_MAGIC, sizeof(lmhp->lmh_magic));
+    HtoS(lmhp->lmh_version, LBA_MAP_VERSION);
+    HtoS(lmhp->lmh_device_size, lsmp->lsm_device_size);
+    HtoS(lmhp->lmh_starting_lba, (extent_count) ? extents[0].starting_lba : 0);
+    HtoS(lmhp->lmh_total_blocks, total_blocks);
+    HtoS(lmhp->lmh_extent_count, extent_count);
+
+    status = open_file(sdp, sdp->lba_map_file, OPEN_FOR_WRITING, &fd);
+    if (status == SUCCESS) {
+	status = write_file(sdp, sdp->lba_map_file, fd, (unsigned char *)lmhp, map_size);
+	(void)close_file(sdp, &fd);
+    }
+    Free(sdp, lmhp);
+    return(status);
+}
+
 /* ======================================================================== */
 
 #define REPORT_LUNS_BUFSIZE	(sizeof(report_luns_header_t) + (1024 * sizeof(report_luns_entry_t)))
@@ -1262,7 +1659,7 @@ report_luns_decode(void *arg)
 
     rlep = (report_luns_entry_t *)(rlhp + 1);
     for (entries = 0; (entries < lun_entries); rlep++) {
-	if (CmdInterruptedFlag) break;
+	if (CmdInterrupted(sdp)) break;
 	lun_value = StoH(rlep->lun_entry);
 	pdap = (PeripheralDeviceAddressing_t *)rlep;
 	//(void)sprintf(tmp, "Logical Unit Entry #%u", ++entries);
@@ -1669,7 +2066,7 @@ initialize_io_parameters(
 	 * data length was specified by the user, but now that has changed!
 	 * FYI: Without this pattern buffer, data verification does NOT happen!
 	*/
-	if ( (iop->sop->data_dir == scsi_data_read) &&
+	if ( (iop->sop->data_dir == scsi_data_read) && (sdp->rnd_pattern == False) &&
 	     (sgp->data_length && (sdp->pattern_buffer == NULL)) &&
 	     ((sdp->compare_data == True) || (sdp->user_pattern == True)) ) {
 	    sdp->pattern_buffer = malloc_palign(sdp, sgp->data_length, 0);
@@ -1732,6 +2129,18 @@ initialize_io_parameters(
 	} else if (iop->sop->data_dir == scsi_data_write) {
 	    (void)init_iotdata(sdp, iop, sgp->data_buffer, sgp->data_length, (uint32_t)iop->current_lba, sdp->iot_seed_per_pass);
 	}
+    } else if (sdp->dr_pattern) {
+	if ( (iop->sop->data_dir == scsi_data_read) && (sdp->compare_data == True) && sdp->pattern_buffer) {
+	    (void)init_drdata(sdp, iop, sdp->pattern_buffer, sgp->data_length, iop->current_lba, sdp->dr_seed);
+	} else if (iop->sop->data_dir == scsi_data_write) {
+	    (void)init_drdata(sdp, iop, sgp->data_buffer, sgp->data_length, iop->current_lba, sdp->dr_seed);
+	}
+    } else if (sdp->rnd_pattern) {
+	/* Note: Reads are verified by recomputing, so no pattern buffer. */
+	if (iop->sop->data_dir == scsi_data_write) {
+	    (void)init_rnddata(sdp, iop, sgp->data_buffer, sgp->data_length, iop->current_lba,
+			       sdp->rnd_seed, sdp->rnd_pass);
+	}
     }
     return (status);
 }
@@ -1772,6 +2181,7 @@ random_rw10_encode(void *arg)
     if (status != SUCCESS) return (status);
 
     HtoS(cdb->lba, iop->current_lba);
+    cdb->flags = pi_setup_flags(sdp, iop, cdb->flags);
     if (iop->cdb_blocks) {
 	HtoS(cdb->length, iop->cdb_blocks);
     } else {
@@ -1796,7 +2206,41 @@ random_rw16_encode(void *arg)
     if (status != SUCCESS) return (status);
 
     HtoS(cdb->lba, iop->current_lba);
+    cdb->flags = pi_setup_flags(sdp, iop, cdb->flags);
+
+    if (iop->cdb_blocks) {
+	HtoS(cdb->length, iop->cdb_blocks);
+    } else {
+	HtoS(cdb->length, (sgp->data_length / iop->device_size));
+    }
+    return (SUCCESS);
+}
+
+/*
+ * random_rw32_encode() - Encode Read(32) and Write(32) CDB's.
+ *
+ * Description:
+ *	These variable length CDB's are required for Type 2 protection, and
+ * include the expected initial reference tag, and the application tag.
+ */
+int
+random_rw32_encode(void *arg)
+{
+    scsi_device_t *sdp = arg;
+    io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
+    scsi_generic_t *sgp = &iop->sg;
+    DirectRW32_CDB_t *cdb = (DirectRW32_CDB_t *)sgp->cdb;
+    uint64_t max_lba = SCSI_MAX_LBA16, max_blocks = SCSI_MAX_BLOCKS16;
+    int status;
+
+    status = random_rw_process_cdb(sdp, iop, max_lba, max_blocks);
+    if (status != SUCCESS) return (status);
 
+    HtoS(cdb->lba, iop->current_lba);
+    cdb->flags = pi_setup_flags(sdp, iop, cdb->flags);
+    HtoS(cdb->reference_tag, iop->pi_initial_reftag);
+    HtoS(cdb->application_tag, sdp->pi_apptag);
+    HtoS(cdb->application_mask, (sdp->pi_check_apptag) ? sdp->pi_appmask : 0);
     if (iop->cdb_blocks) {
 	HtoS(cdb->length, iop->cdb_blocks);
     } else {
@@ -2016,161 +2460,1112 @@ cawReadVerifyData(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp,
 	}
     }
     free(rsgp);
-    return (status);
+    return (status);
+}
+
+/* ======================================================================== */
+
+/*
+ * Compare and Write Contention Support:
+ *
+ * This simulates many initiators contending for on-disk locks, such as
+ * VMFS ATS heartbeats. Each thread selects a lock LBA at random (from the
+ * caw_locks= lock count), and swaps in its own lock record via CAW, using
+ * its cached copy as the compare data. On miscompare, another thread won
+ * the race, so the current lock contents are read and the CAW retried.
+ */
+hbool_t
+is_caw_contention(scsi_device_t *sdp)
+{
+    io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
+    scsi_generic_t *sgp = &iop->sg;
+
+    return( (sdp->caw_locks && (sgp->cdb[0] == SOPC_COMPARE_AND_WRITE)) ? True : False );
+}
+
+int
+create_caw_contention(scsi_device_t *sdp)
+{
+    caw_contention_t *ccp;
+    int status;
+
+    sdp->caw_contention = NULL;
+    if (is_caw_contention(sdp) == False) {
+	return(SUCCESS);
+    }
+    ccp = Malloc(sdp, sizeof(*ccp));
+    if (ccp == NULL) return(FAILURE);
+    if ( (status = pthread_mutex_init(&ccp->cc_lock, NULL)) != SUCCESS) {
+	tPerror(sdp, status, "pthread_mutex_init() of CAW contention lock failed!");
+	Free(sdp, ccp);
+	return(FAILURE);
+    }
+    ccp->cc_references = sdp->threads;
+    ccp->cc_contenders = sdp->threads;
+    ccp->cc_paths = min(sdp->threads, sdp->io_devices);
+    ccp->cc_start_usecs = get_usecs();
+    sdp->caw_contention = ccp;
+    return(SUCCESS);
+}
+
+static void
+merge_caw_stats(caw_stats_t *csp, caw_stats_t *scsp)
+{
+    csp->cs_acquires += scsp->cs_acquires;
+    csp->cs_miscompares += scsp->cs_miscompares;
+    csp->cs_errors += scsp->cs_errors;
+    if (scsp->cs_max_attempts > csp->cs_max_attempts) {
+	csp->cs_max_attempts = scsp->cs_max_attempts;
+    }
+    merge_latency_stats(&csp->cs_caw_latency, &scsp->cs_caw_latency);
+    merge_latency_stats(&csp->cs_acquire_latency, &scsp->cs_acquire_latency);
+    return;
+}
+
+static void
+report_caw_contention(scsi_device_t *sdp, caw_contention_t *ccp)
+{
+    caw_stats_t *csp = &ccp->cc_stats;
+    uint64_t commands = (csp->cs_acquires + csp->cs_miscompares);
+    double secs = ((double)(get_usecs() - ccp->cc_start_usecs) / 1000000.0);
+    char buffer[LARGE_BUFFER_SIZE];
+
+    PrintHeader(sdp, "Compare and Write Contention");
+    PrintDecimal(sdp, "Contending Threads", ccp->cc_contenders, PNL);
+    PrintDecimal(sdp, "Device Paths", ccp->cc_paths, PNL);
+    PrintDecimal(sdp, "Number of Locks", sdp->caw_locks, PNL);
+    PrintLongDec(sdp, "Lock Acquires", csp->cs_acquires, PNL);
+    PrintLongDec(sdp, "Miscompares", csp->cs_miscompares, PNL);
+    PrintLongDec(sdp, "Command Errors", csp->cs_errors, PNL);
+    PrintLongDec(sdp, "Maximum Acquire Attempts", csp->cs_max_attempts, PNL);
+    if (secs > 0.0) {
+	(void)sprintf(buffer, "%.3f acquires/sec", ((double)csp->cs_acquires / secs));
+	PrintAscii(sdp, "Acquire Rate", buffer, PNL);
+    }
+    if (commands) {
+	(void)sprintf(buffer, "%.2f%%", (((double)csp->cs_miscompares * 100.0) / (double)commands));
+	PrintAscii(sdp, "Miscompare Rate", buffer, PNL);
+    }
+    (void)FormatElapstedTime(buffer, (clock_t)(secs * hertz));
+    PrintAscii(sdp, "Elapsed Time", buffer, PNL);
+    Printf(sdp, "\n");
+    report_latency_stats(sdp, "Compare and Write Latency", &csp->cs_caw_latency);
+    report_latency_stats(sdp, "Lock Acquire Latency", &csp->cs_acquire_latency);
+    return;
+}
+
+/*
+ * release_caw_contention() - Release a thread reference.
+ *
+ * Description:
+ *	The last thread reports the merged statistics, and frees the data.
+ */
+void
+release_caw_contention(scsi_device_t *sdp)
+{
+    caw_contention_t *ccp = sdp->caw_contention;
+    int references;
+
+    if (ccp == NULL) return;
+    sdp->caw_contention = NULL;
+    (void)pthread_mutex_lock(&ccp->cc_lock);
+    references = --ccp->cc_references;
+    (void)pthread_mutex_unlock(&ccp->cc_lock);
+    if (references) return;
+
+    report_caw_contention(sdp, ccp);
+    (void)pthread_mutex_destroy(&ccp->cc_lock);
+    Free(sdp, ccp);
+    return;
+}
+
+int
+caw_contention_setup(scsi_device_t *sdp)
+{
+    io_params_t *biop = &sdp->io_params[IO_INDEX_BASE];
+    io_params_t *iop;
+    scsi_generic_t *sgp;
+    caw_thread_t *ctp;
+    uint32_t lock;
+    int status = SUCCESS;
+
+    /* Spread the threads across the device paths. */
+    iop = &sdp->io_params[(sdp->thread_number - 1) % sdp->io_devices];
+    sgp = &iop->sg;
+    if ( !iop->device_size || !iop->device_capacity) {
+	status = GetCapacity(sdp, iop);
+	if (status != SUCCESS) return(status);
+    }
+    ctp = Malloc(sdp, sizeof(*ctp));
+    if (ctp == NULL) return(FAILURE);
+    sdp->caw_thread = ctp;
+    ctp->ct_iop = iop;
+    ctp->ct_lock_blocks = (biop->cdb_blocks) ? (uint32_t)biop->cdb_blocks : CAW_DEFAULT_BLOCKS;
+    ctp->ct_lock_bytes = (ctp->ct_lock_blocks * iop->device_size);
+    ctp->ct_starting_lba = biop->starting_lba;
+    /* The cycles are controlled by repeat or runtime, not the limit. */
+    biop->block_limit = 0;
+    if ( (ctp->ct_starting_lba + ((uint64_t)sdp->caw_locks * ctp->ct_lock_blocks)) > iop->device_capacity) {
+	ReportDeviceInformation(sdp, sgp);
+	Fprintf(sdp, "The CAW locks (%u) exceed the device capacity (" LUF ")!\n",
+		sdp->caw_locks, iop->device_capacity);
+	return(FAILURE);
+    }
+    ctp->ct_random = (sdp->random_seed + sdp->thread_number);
+    ctp->ct_locks = malloc_palign(sdp, ((size_t)sdp->caw_locks * ctp->ct_lock_bytes), 0);
+    ctp->ct_buffer = malloc_palign(sdp, (ctp->ct_lock_bytes * 2), 0);
+    ctp->ct_sgp = Malloc(sdp, sizeof(*sgp));
+    if ( (ctp->ct_locks == NULL) || (ctp->ct_buffer == NULL) || (ctp->ct_sgp == NULL) ) {
+	return(FAILURE);
+    }
+    /*
+     * Duplicate the SCSI generic, to keep sane (CDB, SCSI name, etc).
+     */ 
+    *ctp->ct_sgp = *sgp;
+    /* Read the current lock contents. */
+    for (lock = 0; (lock < sdp->caw_locks); lock++) {
+	ctp->ct_sgp->data_buffer = ctp->ct_locks + (lock * ctp->ct_lock_bytes);
+	status = ReadData(sdp->scsi_read_type, ctp->ct_sgp,
+			  (ctp->ct_starting_lba + (lock * ctp->ct_lock_blocks)),
+			  ctp->ct_lock_blocks, ctp->ct_lock_bytes);
+	if (status != SUCCESS) break;
+    }
+    return(status);
+}
+
+/*
+ * caw_contention_cycle() - Acquire one lock, retrying on miscompares.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE
+ */
+int
+caw_contention_cycle(scsi_device_t *sdp)
+{
+    caw_thread_t *ctp = sdp->caw_thread;
+    io_params_t *iop = ctp->ct_iop;
+    scsi_generic_t *sgp = ctp->ct_sgp;
+    caw_stats_t *csp = &ctp->ct_stats;
+    caw_lock_record_t *clrp;
+    uint8_t *cached, *compare_buffer, *write_buffer;
+    uint64_t lba, start_usecs, attempts = 0;
+    uint32_t lock;
+    hbool_t errlog = sgp->errlog;
+    int status;
+
+    ctp->ct_random = (ctp->ct_random * 6364136223846793005ULL) + 1442695040888963407ULL;
+    lock = (uint32_t)((ctp->ct_random >> 33) % sdp->caw_locks);
+    lba = ctp->ct_starting_lba + ((uint64_t)lock * ctp->ct_lock_blocks);
+    cached = ctp->ct_locks + (lock * ctp->ct_lock_bytes);
+    compare_buffer = ctp->ct_buffer;
+    write_buffer = ctp->ct_buffer + ctp->ct_lock_bytes;
+    start_usecs = get_usecs();
+
+    while (CmdInterrupted(sdp) == False) {
+	memcpy(compare_buffer, cached, ctp->ct_lock_bytes);
+	memcpy(write_buffer, cached, ctp->ct_lock_bytes);
+	clrp = (caw_lock_record_t *)write_buffer;
+	memcpy(clrp->clr_magic, CAW_LOCK_MAGIC, sizeof(clrp->clr_magic));
+	HtoS(clrp->clr_owner, sdp->thread_number);
+	HtoS(clrp->clr_generation, ++ctp->ct_generation);
+	HtoS(clrp->clr_timestamp, start_usecs);
+	attempts++;
+	/* Miscompares are expected, so we report other errors below. */
+	sgp->errlog = False;
+	status = CompareWrite16(sgp, lba, (uint8_t)ctp->ct_lock_blocks,
+				ctp->ct_buffer, (ctp->ct_lock_bytes * 2));
+	sgp->errlog = errlog;
+	record_latency(&csp->cs_caw_latency, iop->cmd_latency, 0);
+	if (status == SUCCESS) {
+	    memcpy(cached, write_buffer, ctp->ct_lock_bytes);
+	    csp->cs_acquires++;
+	    if (attempts > csp->cs_max_attempts) {
+		csp->cs_max_attempts = attempts;
+	    }
+	    record_latency(&csp->cs_acquire_latency, (get_usecs() - start_usecs), 0);
+	    return(SUCCESS);
+	}
+	if (is_miscompare_error(sgp) == True) {
+	    csp->cs_miscompares++;
+	    /* Lost the race, so refresh with the current lock contents. */
+	    sgp->data_buffer = cached;
+	    status = ReadData(sdp->scsi_read_type, sgp, lba,
+			      ctp->ct_lock_blocks, ctp->ct_lock_bytes);
+	    if (status != SUCCESS) break;
+	    continue;
+	}
+	csp->cs_errors++;
+	if (errlog == True) {
+	    ReportCdbDeviceInformation(sdp, sgp);
+	    if (sgp->error == True) {
+		libReportScsiError(sgp, False);
+	    } else {
+		libReportIoctlError(sgp, False);
+	    }
+	}
+	break;
+    }
+    return( (CmdInterrupted(sdp) == True) ? SUCCESS : FAILURE );
+}
+
+void
+caw_contention_finish(scsi_device_t *sdp)
+{
+    caw_contention_t *ccp = sdp->caw_contention;
+    caw_thread_t *ctp = sdp->caw_thread;
+
+    if (ctp == NULL) return;
+    if (ccp) {
+	(void)pthread_mutex_lock(&ccp->cc_lock);
+	merge_caw_stats(&ccp->cc_stats, &ctp->ct_stats);
+	(void)pthread_mutex_unlock(&ccp->cc_lock);
+    }
+    if (ctp->ct_locks) free_palign(sdp, ctp->ct_locks);
+    if (ctp->ct_buffer) free_palign(sdp, ctp->ct_buffer);
+    if (ctp->ct_sgp) Free(sdp, ctp->ct_sgp);
+    Free(sdp, ctp);
+    sdp->caw_thread = NULL;
+    return;
+}
+
+int
+random_rw_complete_io(scsi_device_t *sdp, uint64_t max_lba, uint64_t max_blocks)
+{
+    io_params_t *iop;
+    int device_index;
+    int status = SUCCESS;
+
+    for (device_index = 0; (device_index < sdp->io_devices); device_index++) {
+	int device_status;
+	iop = &sdp->io_params[device_index];
+	device_status = initialize_io_parameters(sdp, iop, max_lba, max_blocks);
+	if (device_status != SUCCESS) {
+	    status = device_status;	/* End of data or failure, go no further! */
+	    break;
+	}
+    }
+    return (status);
+}
+
+int
+random_rw_process_cdb(scsi_device_t *sdp, io_params_t *iop, uint64_t max_lba, uint64_t max_blocks)
+{
+    scsi_generic_t *sgp = &iop->sg;
+    int status = SUCCESS;
+
+    /*
+     * If this is a write request, test mode, a single device, and read
+     * after write is enabled, then read and verify the last data written.
+     * Note: All read and write requests come through this code flow!
+     */
+    if ( (iop->first_time == False) && (sdp->iomode == IOMODE_TEST) &&
+	 (sgp->data_dir == scsi_data_write) && (sdp->io_devices == 1) &&
+	 (sdp->status == SUCCESS) && (sdp->read_after_write == True) ) {
+	status = random_rw_ReadVerifyData(sdp, iop, sgp, iop->current_lba, sgp->data_transferred);
+	if (status != SUCCESS) return(status);
+    }
+
+    if (iop->first_time) {
+	status = initialize_io_parameters(sdp, iop, max_lba, max_blocks);
+	if (status != SUCCESS) return (status);
+	if ( sdp->first_write_flag && (sdp->iomode == IOMODE_TEST) &&
+	     (sgp->data_dir == scsi_data_write) ) {
+	    status = thin_write_setup(sdp, iop);
+	    if (status != SUCCESS) return (status);
+	}
+	if ( (sdp->iomode != IOMODE_TEST) && (sdp->io_devices > 1) ) {
+	    io_params_t *miop = &sdp->io_params[IO_INDEX_DSF1];
+	    //status = initialize_multiple_devices(sdp);
+	    //if (status != SUCCESS) return(status);
+	    status = initialize_io_parameters(sdp, miop, max_lba, max_blocks);
+	    if ( (status == SUCCESS) && sdp->sparse_flag ) {
+		iop->sparse_extent_count = miop->sparse_extent_count = 0;
+		iop->sparse_skipped_blocks = miop->sparse_unmapped_blocks = 0;
+		status = sparse_process_extents(sdp);
+	    }
+	}
+    } else {
+	if ( (sdp->iomode != IOMODE_TEST) && (sdp->io_devices > 1) ) {
+	    status = random_rw_process_data(sdp);
+	    if (status != SUCCESS) return(status);
+	    status = random_rw_complete_io(sdp, max_lba, max_blocks);
+	    if ( (status == SUCCESS) && sdp->sparse_flag ) {
+		status = sparse_process_extents(sdp);
+	    }
+	} else {
+	    status = initialize_io_parameters(sdp, iop, max_lba, max_blocks);
+	}
+    }
+    if ( sdp->first_write_flag && iop->thin_write_stats &&
+	 (sdp->iomode == IOMODE_TEST) && (sgp->data_dir == scsi_data_write) ) {
+	if (status == SUCCESS) {
+	    status = thin_write_classify(sdp, iop);
+	} else if (status == END_OF_DATA) {
+	    status = thin_write_end_of_pass(sdp, iop, max_lba, max_blocks);
+	    if (status != END_OF_DATA) return(status);
+	}
+    }
+    if (status == END_OF_DATA) {
+	if (sdp->sparse_flag && (sdp->io_devices > 1) ) {
+	    sparse_report_totals(sdp);
+	}
+	if (sdp->verify_offload == True) {
+	    verify_report_totals(sdp);
+	}
+	restore_saved_parameters(sdp);
+	iop->end_of_data = True;
+    }
+    return(status);
+}
+    
+int
+random_rw_ReadVerifyData(
+    scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp,
+    uint64_t lba, uint32_t bytes)
+{
+    uint8_t *verify_buffer = (uint8_t *)sgp->data_buffer;
+    scsi_generic_t *rsgp;
+    uint32_t blocks = howmany(bytes, iop->device_size);
+    uint64_t start_usecs, start_cpu_usecs;
+    int status = SUCCESS;
+
+    if ( (sdp->verify_offload == True) && (sdp->compare_data == True) ) {
+	hbool_t miscompare;
+	status = verify_offload_data(sdp, iop, sgp, lba, blocks, verify_buffer, bytes, &miscompare);
+	/* On miscompares, read the data to report the compare error details. */
+	if ( (status == SUCCESS) || (miscompare == False) ) {
+	    return(status);
+	}
+    }
+    rsgp = Malloc(sdp, sizeof(*sgp));
+    if (rsgp == NULL) return(FAILURE);
+    /*
+     * Duplicate the SCSI generic, to keep sane (CDB, SCSI name, etc).
+     */ 
+    *rsgp = *sgp;
+    rsgp->data_buffer = malloc_palign(sdp, bytes, 0);
+    if (rsgp->data_buffer == NULL) {
+	free(rsgp);
+	return(FAILURE);
+    }
+    start_usecs = get_usecs();
+    start_cpu_usecs = get_cpu_usecs();
+    status = scsiReadData(iop, sdp->scsi_read_type, rsgp, lba, blocks, bytes);
+    if ( (status == SUCCESS) && (sdp->compare_data == True) ) {
+	status = VerifyBuffers(sdp, rsgp->data_buffer,
+			       verify_buffer, rsgp->data_transferred);
+	if (status == FAILURE) {
+	    if (sdp->iot_pattern) {
+		process_iot_data(sdp, iop, verify_buffer,
+				 rsgp->data_buffer, rsgp->data_transferred);
+	    }
+	} else if (sdp->verify_offload == True) {
+	    record_verify_stats(iop, VERIFY_HOST_COMPARE, bytes, start_usecs, start_cpu_usecs);
+	}
+    }
+    free_palign(sdp, rsgp->data_buffer);
+    free(rsgp);
+    return (status);
+}
+
+int
+random_rw_process_data(scsi_device_t *sdp)
+{
+    io_params_t *iop = &sdp->io_params[IO_INDEX_DSF];
+    scsi_generic_t *sgp = &iop->sg;
+    io_params_t *miop = &sdp->io_params[IO_INDEX_DSF1];
+    scsi_generic_t *msgp = &miop->sg;
+    uint32_t blocks;
+    size_t bytes;
+    uint64_t src_starting_lba, dst_starting_lba;
+    int status;
+    
+    bytes = sgp->data_transferred;
+    blocks = howmany(sgp->data_transferred, iop->device_size);
+    if ( (miop->block_count + blocks) > miop->block_limit ) {
+	blocks = (uint32_t)(miop->block_limit - miop->block_count);
+	bytes = (blocks * miop->device_size);
+    }
+    src_starting_lba = iop->current_lba;
+    dst_starting_lba = miop->current_lba;
+    if (sdp->xDebugFlag) {
+	Printf(sdp, "Starting %s:\n", (sdp->iomode == IOMODE_COPY) ? "Copy" : "Verify");
+	PrintDecHex(sdp, "Number of Blocks", blocks, PNL);
+	PrintLongDecHex(sdp, "Source Block Device LBA", src_starting_lba, DNL);
+	Print(sdp, " (lba's " LUF " - " LUF ")\n", src_starting_lba, (src_starting_lba + blocks - 1));
+	PrintLongDecHex(sdp, "Destination Block Device LBA", dst_starting_lba, DNL);
+	Print(sdp, " (lba's " LUF " - " LUF ")\n", dst_starting_lba, (dst_starting_lba + blocks - 1));
+	Printf(sdp, "\n");
+    }
+
+    if (sdp->iomode == IOMODE_COPY) {
+	void *saved_buffer = msgp->data_buffer;
+	msgp->data_buffer = sgp->data_buffer;
+	status = scsiWriteData(miop, sdp->scsi_write_type, msgp, dst_starting_lba, blocks, (uint32_t)bytes);
+	msgp->data_buffer = saved_buffer;
+	if ( (status == SUCCESS) && (sdp->compare_data) ) {
+	    msgp->data_dir = scsi_data_read;
+	    status = scsiReadData(miop, sdp->scsi_read_type, msgp, dst_starting_lba, blocks, (uint32_t)bytes);
+	    if (status != SUCCESS) return(status);
+	    status = extended_copy_verify_buffers(sdp, msgp, sgp,
+						  blocks, src_starting_lba, dst_starting_lba,
+						  msgp->data_buffer, sgp->data_buffer, (uint32_t)bytes);
+	    msgp->data_dir = scsi_data_write;
+	}
+    } else { /* Mirror or Verify modes. */
+	uint64_t start_usecs, start_cpu_usecs;
+	if (sdp->verify_offload == True) {
+	    hbool_t miscompare;
+	    status = verify_offload_data(sdp, miop, msgp, dst_starting_lba, blocks,
+					 sgp->data_buffer, (uint32_t)bytes, &miscompare);
+	    /* On miscompares, read the data to report the compare error details. */
+	    if ( (status == SUCCESS) || (miscompare == False) ) {
+		return(status);
+	    }
+	}
+	start_usecs = get_usecs();
+	start_cpu_usecs = get_cpu_usecs();
+	status = scsiReadData(miop, sdp->scsi_read_type, msgp, dst_starting_lba, blocks, (uint32_t)bytes);
+	if (status != SUCCESS) return(status);
+	status = extended_copy_verify_buffers(sdp, msgp, sgp,
+					      blocks, src_starting_lba, dst_starting_lba,
+					      msgp->data_buffer, sgp->data_buffer, bytes);
+	if ( (status == SUCCESS) && (sdp->verify_offload == True) ) {
+	    record_verify_stats(miop, VERIFY_HOST_COMPARE, (uint32_t)bytes, start_usecs, start_cpu_usecs);
+	}
+    }
+    return(status);
+}
+
+/* ======================================================================== */
+
+/*
+ * Verify Offload Support: (enable=bytchk)
+ *
+ * Rather than reading the data back, and comparing on the host, the
+ * expected data is sent with Verify(16) BYTCHK=1, so the target does the
+ * comparison. When every block is identical (pattern data), BYTCHK=3 is
+ * used, so only a single block is transferred. Both paths are timed, with
+ * the host CPU used, so the two methods can be compared.
+ */
+static hbool_t
+is_miscompare_error(scsi_generic_t *sgp)
+{
+    unsigned char sense_key, asc, asq;
+
+    if ( (sgp->error == False) || (sgp->scsi_status != SCSI_CHECK_CONDITION) ) {
+	return(False);
+    }
+    GetSenseErrors(sgp->sense_data, &sense_key, &asc, &asq);
+    return( (sense_key == SKV_MISCOMPARE) ? True : False );
+}
+
+static hbool_t
+is_repeated_block(uint8_t *buffer, uint32_t block_size, uint32_t bytes)
+{
+    uint8_t *bptr;
+
+    for (bptr = (buffer + block_size); (bptr < (buffer + bytes)); bptr += block_size) {
+	if (memcmp(buffer, bptr, block_size) != 0) {
+	    return(False);
+	}
+    }
+    return(True);
+}
+
+static void
+record_verify_stats(io_params_t *iop, verify_path_t path, uint32_t bytes,
+		    uint64_t start_usecs, uint64_t start_cpu_usecs)
+{
+    verify_stats_t *vsp = &iop->verify_stats[path];
+
+    vsp->vs_commands++;
+    vsp->vs_bytes += bytes;
+    vsp->vs_elapsed_usecs += (get_usecs() - start_usecs);
+    vsp->vs_cpu_usecs += (get_cpu_usecs() - start_cpu_usecs);
+    return;
+}
+
+/*
+ * verify_offload_data() - Verify data with Verify(16) byte check.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	iop = The I/O parameters.
+ *	sgp = The SCSI generic (duplicated, since the CDB is overwritten).
+ *	lba = The starting logical block.
+ *	blocks = The number of blocks to verify.
+ *	buffer = The expected data.
+ *	bytes = The number of data bytes.
+ *	miscompare = Pointer to return miscompare flag.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE
+ */
+static int
+verify_offload_data(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp,
+		    uint64_t lba, uint32_t blocks, uint8_t *buffer, uint32_t bytes,
+		    hbool_t *miscompare)
+{
+    scsi_generic_t *vsgp;
+    uint64_t start_usecs = get_usecs();
+    uint64_t start_cpu_usecs = get_cpu_usecs();
+    uint8_t bytchk = SCSI_VERIFY_BYTCHK_COMPARE;
+    uint32_t data_length = bytes;
+    int status;
+
+    *miscompare = False;
+    vsgp = Malloc(sdp, sizeof(*sgp));
+    if (vsgp == NULL) return(FAILURE);
+    /*
+     * Duplicate the SCSI generic, to keep sane (CDB, SCSI name, etc).
+     */ 
+    *vsgp = *sgp;
+    /* IOT data has the LBA in every block, so never repeats. */
+    if ( (sdp->iot_pattern == False) && (blocks > 1) &&
+	 is_repeated_block(buffer, iop->device_size, bytes) ) {
+	bytchk = SCSI_VERIFY_BYTCHK_SINGLE;
+	data_length = iop->device_size;
+    }
+    status = Verify16(vsgp, lba, blocks, bytchk, buffer, data_length);
+    if (status == SUCCESS) {
+	iop->total_blocks += blocks;
+	iop->total_transferred += bytes;
+	record_verify_stats(iop, VERIFY_TARGET_COMPARE, bytes, start_usecs, start_cpu_usecs);
+	if (bytchk == SCSI_VERIFY_BYTCHK_SINGLE) {
+	    iop->verify_stats[VERIFY_TARGET_COMPARE].vs_single_blocks++;
+	}
+    } else {
+	*miscompare = is_miscompare_error(vsgp);
+    }
+    free(vsgp);
+    return(status);
+}
+
+static void
+report_verify_stats(scsi_device_t *sdp, io_params_t *iop)
+{
+    static char *path_names[VERIFY_PATHS] = { "Host Compare", "Target Compare" };
+    verify_stats_t *vsp;
+    char field[SMALL_BUFFER_SIZE];
+    char buffer[LARGE_BUFFER_SIZE];
+    verify_path_t path;
+
+    PrintHeader(sdp, "Data Verification Statistics");
+    PrintAscii(sdp, "Device Name", iop->sg.dsf, PNL);
+    for (path = VERIFY_HOST_COMPARE; (path < VERIFY_PATHS); path++) {
+	vsp = &iop->verify_stats[path];
+	if (vsp->vs_commands == 0) continue;
+	(void)sprintf(field, "%s Operations", path_names[path]);
+	PrintLongDec(sdp, field, vsp->vs_commands, PNL);
+	(void)sprintf(field, "%s Bytes", path_names[path]);
+	PrintLongDec(sdp, field, vsp->vs_bytes, PNL);
+	if (path == VERIFY_TARGET_COMPARE) {
+	    PrintLongDec(sdp, "Single Block Compares", vsp->vs_single_blocks, PNL);
+	}
+	if (vsp->vs_elapsed_usecs) {
+	    (void)sprintf(field, "%s Throughput", path_names[path]);
+	    (void)sprintf(buffer, "%.3f Mbytes/sec",
+			  (((double)vsp->vs_bytes / (double)MBYTE_SIZE) /
+			   ((double)vsp->vs_elapsed_usecs / 1000000.0)));
+	    PrintAscii(sdp, field, buffer, PNL);
+	}
+	(void)sprintf(field, "%s CPU per Gbyte", path_names[path]);
+	(void)sprintf(buffer, "%.3f secs",
+		      (((double)vsp->vs_cpu_usecs / 1000000.0) /
+		       ((double)vsp->vs_bytes / (double)GBYTE_SIZE)));
+	PrintAscii(sdp, field, buffer, PNL);
+    }
+    Printf(sdp, "\n");
+    memset(iop->verify_stats, '\0', sizeof(iop->verify_stats));
+    return;
+}
+
+/*
+ * verify_report_totals() - Report the verify statistics at end of pass.
+ */
+static void
+verify_report_totals(scsi_device_t *sdp)
+{
+    io_params_t *iop;
+    int device_index;
+
+    for (device_index = 0; (device_index < sdp->io_devices); device_index++) {
+	iop = &sdp->io_params[device_index];
+	if ( iop->verify_stats[VERIFY_HOST_COMPARE].vs_commands ||
+	     iop->verify_stats[VERIFY_TARGET_COMPARE].vs_commands ) {
+	    report_verify_stats(sdp, iop);
+	}
+    }
+    return;
+}
+
+/* ======================================================================== */
+
+/*
+ * Sparse Copy/Verify Support:
+ *
+ * Before each source read, the provisioning status at the current source
+ * LBA is looked up (Get LBA Status results are cached per device). Mapped
+ * extents are transferred as usual, but clipped at the extent boundary.
+ * Deallocated extents are skipped when the source reads zeroes (LBPRZ),
+ * so the elapsed time is proportional to the allocated data:
+ *
+ *   Copy   - The destination range is unmapped, if the destination also
+ *	      guarantees zeroes, otherwise the zeroes are copied.
+ *   Verify - If the destination range is also deallocated (with LBPRZ),
+ *	      neither device is read, otherwise the zeroes are compared.
+ */
+#define SPARSE_EXTENT_ENTRIES	256	/* Get LBA Status descriptors.	*/
+
+/*
+ * Only deallocated and anchored extents read as zeroes (with LBPRZ), the
+ * "mapped or unknown" and "unknown" statuses must be treated as mapped!
+ */
+#define SPARSE_READS_ZEROES(status) \
+	( ((status) == SCSI_PROV_STATUS_HOLE) || ((status) == SCSI_PROV_STATUS_ANCHORED) )
+
+static int
+sparse_get_extent(scsi_device_t *sdp, io_params_t *iop, uint64_t lba, lba_extent_t *extent)
+{
+    scsi_generic_t *sgp = &iop->sg;
+    scsi_generic_t *rsgp;
+    get_lba_status_param_data_t *paramp;
+    lba_status_descriptor_t *lbasdp;
+    lba_extent_t *lep;
+    uint32_t bytes, descriptors, param_data_length;
+    uint32_t entry;
+    int status;
+
+    for (entry = 0; (entry < iop->sparse_extent_count); entry++) {
+	lep = &iop->sparse_extents[entry];
+	if ( (lba >= lep->starting_lba) &&
+	     (lba < (lep->starting_lba + lep->extent_length)) ) {
+	    extent->starting_lba = lba;
+	    extent->extent_length = (lep->starting_lba + lep->extent_length) - lba;
+	    extent->provisioning_status = lep->provisioning_status;
+	    return(SUCCESS);
+	}
+    }
+    /*
+     * Not cached, so request the extents starting at this LBA.
+     */
+    if (iop->sparse_extents == NULL) {
+	iop->sparse_extents = Malloc(sdp, (sizeof(*lep) * SPARSE_EXTENT_ENTRIES));
+	if (iop->sparse_extents == NULL) return(FAILURE);
+    }
+    iop->sparse_extent_count = 0;
+    rsgp = Malloc(sdp, sizeof(*sgp));
+    if (rsgp == NULL) return(FAILURE);
+    /*
+     * Duplicate the SCSI generic, to keep sane (CDB, SCSI name, etc).
+     */ 
+    *rsgp = *sgp;
+    bytes = (uint32_t)(sizeof(*paramp) + (sizeof(*lbasdp) * SPARSE_EXTENT_ENTRIES));
+    rsgp->data_buffer = malloc_palign(sdp, bytes, 0);
+    if (rsgp->data_buffer == NULL) {
+	free(rsgp);
+	return(FAILURE);
+    }
+    status = GetLbaStatus(rsgp, lba, rsgp->data_buffer, bytes);
+    if (status == SUCCESS) {
+	paramp = (get_lba_status_param_data_t *)rsgp->data_buffer;
+	param_data_length = (uint32_t)StoH(paramp->parameter_data_length);
+	descriptors = (param_data_length / sizeof(*lbasdp));
+	if (descriptors > SPARSE_EXTENT_ENTRIES) {
+	    descriptors = SPARSE_EXTENT_ENTRIES;
+	}
+	lbasdp = (lba_status_descriptor_t *)((unsigned char *)rsgp->data_buffer + sizeof(*paramp));
+	for (; descriptors--; lbasdp++) {
+	    lep = &iop->sparse_extents[iop->sparse_extent_count];
+	    lep->starting_lba = StoH(lbasdp->start_lba);
+	    lep->extent_length = (uint32_t)StoH(lbasdp->extent_length);
+	    lep->provisioning_status = lbasdp->provisioning_status;
+	    if (lep->extent_length) iop->sparse_extent_count++;
+	}
+	if ( (iop->sparse_extent_count == 0) ||
+	     (lba < iop->sparse_extents[0].starting_lba) ||
+	     (lba >= (iop->sparse_extents[0].starting_lba + iop->sparse_extents[0].extent_length)) ) {
+	    Wprintf(sdp, "%s: Get LBA Status did not return an extent for LBA " LUF "!\n", sgp->dsf, lba);
+	    iop->sparse_extent_count = 0;
+	    status = FAILURE;
+	} else {
+	    lep = &iop->sparse_extents[0];
+	    extent->starting_lba = lba;
+	    extent->extent_length = (lep->starting_lba + lep->extent_length) - lba;
+	    extent->provisioning_status = lep->provisioning_status;
+	}
+    }
+    free_palign(sdp, rsgp->data_buffer);
+    free(rsgp);
+    return(status);
 }
 
-int
-random_rw_complete_io(scsi_device_t *sdp, uint64_t max_lba, uint64_t max_blocks)
+static int
+sparse_unmap_blocks(scsi_device_t *sdp, io_params_t *iop, uint64_t lba, uint64_t blocks, latency_stats_t *lsp)
 {
-    io_params_t *iop;
-    int device_index;
+    scsi_generic_t *sgp = &iop->sg;
+    scsi_generic_t *rsgp;
+    uint32_t unmap_blocks;
     int status = SUCCESS;
 
-    for (device_index = 0; (device_index < sdp->io_devices); device_index++) {
-	int device_status;
-	iop = &sdp->io_params[device_index];
-	device_status = initialize_io_parameters(sdp, iop, max_lba, max_blocks);
-	if (device_status != SUCCESS) {
-	    status = device_status;	/* End of data or failure, go no further! */
-	    break;
+    if (iop->max_unmap_lba_count == 0) {
+	inquiry_block_limits_t block_limits;
+	inquiry_block_limits_t *blp = &block_limits;
+	/* Note: Not using get_unmap_block_limits(), since it overrides CDB blocks! */
+	status = GetBlockLimits(sgp->fd, sgp->dsf, sgp->debug, False, blp, sgp->tsp);
+	if ( (status == SUCCESS) && blp->max_unmap_lba_count ) {
+	    iop->max_unmap_lba_count = blp->max_unmap_lba_count;
+	} else {
+	    iop->max_unmap_lba_count = UNMAP_MAX_BLOCKS;
 	}
     }
-    return (status);
+    rsgp = Malloc(sdp, sizeof(*sgp));
+    if (rsgp == NULL) return(FAILURE);
+    *rsgp = *sgp;
+    while (blocks) {
+	unmap_blocks = (uint32_t)min(blocks, (uint64_t)iop->max_unmap_lba_count);
+	if (sdp->xDebugFlag) {
+	    Printf(sdp, "Unmapping %u blocks, lba's " LUF " - " LUF " on %s\n",
+		   unmap_blocks, lba, (lba + unmap_blocks - 1), sgp->dsf);
+	}
+	status = Unmap(rsgp, lba, unmap_blocks);
+	if (status != SUCCESS) break;
+	if (lsp) {
+	    record_latency(lsp, iop->cmd_latency, 0);
+	}
+	iop->sparse_unmapped_blocks += unmap_blocks;
+	lba += unmap_blocks;
+	blocks -= unmap_blocks;
+    }
+    free(rsgp);
+    return(status);
 }
 
-int
-random_rw_process_cdb(scsi_device_t *sdp, io_params_t *iop, uint64_t max_lba, uint64_t max_blocks)
+/*
+ * sparse_process_extents() - Skip deallocated extents for copy/verify.
+ *
+ * Description:
+ *	This is called after the I/O parameters for the next request are
+ * setup, and either clips the source data length to the current mapped
+ * extent, or skips deallocated extents on both devices.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE / END_OF_DATA
+ */
+static int
+sparse_process_extents(scsi_device_t *sdp)
 {
+    io_params_t *iop = &sdp->io_params[IO_INDEX_DSF];
     scsi_generic_t *sgp = &iop->sg;
+    io_params_t *miop = &sdp->io_params[IO_INDEX_DSF1];
+    lba_extent_t src_extent, dst_extent;
+    uint64_t data_blocks, blocks;
     int status = SUCCESS;
 
-    /*
-     * If this is a write request, test mode, a single device, and read
-     * after write is enabled, then read and verify the last data written.
-     * Note: All read and write requests come through this code flow!
-     */
-    if ( (iop->first_time == False) && (sdp->iomode == IOMODE_TEST) &&
-	 (sgp->data_dir == scsi_data_write) && (sdp->io_devices == 1) &&
-	 (sdp->status == SUCCESS) && (sdp->read_after_write == True) ) {
-	status = random_rw_ReadVerifyData(sdp, iop, sgp, iop->current_lba, sgp->data_transferred);
-	if (status != SUCCESS) return(status);
+    /* Deallocated blocks must read as zeroes, for skipping to be safe! */
+    if ( (iop->lbpme_flag == False) || (iop->lbprz_flag == False) ||
+	 (sdp->iomode == IOMODE_MIRROR) || iop->cdb_blocks || iop->step_value ) {
+	if (sdp->verbose && (sdp->thread_number == 1) ) {
+	    Wprintf(sdp, "%s: Source is NOT thin provisioned with LBPRZ (or unsupported mode), disabling sparse!\n",
+		    sgp->dsf);
+	}
+	sdp->sparse_flag = False;
+	return(SUCCESS);
     }
-
-    if (iop->first_time) {
-	status = initialize_io_parameters(sdp, iop, max_lba, max_blocks);
-	if (status != SUCCESS) return (status);
-	if ( (sdp->iomode != IOMODE_TEST) && (sdp->io_devices > 1) ) {
-	    io_params_t *miop = &sdp->io_params[IO_INDEX_DSF1];
-	    //status = initialize_multiple_devices(sdp);
-	    //if (status != SUCCESS) return(status);
-	    status = initialize_io_parameters(sdp, miop, max_lba, max_blocks);
+    for (;;) {
+	data_blocks = (iop->block_limit - iop->block_count);
+	if ( (miop->block_limit - miop->block_count) < data_blocks ) {
+	    data_blocks = (miop->block_limit - miop->block_count);
 	}
-    } else {
-	if ( (sdp->iomode != IOMODE_TEST) && (sdp->io_devices > 1) ) {
-	    status = random_rw_process_data(sdp);
+	/* Restore the data length, since extents clip the length. */
+	blocks = min(data_blocks, (iop->saved_data_length / iop->device_size));
+	sgp->data_length = (uint32_t)(blocks * iop->device_size);
+
+	status = sparse_get_extent(sdp, iop, iop->current_lba, &src_extent);
+	if (status != SUCCESS) {
+	    Wprintf(sdp, "%s: Get LBA Status failed, disabling sparse %s!\n",
+		    sgp->dsf, (sdp->iomode == IOMODE_COPY) ? "copy" : "verify");
+	    sdp->sparse_flag = False;
+	    status = SUCCESS;
+	    break;
+	}
+	if ( SPARSE_READS_ZEROES(src_extent.provisioning_status) == False ) {
+	    if (src_extent.extent_length < blocks) {
+		sgp->data_length = (uint32_t)(src_extent.extent_length * iop->device_size);
+	    }
+	    break;
+	}
+	/* Deallocated or anchored, both read as zeroes. */
+	blocks = min(data_blocks, src_extent.extent_length);
+	if ( (miop->lbpme_flag == False) || (miop->lbprz_flag == False) ) {
+	    /* The destination cannot be trusted to return zeroes, so transfer them. */
+	    break;
+	}
+	if (sdp->iomode == IOMODE_COPY) {
+	    status = sparse_unmap_blocks(sdp, miop, miop->current_lba, blocks, NULL);
 	    if (status != SUCCESS) return(status);
-	    status = random_rw_complete_io(sdp, max_lba, max_blocks);
 	} else {
-	    status = initialize_io_parameters(sdp, iop, max_lba, max_blocks);
+	    status = sparse_get_extent(sdp, miop, miop->current_lba, &dst_extent);
+	    if (status != SUCCESS) return(status);
+	    if ( SPARSE_READS_ZEROES(dst_extent.provisioning_status) == False ) {
+		/* Verify the destination range reads zeroes. */
+		if (dst_extent.extent_length < (sgp->data_length / iop->device_size)) {
+		    sgp->data_length = (uint32_t)(dst_extent.extent_length * iop->device_size);
+		}
+		break;
+	    }
+	    blocks = min(blocks, dst_extent.extent_length);
+	}
+	if (sdp->xDebugFlag) {
+	    Printf(sdp, "Skipping " LUF " deallocated blocks, lba's " LUF " - " LUF " on %s\n",
+		   blocks, iop->current_lba, (iop->current_lba + blocks - 1), sgp->dsf);
+	}
+	iop->sparse_skipped_blocks += blocks;
+	iop->block_count += blocks;
+	iop->current_lba += blocks;
+	miop->block_count += blocks;
+	miop->current_lba += blocks;
+	if ( (iop->block_count >= iop->block_limit) ||
+	     (miop->block_count >= miop->block_limit) ) {
+	    (void)process_end_of_data(sdp, miop, &miop->sg);
+	    return( process_end_of_data(sdp, iop, sgp) );
 	}
     }
-    if (status == END_OF_DATA) {
-	restore_saved_parameters(sdp);
-	iop->end_of_data = True;
+    /* The source LBA has moved, so regenerate the expected IOT data. */
+    if ( sdp->iot_pattern && (sdp->compare_data == True) && sdp->pattern_buffer ) {
+	(void)init_iotdata(sdp, iop, sdp->pattern_buffer, sgp->data_length, (uint32_t)iop->current_lba, sdp->iot_seed);
+    } else if ( sdp->dr_pattern && (sdp->compare_data == True) && sdp->pattern_buffer ) {
+	(void)init_drdata(sdp, iop, sdp->pattern_buffer, sgp->data_length, iop->current_lba, sdp->dr_seed);
     }
     return(status);
 }
-    
-int
-random_rw_ReadVerifyData(
-    scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp,
-    uint64_t lba, uint32_t bytes)
+
+static void
+sparse_report_totals(scsi_device_t *sdp)
 {
-    uint8_t *verify_buffer = (uint8_t *)sgp->data_buffer;
-    scsi_generic_t *rsgp = Malloc(sdp, sizeof(*sgp));
-    uint32_t blocks = howmany(bytes, iop->device_size);
-    int status = SUCCESS;
+    io_params_t *iop = &sdp->io_params[IO_INDEX_DSF];
+    io_params_t *miop = &sdp->io_params[IO_INDEX_DSF1];
 
-    if (rsgp == NULL) return(FAILURE);
-    /*
-     * Duplicate the SCSI generic, to keep sane (CDB, SCSI name, etc).
-     */ 
-    *rsgp = *sgp;
-    rsgp->data_buffer = malloc_palign(sdp, bytes, 0);
-    if (rsgp->data_buffer == NULL) {
-	free(rsgp);
-	return(FAILURE);
+    PrintHeader(sdp, (sdp->iomode == IOMODE_COPY) ? "Sparse Copy Information" : "Sparse Verify Information");
+    PrintLongDec(sdp, "Source Blocks Transferred", (iop->block_limit - iop->sparse_skipped_blocks), PNL);
+    PrintLongDec(sdp, "Deallocated Blocks Skipped", iop->sparse_skipped_blocks, PNL);
+    if (sdp->iomode == IOMODE_COPY) {
+	PrintLongDec(sdp, "Destination Blocks Unmapped", miop->sparse_unmapped_blocks, PNL);
     }
-    status = scsiReadData(iop, sdp->scsi_read_type, rsgp, lba, blocks, bytes);
-    if ( (status == SUCCESS) && (sdp->compare_data == True) ) {
-	status = VerifyBuffers(sdp, rsgp->data_buffer,
-			       verify_buffer, rsgp->data_transferred);
-	if (status == FAILURE) {
-	    if (sdp->iot_pattern) {
-		process_iot_data(sdp, iop, verify_buffer,
-				 rsgp->data_buffer, rsgp->data_transferred);
-	    }
+    Printf(sdp, "\n");
+    return;
+}
+
+/* ======================================================================== */
+
+/*
+ * Thin Provisioning First Write Benchmark:
+ *
+ * On thin provisioned LUNs, the first write to a deallocated extent must
+ * also allocate backing storage, so is often slower than an overwrite. Each
+ * write is classified (via Get LBA Status) and clipped at the extent boundary,
+ * so the latency is recorded for a single class. After the write pass, the
+ * range is unmapped and rewritten, to show the latency after unmap.
+ */
+static char *thin_write_headers[THIN_WRITE_CLASSES] = {
+    "Fresh Allocation Writes",
+    "Overwrite Writes",
+    "Unknown Status Writes",
+    "Writes After Unmap",
+    "Unmap Commands"
+};
+
+static int
+thin_write_setup(scsi_device_t *sdp, io_params_t *iop)
+{
+    scsi_generic_t *sgp = &iop->sg;
+    int wclass;
+
+    if (iop->lbpmgmt_valid && (iop->provisioning_type == PROVISIONING_TYPE_FULL) ) {
+	inquiry_logical_block_provisioning_t block_provisioning;
+	if (GetLogicalBlockProvisioning(sgp->fd, sgp->dsf, sgp->debug, False,
+					&block_provisioning, sgp->tsp) == SUCCESS) {
+	    iop->provisioning_type = block_provisioning.provisioning_type;
 	}
     }
-    free_palign(sdp, rsgp->data_buffer);
-    free(rsgp);
-    return (status);
+    if ( (iop->lbpme_flag == False) || iop->cdb_blocks || iop->step_value ) {
+	if (sdp->thread_number == 1) {
+	    Wprintf(sdp, "%s: Device is NOT thin provisioned (or unsupported CDB), disabling first write benchmark!\n",
+		    sgp->dsf);
+	}
+	sdp->first_write_flag = False;
+	return(SUCCESS);
+    }
+    if (iop->thin_write_stats == NULL) {
+	iop->thin_write_stats = Malloc(sdp, (sizeof(latency_stats_t) * THIN_WRITE_CLASSES));
+	if (iop->thin_write_stats == NULL) return(FAILURE);
+    } else {
+	for (wclass = 0; (wclass < THIN_WRITE_CLASSES); wclass++) {
+	    init_latency_stats(&iop->thin_write_stats[wclass]);
+	}
+    }
+    iop->sparse_extent_count = 0;
+    iop->thin_write_unmapped = False;
+    return(SUCCESS);
 }
 
-int
-random_rw_process_data(scsi_device_t *sdp)
+static int
+thin_write_classify(scsi_device_t *sdp, io_params_t *iop)
 {
-    io_params_t *iop = &sdp->io_params[IO_INDEX_DSF];
     scsi_generic_t *sgp = &iop->sg;
-    io_params_t *miop = &sdp->io_params[IO_INDEX_DSF1];
-    scsi_generic_t *msgp = &miop->sg;
-    uint32_t blocks;
-    size_t bytes;
-    uint64_t src_starting_lba, dst_starting_lba;
-    int status;
-    
-    bytes = sgp->data_transferred;
-    blocks = howmany(sgp->data_transferred, iop->device_size);
-    if ( (miop->block_count + blocks) > miop->block_limit ) {
-	blocks = (uint32_t)(miop->block_limit - miop->block_count);
-	bytes = (blocks * miop->device_size);
+    lba_extent_t extent;
+    uint64_t blocks;
+
+    /* Restore the data length, since extents clip the length. */
+    blocks = min((iop->block_limit - iop->block_count), (iop->saved_data_length / iop->device_size));
+    sgp->data_length = (uint32_t)(blocks * iop->device_size);
+    if (iop->thin_write_unmapped == True) {
+	iop->thin_write_class = THIN_WRITE_AFTER_UNMAP;
+    } else {
+	if (sparse_get_extent(sdp, iop, iop->current_lba, &extent) != SUCCESS) {
+	    Wprintf(sdp, "%s: Get LBA Status failed, disabling first write benchmark!\n", sgp->dsf);
+	    sdp->first_write_flag = False;
+	    return(SUCCESS);
+	}
+	if (extent.provisioning_status == SCSI_PROV_STATUS_MAPPED) {
+	    iop->thin_write_class = THIN_WRITE_OVERWRITE;
+	} else if (SPARSE_READS_ZEROES(extent.provisioning_status)) {
+	    iop->thin_write_class = THIN_WRITE_FRESH;
+	} else { /* Mapped or unknown, or unknown. */
+	    iop->thin_write_class = THIN_WRITE_UNKNOWN;
+	}
+	if (extent.extent_length < blocks) {
+	    sgp->data_length = (uint32_t)(extent.extent_length * iop->device_size);
+	}
     }
-    src_starting_lba = iop->current_lba;
-    dst_starting_lba = miop->current_lba;
-    if (sdp->xDebugFlag) {
-	Printf(sdp, "Starting %s:\n", (sdp->iomode == IOMODE_COPY) ? "Copy" : "Verify");
-	PrintDecHex(sdp, "Number of Blocks", blocks, PNL);
-	PrintLongDecHex(sdp, "Source Block Device LBA", src_starting_lba, DNL);
-	Print(sdp, " (lba's " LUF " - " LUF ")\n", src_starting_lba, (src_starting_lba + blocks - 1));
-	PrintLongDecHex(sdp, "Destination Block Device LBA", dst_starting_lba, DNL);
-	Print(sdp, " (lba's " LUF " - " LUF ")\n", dst_starting_lba, (dst_starting_lba + blocks - 1));
-	Printf(sdp, "\n");
+    if (sdp->iot_pattern) {
+	(void)init_iotdata(sdp, iop, sgp->data_buffer, sgp->data_length, (uint32_t)iop->current_lba, sdp->iot_seed_per_pass);
+    } else if (sdp->dr_pattern) {
+	(void)init_drdata(sdp, iop, sgp->data_buffer, sgp->data_length, iop->current_lba, sdp->dr_seed);
+    } else if (sdp->rnd_pattern) {
+	(void)init_rnddata(sdp, iop, sgp->data_buffer, sgp->data_length, iop->current_lba,
+			   sdp->rnd_seed, sdp->rnd_pass);
     }
+    return(SUCCESS);
+}
 
-    if (sdp->iomode == IOMODE_COPY) {
-	void *saved_buffer = msgp->data_buffer;
-	msgp->data_buffer = sgp->data_buffer;
-	status = scsiWriteData(miop, sdp->scsi_write_type, msgp, dst_starting_lba, blocks, (uint32_t)bytes);
-	msgp->data_buffer = saved_buffer;
-	if ( (status == SUCCESS) && (sdp->compare_data) ) {
-	    msgp->data_dir = scsi_data_read;
-	    status = scsiReadData(miop, sdp->scsi_read_type, msgp, dst_starting_lba, blocks, (uint32_t)bytes);
-	    if (status != SUCCESS) return(status);
-	    status = extended_copy_verify_buffers(sdp, msgp, sgp,
-						  blocks, src_starting_lba, dst_starting_lba,
-						  msgp->data_buffer, sgp->data_buffer, (uint32_t)bytes);
-	    msgp->data_dir = scsi_data_write;
+void
+thin_write_complete(scsi_device_t *sdp, io_params_t *iop)
+{
+    scsi_generic_t *sgp = &iop->sg;
+
+    if ( (iop->thin_write_stats == NULL) || (sgp->data_dir != scsi_data_write) ) {
+	return;
+    }
+    record_latency(&iop->thin_write_stats[iop->thin_write_class],
+		   iop->cmd_latency, (uint64_t)sgp->data_transferred);
+    /*
+     * The blocks written are now mapped, so remove them from the cached
+     * extent, so rewrites of this range (next pass) are classified again.
+     */
+    if (iop->thin_write_class != THIN_WRITE_OVERWRITE) {
+	lba_extent_t *lep;
+	uint64_t lba = iop->current_lba;
+	uint64_t blocks = iop->blocks_transferred;
+	uint32_t entry;
+
+	for (entry = 0; (entry < iop->sparse_extent_count); entry++) {
+	    lep = &iop->sparse_extents[entry];
+	    if ( (lba >= lep->starting_lba) &&
+		 (lba < (lep->starting_lba + lep->extent_length)) ) {
+		if ( (lba == lep->starting_lba) && (blocks < lep->extent_length) ) {
+		    lep->starting_lba += blocks;
+		    lep->extent_length -= blocks;
+		} else {
+		    lep->extent_length = (lba - lep->starting_lba);
+		}
+		break;
+	    }
 	}
-    } else { /* Mirror or Verify modes. */
-	status = scsiReadData(miop, sdp->scsi_read_type, msgp, dst_starting_lba, blocks, (uint32_t)bytes);
-	if (status != SUCCESS) return(status);
-	status = extended_copy_verify_buffers(sdp, msgp, sgp,
-					      blocks, src_starting_lba, dst_starting_lba,
-					      msgp->data_buffer, sgp->data_buffer, bytes);
+    }
+    return;
+}
+
+/*
+ * thin_write_end_of_pass() - Handle end of data for first write benchmark.
+ *
+ * Description:
+ *	After the initial write pass, the range written is unmapped, and
+ * the I/O parameters are reinitialized to rewrite the same range. After
+ * the rewrite pass, the results for all classes are reported.
+ *
+ * Return Value:
+ *	SUCCESS (rewriting) / FAILURE / END_OF_DATA
+ */
+static int
+thin_write_end_of_pass(scsi_device_t *sdp, io_params_t *iop, uint64_t max_lba, uint64_t max_blocks)
+{
+    int status;
+
+    if (iop->thin_write_unmapped == True) {
+	thin_write_report(sdp, iop);
+	iop->thin_write_unmapped = False;
+	return(END_OF_DATA);
+    }
+    /* Note: The starting LBA and block limit were restored at end of data. */
+    status = sparse_unmap_blocks(sdp, iop, iop->starting_lba, iop->block_limit,
+				 &iop->thin_write_stats[THIN_WRITE_UNMAP]);
+    if (status != SUCCESS) return(status);
+    iop->sparse_extent_count = 0;	/* The cached extents are stale. */
+    iop->thin_write_unmapped = True;
+    restore_saved_parameters(sdp);
+    status = initialize_io_parameters(sdp, iop, max_lba, max_blocks);
+    if (status == SUCCESS) {
+	status = thin_write_classify(sdp, iop);
     }
     return(status);
 }
 
+static void
+thin_write_report(scsi_device_t *sdp, io_params_t *iop)
+{
+    scsi_generic_t *sgp = &iop->sg;
+    latency_stats_t *fresh = &iop->thin_write_stats[THIN_WRITE_FRESH];
+    latency_stats_t *overwrite = &iop->thin_write_stats[THIN_WRITE_OVERWRITE];
+    char *provisioning_type;
+    char buffer[SMALL_BUFFER_SIZE];
+    int wclass;
+
+    switch (iop->provisioning_type) {
+	case PROVISIONING_TYPE_IS_THIN_PROVISIONED:
+	    provisioning_type = "Thin Provisioned";
+	    break;
+	case PROVISIONING_TYPE_RESOURCE_PROVISIONED:
+	    provisioning_type = "Resource Provisioned";
+	    break;
+	default:
+	    provisioning_type = "Not Reported";
+	    break;
+    }
+    PrintHeader(sdp, "Thin Provisioning Write Information");
+    PrintAscii(sdp, "Device Name", sgp->dsf, PNL);
+    PrintAscii(sdp, "Provisioning Type", provisioning_type, PNL);
+    PrintAscii(sdp, "Unmapped Reads Zeroes", (iop->lbprz_flag) ? "Yes" : "No", PNL);
+    PrintLongDec(sdp, "Starting LBA", iop->starting_lba, PNL);
+    PrintLongDec(sdp, "Number of Blocks", iop->block_limit, PNL);
+    if (fresh->ls_count && overwrite->ls_count) {
+	(void)sprintf(buffer, "%.2f",
+		      ((double)fresh->ls_total_usecs / (double)fresh->ls_count) /
+		      ((double)overwrite->ls_total_usecs / (double)overwrite->ls_count));
+	PrintAscii(sdp, "First Write Penalty (avg)", buffer, PNL);
+    }
+    Printf(sdp, "\n");
+    for (wclass = 0; (wclass < THIN_WRITE_CLASSES); wclass++) {
+	/* Only report unknown status writes, when the device reported some. */
+	if ( (wclass == THIN_WRITE_UNKNOWN) && (iop->thin_write_stats[wclass].ls_count == 0) ) {
+	    continue;
+	}
+	report_latency_stats(sdp, thin_write_headers[wclass], &iop->thin_write_stats[wclass]);
+    }
+    return;
+}
+
 int
 scsiReadData(io_params_t *iop, scsi_io_type_t read_type, scsi_generic_t *sgp, uint64_t lba, uint32_t blocks, uint32_t bytes)
 {
@@ -2317,6 +3712,8 @@ extended_copy_init_devices(scsi_device_t *sdp)
 	    if (sgp->data_buffer == NULL) return(FAILURE);
 	}
 	sdp->iot_pattern = False;
+	sdp->dr_pattern = False;
+	sdp->rnd_pattern = False;
 	sdp->user_pattern = False;
 	iop->scale_count = sdp->segment_count;
 
@@ -2673,7 +4070,7 @@ extended_copy_verify_data(scsi_device_t *sdp)
     }
     segdp = (xcopy_b2b_seg_desc_t *)(tgtdp + num_targets);
     for (segment = 0; segment < num_segments; segment++, segdp++) {
-	if (CmdInterruptedFlag) break;
+	if (CmdInterrupted(sdp)) break;
 	src_index = (int)StoH(segdp->src_cscd_desc_idx);
 	dst_index = (int)StoH(segdp->dst_cscd_desc_idx);
 	blocks = (uint16_t)StoH(segdp->block_device_num_of_blocks);
@@ -2744,7 +4141,7 @@ extended_copy_read_and_compare(scsi_device_t *sdp,
      * Verify the source and destination blocks.
      */ 
     for (blocks = 0, current_blocks = 0; (current_blocks < xcopy_blocks); ) {
-	if (CmdInterruptedFlag) break;
+	if (CmdInterrupted(sdp)) break;
 	blocks = min(read_blocks, (xcopy_blocks - current_blocks));
 	bytes = (blocks * iop->device_size);
 	/* Read the source blocks. */
@@ -3081,6 +4478,8 @@ populate_token_init_devices(scsi_device_t *sdp)
 	    if (sgp->data_buffer == NULL) return(FAILURE);
 	}
 	sdp->iot_pattern = False;
+	sdp->dr_pattern = False;
+	sdp->rnd_pattern = False;
 	/* 
 	 * Unlike non-token based xcopy, we always transfer the max blocks,
 	 * then breakup this max into the ranges specified.
@@ -4037,6 +5436,39 @@ setup_write16(scsi_device_t *sdp, scsi_generic_t *sgp)
 
 /* ======================================================================== */
 
+static void
+setup_rw32(scsi_device_t *sdp, scsi_generic_t *sgp, uint16_t service_action)
+{
+    DirectRW32_CDB_t *cdb = (DirectRW32_CDB_t *)sgp->cdb;
+
+    memset(sgp->cdb, '\0', sizeof(sgp->cdb));
+    cdb->opcode = SOPC_VARIABLE_LENGTH;
+    cdb->additional_length = (SOPC_VARIABLE_LENGTH_CDB_SIZE - 8);
+    HtoS(cdb->service_action, service_action);
+    sdp->op_type = SCSI_CDB_OP;
+    sdp->encode_flag = True;
+    sgp->cdb_size = GetCdbLength(sgp->cdb[0]);
+    return;
+}
+
+int
+setup_read32(scsi_device_t *sdp, scsi_generic_t *sgp)
+{
+    setup_rw32(sdp, sgp, SVA_READ_32);
+    sgp->data_dir = scsi_data_read;
+    return(SUCCESS);
+}
+
+int
+setup_write32(scsi_device_t *sdp, scsi_generic_t *sgp)
+{
+    setup_rw32(sdp, sgp, SVA_WRITE_32);
+    sgp->data_dir = scsi_data_write;
+    return(SUCCESS);
+}
+
+/* ======================================================================== */
+
 int
 setup_verify10(scsi_device_t *sdp, scsi_generic_t *sgp)
 {
@@ -4227,6 +5659,10 @@ static scsi_opcode_t scsiOpcodeTable[] = {
     {	SOPC_RECEIVE_ROD_TOKEN_INFO,RECEIVE_ROD_TOKEN_INFORMATION,
 					  ALL_RANDOM_DEVICES, "Receive ROD Token Information",
 	scsi_data_read, NULL, receive_rod_token_decode					},
+    {	SOPC_VARIABLE_LENGTH,	    SVA_READ_32, ALL_RANDOM_DEVICES, "Read(32)",
+	scsi_data_read, random_rw32_encode, NULL					},
+    {	SOPC_VARIABLE_LENGTH,	    SVA_WRITE_32, ALL_RANDOM_DEVICES, "Write(32)",
+	scsi_data_write, random_rw32_encode, NULL					},
     {	SOPC_READ_16,		    0x00, ALL_RANDOM_DEVICES, "Read(16)",
 	scsi_data_read, random_rw16_encode, NULL					},
     {	SOPC_WRITE_16,		    0x00, ALL_RANDOM_DEVICES, "Write(16)",
@@ -4479,6 +5915,11 @@ ScsiOpcodeEntry(unsigned char *cdb, unsigned short device_type)
 	    check_subcode = True;
 	    break;
 
+	case SOPC_VARIABLE_LENGTH:
+	    subcode = cdb[9];		/* Low byte of service action. */
+	    check_subcode = True;
+	    break;
+
 	default:
 	    break;
     }
@@ -278,6 +278,14 @@ typedef enum {
 #define SOPC_SERVICE_ACTION_IN_16		0x9E
 #define SOPC_COMPARE_AND_WRITE			0x89
 
+/*
+ * 32-byte (Variable Length) Opcodes:
+ */
+#define SOPC_VARIABLE_LENGTH			0x7F
+#define SOPC_VARIABLE_LENGTH_CDB_SIZE		32
+#define SVA_READ_32				0x0009
+#define SVA_WRITE_32				0x000B
+
 typedef enum {
     SCSI_SERVICE_ACTION_RECEIVE_COPY_RESULTS    = 0x03,
     SCSI_SERVICE_ACTION_READ_CAPACITY_16        = 0x10,
@@ -32,6 +32,25 @@
  *
  * Modification History:
  * 
+ * October 18th, 2026 by Robin T. Miller
+ *      The discovery timeout is now a deadline for all commands to each
+ * device, and the users' timeout= is honored when specified.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add a persistent device inventory cache for show devices. Entries
+ * are revalidated by SCSI nexus, sysfs device inode, and time to live,
+ * so only new or changed devices are queried with SCSI commands.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add sysfs device discovery, which builds the SCSI device table from
+ * the Inquiry and VPD pages saved by the kernel, and only issues SCSI
+ * commands when a sysfs attribute is missing.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Issue the find_scsi_devices() SCSI commands from a bounded pool of
+ * threads, with a short per device timeout, then merge the results into
+ * the SCSI device table in directory order, so the output is unchanged.
+ * 
  * January 5th, 2021 by Robin T. Miller
  *      Remove extra DecodeTargetPortIdentifier() in find_scsi_devices(),
  * left over by accident, after refactoring code.
@@ -140,7 +159,11 @@ static void DumpScsiCmd(scsi_generic_t *sgp, sg_io_hdr_t *siop);
 static int force_path_failover(scsi_generic_t *sgp);
 
 static int get_device_nexus(scsi_generic_t *sgp, char *devname, int fd, int *bus, int *channel, int *target, int *lun);
-static int find_scsi_devices(scsi_generic_t *sgp, char *devpath, char *scsi_name, scsi_filters_t *sfp);
+struct discovery_cache;
+static int find_scsi_devices(scsi_generic_t *sgp, char *devpath, char *scsi_name,
+			     scsi_filters_t *sfp, struct discovery_cache *dcp);
+static struct discovery_cache *open_discovery_cache(scsi_generic_t *sgp, scsi_filters_t *sfp);
+static void close_discovery_cache(scsi_generic_t *sgp, struct discovery_cache *dcp);
 static scsi_device_name_t *find_device_by_nexus(scsi_generic_t *sgp, scsi_device_entry_t *sdep,
 						char *path, int bus, int channel, int target, int lun);
 static hbool_t omit_device_name(scsi_generic_t *sgp, char *name);
@@ -1237,9 +1260,12 @@ int
 os_find_scsi_devices(scsi_generic_t *sgp, scsi_filters_t *sfp, char *paths)
 {
     void *opaque = sgp->tsp->opaque;
+    struct discovery_cache *dcp;
     scsi_dir_path_t *sdp;
     int status;
 
+    dcp = open_discovery_cache(sgp, sfp);
+
     /* Allow user to overide our default directory/device name list. */
     if (paths) {
 	char *path, *sep, *str;
@@ -1258,7 +1284,7 @@ os_find_scsi_devices(scsi_generic_t *sgp, scsi_filters_t *sfp, char *paths)
 		dev_name = NULL;	/* Wildcard '*' says use all device names! */
 	    }
 	    if (dir_path) {
-		status = find_scsi_devices(sgp, dir_path, dev_name, sfp);
+		status = find_scsi_devices(sgp, dir_path, dev_name, sfp, dcp);
 	    }
 	    Free(opaque, dirp);
 	    Free(opaque, basep);
@@ -1270,9 +1296,12 @@ os_find_scsi_devices(scsi_generic_t *sgp, scsi_filters_t *sfp, char *paths)
 	    if ( (sfp->all_device_paths == False) && (sdp->default_scan == False) ) {
 		continue;
 	    }
-	    status = find_scsi_devices(sgp, sdp->sdp_dir_path, sdp->sdp_dev_name, sfp);
+	    status = find_scsi_devices(sgp, sdp->sdp_dir_path, sdp->sdp_dev_name, sfp, dcp);
 	}
     }
+    if (dcp) {
+	close_discovery_cache(sgp, dcp);
+    }
     if (sfp && sfp->exclude_paths) {
 	FreeScsiExcludeTable(sgp);
     }
@@ -1342,23 +1371,897 @@ get_device_nexus(scsi_generic_t *sgp, char *devpath, int fd, int *bus, int *chan
     return(status);
 }
 
+/*
+ * Parallel Device Discovery:
+ *
+ *	Devices are opened and filtered by path serially, in directory order,
+ * then the SCSI commands (Inquiry, serial number, device ID, and firmware)
+ * are issued by a bounded pool of threads, with a short per device timeout,
+ * so one hung device no longer stalls discovery. Results are merged into the
+ * SCSI device table in the original order, so the output is unchanged.
+ */
+#define DISCOVERY_BATCH_SIZE	128	/* Devices opened per batch.	*/
+
+/*
+ * Device Inventory Cache:
+ *
+ *	The device information is saved to a cache file, so later discovery
+ * can avoid issuing SCSI commands. Each cache entry is only used when the
+ * SCSI nexus and the sysfs device inode are unchanged, and the entry is
+ * younger than the time to live (TTL). New or changed devices are queried.
+ *
+ * File Format: (one line per device path, fields separated by tabs)
+ *	path nexus inode time device-page inquiry serial device-id target-port fw-version
+ */
+#define CACHE_FILE_HEADER	"# spt device inventory cache, version 1"
+#define CACHE_LINE_SIZE		(MAX_INQ_LEN * 8)
+#define CACHE_SEP		"\t"
+
+typedef struct cache_entry {
+    struct cache_entry *ce_flink;	/* Forward link to next entry.	*/
+    char	*ce_path;		/* The device path.		*/
+    int		ce_bus;			/* The SCSI bus (host).		*/
+    int		ce_channel;		/* The SCSI channel.		*/
+    int		ce_target;		/* The SCSI target.		*/
+    int		ce_lun;			/* The SCSI LUN.		*/
+    ino_t	ce_sysfs_inode;		/* The sysfs device inode.	*/
+    time_t	ce_time;		/* The time device was queried.	*/
+    hbool_t	ce_device_page;		/* Device ID page supported.	*/
+    inquiry_t	ce_inquiry;		/* The standard Inquiry data.	*/
+    char	*ce_serial;		/* The serial number.		*/
+    char	*ce_device_id;		/* The device ID (WWN).		*/
+    char	*ce_target_port;	/* The target port.		*/
+    char	*ce_fw_version;		/* The firmware version.	*/
+} cache_entry_t;
+
+typedef struct discovery_cache {
+    cache_entry_t	*dc_entries;	/* The cache entries.		*/
+    char		*dc_file;	/* The cache file name.		*/
+    time_t		dc_ttl;		/* The time to live (secs).	*/
+    time_t		dc_now;		/* The discovery start time.	*/
+    hbool_t		dc_refresh;	/* Ignore the cache entries.	*/
+    hbool_t		dc_modified;	/* Cache entries were updated.	*/
+} discovery_cache_t;
+
+static void
+free_cache_entry(void *opaque, cache_entry_t *cep)
+{
+    if (cep->ce_path) Free(opaque, cep->ce_path);
+    if (cep->ce_serial) Free(opaque, cep->ce_serial);
+    if (cep->ce_device_id) Free(opaque, cep->ce_device_id);
+    if (cep->ce_target_port) Free(opaque, cep->ce_target_port);
+    if (cep->ce_fw_version) Free(opaque, cep->ce_fw_version);
+    Free(opaque, cep);
+    return;
+}
+
+/*
+ * Cache strings are written as is, so omit those with our separators.
+ */
+static hbool_t
+valid_cache_string(char *str)
+{
+    return( (str == NULL) || (strpbrk(str, CACHE_SEP "\n") == NULL) );
+}
+
+static char *
+cache_string(char *field)
+{
+    return( (field && *field) ? strdup(field) : NULL );
+}
+
+/*
+ * load_discovery_cache() - Load the device inventory cache file.
+ *
+ * Note: A missing or invalid cache file is not an error, since we simply
+ * query the devices and create a new cache file.
+ */
+static void
+load_discovery_cache(scsi_generic_t *sgp, discovery_cache_t *dcp)
+{
+    void *opaque = sgp->tsp->opaque;
+    cache_entry_t *cep, **cepp = &dcp->dc_entries;
+    char *fields[10];
+    char *line, *str, *p;
+    int field, count, entries = 0;
+    FILE *fp;
+
+    fp = fopen(dcp->dc_file, "r");
+    if (fp == NULL) {
+	if ( (errno != ENOENT) && sgp->debug ) {
+	    Perror(opaque, "Failed to open cache file %s", dcp->dc_file);
+	}
+	return;
+    }
+    line = Malloc(opaque, CACHE_LINE_SIZE);
+    if (line == NULL) {
+	(void)fclose(fp);
+	return;
+    }
+    if ( (fgets(line, CACHE_LINE_SIZE, fp) == NULL) ||
+	 (strncmp(line, CACHE_FILE_HEADER, strlen(CACHE_FILE_HEADER)) != 0) ) {
+	if (sgp->debug == True) {
+	    Printf(opaque, "Ignoring invalid cache file %s\n", dcp->dc_file);
+	}
+	goto done;
+    }
+    while (fgets(line, CACHE_LINE_SIZE, fp) != NULL) {
+	if ( (p = strchr(line, '\n')) ) *p = '\0';
+	str = line;
+	for (field = 0; (field < 10); field++) {
+	    fields[field] = strsep(&str, CACHE_SEP);
+	    if (fields[field] == NULL) break;
+	}
+	if (field != 10) continue;	/* Skip malformed entries. */
+	cep = Malloc(opaque, sizeof(*cep));
+	if (cep == NULL) break;
+	count = sscanf(fields[1], "%d:%d:%d:%d",
+		       &cep->ce_bus, &cep->ce_channel, &cep->ce_target, &cep->ce_lun);
+	if ( (count != 4) ||
+	     (strlen(fields[5]) != (sizeof(cep->ce_inquiry) * 2)) ) {
+	    Free(opaque, cep);
+	    continue;
+	}
+	cep->ce_path = strdup(fields[0]);
+	cep->ce_sysfs_inode = (ino_t)strtoull(fields[2], NULL, 10);
+	cep->ce_time = (time_t)strtoll(fields[3], NULL, 10);
+	cep->ce_device_page = (*fields[4] == '1') ? True : False;
+	for (count = 0, p = fields[5]; (count < (int)sizeof(cep->ce_inquiry)); count++, p += 2) {
+	    unsigned int byte;
+	    (void)sscanf(p, "%2x", &byte);
+	    ((uint8_t *)&cep->ce_inquiry)[count] = (uint8_t)byte;
+	}
+	cep->ce_serial = cache_string(fields[6]);
+	cep->ce_device_id = cache_string(fields[7]);
+	cep->ce_target_port = cache_string(fields[8]);
+	cep->ce_fw_version = cache_string(fields[9]);
+	*cepp = cep;
+	cepp = &cep->ce_flink;
+	entries++;
+    }
+    if (sgp->debug == True) {
+	Printf(opaque, "Loaded %d entries from cache file %s\n", entries, dcp->dc_file);
+    }
+done:
+    Free(opaque, line);
+    (void)fclose(fp);
+    return;
+}
+
+/*
+ * save_discovery_cache() - Save the device inventory cache file.
+ *
+ * Note: The cache is written to a unique temporary file (in the cache file
+ * directory), then renamed, so other spt processes never see a partially
+ * written cache file.
+ */
+static void
+save_discovery_cache(scsi_generic_t *sgp, discovery_cache_t *dcp)
+{
+    void *opaque = sgp->tsp->opaque;
+    char tmpfile[PATH_BUFFER_SIZE];
+    cache_entry_t *cep;
+    FILE *fp;
+    int count, fd;
+
+    /* Note: mkstemp() creates a unique file, so symlinks are not followed. */
+    (void)snprintf(tmpfile, sizeof(tmpfile), "%s.XXXXXX", dcp->dc_file);
+    fd = mkstemp(tmpfile);
+    if (fd == INVALID_HANDLE_VALUE) {
+	Perror(opaque, "Failed to create cache file %s", tmpfile);
+	return;
+    }
+    fp = fdopen(fd, "w");
+    if (fp == NULL) {
+	Perror(opaque, "Failed to open cache file %s", tmpfile);
+	(void)close(fd);
+	(void)unlink(tmpfile);
+	return;
+    }
+    fprintf(fp, "%s\n", CACHE_FILE_HEADER);
+    for (cep = dcp->dc_entries; cep; cep = cep->ce_flink) {
+	/* Expired entries are dropped, in case the device was removed. */
+	if ( (dcp->dc_now - cep->ce_time) >= dcp->dc_ttl ) continue;
+	fprintf(fp, "%s\t%d:%d:%d:%d\t%llu\t%lld\t%d\t", cep->ce_path,
+		cep->ce_bus, cep->ce_channel, cep->ce_target, cep->ce_lun,
+		(unsigned long long)cep->ce_sysfs_inode, (long long)cep->ce_time,
+		(cep->ce_device_page == True) ? 1 : 0);
+	for (count = 0; (count < (int)sizeof(cep->ce_inquiry)); count++) {
+	    fprintf(fp, "%02x", ((uint8_t *)&cep->ce_inquiry)[count]);
+	}
+	fprintf(fp, "\t%s\t%s\t%s\t%s\n",
+		(cep->ce_serial) ? cep->ce_serial : "",
+		(cep->ce_device_id) ? cep->ce_device_id : "",
+		(cep->ce_target_port) ? cep->ce_target_port : "",
+		(cep->ce_fw_version) ? cep->ce_fw_version : "");
+    }
+    if (fclose(fp) != SUCCESS) {
+	Perror(opaque, "Failed to write cache file %s", tmpfile);
+	(void)unlink(tmpfile);
+	return;
+    }
+    if (rename(tmpfile, dcp->dc_file) != SUCCESS) {
+	Perror(opaque, "Failed to rename %s to %s", tmpfile, dcp->dc_file);
+	(void)unlink(tmpfile);
+    }
+    return;
+}
+
+static void
+free_discovery_cache(scsi_generic_t *sgp, discovery_cache_t *dcp)
+{
+    void *opaque = sgp->tsp->opaque;
+    cache_entry_t *cep;
+
+    while ( (cep = dcp->dc_entries) ) {
+	dcp->dc_entries = cep->ce_flink;
+	free_cache_entry(opaque, cep);
+    }
+    return;
+}
+
+/*
+ * open_discovery_cache() - Open the device inventory cache (if enabled).
+ *
+ * Return Value:
+ *	Returns the discovery cache or NULL if caching is disabled.
+ */
+static discovery_cache_t *
+open_discovery_cache(scsi_generic_t *sgp, scsi_filters_t *sfp)
+{
+    void *opaque = sgp->tsp->opaque;
+    discovery_cache_t *dcp;
+
+    if ( (sfp == NULL) || (sfp->cache_file == NULL) ) return(NULL);
+    dcp = Malloc(opaque, sizeof(*dcp));
+    if (dcp == NULL) return(NULL);
+    dcp->dc_file = sfp->cache_file;
+    dcp->dc_ttl = (sfp->cache_ttl) ? (time_t)sfp->cache_ttl : DiscoveryCacheTTLDefault;
+    dcp->dc_now = time((time_t *)0);
+    dcp->dc_refresh = sfp->cache_refresh;
+    load_discovery_cache(sgp, dcp);
+    return(dcp);
+}
+
+static void
+close_discovery_cache(scsi_generic_t *sgp, discovery_cache_t *dcp)
+{
+    if ( (dcp->dc_modified == True) || (dcp->dc_refresh == True) ) {
+	save_discovery_cache(sgp, dcp);
+    }
+    free_discovery_cache(sgp, dcp);
+    Free(sgp->tsp->opaque, dcp);
+    return;
+}
+
+typedef struct discovery_entry {
+    char	*de_path;		/* The device path.		*/
+    int		de_fd;			/* The device file descriptor.	*/
+    int		de_bus;			/* The SCSI bus (host).		*/
+    int		de_channel;		/* The SCSI channel.		*/
+    int		de_target;		/* The SCSI target.		*/
+    int		de_lun;			/* The SCSI LUN.		*/
+    int		de_status;		/* The Inquiry status.		*/
+    hbool_t	de_selected;		/* Device passed the filters.	*/
+    inquiry_t	de_inquiry;		/* The standard Inquiry data.	*/
+    char	*de_serial;		/* The serial number.		*/
+    char	*de_device_id;		/* The device ID (WWN).		*/
+    char	*de_target_port;	/* The target port.		*/
+    char	*de_fw_version;		/* The firmware version.	*/
+    ino_t	de_sysfs_inode;		/* The sysfs device inode.	*/
+    hbool_t	de_device_page;		/* Device ID page supported.	*/
+    hbool_t	de_cached;		/* Information from the cache.	*/
+    hbool_t	de_complete;		/* All information acquired.	*/
+} discovery_entry_t;
+
+/*
+ * find_cache_entry() - Find a valid cache entry for this device.
+ *
+ * Return Value:
+ *	Returns the cache entry or NULL if not found, changed, or expired.
+ */
+static cache_entry_t *
+find_cache_entry(discovery_cache_t *dcp, discovery_entry_t *dep)
+{
+    cache_entry_t *cep;
+
+    if (dcp->dc_refresh == True) return(NULL);
+    for (cep = dcp->dc_entries; cep; cep = cep->ce_flink) {
+	if (strcmp(cep->ce_path, dep->de_path) == 0) {
+	    break;
+	}
+    }
+    if ( (cep == NULL) ||
+	 (cep->ce_bus != dep->de_bus) || (cep->ce_channel != dep->de_channel) ||
+	 (cep->ce_target != dep->de_target) || (cep->ce_lun != dep->de_lun) ||
+	 (dep->de_sysfs_inode == 0) || (cep->ce_sysfs_inode != dep->de_sysfs_inode) ||
+	 ((dcp->dc_now - cep->ce_time) >= dcp->dc_ttl) ) {
+	return(NULL);
+    }
+    return(cep);
+}
+
+/*
+ * update_cache_entry() - Add or replace the cache entry for this device.
+ *
+ * Note: This is called while merging, so the cache is *not* being searched.
+ */
+static void
+update_cache_entry(scsi_generic_t *sgp, discovery_cache_t *dcp, discovery_entry_t *dep)
+{
+    void *opaque = sgp->tsp->opaque;
+    cache_entry_t *cep, **cepp;
+
+    if ( (valid_cache_string(dep->de_path) == False) ||
+	 (valid_cache_string(dep->de_serial) == False) ||
+	 (valid_cache_string(dep->de_device_id) == False) ||
+	 (valid_cache_string(dep->de_target_port) == False) ||
+	 (valid_cache_string(dep->de_fw_version) == False) ) {
+	return;
+    }
+    for (cepp = &dcp->dc_entries; (cep = *cepp); cepp = &cep->ce_flink) {
+	if (strcmp(cep->ce_path, dep->de_path) == 0) {
+	    *cepp = cep->ce_flink;
+	    free_cache_entry(opaque, cep);
+	    break;
+	}
+    }
+    cep = Malloc(opaque, sizeof(*cep));
+    if (cep == NULL) return;
+    cep->ce_path = strdup(dep->de_path);
+    cep->ce_bus = dep->de_bus;
+    cep->ce_channel = dep->de_channel;
+    cep->ce_target = dep->de_target;
+    cep->ce_lun = dep->de_lun;
+    cep->ce_sysfs_inode = dep->de_sysfs_inode;
+    cep->ce_time = dcp->dc_now;
+    cep->ce_device_page = dep->de_device_page;
+    cep->ce_inquiry = dep->de_inquiry;
+    if (dep->de_serial) cep->ce_serial = strdup(dep->de_serial);
+    if (dep->de_device_id) cep->ce_device_id = strdup(dep->de_device_id);
+    if (dep->de_target_port) cep->ce_target_port = strdup(dep->de_target_port);
+    if (dep->de_fw_version) cep->ce_fw_version = strdup(dep->de_fw_version);
+    /* Insert at the head, the order of entries is not important. */
+    cep->ce_flink = dcp->dc_entries;
+    dcp->dc_entries = cep;
+    dcp->dc_modified = True;
+    return;
+}
+
+typedef struct discovery_pool {
+    scsi_generic_t	*dp_sgp;	/* The SCSI generic data.	*/
+    scsi_filters_t	*dp_sfp;	/* The SCSI filters.		*/
+    discovery_cache_t	*dp_cache;	/* The inventory cache.		*/
+    discovery_entry_t	*dp_entries;	/* The device entries.		*/
+    int			dp_count;	/* The number of entries.	*/
+    int			dp_next;	/* The next entry to query.	*/
+    unsigned int	dp_timeout;	/* The per device deadline (ms).*/
+    pthread_mutex_t	dp_lock;	/* Protects the next entry.	*/
+} discovery_pool_t;
+
+/*
+ * Sysfs Device Discovery:
+ *
+ *	The kernel saves the standard Inquiry and VPD pages 0x80/0x83 when
+ * the device is scanned, so these are read from sysfs when requested, and
+ * we only issue SCSI commands when an attribute is missing or invalid.
+ */
+#define SYSFS_SCSI_DEVICE	"/sys/class/scsi_device"
+
+static int
+read_sysfs_attribute(char *sysdir, char *name, void *buffer, size_t size)
+{
+    char path[PATH_BUFFER_SIZE];
+    ssize_t count, total = 0;
+    int fd;
+
+    (void)snprintf(path, sizeof(path), "%s/%s", sysdir, name);
+    fd = open(path, O_RDONLY);
+    if (fd == INVALID_HANDLE_VALUE) return(FAILURE);
+    memset(buffer, '\0', size);
+    while ( (size_t)total < size ) {
+	count = read(fd, (char *)buffer + total, (size - total));
+	if (count <= 0) break;
+	total += count;
+    }
+    (void)close(fd);
+    return( (int)total );
+}
+
+/*
+ * sysfs_get_inquiry() - Get the standard Inquiry data from sysfs.
+ *
+ * Description:
+ *	The raw "inquiry" attribute is preferred, since this includes the
+ * vendor unique data. Otherwise, we construct the fields we require from
+ * the "type", "vendor", "model", and "rev" attributes.
+ *
+ * Return Value:
+ *	Returns SUCCESS / FAILURE (attribute(s) missing).
+ */
+static int
+sysfs_get_inquiry(scsi_generic_t *sgp, char *sysdir, inquiry_t *inquiry)
+{
+    struct {
+	char	*name;
+	uint8_t	*field;
+	size_t	length;
+    } *sfap, sysfs_attrs[] = {
+	{ "vendor", inquiry->inq_vid,      INQ_VID_LEN },
+	{ "model",  inquiry->inq_pid,      INQ_PID_LEN },
+	{ "rev",    inquiry->inq_revlevel, INQ_REV_LEN },
+	{ NULL,     NULL,                  0           }
+    };
+    char text[SMALL_BUFFER_SIZE];
+    char *p;
+    int count;
+
+    count = read_sysfs_attribute(sysdir, "inquiry", inquiry, sizeof(*inquiry));
+    if (count >= STD_INQ_LEN) {
+	return(SUCCESS);
+    }
+    memset(inquiry, '\0', sizeof(*inquiry));
+    count = read_sysfs_attribute(sysdir, "type", text, (sizeof(text) - 1));
+    if (count <= 0) return(FAILURE);
+    inquiry->inq_dtype = (uint8_t)atoi(text);
+    for (sfap = sysfs_attrs; sfap->name; sfap++) {
+	count = read_sysfs_attribute(sysdir, sfap->name, text, (sizeof(text) - 1));
+	if (count <= 0) return(FAILURE);
+	if ( (p = strchr(text, '\n')) ) *p = '\0';
+	/* Inquiry strings are space padded, not NULL terminated. */
+	memset(sfap->field, ' ', sfap->length);
+	memcpy(sfap->field, text, min(strlen(text), sfap->length));
+    }
+    if (sgp->debug == True) {
+	Printf(sgp->tsp->opaque, "Constructed Inquiry from %s attributes.\n", sysdir);
+    }
+    return(SUCCESS);
+}
+
+/*
+ * sysfs_get_inquiry_page() - Get an Inquiry VPD page from sysfs.
+ *
+ * Return Value:
+ *	Returns SUCCESS / FAILURE (attribute missing or invalid).
+ */
 static int
-find_scsi_devices(scsi_generic_t *sgp, char *devpath, char *scsi_name, scsi_filters_t *sfp)
+sysfs_get_inquiry_page(char *sysdir, char *name, inquiry_t *inquiry,
+		       inquiry_page_t *inquiry_page, unsigned char page)
+{
+    int count;
+
+    count = read_sysfs_attribute(sysdir, name, inquiry_page, sizeof(*inquiry_page));
+    if (count < (int)sizeof(inquiry_header_t)) return(FAILURE);
+    return( verify_inquiry_header(inquiry, &inquiry_page->inquiry_hdr, page) );
+}
+
+/*
+ * sysfs_get_serial_number() - Get the serial number from VPD page 0x80.
+ *
+ * Return Value:
+ *	Returns NULL if the attribute is missing or invalid.
+ *	Otherwise, returns a pointer to a malloc'd buffer w/serial #.
+ */
+static char *
+sysfs_get_serial_number(char *sysdir, inquiry_t *inquiry)
+{
+    inquiry_page_t inquiry_data;  
+    inquiry_page_t *inquiry_page = &inquiry_data;
+    size_t page_length;
+    char *bp;
+
+    if (sysfs_get_inquiry_page(sysdir, "vpd_pg80", inquiry,
+			       inquiry_page, INQ_SERIAL_PAGE) == FAILURE) {
+	return(NULL);
+    }
+    page_length = (size_t)StoH(inquiry_page->inquiry_hdr.inq_page_length);
+    page_length = min(page_length, sizeof(inquiry_page->inquiry_page_data));
+    bp = (char *)malloc(page_length + 1);
+    if (bp == NULL) return(NULL);
+    strncpy (bp, (char *)inquiry_page->inquiry_page_data, page_length);
+    bp[page_length] = '\0';
+    /* NOTE: Caller MUST free allocated buffer! */
+    return(bp);
+}
+
+/*
+ * Device Filter Functions:
+ *
+ * Return Value:
+ *	Returns True if the device is selected, else False (filtered).
+ */
+static hbool_t
+filter_inquiry(scsi_filters_t *sfp, inquiry_t *inquiry)
+{
+    int length = 0;
+
+    if (sfp == NULL) return(True);
+    /* List of device types. */
+    if (sfp->device_types) {
+	int dindex;
+	hbool_t dtype_found = False;
+	/* List is terminated with DTYPE_UNKNOWN. */
+	for (dindex = 0; (sfp->device_types[dindex] != DTYPE_UNKNOWN); dindex++) {
+	    if (inquiry->inq_dtype == sfp->device_types[dindex]) {
+		dtype_found = True;
+		break;
+	    }
+	}
+	if (dtype_found == False) {
+	    return(False);
+	}
+    }
+    if (sfp->product) {
+	char pid[sizeof(inquiry->inq_pid)+1];
+	strncpy(pid, (char *)inquiry->inq_pid, sizeof(inquiry->inq_pid));
+	pid[sizeof(inquiry->inq_pid)] = '\0';
+	/* Allow substring match to find things like "SDLF". */
+	if (strstr(pid, sfp->product) == NULL) {
+	    return(False);
+	}
+    }
+    if (sfp->vendor) {
+	length = strlen(sfp->vendor);
+	if (strncmp(sfp->vendor, (char *)inquiry->inq_vid, length)) {
+	    return(False);
+	}
+    }
+    if (sfp->revision) {
+	length = strlen(sfp->revision);
+	if (strncmp(sfp->revision, (char *)inquiry->inq_revlevel, length)) {
+	    return(False);
+	}
+    }
+    return(True);
+}
+
+static hbool_t
+filter_serial(scsi_filters_t *sfp, char *serial)
+{
+    /* 
+     * We delay filtering until showing device to acquire all paths.
+     */
+    if ( serial && sfp && sfp->serial) {
+	/* Use substring search due to leading spaces in serial number! */
+	if (strstr(serial, sfp->serial) == NULL) {
+	    return(False);
+	}
+    } else if (sfp && sfp->serial) { /* Skip devices without a serial number. */
+	return(False);
+    }
+    return(True);
+}
+
+static hbool_t
+filter_device_id(scsi_filters_t *sfp, char *device_id)
+{
+    if ( device_id && sfp && sfp->device_id) {
+	if (strcmp(sfp->device_id, device_id) != 0) {
+	    return(False);
+	}
+    } else if (sfp && sfp->device_id) { /* Skip devices without a device ID. */
+	return(False);
+    }
+    return(True);
+}
+
+static hbool_t
+filter_target_port(scsi_filters_t *sfp, char *target_port)
 {
+    if ( target_port && sfp && sfp->target_port) {
+	if (strcmp(sfp->target_port, target_port) != 0) {
+	    return(False);
+	}
+    } else if (sfp && sfp->target_port) { /* Skip devices without a target port. */
+	return(False);
+    }
+    return(True);
+}
+
+static hbool_t
+filter_fw_version(scsi_filters_t *sfp, char *fw_version)
+{
+    if ( fw_version && sfp && sfp->fw_version) {
+	if (strcmp(sfp->fw_version, fw_version) != 0) {
+	    return(False);
+	}
+    } else if (sfp && sfp->fw_version) { /* Skip devices without a FW version. */
+	return(False);
+    }
+    return(True);
+}
+
+/*
+ * query_time_remaining() - Get the time remaining to query a device (ms).
+ *
+ * Description:
+ *	The discovery timeout is a deadline for all commands to a device,
+ * rather than a timeout for each command, so a hung device only holds its'
+ * discovery thread for one timeout. Zero is returned after the deadline.
+ */
+static unsigned int
+query_time_remaining(discovery_pool_t *dpp, struct timespec *start)
+{
+    struct timespec now;
+    int64_t elapsed;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = ( ((int64_t)(now.tv_sec - start->tv_sec) * MSECS) +
+		((int64_t)(now.tv_nsec - start->tv_nsec) / 1000000) );
+    return( (elapsed < (int64_t)dpp->dp_timeout) ? (unsigned int)(dpp->dp_timeout - elapsed) : 0 );
+}
+
+/*
+ * query_device() - Issue the SCSI commands and filter a single device.
+ *
+ * Note: When sysfs discovery is enabled, SCSI commands are only issued for
+ * missing sysfs attributes, and the ATA firmware version (if ATA device).
+ *
+ * When the inventory cache is enabled, a valid cache entry avoids all SCSI
+ * commands, otherwise all device information is acquired (even for devices
+ * filtered) so the cache entry is complete for the next discovery.
+ */
+static void
+query_device(discovery_pool_t *dpp, discovery_entry_t *dep)
+{
+    scsi_generic_t *sgp = dpp->dp_sgp;
+    scsi_filters_t *sfp = dpp->dp_sfp;
+    discovery_cache_t *dcp = dpp->dp_cache;
+    cache_entry_t *cep = NULL;
     void *opaque = sgp->tsp->opaque;
-    int bus, target, lun, channel, ids[2];
-    char *scsi_device = NULL;
-    char *serial = NULL, *device_id = NULL, *target_port = NULL;
-    char *fw_version = NULL;
-    inquiry_t *inquiry = NULL;
+    tool_specific_t tool_specific;
+    tool_specific_t *tsp = &tool_specific;
+    inquiry_t *inquiry = &dep->de_inquiry;
     inquiry_page_t inquiry_data;  
     inquiry_page_t *inquiry_page = &inquiry_data;
+    char *path = dep->de_path;
+    char sysdir[PATH_BUFFER_SIZE];
+    hbool_t sysfs = (sfp && sfp->discovery_sysfs);
+    hbool_t selected = True;
+    struct timespec start;
+    unsigned int timeout;
+    int fd = dep->de_fd;
+    int status;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    (void)snprintf(sysdir, sizeof(sysdir), "%s/%d:%d:%d:%d/device", SYSFS_SCSI_DEVICE,
+		   dep->de_bus, dep->de_channel, dep->de_target, dep->de_lun);
+    if (dcp) {
+	struct stat sb;
+	/* The sysfs inode changes when a device is removed and added again. */
+	if (stat(sysdir, &sb) == SUCCESS) {
+	    dep->de_sysfs_inode = sb.st_ino;
+	}
+	cep = find_cache_entry(dcp, dep);
+    }
+    if (cep) {
+	if (sgp->debug == True) {
+	    Printf(opaque, "Using cached information for device %s...\n", path);
+	}
+	dep->de_cached = True;
+	dep->de_device_page = cep->ce_device_page;
+	*inquiry = cep->ce_inquiry;
+	if (cep->ce_serial) dep->de_serial = strdup(cep->ce_serial);
+	if (cep->ce_device_id) dep->de_device_id = strdup(cep->ce_device_id);
+	if (cep->ce_target_port) dep->de_target_port = strdup(cep->ce_target_port);
+	if (cep->ce_fw_version) dep->de_fw_version = strdup(cep->ce_fw_version);
+	selected = ( filter_inquiry(sfp, inquiry) &&
+		     filter_serial(sfp, dep->de_serial) &&
+		     ( (dep->de_device_page == False) ||
+		       ( filter_device_id(sfp, dep->de_device_id) &&
+			 filter_target_port(sfp, dep->de_target_port) ) ) &&
+		     filter_fw_version(sfp, dep->de_fw_version) );
+	dep->de_selected = selected;
+	return;
+    }
+    /*
+     * Note: We are *not* using our own SCSI generic (sdp) structure, but rather 
+     * leave this empty so one is dynamically allocated and initialized. This is 
+     * done since we are querying multiple devices and avoids sgp cleanup.
+     *
+     * Each query uses its own tool information, without the execute CDB hook,
+     * since the caller's execute function updates the caller's device (sdp)
+     * state (statistics, trace, etc), which is not protected for threads.
+     */
+    *tsp = *sgp->tsp;
+    tsp->execute_cdb = NULL;
+    if ( (sysfs == False) || (sysfs_get_inquiry(sgp, sysdir, inquiry) == FAILURE) ) {
+	dep->de_status = Inquiry(fd, path, sgp->debug, False, NULL, NULL,
+				 inquiry, sizeof(*inquiry), 0, 0, dpp->dp_timeout, tsp);
+	if (dep->de_status) {
+	    return;
+	}
+    }
+    /* SCSI Filters */
+    selected = filter_inquiry(sfp, inquiry);
+    if ( (selected == False) && (dcp == NULL) ) return;
+    /*
+     * Get the Inquiry Serial Number page (0x80).
+     */
+    if (sysfs == True) {
+	dep->de_serial = sysfs_get_serial_number(sysdir, inquiry);
+    }
+    if ( (dep->de_serial == NULL) && (timeout = query_time_remaining(dpp, &start)) ) {
+	dep->de_serial = GetSerialNumber(fd, path, sgp->debug, False,
+					 NULL, NULL, inquiry, timeout, tsp);
+    }
+    selected = selected && filter_serial(sfp, dep->de_serial);
+    if ( (selected == False) && (dcp == NULL) ) return;
+    /*
+     * Get Inquiry Device Identification page (0x83).
+     */
+    if ( (sysfs == False) ||
+	 (sysfs_get_inquiry_page(sysdir, "vpd_pg83", inquiry,
+				 inquiry_page, INQ_DEVICE_PAGE) == FAILURE) ) {
+	if ( (timeout = query_time_remaining(dpp, &start)) ) {
+	    status = Inquiry(fd, path, sgp->debug, False, NULL, NULL,
+			     inquiry_page, sizeof(*inquiry_page), INQ_DEVICE_PAGE,
+			     0, timeout, tsp);
+	} else {
+	    status = FAILURE;
+	}
+    } else {
+	status = SUCCESS;
+    }
+    if (status == SUCCESS) {
+	dep->de_device_page = True;
+	/*
+	 * Get the LUN device identifier (aka WWID).
+	 */
+	dep->de_device_id = DecodeDeviceIdentifier(opaque, inquiry, inquiry_page, False);
+	selected = selected && filter_device_id(sfp, dep->de_device_id);
+	if ( (selected == False) && (dcp == NULL) ) return;
+	/*
+	 * For SAS protocol, the target port is the drive SAS address.
+	 */
+	dep->de_target_port = DecodeTargetPortIdentifier(opaque, inquiry, inquiry_page);
+	selected = selected && filter_target_port(sfp, dep->de_target_port);
+	if ( (selected == False) && (dcp == NULL) ) return;
+    } /* Device may not support the device ID page, but continue... */
+ 
+    /*
+     * Get the full firmware version string. 
+     * Note: This provides 8 character string versus truncated Inquiry revision! 
+     */
+    if ( (inquiry->inq_dtype == DTYPE_DIRECT) &&
+	 (strncmp((char *)inquiry->inq_vid, "ATA", 3) == 0) &&
+	 (timeout = query_time_remaining(dpp, &start)) ) {
+	dep->de_fw_version = AtaGetDriveFwVersion(fd, path, sgp->debug, False,
+						  NULL, NULL, inquiry, timeout, tsp);
+    }
+
+    /*
+     * Filter on user specified FW version (if any).
+     */
+    selected = selected && filter_fw_version(sfp, dep->de_fw_version);
+    /* Don't cache a device missing information, due to the deadline. */
+    if (query_time_remaining(dpp, &start) == 0) {
+	if (sgp->debug == True) {
+	    Printf(opaque, "Device %s exceeded the discovery timeout of %u ms!\n",
+		   path, dpp->dp_timeout);
+	}
+    } else {
+	dep->de_complete = True;
+    }
+    dep->de_selected = selected;
+    return;
+}
+
+static void *
+discovery_thread(void *arg)
+{
+    discovery_pool_t *dpp = arg;
+    discovery_entry_t *dep;
+
+    for (;;) {
+	(void)pthread_mutex_lock(&dpp->dp_lock);
+	dep = (dpp->dp_next < dpp->dp_count) ? &dpp->dp_entries[dpp->dp_next++] : NULL;
+	(void)pthread_mutex_unlock(&dpp->dp_lock);
+	if (dep == NULL) break;
+	query_device(dpp, dep);
+	(void)close(dep->de_fd);
+	dep->de_fd = INVALID_HANDLE_VALUE;
+    }
+    return(NULL);
+}
+
+/*
+ * discover_devices() - Query a batch of devices, then add them in order.
+ *
+ * Inputs:
+ *	dpp = The discovery pool (with the opened devices).
+ *	threads = The maximum number of threads.
+ *	status = The current status (updated by each Inquiry).
+ *
+ * Return Value:
+ *	Returns the status of the last Inquiry issued (as serial code did).
+ */
+static int
+discover_devices(discovery_pool_t *dpp, int threads, int status)
+{
+    scsi_generic_t *sgp = dpp->dp_sgp;
+    pthread_t thread_ids[DISCOVERY_BATCH_SIZE];
+    scsi_device_entry_t *sdep;
+    discovery_entry_t *dep;
+    int thread, started = 0;
+
+    dpp->dp_next = 0;
+    if (threads > dpp->dp_count) {
+	threads = dpp->dp_count;
+    }
+    /* Note: If threads cannot be created, we do the work ourselves. */
+    for (thread = 0; (threads > 1) && (thread < threads); thread++) {
+	if (pthread_create(&thread_ids[thread], NULL, discovery_thread, dpp) != SUCCESS) {
+	    break;
+	}
+	started++;
+    }
+    (void)discovery_thread(dpp);
+    for (thread = 0; (thread < started); thread++) {
+	(void)pthread_join(thread_ids[thread], NULL);
+    }
+
+    /* 
+     * Now, create the SCSI device table entries (in directory order).
+     */
+    for (dep = dpp->dp_entries; (dep < &dpp->dp_entries[dpp->dp_count]); dep++) {
+	status = dep->de_status;
+	if ( dpp->dp_cache && (dep->de_complete == True) ) {
+	    update_cache_entry(sgp, dpp->dp_cache, dep);
+	}
+	if (dep->de_selected == True) {
+	    inquiry_t *inquiry = &dep->de_inquiry;
+	    sdep = add_device_entry(sgp, dep->de_path, inquiry, dep->de_serial, dep->de_device_id,
+				    dep->de_target_port, dep->de_bus, dep->de_channel,
+				    dep->de_target, dep->de_lun);
+
+	    if (dep->de_fw_version && sdep->sde_fw_version == NULL) {
+		sdep->sde_fw_version = strdup(dep->de_fw_version);
+	    }
+#if defined(Nimble)
+	    if ( (inquiry->inq_dtype == DTYPE_DIRECT) &&
+		 (strncmp((char *)inquiry->inq_vid, "Nimble", 6) == 0) ) {
+		nimble_vu_disk_inquiry_t *nimble_inq = (nimble_vu_disk_inquiry_t *)&inquiry->inq_vendor_unique;
+		char text[SMALL_BUFFER_SIZE];
+        	char *target_type = NULL;
+		sdep->sde_nimble_device = True;
+		(void)memcpy(text, nimble_inq->array_sw_version, sizeof(nimble_inq->array_sw_version));
+		text[sizeof(nimble_inq->array_sw_version)] = '\0';
+        	sdep->sde_sw_version = strdup(text);
+		target_type = (nimble_inq->target_type == NIMBLE_VOLUME_SCOPED_TARGET)
+          					? "Volume Scoped" : "Group Scoped";
+        	sdep->sde_target_type = strdup(target_type);
+        	sdep->sde_sync_replication = (nimble_inq->sync_replication == True);
+	    } else {
+		sdep->sde_nimble_device = False;
+	    }
+#endif /* defined(Nimble) */
+	}
+	Free(sgp->tsp->opaque, dep->de_path);
+	if (dep->de_serial) Free(sgp->tsp->opaque, dep->de_serial);
+	if (dep->de_device_id) Free(sgp->tsp->opaque, dep->de_device_id);
+	if (dep->de_target_port) Free(sgp->tsp->opaque, dep->de_target_port);
+	if (dep->de_fw_version) Free(sgp->tsp->opaque, dep->de_fw_version);
+    }
+    dpp->dp_count = 0;
+    return(status);
+}
+
+static int
+find_scsi_devices(scsi_generic_t *sgp, char *devpath, char *scsi_name,
+		  scsi_filters_t *sfp, discovery_cache_t *dcp)
+{
+    void *opaque = sgp->tsp->opaque;
+    int bus, target, lun, channel;
     scsi_device_entry_t *sdep = NULL;
     struct sg_scsi_id scsi_id, *sid = &scsi_id;
+    discovery_pool_t discovery_pool;
+    discovery_pool_t *dpp = &discovery_pool;
+    discovery_entry_t *dep;
+    int threads;
     DIR *dir;
     struct dirent *dirent;
     char path[PATH_BUFFER_SIZE];
-    char *dsf = sgp->dsf;
     int fd = INVALID_HANDLE_VALUE;
     int oflags = (O_RDONLY|O_NONBLOCK);
     int status = SUCCESS;
@@ -1368,6 +2271,25 @@ find_scsi_devices(scsi_generic_t *sgp, char *devpath, char *scsi_name, scsi_filt
     }
     dir = opendir(devpath);
     if (dir) {
+	memset(dpp, '\0', sizeof(*dpp));
+	dpp->dp_sgp = sgp;
+	dpp->dp_sfp = sfp;
+	dpp->dp_cache = dcp;
+	/* Honor the users' timeout=, unless a discovery timeout was specified. */
+	if (sfp && sfp->discovery_timeout) {
+	    dpp->dp_timeout = sfp->discovery_timeout;
+	} else if (sgp->timeout && (sgp->timeout != ScsiDefaultTimeout)) {
+	    dpp->dp_timeout = sgp->timeout;
+	} else {
+	    dpp->dp_timeout = DiscoveryTimeoutDefault;
+	}
+	threads = (sfp && sfp->discovery_threads) ? sfp->discovery_threads : DiscoveryThreadsDefault;
+	dpp->dp_entries = Malloc(opaque, (sizeof(*dep) * DISCOVERY_BATCH_SIZE));
+	if (dpp->dp_entries == NULL) {
+	    closedir(dir);
+	    return(FAILURE);
+	}
+	(void)pthread_mutex_init(&dpp->dp_lock, NULL);
 	while ((dirent = readdir(dir)) != NULL) {
 	    if ( (dirent->d_type != DT_CHR) &&
 		 (dirent->d_type != DT_LNK) &&
@@ -1409,7 +2331,7 @@ find_scsi_devices(scsi_generic_t *sgp, char *devpath, char *scsi_name, scsi_filt
 		} else { /* Control w/debug? */
 		    Perror(opaque, "Failed to open device %s", path);
 		}
-		goto close_and_continue;
+		continue;
 	    }
 	    if (strncmp(dirent->d_name, "sg", 2) == 0) {
 		if (ioctl(fd, SG_GET_SCSI_ID, sid) == SUCCESS) {
@@ -1480,187 +2402,33 @@ find_scsi_devices(scsi_generic_t *sgp, char *devpath, char *scsi_name, scsi_filt
 		    goto close_and_continue; /* Match, so skip this device. */
 		}
 	    }
-	    if (inquiry == NULL) {
-		inquiry = Malloc(opaque, sizeof(*inquiry));
-		if (inquiry == NULL) return(FAILURE);
-	    }
-	    /*
-	     * int
-	     * Inquiry(HANDLE fd, char *dsf, hbool_t debug, hbool_t errlog,
-	     *         scsi_addr_t *sap, scsi_generic_t **sgpp,
-	     *         void *data, unsigned int len, unsigned char page,
-	     *         unsigned int sflags, unsigned int timeout, tool_specific_t *tsp)
-	     *  
-	     * Note: We are *not* using our own SCSI generic (sdp) structure, but rather 
-	     * leave this empty so one is dynamically allocated and initialized. This is 
-	     * done since we are querying multiple devices and avoids sgp cleanup.
-	     */
-	    status = Inquiry(fd, path, sgp->debug, False, NULL, NULL,
-			     inquiry, sizeof(*inquiry), 0, 0, sgp->timeout, sgp->tsp);
-	    if (status) {
-		goto close_and_continue;
-	    }
-	    /* SCSI Filters */
-	    if ( sfp ) {
-		int length = 0;
-		/* List of device types. */
-		if (sfp->device_types) {
-		    int dindex;
-		    hbool_t dtype_found = False;
-		    /* List is terminated with DTYPE_UNKNOWN. */
-		    for (dindex = 0; (sfp->device_types[dindex] != DTYPE_UNKNOWN); dindex++) {
-			if (inquiry->inq_dtype == sfp->device_types[dindex]) {
-			    dtype_found = True;
-			    break;
-			}
-		    }
-		    if (dtype_found == False) {
-			goto close_and_continue;
-		    }
-		}
-		if (sfp->product) {
-		    char pid[sizeof(inquiry->inq_pid)+1];
-		    strncpy(pid, (char *)inquiry->inq_pid, sizeof(inquiry->inq_pid));
-		    pid[sizeof(inquiry->inq_pid)] = '\0';
-		    /* Allow substring match to find things like "SDLF". */
-		    if (strstr(pid, sfp->product) == NULL) {
-			goto close_and_continue;
-		    }
-		}
-		if (sfp->vendor) {
-		    length = strlen(sfp->vendor);
-		    if (strncmp(sfp->vendor, (char *)inquiry->inq_vid, length)) {
-			goto close_and_continue;
-		    }
-		}
-		if (sfp->revision) {
-		    length = strlen(sfp->revision);
-		    if (strncmp(sfp->revision, (char *)inquiry->inq_revlevel, length)) {
-			goto close_and_continue;
-		    }
-		}
-	    }
-	    if (serial == NULL) {
-		/*
-		 * Get the Inquiry Serial Number page (0x80).
-		 */
-		serial = GetSerialNumber(fd, path, sgp->debug, False,
-					 NULL, NULL, inquiry, sgp->timeout, sgp->tsp);
-	    }
-	    /* 
-	     * We delay filtering until showing device to acquire all paths.
-	     */
-	    if ( serial && sfp && sfp->serial) {
-		/* Use substring search due to leading spaces in serial number! */
-		if (strstr(serial, sfp->serial) == NULL) {
-		    goto close_and_continue;
-		}
-	    } else if (sfp && sfp->serial) { /* Skip devices without a serial number. */
-		goto close_and_continue;
-	    }
 	    /*
-	     * Get Inquiry Device Identification page (0x83).
+	     * Queue the device, the SCSI commands are issued by the pool.
 	     */
-	    status = Inquiry(fd, path, sgp->debug, False, NULL, NULL,
-			     inquiry_page, sizeof(*inquiry_page), INQ_DEVICE_PAGE,
-			     0, sgp->timeout, sgp->tsp);
-	    if (status == SUCCESS) {
-		/*
-		 * Get the LUN device identifier (aka WWID).
-		 */
-		device_id = DecodeDeviceIdentifier(opaque, inquiry, inquiry_page, False);
-		if ( device_id && sfp && sfp->device_id) {
-		    if (strcmp(sfp->device_id, device_id) != 0) {
-			goto close_and_continue;
-		    }
-		} else if (sfp && sfp->device_id) { /* Skip devices without a device ID. */
-		    goto close_and_continue;
-		}
-		/*
-		 * For SAS protocol, the target port is the drive SAS address.
-		 */
-		target_port = DecodeTargetPortIdentifier(opaque, inquiry, inquiry_page);
-		if ( target_port && sfp && sfp->target_port) {
-		    if (strcmp(sfp->target_port, target_port) != 0) {
-			goto close_and_continue;
-		    }
-		} else if (sfp && sfp->target_port) { /* Skip devices without a target port. */
-		    goto close_and_continue;
-		}
-	    } else {
-		status = SUCCESS; /* Device may not support the device ID page, but continue... */
-	    }
- 
-	    /*
-	     * Get the full firmware version string. 
-	     * Note: This provides 8 character string versus truncated Inquiry revision! 
-	     */
-	    if ( (inquiry->inq_dtype == DTYPE_DIRECT) &&
-		 (strncmp((char *)inquiry->inq_vid, "ATA", 3) == 0) ) {
-		fw_version = AtaGetDriveFwVersion(fd, path, sgp->debug, False,
-						  NULL, NULL, inquiry, sgp->timeout, sgp->tsp);
-	    }
-
-	    /*
-	     * Filter on user specified FW version (if any).
-	     */
-	    if ( fw_version && sfp && sfp->fw_version) {
-		if (strcmp(sfp->fw_version, fw_version) != 0) {
-		    goto close_and_continue;
-		}
-	    } else if (sfp && sfp->fw_version) { /* Skip devices without a FW version. */
-		goto close_and_continue;
-	    }
-
-	    /* 
-	     * Now, create the SCSI device table entries.
-	     */
-	    sdep = add_device_entry(sgp, path, inquiry, serial, device_id,
-				    target_port, bus, channel, target, lun);
-
-	    if (fw_version && sdep->sde_fw_version == NULL) {
-		sdep->sde_fw_version = strdup(fw_version);
-	    }
-#if defined(Nimble)
-	    if ( (inquiry->inq_dtype == DTYPE_DIRECT) &&
-		 (strncmp((char *)inquiry->inq_vid, "Nimble", 6) == 0) ) {
-		nimble_vu_disk_inquiry_t *nimble_inq = (nimble_vu_disk_inquiry_t *)&inquiry->inq_vendor_unique;
-		char text[SMALL_BUFFER_SIZE];
-        	char *target_type = NULL;
-		sdep->sde_nimble_device = True;
-		(void)memcpy(text, nimble_inq->array_sw_version, sizeof(nimble_inq->array_sw_version));
-		text[sizeof(nimble_inq->array_sw_version)] = '\0';
-        	sdep->sde_sw_version = strdup(text);
-		target_type = (nimble_inq->target_type == NIMBLE_VOLUME_SCOPED_TARGET)
-          					? "Volume Scoped" : "Group Scoped";
-        	sdep->sde_target_type = strdup(target_type);
-        	sdep->sde_sync_replication = (nimble_inq->sync_replication == True);
-	    } else {
-		sdep->sde_nimble_device = False;
+	    dep = &dpp->dp_entries[dpp->dp_count++];
+	    memset(dep, '\0', sizeof(*dep));
+	    dep->de_path = strdup(path);
+	    dep->de_fd = fd;
+	    dep->de_bus = bus;
+	    dep->de_channel = channel;
+	    dep->de_target = target;
+	    dep->de_lun = lun;
+	    fd = INVALID_HANDLE_VALUE;
+	    if (dpp->dp_count == DISCOVERY_BATCH_SIZE) {
+		status = discover_devices(dpp, threads, status);
 	    }
-#endif /* defined(Nimble) */
+	    continue;
 
 close_and_continue:
 	    (void)close(fd);
 	    fd = INVALID_HANDLE_VALUE;
-	    if (serial) {
-		Free(opaque, serial);
-		serial = NULL;
-	    }
-	    if (device_id) {
-		Free(opaque, device_id);
-		device_id = NULL;
-	    }
-	    if (target_port) {
-		Free(opaque, target_port);
-		target_port = NULL;
-	    }
-	    if (fw_version) {
-		Free(opaque, fw_version);
-		fw_version = NULL;
-	    }
 	}
 	closedir(dir);
+	if (dpp->dp_count) {
+	    status = discover_devices(dpp, threads, status);
+	}
+	(void)pthread_mutex_destroy(&dpp->dp_lock);
+	Free(opaque, dpp->dp_entries);
     } else {
 	if (sgp->debug) {
 	    Perror(opaque, "Failed to open directory %s", devpath);
@@ -1668,11 +2436,6 @@ close_and_continue:
 	/* Note: Directory, such as /dev/mapper, may *not* exist! */
 	//status = FAILURE;
     }
-    if (inquiry) Free(opaque, inquiry);
-    if (serial) Free(opaque, serial);
-    if (device_id) Free(opaque, device_id);
-    if (target_port) Free(opaque, target_port);
-    if (fw_version) Free(opaque, fw_version);
     return(status);
 }
 
@@ -62,6 +62,11 @@ extern hbool_t os_is_retriable(scsi_generic_t *sgp);
 extern char *os_host_status_msg(scsi_generic_t *sgp);
 extern char *os_driver_status_msg(scsi_generic_t *sgp);
 
+/* Parallel Device Discovery: (show devices) */
+#define DiscoveryThreadsDefault	16		/* The discovery threads.	*/
+#define DiscoveryTimeoutDefault	(10 * MSECS)	/* Per device timeout (ms).	*/
+#define DiscoveryCacheTTLDefault (60 * 60)	/* Cache time to live (secs).	*/
+
 /* SCSI Filters: */
 typedef struct scsi_filters {
     hbool_t	all_device_paths;	/* Include all device paths.	*/
@@ -75,6 +80,12 @@ typedef struct scsi_filters {
     char	*serial;		/* The serial number.		*/
     char	*target_port;		/* The target port.		*/
     char	*fw_version;		/* The firmware version.	*/
+    int		discovery_threads;	/* The discovery threads.	*/
+    unsigned int discovery_timeout;	/* The discovery timeout (ms).	*/
+    hbool_t	discovery_sysfs;	/* Discover devices via sysfs.	*/
+    char	*cache_file;		/* The inventory cache file.	*/
+    unsigned int cache_ttl;		/* The cache time to live.	*/
+    hbool_t	cache_refresh;		/* Refresh the cache entries.	*/
 } scsi_filters_t;
 
 extern hbool_t match_device_paths(char *device_path, char *paths);
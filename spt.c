@@ -32,6 +32,86 @@
  *
  * Modification History:
  * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add spt_exec_stream(), passing output to the callers' function as
+ * it's produced, so large output (e.g. SES pages) is never truncated.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add spt_exec_result(), which returns the status, sense, and data-in
+ * in a binary result structure, and only decodes data on request.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add the spt_open(), spt_exec(), and spt_close() handle interface to
+ * the shared library, which keeps the device open with its' capacity and
+ * Inquiry data between commands. Library initialization is now done once.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Emit status formats are now compiled once per thread (see spt_fmt.c).
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Replace the sequential match() calls in parse_args() with a sorted
+ * keyword table and switch, to reduce parsing overhead for pipe mode and
+ * scripts. The accepted syntax is unchanged.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add "bench" keyword, to benchmark spt's own overhead against the
+ * emulator (spt bench [bench_file=file] [baseline=file]).
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add inject= and inject_latency= options, to inject faults and latency
+ * in ExecuteCdb(), and report the cost of each error recovery path.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add RAM backed emulated devices (dsf=emu:size=value,...), for
+ * testing without storage.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add workload=file option, to run a JSON workload of concurrent
+ * thread groups and sequential phases, with merged group statistics.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add "analyze" keyword, to analyze binary command traces offline
+ * (spt analyze trace=file[,file...]).
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add replay=file option, to replay a binary command trace with the
+ * original timing (scaled via replay_scale=) and concurrency.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add trace=file option, to record each command executed into a per
+ * thread binary trace ring (trace_records=value sets the ring size).
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add ptype=random pattern, verified without a pattern buffer, with
+ * rndseed= and rndpass= options.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add ptype=reduce data reduction pattern, with compress=, dedupe=,
+ * and drseed= options, for arrays with inline compression and dedupe.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add T10 Protection Information options (rdprotect=, wrprotect=,
+ * pitype=, apptag=, appmask=, reftag=), and read32/write32 keywords.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add manifest=file option, to record per-block CRC32C's on writes,
+ * and verify reads against the manifest (in parallel using slices).
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add enable=bytchk to verify data with Verify(16) byte check.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add a Compare and Write contention mode (caw_locks=value), where
+ * threads contend for a small set of lock LBAs across device paths.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Record each command latency (including retries) in ExecuteCdb(),
+ * and add enable=firstwrite for the thin provisioning write benchmark.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      For Get LBA Status with threads, divide the LUN into slices, and
+ * add lbamap=file option to write a run-length map of all extents.
+ * 
  * January 29th, 2021 by Robin T. Miller
  *      When creating log files, create the directory (as required).
  * 
@@ -213,7 +293,6 @@ uint32_t PipeDelay = 250;		/* Pipe mopde delay value.	*/
 /* Note: These will become unique per thread w/log option! */
 FILE	*efp;				/* Default error data stream.	*/
 FILE	*ofp;				/* Default output data stream.	*/
-uint32_t jobid = 1;			/* The job identifier.		*/
 
 clock_t hertz;
 
@@ -400,12 +479,24 @@ char *emit_status_multiple_json="{\n"
 int spt(char *stdin_buffer, char *stderr_buffer, int stderr_length,
 	char *stdout_buffer, int stdout_length, char *emit_status_buffer, int emit_status_length);
 void cleanup_cloned_master(scsi_device_t *sdp);
+#if defined(SHARED_LIBRARY)
+typedef struct spt_handle spt_handle_t;
+spt_handle_t *spt_open(char *dsf, char *options);
+int spt_exec(spt_handle_t *shp, char *stdin_buffer, char *stderr_buffer, int stderr_length,
+	     char *stdout_buffer, int stdout_length, char *emit_status_buffer, int emit_status_length);
+int spt_exec_result(spt_handle_t *shp, char *stdin_buffer, spt_result_t *srp,
+		    char *stdout_buffer, int stdout_length);
+int spt_exec_stream(spt_handle_t *shp, char *stdin_buffer,
+		    spt_output_func_t output_func, void *output_arg);
+void spt_close(spt_handle_t *shp);
+#endif /* defined(SHARED_LIBRARY) */
 int main(int argc, char **argv);
 int spt_main(int argc, char **argv, scsi_device_t *msdp);
 int main_loop(scsi_device_t *sdp);
 int create_detached_thread(scsi_device_t *sdp, void *(*func)(void *));
 void *a_cdb(void *arg);
 void *a_tmf(void *arg);
+void *a_replay(void *arg);
 int process_cdb_params(scsi_device_t *sdp);
 int process_input_file(scsi_device_t *sdp);
 int process_output_file(scsi_device_t *sdp);
@@ -416,7 +507,7 @@ static hbool_t check_expected_status(scsi_device_t *sdp, hbool_t report);
 void cleanup_EOL(char *string);
 void display_command(scsi_device_t *sdp, char *command, hbool_t prompt);
 char *expand_word(scsi_device_t *sdp, char **from, size_t bufsiz, int *status);
-static int parse_args(scsi_device_t *sdp, int argc, char **argv);
+int parse_args(scsi_device_t *sdp, int argc, char **argv);
 static int parse_exp_data(char *str, scsi_device_t *sdp);
 static int expand_exp_data(scsi_device_t *sdp);
 hbool_t match(char **sptr, char *s);
@@ -431,6 +522,7 @@ int DoErrorControl(scsi_device_t *sdp, int status);
 
 void init_devices(scsi_device_t *sdp);
 void cleanup_devices(scsi_device_t *sdp, hbool_t master);
+void save_spt_result(scsi_device_t *sdp);
 int open_devices(scsi_device_t *sdp);
 int close_devices(scsi_device_t *sdp, int starting_index);
 int clone_devices(scsi_device_t *sdp, scsi_device_t *tsdp);
@@ -452,7 +544,7 @@ void save_cmdline(scsi_device_t *sdp);
 
 int setup_thread_attributes(scsi_device_t *sdp, pthread_attr_t *tattrp, hbool_t joinable_flag);
 int init_pthread_attributes(scsi_device_t *sdp);
-static scsi_device_t *init_device_information(void);
+scsi_device_t *init_device_information(void);
 void init_device_defaults(scsi_device_t *sdp);
 
 void
@@ -524,7 +616,13 @@ open_devices(scsi_device_t *sdp)
 	}
 
 	if (sgp->dsf && (sgp->fd == INVALID_HANDLE_VALUE)) {
-	    if ( (status = os_open_device(sgp)) == FAILURE) {
+	    if (is_emulated_device(sgp->dsf) == True) {
+		status = emu_open_device(sdp, iop, sgp);
+	    } else {
+		iop->emu_device = NULL;
+		status = os_open_device(sgp);
+	    }
+	    if (status == FAILURE) {
 		free(sgp->dsf);
 		sgp->dsf = NULL; /* Avoid trying to open again! */
 		break;
@@ -537,7 +635,7 @@ open_devices(scsi_device_t *sdp)
 	if ( (sgp->sense_data == NULL) && sgp->sense_length) {
 	    sgp->sense_data = malloc_palign(sdp, sgp->sense_length, 0);
 	}
-	if (sdp->scsi_info_flag == True) {
+	if ( (sdp->scsi_info_flag == True) && (iop->sip == NULL) ) {
 	    (void)get_scsi_information(sdp, iop);
 	}
     }
@@ -568,6 +666,53 @@ close_devices(scsi_device_t *sdp, int starting_index)
     return (status);
 }
 
+/*
+ * save_spt_result() - Save the first threads' result for the library caller.
+ *
+ * Inputs:
+ * 	sdp = The thread device pointer.
+ *
+ * Return Value:
+ * 	Void.
+ */
+void
+save_spt_result(scsi_device_t *sdp)
+{
+    scsi_device_t	*msdp = sdp->master_sdp;
+    io_params_t		*iop = &sdp->io_params[IO_INDEX_BASE];
+    scsi_generic_t 	*sgp = &iop->sg;
+    spt_result_t	*srp = msdp->spt_result;
+    scsi_sense_t	*ssp = sgp->sense_data;
+
+    srp->sr_scsi_status = (uint8_t)sgp->scsi_status;
+    srp->sr_host_status = sgp->host_status;
+    srp->sr_driver_status = sgp->driver_status;
+    srp->sr_data_resid = sgp->data_resid;
+    srp->sr_duration = iop->cmd_latency;
+    if ( ssp && (sgp->scsi_status == SCSI_CHECK_CONDITION) ) {
+	srp->sr_sense_length = (sgp->sense_length - sgp->sense_resid);
+	if (srp->sr_sense_length > sizeof(srp->sr_sense_data)) {
+	    srp->sr_sense_length = sizeof(srp->sr_sense_data);
+	}
+	memcpy(srp->sr_sense_data, ssp, srp->sr_sense_length);
+	GetSenseErrors(ssp, &srp->sr_sense_key, &srp->sr_asc, &srp->sr_ascq);
+    }
+    if ( (sgp->data_dir == scsi_data_read) && sgp->data_buffer && sgp->data_transferred) {
+	/* The handle buffer is reused, and only grows as required. */
+	if (msdp->result_data_size < sgp->data_transferred) {
+	    Free(msdp, msdp->result_data);
+	    msdp->result_data = Malloc(msdp, sgp->data_transferred);
+	    msdp->result_data_size = (msdp->result_data) ? sgp->data_transferred : 0;
+	}
+	if (msdp->result_data) {
+	    memcpy(msdp->result_data, sgp->data_buffer, sgp->data_transferred);
+	    srp->sr_data = msdp->result_data;
+	    srp->sr_data_length = sgp->data_transferred;
+	}
+    }
+    return;
+}
+
 /*
  * cleanup_devices() - Cleanup per thread devices.
  * 
@@ -583,19 +728,35 @@ cleanup_devices(scsi_device_t *sdp, hbool_t master)
 {
     scsi_generic_t 	*sgp;
     io_params_t		*iop;
+    hbool_t		retain;
     int			device_index;
 
+    if ( (master == False) && sdp->shared_library && sdp->master_sdp &&
+	 (sdp->thread_number == 1) ) {
+	/* Note: The master result may be gone using async jobs! */
+	(void)acquire_print_lock();
+	if (sdp->master_sdp->spt_result) {
+	    save_spt_result(sdp);
+	}
+	(void)release_print_lock();
+    }
     /*
      * Free per device resource allocated.
      */
     for (device_index = 0; device_index < sdp->io_devices; device_index++) {
 	iop = &sdp->io_params[device_index];
 	sgp = &iop->sg;
+	/* Handles keep the base device capacity and Inquiry across commands. */
+	retain = ( (master == True) && sdp->retain_device_info &&
+		   (device_index == IO_INDEX_BASE) &&
+		   !iop->user_capacity && !iop->capacity_percentage );
 
 	/* Initialize data, so we don't have stale for next command! */
 	iop->sop		= NULL;
 	iop->cdb_blocks		= 0;
-	iop->device_capacity	= 0;
+	if (retain == False) {
+	    iop->device_capacity = 0;
+	}
 	//iop->device_size	= BLOCK_SIZE;
 	iop->starting_lba	= 0;
 	iop->ending_lba		= 0;
@@ -627,7 +788,28 @@ cleanup_devices(scsi_device_t *sdp, hbool_t master)
         iop->designator_type	= 0;
 	iop->deallocated_blocks	= 0;
 	iop->mapped_blocks	= 0;
+	iop->anchored_blocks	= 0;
 	iop->total_lba_blocks	= 0;
+	if (iop->lba_extents) {
+	    free(iop->lba_extents);
+	    iop->lba_extents	= NULL;
+	}
+	iop->lba_extent_count	= 0;
+	iop->lba_extent_entries	= 0;
+	if (iop->sparse_extents) {
+	    free(iop->sparse_extents);
+	    iop->sparse_extents	= NULL;
+	}
+	iop->sparse_extent_count = 0;
+	iop->sparse_skipped_blocks = 0;
+	iop->sparse_unmapped_blocks = 0;
+	if (iop->thin_write_stats) {
+	    free(iop->thin_write_stats);
+	    iop->thin_write_stats = NULL;
+	}
+	iop->thin_write_unmapped = False;
+	memset(iop->verify_stats, '\0', sizeof(iop->verify_stats));
+	pi_free_buffer(sdp, iop);
 	iop->max_segment_descriptors = 0;
 	iop->maximum_segment_length = 0;
 	iop->pt_max_range_descriptors = 0;
@@ -676,7 +858,7 @@ cleanup_devices(scsi_device_t *sdp, hbool_t master)
 		sgp->sense_data = NULL;
 	    }
 	}
-	if (iop->sip) {
+	if (iop->sip && (retain == False)) {
 	    free_scsi_information(iop);
 	}
     } /* end of for (device_index = 0;... */
@@ -698,6 +880,7 @@ cleanup_devices(scsi_device_t *sdp, hbool_t master)
 	    free(sdp->emit_status);
 	    sdp->emit_status = NULL;
 	}
+	release_emit_programs(sdp);
 	if (sdp->keepalive) {
 	    free(sdp->keepalive);
 	    sdp->keepalive = NULL;
@@ -737,6 +920,25 @@ cleanup_devices(scsi_device_t *sdp, hbool_t master)
 	sdp->rod_token_data = NULL;
 	sdp->rod_token_valid = False;
     }
+    /* Note: The map is shared, so the last thread frees it! */
+    if (master == False) {
+	release_lba_status_map(sdp);
+	release_caw_contention(sdp);
+	release_crc_manifest(sdp);
+	release_cmd_trace(sdp);
+	release_cmd_replay(sdp);
+	release_workload_stats(sdp);
+	release_inject_thread(sdp);
+    } else {
+	sdp->lba_status_map = NULL;
+	sdp->caw_contention = NULL;
+	sdp->crc_manifest = NULL;
+	sdp->cmd_trace = NULL;
+	sdp->cmd_replay = NULL;
+	sdp->workload_stats = NULL;
+	sdp->inject_data = NULL;
+	sdp->inject_thread = NULL;
+    }
     /*
      * For shared library interface, copy data to master to return.
      */
@@ -902,6 +1104,9 @@ clone_devices(scsi_device_t *sdp, scsi_device_t *tsdp)
     if (sdp->emit_status) {
 	tsdp->emit_status = strdup(sdp->emit_status);
     }
+    /* Each thread compiles its own emit status programs. */
+    memset(tsdp->emit_programs, '\0', sizeof(tsdp->emit_programs));
+    tsdp->emit_program_next = 0;
     if (sdp->keepalive) {
 	tsdp->keepalive = strdup(sdp->keepalive);
     }
@@ -936,7 +1141,8 @@ clone_devices(scsi_device_t *sdp, scsi_device_t *tsdp)
      */
     iop = &sdp->io_params[IO_INDEX_BASE];
     sgp = &iop->sg;
-    if ( (sgp->data_dir == scsi_data_read) && sgp->data_length && (sdp->compare_data || sdp->user_pattern)) {
+    if ( (sgp->data_dir == scsi_data_read) && sgp->data_length && (sdp->rnd_pattern == False) &&
+	 (sdp->compare_data || sdp->user_pattern)) {
 	/* Note: Not used in the case of pin= option, but simplifies logic! */
 	tsdp->pattern_buffer = malloc_palign(sdp, tsgp->data_length, 0);
 	InitBuffer(tsdp->pattern_buffer, (size_t)tsgp->data_length, tsdp->pattern);
@@ -973,6 +1179,8 @@ EmitStatus(scsi_device_t *sdp, char *status_string, hbool_t prefix_flag)
     /*
      * If an emit statusi/keepalive string was specified, format and display it.
      */
+    /* Avoid formatting when the library caller has no emit status buffer. */
+    if (sdp->shared_library && (sdp->emit_status_buffer == NULL) && (sdp->output_func == NULL)) return;
     if (status_string && strlen(status_string)) {
 	char *efmt_buffer = Malloc(sdp, EMIT_STATUS_BUFFER_SIZE);
 	if (efmt_buffer == NULL) return;
@@ -980,6 +1188,9 @@ EmitStatus(scsi_device_t *sdp, char *status_string, hbool_t prefix_flag)
 	strcat(efmt_buffer, "\n");
 	if (sdp->shared_library) {
 	    int slen = (int)strlen(efmt_buffer);
+	    if ( PrintOutput(sdp, SPT_OUTPUT_EMIT, efmt_buffer) ) {
+		slen = 0; /* Streamed to the callers' function. */
+	    }
             if (sdp->emit_status_remaining < slen) {
                 slen = sdp->emit_status_remaining;
             }
@@ -1110,6 +1321,48 @@ do_sleeps(scsi_device_t *sdp)
  */
 #if defined(SHARED_LIBRARY)
 
+static pthread_once_t spt_library_once = PTHREAD_ONCE_INIT;
+
+/*
+ * spt_library_init() - One time library initialization.
+ *
+ * Description:
+ *	This performs the process wide setup normally done by spt_main(),
+ * exactly once, no matter how many threads call the library at once.
+ * Signal handlers are *not* installed, since these belong to the caller.
+ */
+static void
+spt_library_init(void)
+{
+    scsi_device_t *msdp;
+
+    OurName = "spt";
+    sptpath = "spt";
+    ExitFlag = True;
+    efp = stderr;
+    ofp = stdout;
+#if defined(__unix)
+    hertz = sysconf(_SC_CLK_TCK);
+#else /* !defined(__unix) */
+    hertz = CLK_TCK;
+#endif /* defined(__unix) */
+    if (getenv(PROGRAM_DEBUG)) {
+	DebugFlag = True;
+    }
+    master_sdp = msdp = init_device_information();
+    if (msdp == NULL) return;
+    init_device_defaults(msdp);
+    msdp->shared_library = True;
+    StdinIsAtty = StdoutIsAtty = False;
+
+    (void)init_pthread_attributes(msdp);
+    (void)initialize_print_lock(msdp);
+    (void)initialize_jobs_data(msdp);
+    (void)initialize_emulator(msdp);
+    FirstTime = False;
+    return;
+}
+
 /*
  * spt - The External spt Callable Interface. 
  *  
@@ -1147,24 +1400,15 @@ spt(char *stdin_buffer,
     if (emit_status_buffer) {
 	*emit_status_buffer = '\0';
     }
-    OurName = "spt";
-    sptpath = "spt";
-    ExitFlag = True;
-    //DebugFlag = True;
-    if (master_sdp == NULL) {
-	scsi_device_t *msdp;
-	efp = stderr;
-	ofp = stdout;
-	master_sdp = msdp = init_device_information();
-	init_device_defaults(msdp);
-	msdp->shared_library = True;
-    }
+    (void)pthread_once(&spt_library_once, spt_library_init);
+    if (master_sdp == NULL) return(FAILURE);
     /* Clone master for multiple thread callers. */
     sdp = Malloc(master_sdp, sizeof(*sdp));
     if (sdp == NULL) return(FAILURE);
     *sdp = *master_sdp;
     status = clone_devices(master_sdp, sdp);
     sdp->master_sdp = sdp;
+    sdp->cmd_interrupted = &sdp->interrupted_flag;
     /* Now setup parameters for execution. */
     sdp->shared_library = True;
     sdp->output_format = JSON_FMT;
@@ -1205,11 +1449,7 @@ spt(char *stdin_buffer,
     strcpy(sdp->cmdbufptr, stdin_buffer);
     sdp->argc = MakeArgList(sdp, sdp->argv, sdp->cmdbufptr);
 
-    if (FirstTime == True) {
-	status = spt_main(sdp->argc, sdp->argv, sdp);
-    } else {
-	status = main_loop(sdp);
-    }
+    status = main_loop(sdp);
     cleanup_cloned_master(sdp);
     return(status);
 }
@@ -1236,6 +1476,314 @@ cleanup_cloned_master(scsi_device_t *sdp)
     free(sdp);
 }
 
+/*
+ * Handle Based Interface:
+ *
+ *	For callers issuing many commands to the same device(s), spt_open()
+ * creates a handle with its' own device information, so the device stays
+ * open and its' capacity and Inquiry data are retrieved only once. Each
+ * spt_exec() then executes one command, the same as an interactive spt
+ * command line, so options specified persist for later commands.
+ *
+ *	Different handles may be used concurrently from multiple threads,
+ * while commands to the same handle are serialized by the handle lock.
+ */
+struct spt_handle {
+    pthread_mutex_t sh_lock;		/* Serializes handle commands.	*/
+    pthread_mutex_t sh_output_lock;	/* Serializes output callbacks.	*/
+    scsi_device_t   *sh_sdp;		/* The handle device information*/
+    unsigned long   sh_commands;	/* Number of commands executed.	*/
+};
+
+/*
+ * spt_open() - Open a device and create a handle for spt_exec().
+ *
+ * Inputs:
+ *	dsf = The device special file (required).
+ *	options = Options applied to all commands. (optional)
+ *
+ * Return Value:
+ *	Returns the handle or NULL if the device could not be opened.
+ */
+spt_handle_t *
+spt_open(char *dsf, char *options)
+{
+    spt_handle_t *shp;
+    scsi_device_t *sdp;
+    io_params_t *iop;
+    scsi_generic_t *sgp;
+    int status = SUCCESS;
+
+    if ( (dsf == NULL) || (*dsf == '\0') ) return(NULL);
+    (void)pthread_once(&spt_library_once, spt_library_init);
+    if (master_sdp == NULL) return(NULL);
+
+    shp = Malloc(master_sdp, sizeof(*shp));
+    if (shp == NULL) return(NULL);
+    if (pthread_mutex_init(&shp->sh_lock, NULL) != SUCCESS) {
+	free(shp);
+	return(NULL);
+    }
+    if (pthread_mutex_init(&shp->sh_output_lock, NULL) != SUCCESS) {
+	(void)pthread_mutex_destroy(&shp->sh_lock);
+	free(shp);
+	return(NULL);
+    }
+    shp->sh_sdp = sdp = init_device_information();
+    if (sdp == NULL) {
+	spt_close(shp);
+	return(NULL);
+    }
+    init_device_defaults(sdp);
+    sdp->shared_library = True;
+    sdp->retain_device_info = True;
+    sdp->master_sdp = sdp;
+    sdp->cmd_interrupted = &sdp->interrupted_flag;
+    sdp->output_lock = &shp->sh_output_lock;
+    sdp->output_format = JSON_FMT;
+    sdp->emit_status = strdup(emit_status_default_json);
+    sdp->log_prefix = strdup("");
+    sdp->cmdbufsiz = ARGS_BUFFER_SIZE;
+    sdp->cmdbufptr = Malloc(sdp, sdp->cmdbufsiz);
+    sdp->argv = (char **)Malloc(sdp,  (sizeof(char **) * ARGV_BUFFER_SIZE) );
+    if ( (sdp->cmdbufptr == NULL) || (sdp->argv == NULL) ) {
+	spt_close(shp);
+	return(NULL);
+    }
+    iop = &sdp->io_params[IO_INDEX_BASE];
+    sgp = &iop->sg;
+    sgp->dsf = strdup(dsf);
+    if (options && *options) {
+	if (strlen(options) >= sdp->cmdbufsiz) {
+	    spt_close(shp);
+	    return(NULL);
+	}
+	strcpy(sdp->cmdbufptr, options);
+	sdp->argc = MakeArgList(sdp, sdp->argv, sdp->cmdbufptr);
+	status = parse_args(sdp, sdp->argc, sdp->argv);
+    }
+    if ( (status != SUCCESS) || (open_devices(sdp) != SUCCESS) ) {
+	spt_close(shp);
+	return(NULL);
+    }
+    /* Retrieve Inquiry and capacity once, reused by all commands. */
+    if ( (iop->sip == NULL) && (get_scsi_information(sdp, iop) != SUCCESS) ) {
+	free_scsi_information(iop);
+    }
+    return(shp);
+}
+
+/*
+ * execute_handle() - Execute one command for spt_exec() and spt_exec_result().
+ *
+ * Note: The callers' buffers are optional, output without a buffer is discarded.
+ */
+static int
+execute_handle(spt_handle_t *shp, char *stdin_buffer, spt_result_t *srp,
+	       spt_output_func_t output_func, void *output_arg,
+	       char *stderr_buffer, int stderr_length,
+	       char *stdout_buffer, int stdout_length,
+	       char *emit_status_buffer, int emit_status_length)
+{
+    scsi_device_t *sdp;
+    size_t length;
+    int status;
+
+    if (stderr_buffer) {
+	*stderr_buffer = '\0';
+    }
+    if (stdout_buffer) {
+	*stdout_buffer = '\0';
+    }
+    if (emit_status_buffer) {
+	*emit_status_buffer = '\0';
+    }
+    if (srp) {
+	memset(srp, '\0', sizeof(*srp));
+    }
+    if (pthread_mutex_lock(&shp->sh_lock) != SUCCESS) {
+	return(FAILURE);
+    }
+    sdp = shp->sh_sdp;
+    length = strlen(stdin_buffer);
+    if (length >= sdp->cmdbufsiz) {
+	char *cmdbufptr = Malloc(sdp, length + 1);
+	if (cmdbufptr == NULL) {
+	    (void)pthread_mutex_unlock(&shp->sh_lock);
+	    return(FAILURE);
+	}
+	Free(sdp, sdp->cmdbufptr);
+	sdp->cmdbufptr = cmdbufptr;
+	sdp->cmdbufsiz = length + 1;
+    }
+    sdp->stderr_buffer = sdp->stderr_bufptr = stderr_buffer;
+    sdp->stdout_buffer = sdp->stdout_bufptr = stdout_buffer;
+    sdp->emit_status_buffer = sdp->emit_status_bufptr = emit_status_buffer;
+    /* Note: -1 for NULL byte! */
+    sdp->stderr_length = (stderr_buffer) ? stderr_length : 0;
+    sdp->stderr_remaining = (stderr_buffer) ? stderr_length - 1 : 0;
+    sdp->stdout_length = (stdout_buffer) ? stdout_length : 0;
+    sdp->stdout_remaining = (stdout_buffer) ? stdout_length - 1 : 0;
+    sdp->emit_status_length = (emit_status_buffer) ? emit_status_length : 0;
+    sdp->emit_status_remaining = (emit_status_buffer) ? emit_status_length - 1 : 0;
+    sdp->spt_result = srp;
+    sdp->output_func = output_func;
+    sdp->output_arg = output_arg;
+
+    strcpy(sdp->cmdbufptr, stdin_buffer);
+    sdp->argc = MakeArgList(sdp, sdp->argv, sdp->cmdbufptr);
+    status = main_loop(sdp);
+    shp->sh_commands++;
+
+    /* Note: Async jobs check the master buffers with the print lock held. */
+    (void)acquire_print_lock();
+    sdp->stderr_buffer = sdp->stderr_bufptr = NULL;
+    sdp->stdout_buffer = sdp->stdout_bufptr = NULL;
+    sdp->emit_status_buffer = sdp->emit_status_bufptr = NULL;
+    sdp->stderr_length = sdp->stderr_remaining = 0;
+    sdp->stdout_length = sdp->stdout_remaining = 0;
+    sdp->emit_status_length = sdp->emit_status_remaining = 0;
+    sdp->spt_result = NULL;
+    (void)release_print_lock();
+    (void)pthread_mutex_lock(sdp->output_lock);
+    sdp->output_func = NULL;
+    sdp->output_arg = NULL;
+    (void)pthread_mutex_unlock(sdp->output_lock);
+    (void)pthread_mutex_unlock(&shp->sh_lock);
+    if (srp) {
+	srp->sr_status = status;
+    }
+    return(status);
+}
+
+/*
+ * spt_exec() - Execute an spt command using an open handle.
+ *
+ * Inputs:
+ *	shp = The handle from spt_open().
+ *      stdin_buffer = The input buffer (spt command line).
+ *      (remaining parameters are the same as spt() above)
+ *
+ * Return Value:
+ * 	Returns 0 / 1 / -1 = Success / Warning / Failure
+ */
+int
+spt_exec(spt_handle_t *shp, char *stdin_buffer,
+	 char *stderr_buffer, int stderr_length,
+	 char *stdout_buffer, int stdout_length,
+	 char *emit_status_buffer, int emit_status_length)
+{
+    if ( (shp == NULL) || (stdin_buffer == NULL) ||
+	 (stderr_buffer == NULL) || (stderr_length == 0) ||
+	 (stdout_buffer == NULL) || (stdout_length == 0) ) {
+	return(FAILURE);
+    }
+    if (emit_status_buffer && (emit_status_length == 0)) {
+	return(FAILURE);
+    }
+    return( execute_handle(shp, stdin_buffer, NULL, NULL, NULL,
+			   stderr_buffer, stderr_length,
+			   stdout_buffer, stdout_length,
+			   emit_status_buffer, emit_status_length) );
+}
+
+/*
+ * spt_exec_result() - Execute an spt command returning a binary result.
+ *
+ * Description:
+ *	This avoids formatting and parsing text for each command. The
+ * status, sense information, and data-in are returned in the result.
+ * Data is only decoded (as JSON) when a stdout buffer is specified.
+ *
+ * Inputs:
+ *	shp = The handle from spt_open().
+ *      stdin_buffer = The input buffer (spt command line).
+ *	srp = The callers' result structure.
+ *      stdout_buffer = The output buffer. (optional)
+ *      stdout_length = The output buffer length.
+ *
+ * Return Value:
+ * 	Returns 0 / 1 / -1 = Success / Warning / Failure
+ */
+int
+spt_exec_result(spt_handle_t *shp, char *stdin_buffer, spt_result_t *srp,
+		char *stdout_buffer, int stdout_length)
+{
+    if ( (shp == NULL) || (stdin_buffer == NULL) || (srp == NULL) ) {
+	return(FAILURE);
+    }
+    if (stdout_buffer && (stdout_length == 0)) {
+	return(FAILURE);
+    }
+    return( execute_handle(shp, stdin_buffer, srp, NULL, NULL,
+			   NULL, 0, stdout_buffer, stdout_length, NULL, 0) );
+}
+
+/*
+ * spt_exec_stream() - Execute an spt command streaming output to a function.
+ *
+ * Description:
+ *	Rather than truncating output at the end of fixed size buffers, each
+ * chunk of stdout, stderr, and emit status text is passed to the callers'
+ * function as it's produced. Calls are serialized for each handle, but may
+ * come from spt's threads, so the function should not block for long.
+ *
+ * Inputs:
+ *	shp = The handle from spt_open().
+ *      stdin_buffer = The input buffer (spt command line).
+ *	output_func = The callers' output function.
+ *	output_arg = The argument passed to the output function.
+ *
+ * Return Value:
+ * 	Returns 0 / 1 / -1 = Success / Warning / Failure
+ */
+int
+spt_exec_stream(spt_handle_t *shp, char *stdin_buffer,
+		spt_output_func_t output_func, void *output_arg)
+{
+    if ( (shp == NULL) || (stdin_buffer == NULL) || (output_func == NULL) ) {
+	return(FAILURE);
+    }
+    return( execute_handle(shp, stdin_buffer, NULL, output_func, output_arg,
+			   NULL, 0, NULL, 0, NULL, 0) );
+}
+
+/*
+ * spt_close() - Close the handle devices and free its' resources.
+ */
+void
+spt_close(spt_handle_t *shp)
+{
+    scsi_device_t *sdp;
+
+    if (shp == NULL) return;
+    (void)pthread_mutex_lock(&shp->sh_lock);
+    if ( (sdp = shp->sh_sdp) ) {
+	(void)close_devices(sdp, IO_INDEX_BASE);
+	sdp->master_sdp = NULL;
+	cleanup_devices(sdp, False);
+	if (sdp->cmdbufptr) {
+	    Free(sdp, sdp->cmdbufptr);
+	    sdp->cmdbufptr = NULL;
+	}
+	if (sdp->argv) {
+	    Free(sdp, sdp->argv);
+	    sdp->argv = NULL;
+	}
+	if (sdp->result_data) {
+	    Free(sdp, sdp->result_data);
+	    sdp->result_data = NULL;
+	}
+	free(sdp);
+	shp->sh_sdp = NULL;
+    }
+    (void)pthread_mutex_unlock(&shp->sh_lock);
+    (void)pthread_mutex_destroy(&shp->sh_lock);
+    (void)pthread_mutex_destroy(&shp->sh_output_lock);
+    free(shp);
+    return;
+}
+
 #endif /* defined(SHARED_LIBRARY) */
 
 int
@@ -1350,6 +1898,7 @@ spt_main(int argc, char **argv, scsi_device_t *msdp)
 
     (void)initialize_print_lock(sdp);
     (void)initialize_jobs_data(sdp);
+    (void)initialize_emulator(sdp);
 
     return ( main_loop(sdp) );
 }
@@ -1366,6 +1915,7 @@ main_loop(scsi_device_t *sdp)
     scsi_generic_t 	*tsgp;
     io_params_t		*tiop;
     int         	thread;
+    hbool_t		slices_from_threads;
     int			pstatus, status = SUCCESS;
 
     /*
@@ -1373,9 +1923,12 @@ main_loop(scsi_device_t *sdp)
      */
     do {
 	init_device_defaults(sdp);
-        CmdInterruptedFlag = False;
+        CmdInterrupted(sdp) = False;
 
-	if (FirstTime || sdp->shared_library) {
+	/* Note: The library does not touch FirstTime, since handles run concurrently. */
+	if (sdp->shared_library == True) {
+	    ;	/* Parse command line options first! */
+	} else if (FirstTime) {
 	    /* Parse command line options first! */
 	    FirstTime = False;
 	} else {
@@ -1397,7 +1950,8 @@ main_loop(scsi_device_t *sdp)
 	 * Parse the arguments.
 	 */
 	if ( (pstatus = parse_args(sdp, sdp->argc, sdp->argv)) != SUCCESS) {
-	    HandleExit(sdp, pstatus);
+	    /* Note: The library returns this status, since there's no exit! */
+	    status = HandleExit(sdp, pstatus);
 	    continue;
 	}
 
@@ -1429,9 +1983,19 @@ main_loop(scsi_device_t *sdp)
 	    HandleExit(sdp, status);
 	    continue;
 	}
+	if (sdp->op_type == ANALYZE_TRACE_OP) {
+	    status = analyze_traces(sdp);
+	    HandleExit(sdp, status);
+	    continue;
+	}
+	if (sdp->op_type == BENCHMARK_OP) {
+	    status = run_benchmarks(sdp);
+	    HandleExit(sdp, status);
+	    continue;
+	}
 	if (sgp->dsf == NULL) {
 	    Wprintf(sdp, "Please specify a device special file via dsf= option!\n");
-	    HandleExit(sdp, WARNING);
+	    status = HandleExit(sdp, WARNING);
 	    continue;
 	}
 
@@ -1439,7 +2003,7 @@ main_loop(scsi_device_t *sdp)
 	     ( (sdp->ses_element_flag == False) ||
 	       (sdp->ses_element_type == ELEMENT_TYPE_UNINITIALIZED) ) ) {
 	    Wprintf(sdp, "Please specify an element index and element type!\n");
-	    HandleExit(sdp, WARNING);
+	    status = HandleExit(sdp, WARNING);
 	    continue;
 	}
 
@@ -1479,7 +2043,7 @@ main_loop(scsi_device_t *sdp)
 		    continue;
 		} else {
 		    Wprintf(sdp, "Please specify an operation to perform!\n");
-		    (void)HandleExit(sdp, WARNING);
+		    status = HandleExit(sdp, WARNING);
 		    continue;
 		}
 		break;
@@ -1516,11 +2080,14 @@ main_loop(scsi_device_t *sdp)
 		    status = pstatus;
 		    continue;
 		}
+		if (sdp->replay_file) {
+		    sdp->thread_func = &a_replay;
+		}
 		break;
 
 	    default:
 		Eprintf(sdp, "Unsupported operation type %d!\n", sdp->op_type);
-		(void)HandleExit(sdp, FAILURE);
+		status = HandleExit(sdp, FAILURE);
 		continue;
 	}
 
@@ -1544,6 +2111,26 @@ main_loop(scsi_device_t *sdp)
 	    }
 	}
 
+	/*
+	 * The CRC manifest may set the verify range, so open before slices.
+	 */
+	status = create_crc_manifest(sdp);
+	if (status != SUCCESS) {
+	    (void)HandleExit(sdp, FAILURE);
+	    continue;
+	}
+
+	/*
+	 * Get LBA Status with multiple threads scans the LUN via slices.
+	 */
+	slices_from_threads = False;
+	if ( (sdp->op_type == SCSI_CDB_OP) && sdp->encode_flag && is_get_lba_status(sgp) ) {
+	    if ( (sdp->slices == 0) && (sdp->threads > 1) ) {
+		sdp->slices = sdp->threads;
+		slices_from_threads = True;
+	    }
+	}
+
 	if (sdp->slices && sdp->encode_flag) {
 	    status = initialize_slices(sdp);
 	    if (status != SUCCESS) {
@@ -1559,7 +2146,7 @@ main_loop(scsi_device_t *sdp)
 	    if (sdp->slice_number) {
         	sdp->threads = 1;
 	    } else {
-		if (sdp->threads > 1) {
+		if ( (sdp->threads > 1) && (slices_from_threads == False) ) {
 		    Wprintf(sdp, "The slices option (%u) overrides the threads (%d) specified!\n",
 			    sdp->slices, sdp->threads);
 		}
@@ -1567,11 +2154,35 @@ main_loop(scsi_device_t *sdp)
 	    }
 	}
 
+	status = create_lba_status_map(sdp);
+	if (status != SUCCESS) {
+	    (void)HandleExit(sdp, FAILURE);
+	    continue;
+	}
+	status = create_caw_contention(sdp);
+	if (status != SUCCESS) {
+	    (void)HandleExit(sdp, FAILURE);
+	    continue;
+	}
+	status = create_inject_data(sdp);
+	if (status != SUCCESS) {
+	    (void)HandleExit(sdp, FAILURE);
+	    continue;
+	}
+	if (sdp->crc_manifest) {
+	    sdp->crc_manifest->cm_references = sdp->threads;
+	}
+
+	/* Binary result callers decode data themselves, unless output is requested. */
+	if (sdp->spt_result && (sdp->stdout_buffer == NULL) && (sdp->output_func == NULL)) {
+	    sdp->decode_flag = False;
+	}
+
 	/*
 	 * Ok, execute the command via thread(s), and wait for their results.
 	 */
 	sdp->threads_active = 0;
-	sdp->job_id = jobid++;	/* Note: Temporary, until full job control! */
+	sdp->job_id = get_next_job_id(sdp); /* Note: Temporary, until full job control! */
 	/* Here we allocate an array of device structures to index. */
 	/* Note: dt allocates an array of pointers for cloned devices. */
 	sds = (scsi_device_t *)Malloc(sdp, (sizeof(*sdp) * sdp->threads) );
@@ -1662,12 +2273,15 @@ main_loop(scsi_device_t *sdp)
 
     } while ( (InteractiveFlag || PipeModeFlag || sdp->script_level) && (ExitFlag == False) );
 
-    if (sgp->sense_data) {
-	free_palign(sdp, sgp->sense_data);
-	sgp->sense_data = NULL;
+    /* Handles keep their devices open until spt_close(). */
+    if (sdp->retain_device_info == False) {
+	if (sgp->sense_data) {
+	    free_palign(sdp, sgp->sense_data);
+	    sgp->sense_data = NULL;
+	}
+	/* May already be closed, if not, let OS close things down! */
+	(void)close_devices(sdp, IO_INDEX_BASE);
     }
-    /* May already be closed, if not, let OS close things down! */
-    (void)close_devices(sdp, IO_INDEX_BASE);
     /*
      * Jobs may be active if run async (background) and not waited on!
      */ 
@@ -1752,12 +2366,23 @@ a_cdb(void *arg)
     if (sdp->iot_pattern) {
 	sdp->iot_seed_per_pass = sdp->iot_seed;
     }
+    if (sdp->caw_contention) {
+	sdp->status = caw_contention_setup(sdp);
+	if (sdp->status == FAILURE) goto finish;
+    }
 
     /*
      * Execute the SCSI command for repeat or runtime.
      */
     do {
 top:
+	/*
+	 * Compare and Write contention issues its' own CDB's for each cycle.
+	 */
+	if (sdp->caw_contention) {
+	    sdp->status = caw_contention_cycle(sdp);
+	    goto cycle_complete;
+	}
 	/*
 	 * Do encoding of CDB or paramater data, if enabled and supported.
 	 */ 
@@ -1771,6 +2396,9 @@ top:
 		     (iop->sop->data_dir == scsi_data_write) ) {
 		    /* Note: iterations is bumped after the continue below! */
 		    sdp->iot_seed_per_pass = (uint32_t)(sdp->iot_seed * (sdp->iterations + 2));
+		} else if ( sdp->rnd_pattern && sdp->unique_pattern &&
+			    (iop->sop->data_dir == scsi_data_write) ) {
+		    sdp->rnd_pass++;
 		}
 		continue;
 	    } else if (sdp->status == FAILURE) {
@@ -1782,10 +2410,25 @@ top:
 	    }
 	}
 	/*
-	 * Execute the SCSI command.
+	 * Interleave protection information with the data (as required).
 	 */
-	status = sdp->status = ExecuteCdb(sdp, sgp);
-	if (status == RESTART) continue;
+	if (iop->pi_protect) {
+	    sdp->status = pi_prepare_data(sdp, iop);
+	    if (sdp->status == FAILURE) {
+		if (do_post_processing(sdp, sdp->status) != CONTINUE) {
+		    goto finish;
+		}
+		continue;
+	    }
+	}
+	/*
+	 * Execute the SCSI command.
+	 */
+	status = sdp->status = ExecuteCdb(sdp, sgp);
+	if (iop->pi_protect) {
+	    status = sdp->status = pi_complete_data(sdp, iop, status);
+	}
+	if (status == RESTART) continue;
 	if (status == SUCCESS) {
 	    if (iop->cdb_blocks) {
 		iop->blocks_transferred = iop->cdb_blocks;
@@ -1794,6 +2437,12 @@ top:
 	    }
 	    iop->total_blocks += iop->blocks_transferred;
 	    iop->total_transferred += sgp->data_transferred;
+	    if (sdp->first_write_flag) {
+		thin_write_complete(sdp, iop);
+	    }
+	    if (sdp->crc_manifest) {
+		status = sdp->status = crc_manifest_complete(sdp, iop);
+	    }
 	}
 
 	if (sdp->tci.check_status) {
@@ -1895,6 +2544,11 @@ top:
 		    sdp->status = VerifyBuffers(sdp, sgp->data_buffer, sdp->pin_buffer,
 						min(sdp->pin_length,sgp->data_transferred));
 		    if (sdp->status == FAILURE) break;
+		} else if ( sdp->compare_data && sdp->rnd_pattern && sdp->encode_flag &&
+			    (sgp->data_dir == scsi_data_read) ) {
+		    sdp->status = verify_rnddata(sdp, iop, sgp->data_buffer, (uint32_t)sgp->data_transferred,
+						 iop->current_lba, sdp->rnd_seed, sdp->rnd_pass);
+		    if (sdp->status == FAILURE) break;
 		} else if (sdp->compare_data && sdp->pattern_buffer) {
 		    sdp->status = VerifyBuffers(sdp, sgp->data_buffer,
 						sdp->pattern_buffer, sgp->data_transferred);
@@ -1921,6 +2575,7 @@ top:
 		}
 	    }
 	}
+cycle_complete:
 	if (sdp->emit_all) {
 	    EmitStatus(sdp, sdp->emit_status, True);
 	}
@@ -1958,13 +2613,14 @@ top:
 	    }
 	    goto top;
 	}
-    } while ( (CmdInterruptedFlag == False)			&&
-	      (++sdp->iterations < sdp->repeat_count)		||
+    } while ( ( (CmdInterrupted(sdp) == False)			&&
+		(++sdp->iterations < sdp->repeat_count) )		||
 	      (iop->block_limit && (iop->end_of_data == False))	||
 	      (sdp->runtime < 0)				||
 	      (sdp->runtime && (time(&sdp->loop_time) < sdp->end_time)) );
 
 finish:
+    caw_contention_finish(sdp);
     sdp->end_ticks = times(&end_times);
     sdp->end_time = time((time_t *) 0);
     if (sdp->data_fd) {
@@ -1979,6 +2635,76 @@ finish:
     return(NULL);
 }
 
+/*
+ * a_replay() - Trace replay thread.
+ *
+ * Description:
+ *	Each thread replays its' own trace file, so the original command
+ * concurrency is reproduced by specifying the same number of threads.
+ */
+void *
+a_replay(void *arg)
+{
+    scsi_device_t *sdp = arg;
+    io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
+    scsi_generic_t *sgp = &iop->sg;
+    struct tms end_times;
+
+    sdp->status = do_common_thread_startup(sdp);
+    if (sdp->status == FAILURE) goto finish;
+
+    /* Generally only true for async threads (or Windows). */
+    if (sgp->fd == INVALID_HANDLE_VALUE) {
+	/* Open all devices (as necessary). */
+	if ( (sdp->status = open_devices(sdp)) == FAILURE) {
+	    goto finish;
+	}
+    }
+
+    sdp->start_time = time((time_t *) 0);
+    if (sdp->runtime > 0) {
+	sdp->end_time = (sdp->start_time + sdp->runtime);
+    }
+    sdp->start_ticks = times(&end_times);
+
+    sdp->status = create_cmd_replay(sdp);
+    if (sdp->status == FAILURE) goto finish;
+
+    /*
+     * Replay the trace for repeat or runtime (passes).
+     */
+    do {
+	sdp->status = replay_cmd_trace(sdp);
+	if (sdp->status == END_OF_DATA) {
+	    sdp->status = SUCCESS;
+	    sdp->iterations++;
+	} else if (do_post_processing(sdp, sdp->status) != CONTINUE) {
+	    break;
+	}
+	if (sdp->keepalive_time && sdp->keepalive) {
+	    time_t current_time = time((time_t *) 0);
+	    if ( (current_time - sdp->last_keepalive) >= sdp->keepalive_time) {
+		EmitStatus(sdp, sdp->keepalive, True);
+		sdp->last_keepalive = current_time;
+	    }
+	}
+    } while ( !CmdInterrupted(sdp)					&&
+	      ( (sdp->iterations < sdp->repeat_count)		||
+		(sdp->runtime < 0)				||
+		(sdp->runtime && (time(&sdp->loop_time) < sdp->end_time)) ) );
+
+finish:
+    release_cmd_replay(sdp);
+    sdp->end_ticks = times(&end_times);
+    sdp->end_time = time((time_t *) 0);
+    (void)close_devices(sdp, IO_INDEX_BASE);
+    if ( (PipeModeFlag == False) && (sdp->emit_all == False) ) {
+	EmitStatus(sdp, sdp->emit_status, True);
+    }
+    pthread_exit(sdp);
+    return(NULL);
+}
+
 void *
 a_tmf(void *arg)
 {
@@ -2034,7 +2760,7 @@ a_tmf(void *arg)
 	if (do_post_processing(sdp, sdp->status) != CONTINUE) {
 	    break;
 	}
-    } while ( !CmdInterruptedFlag				&&
+    } while ( !CmdInterrupted(sdp)				&&
 	      (++sdp->iterations < sdp->repeat_count)		||
 	      (sdp->runtime < 0)				||
 	      (sdp->runtime && (time(&sdp->loop_time) < sdp->end_time)) );
@@ -2222,6 +2948,27 @@ process_output_file(scsi_device_t *sdp)
     return (WARNING);
 }
 
+/*
+ * execute_device_cdb() - Execute a CDB on the emulated or real device.
+ *
+ * Inputs:
+ *  sdp = The device information pointer.
+ *  iop = The I/O parameters.
+ *  sgp = Pointer to SCSI generic pointer.
+ *
+ * Return Value:
+ *      Returns the OS pass-through status (0/-1).
+ */
+int
+execute_device_cdb(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp)
+{
+    if (iop->emu_device) {
+	return( emu_execute_cdb(sdp, iop->emu_device, sgp) );
+    } else {
+	return( os_spt(sgp) );
+    }
+}
+
 /*
  * ExecuteCdb() = Execute a SCSI Command Descriptor Block (CDB).
  *
@@ -2238,6 +2985,7 @@ ExecuteCdb(scsi_device_t *sdp, scsi_generic_t *sgp)
     tool_specific_t *tsp = sgp->tsp;
     io_params_t *iop = (tsp) ? (io_params_t *)tsp->params : NULL;
     hbool_t retriable;
+    uint64_t start_usecs;
     int error;
 
     if (iop == NULL) {
@@ -2248,6 +2996,7 @@ ExecuteCdb(scsi_device_t *sdp, scsi_generic_t *sgp)
     }
 
     sgp->recovery_retries = 0;
+    start_usecs = get_usecs();
     do {
 	retriable = False;
 	/*
@@ -2261,9 +3010,13 @@ ExecuteCdb(scsi_device_t *sdp, scsi_generic_t *sgp)
 	/*
 	 * Call OS dependent SCSI Pass-Through (spt) function.
 	 */
-	error = os_spt(sgp);
+	if (sdp->inject_thread) {
+	    error = inject_execute_cdb(sdp, iop, sgp);
+	} else {
+	    error = execute_device_cdb(sdp, iop, sgp);
+	}
 	if (iop) iop->operations++;
-	if ( !CmdInterruptedFlag &&
+	if ( !CmdInterrupted(sdp) &&
 	     ((error == FAILURE) || (sgp->error == True)) && sgp->recovery_flag) {
 	    if (sgp->recovery_retries == sgp->recovery_limit) {
 		Eprintf(sdp, "Exceeded retry limit (%u) for this request!\n", sgp->recovery_limit);
@@ -2289,6 +3042,16 @@ ExecuteCdb(scsi_device_t *sdp, scsi_generic_t *sgp)
 	    }
 	}
     } while (retriable == True);
+    if (iop) iop->cmd_latency = (get_usecs() - start_usecs);
+    if (sdp->cmd_trace) {
+	record_cmd_trace(sdp, iop, sgp, start_usecs, error);
+    }
+    if (sdp->workload_stats) {
+	record_workload_stats(sdp, iop, sgp, error);
+    }
+    if (sdp->inject_thread) {
+	record_inject_stats(sdp, iop, sgp, error);
+    }
    
     if (error == FAILURE) {		/* The system call failed! */
         if (sgp->errlog == True) {
@@ -2408,6 +3171,451 @@ check_expected_status(scsi_device_t *sdp, hbool_t report)
     return (expected_found);
 }
 
+/*
+ * Option Keywords:
+ *
+ * Note: The options are in parse_args() order, which decides the option
+ * used when more than one keyword matches, e.g. "bench_file=" vs. "bench".
+ * New keywords must be added to the enum and to a sorted table below!
+ */
+typedef enum parse_option {
+    OPT_NONE,
+    OPT_BG,
+    OPT_AMPERSAND,
+    OPT_CDB,
+    OPT_CDBSIZE,
+    OPT_DIN,
+    OPT_DOUT,
+    OPT_DSF,
+    OPT_DST,
+    OPT_DSF1,
+    OPT_SRC,
+    OPT_LEN,
+    OPT_LENGTH,
+    OPT_DIR,
+    OPT_ABORTS,
+    OPT_ABORT_TIMEOUT,
+    OPT_DLIMIT,
+    OPT_MAX,
+    OPT_MIN,
+    OPT_INCR,
+    OPT_EMIT,
+    OPT_EXP,
+    OPT_EXPECT,
+    OPT_EXP_RADIX,
+    OPT_ENABLE,
+    OPT_DISABLE,
+    OPT_IOTPASS,
+    OPT_IOTSEED,
+    OPT_COMPRESS,
+    OPT_DEDUPE,
+    OPT_DEDUPE_UNIT,
+    OPT_DRSEED,
+    OPT_RNDPASS,
+    OPT_RNDSEED,
+    OPT_BOFF,
+    OPT_DATESEP,
+    OPT_TIMESEP,
+    OPT_DFMT,
+    OPT_OFMT,
+    OPT_OUTPUT_FORMAT,
+    OPT_RFMT,
+    OPT_REPORT_FORMAT,
+    OPT_KEEPALIVE,
+    OPT_KEEPALIVET,
+    OPT_ONERR,
+    OPT_OP,
+    OPT_COPYPARAMS,
+    OPT_GETLBASTATUS,
+    OPT_INQUIRY,
+    OPT_LOGSENSE,
+    OPT_ZEROLOG,
+    OPT_READCAPACITY10,
+    OPT_READCAPACITY16,
+    OPT_REQUESTSENSE,
+    OPT_RTPG,
+    OPT_RCVDIAG,
+    OPT_SENDDIAG,
+    OPT_SHOWHELP,
+    OPT_READ10,
+    OPT_READ16,
+    OPT_READ32,
+    OPT_VERIFY10,
+    OPT_VERIFY16,
+    OPT_WRITE10,
+    OPT_WRITE16,
+    OPT_WRITE32,
+    OPT_WRITESAME10,
+    OPT_WRITESAME16,
+    OPT_UNMAP,
+    OPT_XCOPY,
+    OPT_WUT,
+    OPT_ODX,
+    OPT_ZEROROD,
+    OPT_ELEMENT,
+    OPT_ELEMENT_INDEX,
+    OPT_ETCODE,
+    OPT_ELEMENT_TCODE,
+    OPT_ESCODE,
+    OPT_ELEMENT_SCODE,
+    OPT_ETYPE,
+    OPT_ELEMENT_TYPE,
+    OPT_ESTATUS,
+    OPT_ELEMENT_STATUS,
+    OPT_SES,
+    OPT_PAGE,
+    OPT_PATH,
+    OPT_PATTERN,
+    OPT_PTYPE,
+    OPT_PIN,
+    OPT_POUT,
+    OPT_QTAG,
+    OPT_IOMODE,
+    OPT_READTYPE,
+    OPT_READLEN,
+    OPT_READLENGTH,
+    OPT_WRITETYPE,
+    OPT_WRITELEN,
+    OPT_WRITELENGTH,
+    OPT_RANGES,
+    OPT_REPEAT,
+    OPT_PASSES,
+    OPT_RECOVERY_DELAY,
+    OPT_RECOVERY_RETRIES,
+    OPT_RETRY,
+    OPT_RUNTIME,
+    OPT_SCRIPT,
+    OPT_WORKLOAD,
+    OPT_SEGMENTS,
+    OPT_STATUS,
+    OPT_SCSI_STATUS,
+    OPT_SKEY,
+    OPT_SENSE_KEY,
+    OPT_ASC,
+    OPT_ASQ,
+    OPT_RESID,
+    OPT_TRANSFER,
+    OPT_SNAME,
+    OPT_SLEEP,
+    OPT_MSLEEP,
+    OPT_USLEEP,
+    OPT_SLICES,
+    OPT_SLICE,
+    OPT_TEST,
+    OPT_THREADS,
+    OPT_TIMEOUT,
+    OPT_LISTID,
+    OPT_SLISTID,
+    OPT_ROD_TIMEOUT,
+    OPT_UNPACK,
+    OPT_UNPACK_FMT,
+    OPT_EXIT,
+    OPT_QUIT,
+    OPT_HELP,
+    OPT_SHOWOPCODES,
+    OPT_ANALYZE,
+    OPT_BENCH_FILE,
+    OPT_BENCH_THRESHOLD,
+    OPT_BASELINE,
+    OPT_BENCH,
+    OPT_SHOW,
+    OPT_EVAL,
+    OPT_SYSTEM,
+    OPT_SHELL,
+    OPT_BANG,
+    OPT_VERSION,
+    OPT_BLOCKS,
+    OPT_BS,
+    OPT_CAW_LOCKS,
+    OPT_CAPACITY,
+    OPT_CAPACITYP,
+    OPT_LIMIT,
+    OPT_LOG,
+    OPT_LOGPREFIX,
+    OPT_LBA,
+    OPT_LBAMAP,
+    OPT_MANIFEST,
+    OPT_PITYPE,
+    OPT_RDPROTECT,
+    OPT_WRPROTECT,
+    OPT_APPTAG,
+    OPT_APPMASK,
+    OPT_REFTAG,
+    OPT_REPLAY,
+    OPT_REPLAY_SCALE,
+    OPT_INJECT,
+    OPT_INJECT_LATENCY,
+    OPT_TRACE,
+    OPT_TRACE_RECORDS,
+    OPT_MAXBAD,
+    OPT_STEP,
+    OPT_STARTING,
+    OPT_ENDING,
+    OPT_ROD_TOKEN,
+    OPT_JOBS,
+    OPT_TAG,
+    OPT_WAIT,
+    OPT_SETENV
+} parse_option_t;
+
+typedef struct option_keyword {
+    char		*ok_keyword;	/* The option keyword.		*/
+    size_t		ok_length;	/* The keyword length.		*/
+    parse_option_t	ok_option;	/* The option identifier.	*/
+} option_keyword_t;
+
+#define OPTION(keyword, option)	{ keyword, (sizeof(keyword) - 1), option }
+
+/*
+ * Keywords with a value, such as "dsf=" (sorted for binary search).
+ */
+static option_keyword_t option_keywords[] = {
+    OPTION("abort_timeout=",		OPT_ABORT_TIMEOUT),
+    OPTION("aborts=",			OPT_ABORTS),
+    OPTION("appmask=",			OPT_APPMASK),
+    OPTION("apptag=",			OPT_APPTAG),
+    OPTION("asc=",			OPT_ASC),
+    OPTION("asq=",			OPT_ASQ),
+    OPTION("baseline=",			OPT_BASELINE),
+    OPTION("bench_file=",		OPT_BENCH_FILE),
+    OPTION("bench_threshold=",		OPT_BENCH_THRESHOLD),
+    OPTION("blocks=",			OPT_BLOCKS),
+    OPTION("boff=",			OPT_BOFF),
+    OPTION("bs=",			OPT_BS),
+    OPTION("capacity=",			OPT_CAPACITY),
+    OPTION("capacityp=",		OPT_CAPACITYP),
+    OPTION("caw_locks=",		OPT_CAW_LOCKS),
+    OPTION("cdb=",			OPT_CDB),
+    OPTION("cdbsize=",			OPT_CDBSIZE),
+    OPTION("compress=",			OPT_COMPRESS),
+    OPTION("datesep=",			OPT_DATESEP),
+    OPTION("dedupe=",			OPT_DEDUPE),
+    OPTION("dedupe_unit=",		OPT_DEDUPE_UNIT),
+    OPTION("dfmt=",			OPT_DFMT),
+    OPTION("din=",			OPT_DIN),
+    OPTION("dir=",			OPT_DIR),
+    OPTION("disable=",			OPT_DISABLE),
+    OPTION("dlimit=",			OPT_DLIMIT),
+    OPTION("dout=",			OPT_DOUT),
+    OPTION("drseed=",			OPT_DRSEED),
+    OPTION("dsf1=",			OPT_DSF1),
+    OPTION("dsf=",			OPT_DSF),
+    OPTION("dst=",			OPT_DST),
+    OPTION("element=",			OPT_ELEMENT),
+    OPTION("element_index=",		OPT_ELEMENT_INDEX),
+    OPTION("element_scode=",		OPT_ELEMENT_SCODE),
+    OPTION("element_status=",		OPT_ELEMENT_STATUS),
+    OPTION("element_tcode=",		OPT_ELEMENT_TCODE),
+    OPTION("element_type=",		OPT_ELEMENT_TYPE),
+    OPTION("emit=",			OPT_EMIT),
+    OPTION("enable=",			OPT_ENABLE),
+    OPTION("ending=",			OPT_ENDING),
+    OPTION("escode=",			OPT_ESCODE),
+    OPTION("estatus=",			OPT_ESTATUS),
+    OPTION("etcode=",			OPT_ETCODE),
+    OPTION("etype=",			OPT_ETYPE),
+    OPTION("exp=",			OPT_EXP),
+    OPTION("exp_radix=",		OPT_EXP_RADIX),
+    OPTION("expect=",			OPT_EXPECT),
+    OPTION("incr=",			OPT_INCR),
+    OPTION("inject=",			OPT_INJECT),
+    OPTION("inject_latency=",		OPT_INJECT_LATENCY),
+    OPTION("iomode=",			OPT_IOMODE),
+    OPTION("iotpass=",			OPT_IOTPASS),
+    OPTION("iotseed=",			OPT_IOTSEED),
+    OPTION("keepalive=",		OPT_KEEPALIVE),
+    OPTION("keepalivet=",		OPT_KEEPALIVET),
+    OPTION("lba=",			OPT_LBA),
+    OPTION("lbamap=",			OPT_LBAMAP),
+    OPTION("len=",			OPT_LEN),
+    OPTION("length=",			OPT_LENGTH),
+    OPTION("limit=",			OPT_LIMIT),
+    OPTION("listid=",			OPT_LISTID),
+    OPTION("log=",			OPT_LOG),
+    OPTION("logprefix=",		OPT_LOGPREFIX),
+    OPTION("manifest=",			OPT_MANIFEST),
+    OPTION("max=",			OPT_MAX),
+    OPTION("maxbad=",			OPT_MAXBAD),
+    OPTION("min=",			OPT_MIN),
+    OPTION("msleep=",			OPT_MSLEEP),
+    OPTION("ofmt=",			OPT_OFMT),
+    OPTION("onerr=",			OPT_ONERR),
+    OPTION("op=",			OPT_OP),
+    OPTION("output-format=",		OPT_OUTPUT_FORMAT),
+    OPTION("page=",			OPT_PAGE),
+    OPTION("passes=",			OPT_PASSES),
+    OPTION("path=",			OPT_PATH),
+    OPTION("pattern=",			OPT_PATTERN),
+    OPTION("pin=",			OPT_PIN),
+    OPTION("pitype=",			OPT_PITYPE),
+    OPTION("pout=",			OPT_POUT),
+    OPTION("ptype=",			OPT_PTYPE),
+    OPTION("qtag=",			OPT_QTAG),
+    OPTION("ranges=",			OPT_RANGES),
+    OPTION("rdprotect=",		OPT_RDPROTECT),
+    OPTION("readlen=",			OPT_READLEN),
+    OPTION("readlength=",		OPT_READLENGTH),
+    OPTION("readtype=",			OPT_READTYPE),
+    OPTION("recovery_delay=",		OPT_RECOVERY_DELAY),
+    OPTION("recovery_retries=",		OPT_RECOVERY_RETRIES),
+    OPTION("reftag=",			OPT_REFTAG),
+    OPTION("repeat=",			OPT_REPEAT),
+    OPTION("replay=",			OPT_REPLAY),
+    OPTION("replay_scale=",		OPT_REPLAY_SCALE),
+    OPTION("report-format=",		OPT_REPORT_FORMAT),
+    OPTION("resid=",			OPT_RESID),
+    OPTION("retry=",			OPT_RETRY),
+    OPTION("rfmt=",			OPT_RFMT),
+    OPTION("rndpass=",			OPT_RNDPASS),
+    OPTION("rndseed=",			OPT_RNDSEED),
+    OPTION("rod_timeout=",		OPT_ROD_TIMEOUT),
+    OPTION("rod_token=",		OPT_ROD_TOKEN),
+    OPTION("runtime=",			OPT_RUNTIME),
+    OPTION("script=",			OPT_SCRIPT),
+    OPTION("scsi_status=",		OPT_SCSI_STATUS),
+    OPTION("segments=",			OPT_SEGMENTS),
+    OPTION("sense_key=",		OPT_SENSE_KEY),
+    OPTION("skey=",			OPT_SKEY),
+    OPTION("sleep=",			OPT_SLEEP),
+    OPTION("slice=",			OPT_SLICE),
+    OPTION("slices=",			OPT_SLICES),
+    OPTION("slistid=",			OPT_SLISTID),
+    OPTION("sname=",			OPT_SNAME),
+    OPTION("src=",			OPT_SRC),
+    OPTION("starting=",			OPT_STARTING),
+    OPTION("status=",			OPT_STATUS),
+    OPTION("step=",			OPT_STEP),
+    OPTION("tag=",			OPT_TAG),
+    OPTION("threads=",			OPT_THREADS),
+    OPTION("timeout=",			OPT_TIMEOUT),
+    OPTION("timesep=",			OPT_TIMESEP),
+    OPTION("trace=",			OPT_TRACE),
+    OPTION("trace_records=",		OPT_TRACE_RECORDS),
+    OPTION("transfer=",			OPT_TRANSFER),
+    OPTION("unpack=",			OPT_UNPACK),
+    OPTION("unpack_fmt=",		OPT_UNPACK_FMT),
+    OPTION("usleep=",			OPT_USLEEP),
+    OPTION("workload=",			OPT_WORKLOAD),
+    OPTION("writelen=",			OPT_WRITELEN),
+    OPTION("writelength=",		OPT_WRITELENGTH),
+    OPTION("writetype=",		OPT_WRITETYPE),
+    OPTION("wrprotect=",		OPT_WRPROTECT),
+};
+static int option_keywords_entries = (sizeof(option_keywords) / sizeof(option_keyword_t));
+
+/*
+ * Keywords without a value, which match as a prefix, such as "jobs:full" (sorted).
+ */
+static option_keyword_t option_prefixes[] = {
+    OPTION("!",				OPT_BANG),
+    OPTION("$",				OPT_SETENV),
+    OPTION("&",				OPT_AMPERSAND),
+    OPTION("analyze",			OPT_ANALYZE),
+    OPTION("bench",			OPT_BENCH),
+    OPTION("bg",			OPT_BG),
+    OPTION("copyparams",		OPT_COPYPARAMS),
+    OPTION("eval",			OPT_EVAL),
+    OPTION("exit",			OPT_EXIT),
+    OPTION("getlbastatus",		OPT_GETLBASTATUS),
+    OPTION("help",			OPT_HELP),
+    OPTION("inquiry",			OPT_INQUIRY),
+    OPTION("jobs",			OPT_JOBS),
+    OPTION("logsense",			OPT_LOGSENSE),
+    OPTION("odx",			OPT_ODX),
+    OPTION("quit",			OPT_QUIT),
+    OPTION("rcvdiag",			OPT_RCVDIAG),
+    OPTION("read10",			OPT_READ10),
+    OPTION("read16",			OPT_READ16),
+    OPTION("read32",			OPT_READ32),
+    OPTION("readcapacity10",		OPT_READCAPACITY10),
+    OPTION("readcapacity16",		OPT_READCAPACITY16),
+    OPTION("requestsense",		OPT_REQUESTSENSE),
+    OPTION("rtpg",			OPT_RTPG),
+    OPTION("senddiag",			OPT_SENDDIAG),
+    OPTION("ses",			OPT_SES),
+    OPTION("shell",			OPT_SHELL),
+    OPTION("show",			OPT_SHOW),
+    OPTION("showhelp",			OPT_SHOWHELP),
+    OPTION("showopcodes",		OPT_SHOWOPCODES),
+    OPTION("system",			OPT_SYSTEM),
+    OPTION("test",			OPT_TEST),
+    OPTION("unmap",			OPT_UNMAP),
+    OPTION("verify10",			OPT_VERIFY10),
+    OPTION("verify16",			OPT_VERIFY16),
+    OPTION("version",			OPT_VERSION),
+    OPTION("wait",			OPT_WAIT),
+    OPTION("write10",			OPT_WRITE10),
+    OPTION("write16",			OPT_WRITE16),
+    OPTION("write32",			OPT_WRITE32),
+    OPTION("writesame10",		OPT_WRITESAME10),
+    OPTION("writesame16",		OPT_WRITESAME16),
+    OPTION("wut",			OPT_WUT),
+    OPTION("xcopy",			OPT_XCOPY),
+    OPTION("zerolog",			OPT_ZEROLOG),
+    OPTION("zerorod",			OPT_ZEROROD),
+};
+static int option_prefixes_entries = (sizeof(option_prefixes) / sizeof(option_keyword_t));
+
+/*
+ * find_option() - Find the Option for a Program Argument.
+ *
+ * Description:
+ *	Keywords with a value are found with a binary search, using the text
+ * up to and including the '=', rather than calling match() for each option.
+ * The few keywords without a value are compared when the first character
+ * matches. If both tables match, the lower option wins, so the results are
+ * the same as checking each keyword with match() in parse_args() order.
+ *
+ * Inputs:
+ *	sptr = Pointer to the argument string pointer.
+ *
+ * Outputs:
+ *	sptr = Points past the keyword (on match).
+ *
+ * Return Value:
+ *	Returns the option found or OPT_NONE.
+ */
+static parse_option_t
+find_option(char **sptr)
+{
+    char *string = *sptr, *p;
+    option_keyword_t *okp, *found = NULL;
+    int lower, middle, upper, result;
+
+    if ( (p = strchr(string, '=')) ) {
+	size_t length = (p - string + 1);
+	lower = 0;
+	upper = (option_keywords_entries - 1);
+	while (lower <= upper) {
+	    middle = ((lower + upper) / 2);
+	    okp = &option_keywords[middle];
+	    /* Note: Both strings end with the first '=', so lengths match! */
+	    result = strncmp(string, okp->ok_keyword, length);
+	    if (result == 0) {
+		found = okp;
+		break;
+	    } else if (result < 0) {
+		upper = (middle - 1);
+	    } else {
+		lower = (middle + 1);
+	    }
+	}
+    }
+    for (okp = option_prefixes; okp < &option_prefixes[option_prefixes_entries]; okp++) {
+	if (okp->ok_keyword[0] < string[0]) continue;
+	if (okp->ok_keyword[0] > string[0]) break;
+	if ( (strncmp(string, okp->ok_keyword, okp->ok_length) == 0) &&
+	     ( (found == NULL) || (okp->ok_option < found->ok_option) ) ) {
+	    found = okp;
+	}
+    }
+    if (found == NULL) {
+	return(OPT_NONE);
+    }
+    *sptr = (string + found->ok_length);
+    return(found->ok_option);
+}
+
 /*
  * parse_args() - Parse 'spt Program Arguments.
  *
@@ -2419,7 +3627,7 @@ check_expected_status(scsi_device_t *sdp, hbool_t report)
  * Return Value;
  *	Returns Success/Failure = Parsed Ok/Parse Error.
  */
-static int
+int
 parse_args(scsi_device_t *sdp, int argc, char **argv)
 {
     io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
@@ -2437,1584 +3645,1841 @@ parse_args(scsi_device_t *sdp, int argc, char **argv)
      */
     for (i = 0; i < argc; i++) {
         string = argv[i];
-	if ( match(&string, "bg") || match(&string, "&") ) {
-	    sdp->async = True;
-	    sdp->verbose = False;
-	    continue;
-	}
-        if (match (&string, "cdb=")) {
-	    uint32_t value;
-            char *str, *token, *saveptr;
-	    char *sep = " ";
-	    if (strchr(string, ',')) {
-		sep = ",";
-	    }
-	    sgp->cdb_size = 0;
-	    str = strdup(string);
-            token = strtok_r(str, sep, &saveptr);
-            while (token != NULL) {
-		value = number(sdp, token, HEX_RADIX, &status, False);
-		if (value > 0xFF) {
-		    Eprintf(sdp, "CDB byte value %#x is too large!\n", value);
-		    Free(sdp, str);
-		    return ( HandleExit(sdp, FATAL_ERROR) );
+	switch (find_option(&string)) {
+	    
+	    case OPT_BG:
+	    case OPT_AMPERSAND: {
+		sdp->async = True;
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_CDB: {
+		uint32_t value;
+		char *str, *token, *saveptr;
+		char *sep = " ";
+		if (strchr(string, ',')) {
+		    sep = ",";
 		}
-                sgp->cdb[sgp->cdb_size++] = (uint8_t)value;
-                token = strtok_r(NULL, sep, &saveptr);
-                if (sgp->cdb_size >= MAX_CDB) {
-                    Eprintf(sdp, "Maximum CDB size is %d bytes!\n", MAX_CDB);
-		    Free(sdp, str);
-		    return ( HandleExit(sdp, FATAL_ERROR) );
-                }
-            }
-	    Free(sdp, str);
-	    sdp->op_type = SCSI_CDB_OP;
-	    /*
-	     * Note: Disabled for fear of breaking existing scripts! (negative testing) 
-	     *  
-	     * This cannot be enabled without the side effect of forcing the direction 
-	     * and data length to be required for where encode functions set these! 
-	     * Therefore, this code MUST stay disabled. Inquiry is an example.
-	     */ 
+		sgp->cdb_size = 0;
+		str = strdup(string);
+		token = strtok_r(str, sep, &saveptr);
+		while (token != NULL) {
+		    value = number(sdp, token, HEX_RADIX, &status, False);
+		    if (value > 0xFF) {
+			Eprintf(sdp, "CDB byte value %#x is too large!\n", value);
+			Free(sdp, str);
+			return ( HandleExit(sdp, FATAL_ERROR) );
+		    }
+		    sgp->cdb[sgp->cdb_size++] = (uint8_t)value;
+		    token = strtok_r(NULL, sep, &saveptr);
+		    if (sgp->cdb_size >= MAX_CDB) {
+			Eprintf(sdp, "Maximum CDB size is %d bytes!\n", MAX_CDB);
+			Free(sdp, str);
+			return ( HandleExit(sdp, FATAL_ERROR) );
+		    }
+		}
+		Free(sdp, str);
+		sdp->op_type = SCSI_CDB_OP;
+		/*
+		 * Note: Disabled for fear of breaking existing scripts! (negative testing) 
+		 *  
+		 * This cannot be enabled without the side effect of forcing the direction 
+		 * and data length to be required for where encode functions set these! 
+		 * Therefore, this code MUST stay disabled. Inquiry is an example.
+		 */ 
 #if 0
-	    /* Setup the CDB size and direction, if known. */
-	    if (sdp->bypass == False) {
+		/* Setup the CDB size and direction, if known. */
+		if (sdp->bypass == False) {
+		    if (sgp->cdb_size == 0) {
+			sgp->cdb_size = GetCdbLength(sgp->cdb[0]);
+		    }
+		    iop->sop = ScsiOpcodeEntry(sgp->cdb, iop->device_type);
+		    if (iop->sop && (sgp->data_dir != iop->sop->data_dir) ) {
+			sgp->data_dir = iop->sop->data_dir;
+		    }
+		}
+#endif
+		continue;
+	    }
+	    /* An option to help with negative testing! */
+	    case OPT_CDBSIZE: {
+		sgp->cdb_size = number(sdp, string, ANY_RADIX, &status, False);
 		if (sgp->cdb_size == 0) {
 		    sgp->cdb_size = GetCdbLength(sgp->cdb[0]);
 		}
-		iop->sop = ScsiOpcodeEntry(sgp->cdb, iop->device_type);
-		if (iop->sop && (sgp->data_dir != iop->sop->data_dir) ) {
-		    sgp->data_dir = iop->sop->data_dir;
+		if (sgp->cdb_size >= MAX_CDB) {
+		    Eprintf(sdp, "Maximum CDB size is %d bytes!\n", MAX_CDB);
+		    return ( HandleExit(sdp, FATAL_ERROR) );
 		}
+		iop->user_cdb_size = True;
+		continue;
 	    }
-#endif
-	    continue;
-	}
-	/* An option to help with negative testing! */
-        if (match (&string, "cdbsize=")) {
-            sgp->cdb_size = number(sdp, string, ANY_RADIX, &status, False);
-	    if (sgp->cdb_size == 0) {
-		sgp->cdb_size = GetCdbLength(sgp->cdb[0]);
-	    }
-	    if (sgp->cdb_size >= MAX_CDB) {
-		Eprintf(sdp, "Maximum CDB size is %d bytes!\n", MAX_CDB);
-		return ( HandleExit(sdp, FATAL_ERROR) );
-	    }
-	    iop->user_cdb_size = True;
-	    continue;
-	}
-        if (match (&string, "din=")) {
-	    if (sdp->din_file) free(sdp->din_file);
-            sdp->din_file = strdup(string);
-            continue;
-        }
-        if (match (&string, "dout=")) {
-	    if (sdp->dout_file) free(sdp->dout_file);
-            sdp->dout_file = strdup(string);
-            continue;
-        }
-        if ( match(&string, "dsf=") || match(&string, "dst=") ) {
-	    /* Switch to base (destination) device. */
-	    siop = iop;	ssgp = sgp;
-	    if (sgp->fd != INVALID_HANDLE_VALUE) {
-		(void)os_close_device(sgp);
-	    }
-	    if (sgp->dsf) {
-		free(sgp->dsf);
-		sgp->dsf = NULL;
-	    }
-	    if ( !strlen(string) ) continue;
-            sgp->dsf = strdup(string);
-	    iop->device_capacity = 0;
-            continue;
-        }
-	if ( match(&string, "dsf1=") || match(&string, "src=") ) {
-	    if (sdp->io_devices == MAX_DEVICES) {
-                Eprintf(sdp, "The maximum devices of %d exceeded!\n", sdp->io_devices);
-		return ( HandleExit(sdp, FATAL_ERROR) );
-	    }
-	    siop = &sdp->io_params[sdp->io_devices];
-	    ssgp = &siop->sg;
-	    if (ssgp->fd != INVALID_HANDLE_VALUE) {
-		(void)os_close_device(ssgp);
-	    }
-	    if (ssgp->dsf) {
-		free(ssgp->dsf);
-		ssgp->dsf = NULL;
+	    case OPT_DIN: {
+		if (sdp->din_file) free(sdp->din_file);
+		sdp->din_file = strdup(string);
+		continue;
 	    }
-	    if ( !strlen(string) ) continue;
-	    ssgp->dsf = strdup(string);
-	    siop->device_capacity = 0;
-	    sdp->encode_flag = True;
-	    sdp->io_devices++;
-	    continue;
-	}
-        if ( match(&string, "len=") || match(&string, "length=") ) {
-            sgp->data_length = number(sdp, string, ANY_RADIX, &status, False);
-            continue;
-        }
-        if (match (&string, "dir=")) {
-            if (match (&string, "none")) {
-                sgp->data_dir = scsi_data_none;
-            } else if (match (&string, "read")) {
-                sgp->data_dir = scsi_data_read;
-            } else if (match (&string, "write")) {
-                sgp->data_dir = scsi_data_write;
-            } else {
-                Eprintf(sdp, "Valid I/O directions are: 'none', 'read' or 'write'.\n");
-		return ( HandleExit(sdp, FATAL_ERROR) );
-            }
-            continue;
-        }
-	if (match (&string, "aborts=")) {
-	    sdp->abort_freq = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "abort_timeout=")) {
-	    sdp->abort_timeout = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "dlimit=")) {
-	    sdp->dump_limit = number(sdp, string, ANY_RADIX, &status, False);
-	    sgp->data_dump_limit = sdp->dump_limit;
-	    continue;
-	}
-	if (match (&string, "max=")) {
-	    iop->user_max = True;
-	    iop->max_size = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "min=")) {
-	    iop->user_min = True;
-	    iop->min_size = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "incr=")) {
-	    iop->user_increment = True;
-	    if (match (&string, "var")) {
-		sdp->random_seed = os_create_random_seed();
-		init_genrand64(sdp->random_seed);
-		iop->incr_variable = True;
-	    } else {
-		iop->incr_variable = False;
-		iop->incr_size = number(sdp, string, ANY_RADIX, &status, False);
+	    case OPT_DOUT: {
+		if (sdp->dout_file) free(sdp->dout_file);
+		sdp->dout_file = strdup(string);
+		continue;
 	    }
-	    continue;
-	}
-	if (match (&string, "emit=")) {
-	    if (sdp->emit_status) free(sdp->emit_status);
-	    if (match (&string, "default")) {
-		if (sdp->output_format == JSON_FMT) {
-		    sdp->emit_status = strdup(emit_status_default_json);
-		} else {
-		    sdp->emit_status = strdup(emit_status_default);
+	    case OPT_DSF:
+	    case OPT_DST: {
+		/* Switch to base (destination) device. */
+		siop = iop;	ssgp = sgp;
+		if (sgp->fd != INVALID_HANDLE_VALUE) {
+		    (void)os_close_device(sgp);
 		}
-	    } else if (match (&string, "multi")) {
-		if (sdp->output_format == JSON_FMT) {
-		    sdp->emit_status = strdup(emit_status_multiple_json);
-		} else {
-		    sdp->emit_status = strdup(emit_status_multiple);
+		if (sgp->dsf) {
+		    free(sgp->dsf);
+		    sgp->dsf = NULL;
 		}
-	    } else {
-		sdp->emit_status = strdup(string);
+		free_scsi_information(iop);
+		if ( !strlen(string) ) continue;
+		sgp->dsf = strdup(string);
+		iop->device_capacity = 0;
+		continue;
 	    }
-	    continue;
-	}
-	if (match (&string, "exp=") || match (&string, "expect=")) {
-	    if (parse_exp_data(string, sdp) != SUCCESS) {
-		return ( HandleExit(sdp, FATAL_ERROR) );
+	    case OPT_DSF1:
+	    case OPT_SRC: {
+		if (sdp->io_devices == MAX_DEVICES) {
+		    Eprintf(sdp, "The maximum devices of %d exceeded!\n", sdp->io_devices);
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		siop = &sdp->io_params[sdp->io_devices];
+		ssgp = &siop->sg;
+		if (ssgp->fd != INVALID_HANDLE_VALUE) {
+		    (void)os_close_device(ssgp);
+		}
+		if (ssgp->dsf) {
+		    free(ssgp->dsf);
+		    ssgp->dsf = NULL;
+		}
+		if ( !strlen(string) ) continue;
+		ssgp->dsf = strdup(string);
+		siop->device_capacity = 0;
+		sdp->encode_flag = True;
+		sdp->io_devices++;
+		continue;
 	    }
-	    continue;
-	}
-	if (match (&string, "exp_radix=")) {
-	    if (match (&string,  "any")) {
-		sdp->exp_radix = ANY_RADIX;
-	    } else if (match (&string,  "dec")) {
-		sdp->exp_radix = DEC_RADIX;
-	    } else if (match (&string,  "hex")) {
-		sdp->exp_radix = HEX_RADIX;
-	    } else {
-		Eprintf(sdp, "Unsupported radix specified '%s', valid radix is: any, dec, or hex\n", string);
-		return ( HandleExit(sdp, FATAL_ERROR) );
+	    case OPT_LEN:
+	    case OPT_LENGTH: {
+		sgp->data_length = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    continue;
-	}
-        if (match (&string, "enable=")) {
-eloop:
-            if (match(&string, ",")) {
-                goto eloop;
+	    case OPT_DIR: {
+		if (match (&string, "none")) {
+		    sgp->data_dir = scsi_data_none;
+		} else if (match (&string, "read")) {
+		    sgp->data_dir = scsi_data_read;
+		} else if (match (&string, "write")) {
+		    sgp->data_dir = scsi_data_write;
+		} else {
+		    Eprintf(sdp, "Valid I/O directions are: 'none', 'read' or 'write'.\n");
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
 	    }
-            if (*string == '\0') {
-                continue;
+	    case OPT_ABORTS: {
+		sdp->abort_freq = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-            if (match(&string, "adapter")) {
-		sgp->flags = SG_ADAPTER;
-                goto eloop;
-            }
-            if (match(&string, "async")) {
-                sdp->async = True;
-		sdp->verbose = False;
-                goto eloop;
-            }
-	    if (match(&string, "bypass")) {
-		sdp->bypass = True;
-		goto eloop;
+	    case OPT_ABORT_TIMEOUT: {
+		sdp->abort_timeout = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    if (match(&string, "compare")) {
-		sdp->compare_data = True;
-		goto eloop;
+	    case OPT_DLIMIT: {
+		sdp->dump_limit = number(sdp, string, ANY_RADIX, &status, False);
+		sgp->data_dump_limit = sdp->dump_limit;
+		continue;
 	    }
-	    if (match(&string, "image")) {
-		sdp->image_copy = True;
-		goto eloop;
+	    case OPT_MAX: {
+		iop->user_max = True;
+		iop->max_size = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-            if (match(&string, "debug")) {
-                sgp->debug = True;
-                goto eloop;
-            }
-            if (match(&string, "Debug")) {
-                DebugFlag = sdp->DebugFlag = True;
-                goto eloop;
-            }
-            if (match(&string, "expandvars")) {
-                ExpandVars = True;
-                goto eloop;
-            }
-            if (match(&string, "jdebug")) {
-                sdp->jDebugFlag = True;
-                goto eloop;
-            }
-            if (match(&string, "mdebug")) {
-                mDebugFlag = True;
-                goto eloop;
-            }
-            if (match(&string, "xdebug")) {
-                sdp->xDebugFlag = True;
-                goto eloop;
-            }
-            if (match(&string, "decode")) {
-                sdp->decode_flag = True;
-                goto eloop;
-            }
-            if (match(&string, "dopen")) {
-                sgp->dopen = True;
-                goto eloop;
-            }
-            if (match(&string, "emit_all")) {
-                sdp->emit_all = True;
-                goto eloop;
-            }
-            if (match(&string, "encode")) {
-                sdp->encode_flag = True;
-                goto eloop;
-            }
-            if (match(&string, "errors")) {
-                sgp->errlog = True;
-                goto eloop;
-            }
-            if (match(&string, "genspt")) {
-                sdp->genspt_flag = True;
-                goto eloop;
-            }
-            if (match(&string, "header")) {
-                sdp->log_header_flag = True;
-                goto eloop;
-            }
-            if (match(&string, "show_caching")) {
-                sdp->show_caching_flag = True;
-                goto eloop;
-            }
-	    if (match(&string, "show_header")) {
-		sdp->show_header_flag = True;
-		goto eloop;
+	    case OPT_MIN: {
+		iop->user_min = True;
+		iop->min_size = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-            if (match(&string, "json_pretty")) {
-                sdp->json_pretty = True;
-                goto eloop;
-            }
-            if (match(&string, "mapscsi")) {
-                sgp->mapscsi = True;
-                goto eloop;
-            }
-            if (match(&string, "multi")) {
-                PipeModeFlag = False;
-		InteractiveFlag = True;
-                goto eloop;
-            }
-            if (match(&string, "pipes")) {
-                PipeModeFlag = True;
-		InteractiveFlag = False;
-		if (sdp->emit_status == NULL) {
-		    sdp->emit_status = strdup(pipe_emit);
+	    case OPT_INCR: {
+		iop->user_increment = True;
+		if (match (&string, "var")) {
+		    sdp->random_seed = os_create_random_seed();
+		    init_genrand64(sdp->random_seed);
+		    iop->incr_variable = True;
+		} else {
+		    iop->incr_variable = False;
+		    iop->incr_size = number(sdp, string, ANY_RADIX, &status, False);
 		}
-                goto eloop;
-            }
-	    if (match(&string, "prewrite")) {
-		sdp->prewrite_flag = True;
-		goto eloop;
+		continue;
 	    }
-	    if (match(&string, "recovery")) {
-		sdp->recovery_flag = True;
-		goto eloop;
+	    case OPT_EMIT: {
+		if (sdp->emit_status) free(sdp->emit_status);
+		if (match (&string, "default")) {
+		    if (sdp->output_format == JSON_FMT) {
+			sdp->emit_status = strdup(emit_status_default_json);
+		    } else {
+			sdp->emit_status = strdup(emit_status_default);
+		    }
+		} else if (match (&string, "multi")) {
+		    if (sdp->output_format == JSON_FMT) {
+			sdp->emit_status = strdup(emit_status_multiple_json);
+		    } else {
+			sdp->emit_status = strdup(emit_status_multiple);
+		    }
+		} else {
+		    sdp->emit_status = strdup(string);
+		}
+		continue;
 	    }
-	    if ( match(&string, "raw") || match(&string, "read_after_write") || match(&string, "read_immed") ) {
-		sdp->read_after_write = True;
-		goto eloop;
+	    case OPT_EXP:
+	    case OPT_EXPECT: {
+		if (parse_exp_data(string, sdp) != SUCCESS) {
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
 	    }
-	    if (match(&string, "scriptverify")) {
-		sdp->script_verify = True;
-		goto eloop;
+	    case OPT_EXP_RADIX: {
+		if (match (&string,  "any")) {
+		    sdp->exp_radix = ANY_RADIX;
+		} else if (match (&string,  "dec")) {
+		    sdp->exp_radix = DEC_RADIX;
+		} else if (match (&string,  "hex")) {
+		    sdp->exp_radix = HEX_RADIX;
+		} else {
+		    Eprintf(sdp, "Unsupported radix specified '%s', valid radix is: any, dec, or hex\n", string);
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
 	    }
-	    if (match(&string, "sata")) {
-		sdp->sata_device_flag = True;
-		goto eloop;
+	    case OPT_ENABLE: {
+eloop:
+		if (match(&string, ",")) {
+		    goto eloop;
+		}
+		if (*string == '\0') {
+		    continue;
+		}
+		if (match(&string, "adapter")) {
+		    sgp->flags = SG_ADAPTER;
+		    goto eloop;
+		}
+		if (match(&string, "async")) {
+		    sdp->async = True;
+		    sdp->verbose = False;
+		    goto eloop;
+		}
+		if (match(&string, "bypass")) {
+		    sdp->bypass = True;
+		    goto eloop;
+		}
+		if (match(&string, "compare")) {
+		    sdp->compare_data = True;
+		    goto eloop;
+		}
+		if (match(&string, "image")) {
+		    sdp->image_copy = True;
+		    goto eloop;
+		}
+		if (match(&string, "debug")) {
+		    sgp->debug = True;
+		    goto eloop;
+		}
+		if (match(&string, "Debug")) {
+		    DebugFlag = sdp->DebugFlag = True;
+		    goto eloop;
+		}
+		if (match(&string, "expandvars")) {
+		    ExpandVars = True;
+		    goto eloop;
+		}
+		if (match(&string, "jdebug")) {
+		    sdp->jDebugFlag = True;
+		    goto eloop;
+		}
+		if (match(&string, "mdebug")) {
+		    mDebugFlag = True;
+		    goto eloop;
+		}
+		if (match(&string, "xdebug")) {
+		    sdp->xDebugFlag = True;
+		    goto eloop;
+		}
+		if (match(&string, "decode")) {
+		    sdp->decode_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "dopen")) {
+		    sgp->dopen = True;
+		    goto eloop;
+		}
+		if (match(&string, "emit_all")) {
+		    sdp->emit_all = True;
+		    goto eloop;
+		}
+		if (match(&string, "encode")) {
+		    sdp->encode_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "errors")) {
+		    sgp->errlog = True;
+		    goto eloop;
+		}
+		if (match(&string, "genspt")) {
+		    sdp->genspt_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "header")) {
+		    sdp->log_header_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "show_caching")) {
+		    sdp->show_caching_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "show_header")) {
+		    sdp->show_header_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "json_pretty")) {
+		    sdp->json_pretty = True;
+		    goto eloop;
+		}
+		if (match(&string, "mapscsi")) {
+		    sgp->mapscsi = True;
+		    goto eloop;
+		}
+		if (match(&string, "multi")) {
+		    PipeModeFlag = False;
+		    InteractiveFlag = True;
+		    goto eloop;
+		}
+		if (match(&string, "pipes")) {
+		    PipeModeFlag = True;
+		    InteractiveFlag = False;
+		    if (sdp->emit_status == NULL) {
+			sdp->emit_status = strdup(pipe_emit);
+		    }
+		    goto eloop;
+		}
+		if (match(&string, "prewrite")) {
+		    sdp->prewrite_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "recovery")) {
+		    sdp->recovery_flag = True;
+		    goto eloop;
+		}
+		if ( match(&string, "raw") || match(&string, "read_after_write") || match(&string, "read_immed") ) {
+		    sdp->read_after_write = True;
+		    goto eloop;
+		}
+		if (match(&string, "scriptverify")) {
+		    sdp->script_verify = True;
+		    goto eloop;
+		}
+		if (match(&string, "sata")) {
+		    sdp->sata_device_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "scsi")) {
+		    sdp->scsi_info_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "sense")) {
+		    sdp->sense_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "firstwrite")) {
+		    sdp->first_write_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "bytchk")) {
+		    sdp->verify_offload = True;
+		    goto eloop;
+		}
+		if (match(&string, "sparse")) {
+		    sdp->sparse_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "unique")) {
+		    sdp->unique_pattern = True;
+		    goto eloop;
+		}
+		if (match(&string, "verbose")) {
+		    sdp->verbose = True;
+		    goto eloop;
+		}
+		if (match(&string, "verify")) {
+		    sdp->verify_data = True;
+		    goto eloop;
+		}
+		if (match(&string, "warnings")) {
+		    sdp->warnings_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "wait")) {
+		    sdp->tci.wait_for_status = True;
+		    goto eloop;
+		}
+		if (match(&string, "rrtiwut")) {
+		    sdp->rrti_wut_flag = True;
+		    goto eloop;
+		}
+		if (match(&string, "zerorod")) {
+		    sdp->zero_rod_flag = True;
+		    goto eloop;
+		}
+		Eprintf(sdp, "Invalid enable keyword: %s\n", string);
+		return ( HandleExit(sdp, FATAL_ERROR) );
+	    }
+	    case OPT_DISABLE: {
+dloop:
+		if (match(&string, ",")) {
+		    goto dloop;
+		}
+		if (*string == '\0') {
+		    continue;
+		}
+		if (match(&string, "adapter")) {
+		    sgp->flags = 0;
+		    goto dloop;
+		}
+		if (match(&string, "async")) {
+		    sdp->async = False;
+		    goto dloop;
+		}
+		if (match(&string, "bypass")) {
+		    sdp->bypass = False;
+		    goto dloop;
+		}
+		if (match(&string, "compare")) {
+		    sdp->compare_data = False;
+		    goto dloop;
+		}
+		if (match(&string, "image")) {
+		    sdp->image_copy = False;
+		    goto dloop;
+		}
+		if (match(&string, "debug")) {
+		    sgp->debug = False;
+		    goto dloop;
+		}
+		if (match(&string, "Debug")) {
+		    DebugFlag = sdp->DebugFlag = False;
+		    goto dloop;
+		}
+		if (match(&string, "expandvars")) {
+		    ExpandVars = False;
+		    goto dloop;
+		}
+		if (match(&string, "jdebug")) {
+		    sdp->jDebugFlag = False;
+		    goto dloop;
+		}
+		if (match(&string, "mdebug")) {
+		    mDebugFlag = False;
+		    goto dloop;
+		}
+		if (match(&string, "header")) {
+		    sdp->logheader_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "show_caching")) {
+		    sdp->show_caching_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "show_header")) {
+		    sdp->show_header_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "json_pretty")) {
+		    sdp->json_pretty = False;
+		    goto dloop;
+		}
+		if (match(&string, "xdebug")) {
+		    sdp->xDebugFlag = False;
+		    goto dloop;
+		}
+		if (match(&string, "decode")) {
+		    sdp->decode_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "dopen")) {
+		    sgp->dopen = False;
+		    goto dloop;
+		}
+		if (match(&string, "emit_all")) {
+		    sdp->emit_all = False;
+		    goto dloop;
+		}
+		if (match(&string, "encode")) {
+		    sdp->encode_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "errors")) {
+		    sgp->errlog = False;
+		    goto dloop;
+		}
+		if (match(&string, "genspt")) {
+		    sdp->genspt_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "header")) {
+		    sdp->log_header_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "mapscsi")) {
+		    sgp->mapscsi = False;
+		    goto dloop;
+		}
+		if (match(&string, "multi")) {
+		    InteractiveFlag = False;
+		    goto dloop;
+		}
+		if (match(&string, "pipes")) {
+		    PipeModeFlag = False;
+		    InteractiveFlag = True;
+		    goto dloop;
+		}
+		if (match(&string, "prewrite")) {
+		    sdp->prewrite_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "recovery")) {
+		    sgp->recovery_flag = False;
+		    goto dloop;
+		}
+		if ( match(&string, "raw") || match(&string, "read_after_write") || match(&string, "read_immed") ) {
+		    sdp->read_after_write = False;
+		    goto dloop;
+		}
+		if (match(&string, "scriptverify")) {
+		    sdp->script_verify = False;
+		    goto dloop;
+		}
+		if (match(&string, "sata")) {
+		    sdp->sata_device_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "scsi")) {
+		    sdp->scsi_info_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "sense")) {
+		    sdp->sense_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "firstwrite")) {
+		    sdp->first_write_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "bytchk")) {
+		    sdp->verify_offload = False;
+		    goto dloop;
+		}
+		if (match(&string, "sparse")) {
+		    sdp->sparse_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "unique")) {
+		    sdp->unique_pattern = False;
+		    goto dloop;
+		}
+		if (match(&string, "verbose")) {
+		    sdp->verbose = False;
+		    goto dloop;
+		}
+		if (match(&string, "verify")) {
+		    sdp->verify_data = False;
+		    goto dloop;
+		}
+		if (match(&string, "warnings")) {
+		    sdp->warnings_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "wait")) {
+		    sdp->tci.wait_for_status = False;
+		    goto dloop;
+		}
+		if (match(&string, "rrtiwut")) {
+		    sdp->rrti_wut_flag = False;
+		    goto dloop;
+		}
+		if (match(&string, "zerorod")) {
+		    sdp->zero_rod_flag = False;
+		    goto dloop;
+		}
+		Eprintf(sdp, "Invalid disable keyword: %s\n", string);
+		return ( HandleExit(sdp, FATAL_ERROR) );
+	    }
+	    /*
+	     * Special options to help seed IOT pattern with multiple passes.
+	     */
+	    case OPT_IOTPASS: {
+		int iot_pass = number(sdp, string, ANY_RADIX, &status, False);
+		sdp->iot_seed *= iot_pass;
+		sdp->iot_pattern = True;
+		continue;
+	    }
+	    case OPT_IOTSEED: {
+		sdp->iot_seed = (uint32_t)number(sdp, string, HEX_RADIX, &status, False);
+		sdp->iot_pattern = True;
+		continue;
+	    }
+	    /*
+	     * Data reduction pattern options (implies ptype=reduce).
+	     */
+	    case OPT_COMPRESS: {
+		char *ratio = strchr(string, ':');
+		uint32_t percent;
+		if (ratio) {
+		    /* Ratio format, e.g. 3:1 is 67% compressible. */
+		    uint32_t original, compressed;
+		    *ratio++ = '\0';
+		    original = (uint32_t)number(sdp, string, ANY_RADIX, &status, False);
+		    compressed = (uint32_t)number(sdp, ratio, ANY_RADIX, &status, False);
+		    if ( (compressed == 0) || (original < compressed) ) {
+			Eprintf(sdp, "The compress ratio must be N:1 or higher!\n");
+			return ( HandleExit(sdp, FAILURE) );
+		    }
+		    percent = (100 - ((compressed * 100) / original));
+		} else {
+		    percent = (uint32_t)number(sdp, string, ANY_RADIX, &status, False);
+		}
+		if (percent > 99) {
+		    Eprintf(sdp, "The compress percentage range is 0-99!\n");
+		    return ( HandleExit(sdp, FAILURE) );
+		}
+		sdp->compress_percent = (uint8_t)percent;
+		sdp->dr_pattern = True;
+		sdp->user_pattern = True;
+		sdp->compare_data = True;
+		continue;
+	    }
+	    case OPT_DEDUPE: {
+		uint32_t percent = (uint32_t)number(sdp, string, ANY_RADIX, &status, False);
+		if (percent > 100) {
+		    Eprintf(sdp, "The dedupe percentage range is 0-100!\n");
+		    return ( HandleExit(sdp, FAILURE) );
+		}
+		sdp->dedupe_percent = (uint8_t)percent;
+		sdp->dr_pattern = True;
+		sdp->user_pattern = True;
+		sdp->compare_data = True;
+		continue;
+	    }
+	    case OPT_DEDUPE_UNIT: {
+		sdp->dedupe_unit = number(sdp, string, ANY_RADIX, &status, False);
+		if (sdp->dedupe_unit == 0) {
+		    Eprintf(sdp, "The dedupe unit size must be non-zero!\n");
+		    return ( HandleExit(sdp, FAILURE) );
+		}
+		sdp->dr_pattern = True;
+		sdp->user_pattern = True;
+		sdp->compare_data = True;
+		continue;
+	    }
+	    case OPT_DRSEED: {
+		sdp->dr_seed = large_number(sdp, string, ANY_RADIX, &status, False);
+		sdp->dr_pattern = True;
+		continue;
+	    }
+	    case OPT_RNDPASS: {
+		sdp->rnd_pass = (uint32_t)number(sdp, string, ANY_RADIX, &status, False);
+		sdp->rnd_pattern = True;
+		continue;
+	    }
+	    case OPT_RNDSEED: {
+		sdp->rnd_seed = large_number(sdp, string, ANY_RADIX, &status, False);
+		sdp->rnd_pattern = True;
+		continue;
+	    }
+	    case OPT_BOFF: {
+		if (match(&string, "dec")) {
+		    sdp->boff_format = DEC_FMT;
+		} else if (match (&string, "hex")) {
+		    sdp->boff_format = HEX_FMT;
+		} else {
+		    Eprintf(sdp, "Valid buffer offset formats are: dec or hex\n");
+		    return ( HandleExit(sdp, FAILURE) );
+		}
+		continue;
+	    }
+	    case OPT_DATESEP: {
+		if (sdp->date_sep) free(sdp->date_sep);
+		sdp->date_sep = strdup(string);
+		continue;
 	    }
-	    if (match(&string, "scsi")) {
-		sdp->scsi_info_flag = True;
-		goto eloop;
+	    case OPT_TIMESEP: {
+		if (sdp->time_sep) free(sdp->time_sep);
+		sdp->time_sep = strdup(string);
+		continue;
 	    }
-	    if (match(&string, "sense")) {
-		sdp->sense_flag = True;
-		goto eloop;
+	    case OPT_DFMT: {
+		if (match(&string, "byte")) {
+		    sdp->data_format = BYTE_FMT;
+		} else if (match (&string, "word")) {
+		    sdp->data_format = WORD_FMT;
+		} else {
+		    Eprintf(sdp, "Valid data formats are: byte or word\n");
+		    return ( HandleExit(sdp, FAILURE) );
+		}
+		continue;
 	    }
-	    if (match(&string, "unique")) {
-		sdp->unique_pattern = True;
-		goto eloop;
+	    case OPT_OFMT:
+	    case OPT_OUTPUT_FORMAT: {
+		if (match(&string, "ascii")) {
+		    sdp->output_format = ASCII_FMT;
+		} else if (match (&string, "json")) {
+		    sdp->output_format = JSON_FMT;
+		} else {
+		    Eprintf(sdp, "Valid data formats are: ascii or json\n");
+		    return ( HandleExit(sdp, FAILURE) );
+		}
+		if (sdp->log_prefix) {
+		    Free(sdp, sdp->log_prefix);
+		}
+		sdp->log_prefix = strdup("");
+		continue;
 	    }
-	    if (match(&string, "verbose")) {
-		sdp->verbose = True;
-		goto eloop;
+	    case OPT_RFMT:
+	    case OPT_REPORT_FORMAT: {
+		if (match(&string, "brief")) {
+		    sdp->report_format = REPORT_BRIEF;
+		} else if (match (&string, "full")) {
+		    sdp->report_format = REPORT_FULL;
+		} else if (match (&string, "none")) {
+		    sdp->report_format = REPORT_NONE;
+		} else {
+		    Eprintf(sdp, "Valid data formats are: brief or full\n");
+		    return ( HandleExit(sdp, FAILURE) );
+		}
+		continue;
 	    }
-	    if (match(&string, "verify")) {
-		sdp->verify_data = True;
-		goto eloop;
+	    case OPT_KEEPALIVE: {
+		if (sdp->keepalive) free(sdp->keepalive);
+		sdp->keepalive = strdup(string);
+		if (sdp->keepalive_time == 0) sdp->keepalive_time++;
+		continue;
 	    }
-	    if (match(&string, "warnings")) {
-		sdp->warnings_flag = True;
-		goto eloop;
+	    case OPT_KEEPALIVET: {
+		sdp->keepalive_time = time_value(sdp, string);
+		if (sdp->keepalive_time && (sdp->keepalive == NULL) ) {
+		    sdp->keepalive = strdup(keepalive);	/* Set the default! */
+		}
+		continue;
 	    }
-	    if (match(&string, "wait")) {
-		sdp->tci.wait_for_status = True;
-		goto eloop;
+	    case OPT_ONERR: {
+		if (match (&string, "continue")) {
+		    sdp->onerr = ONERR_CONTINUE;
+		} else if (match (&string, "stop")) {
+		    sdp->onerr = ONERR_STOP;
+		} else {
+		    Eprintf(sdp, "On error actions are 'continue' or 'stop'.\n");
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
 	    }
-	    if (match(&string, "rrtiwut")) {
-		sdp->rrti_wut_flag = True;
-		goto eloop;
+	    case OPT_OP: {
+		if ( match(&string, "ats") || match (&string, "abort_task_set")) {
+		    sdp->op_type = ABORT_TASK_SET_OP;
+		} else if ( match(&string, "br") || match(&string, "bus_reset") ) {
+		    sdp->op_type = BUS_RESET_OP;
+		} else if ( match(&string, "lr") || match(&string, "lun_reset") ) {
+		    sdp->op_type = LUN_RESET_OP;
+		} else if ( match(&string, "bdr") || match(&string, "target_reset") ) {
+		    sdp->op_type = TARGET_RESET_OP;
+		} else if ( match(&string, "scsi_cdb") ) {
+		    sdp->op_type = SCSI_CDB_OP;
+		} else {
+		    Eprintf(sdp, "Valid operations are: 'abort_task_set'(ats), 'bus_reset'(br), "
+			    "'lun_reset'(lr), 'target_reset'(bdr) or 'scsi_cdb'.\n");
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
+	    }
+	    /*
+	     * Start of Short Hand Commands: (ease of use, avoids specifying CDB's, etc)
+	     */
+	    case OPT_COPYPARAMS: {
+		if ( setup_receive_copy_results(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_GETLBASTATUS: {
+		if ( setup_get_lba_status(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
 	    }
-	    if (match(&string, "zerorod")) {
+	    case OPT_INQUIRY: {
+		size_t data_length = sizeof(inquiry_t);
+		uint8_t page = 0;
+		if ( setup_inquiry(sdp, sgp, data_length, page) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_LOGSENSE: {
+		size_t data_length = LOG_SENSE_LENGTH_MAX;
+		uint8_t page = 0;
+		if ( setup_log_sense(sdp, sgp, data_length, page) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_ZEROLOG: {
+		uint8_t page = 0;
+		if ( setup_zero_log(sdp, sgp, page) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_READCAPACITY10: {
+		if ( setup_read_capacity10(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_READCAPACITY16: {
+		if ( setup_read_capacity16(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_REQUESTSENSE: {
+		if ( setup_request_sense(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_RTPG: {
+		if ( setup_rtpg(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    /* Generic receive diagnostic setup. */
+	    case OPT_RCVDIAG: {
+		size_t data_length = RECEIVE_DIAGNOSTIC_MAX;
+		uint8_t page = 0;
+		if ( setup_receive_diagnostic(sdp, sgp, data_length, page) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    /* Generic send diagnostic setup. */
+	    case OPT_SENDDIAG: {
+		size_t data_length = 0;
+		uint8_t page = 0;
+		if ( setup_send_diagnostic(sdp, sgp, page) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		continue;
+	    }
+	    /* SES diagnostic page to return enclosure help text. */
+	    case OPT_SHOWHELP: {
+		size_t data_length = RECEIVE_DIAGNOSTIC_MAX;
+		if ( setup_receive_diagnostic(sdp, sgp, data_length, DIAG_HELP_TEXT_PAGE) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_READ10: {
+		if ( setup_read10(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_READ16: {
+		if ( setup_read16(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_READ32: {
+		if ( setup_read32(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_VERIFY10: {
+		if ( setup_verify10(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_VERIFY16: {
+		if ( setup_verify16(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_WRITE10: {
+		if ( setup_write10(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_WRITE16: {
+		if ( setup_write16(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_WRITE32: {
+		if ( setup_write32(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_WRITESAME10: {
+		if ( setup_write_same10(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_WRITESAME16: {
+		if ( setup_write_same16(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_UNMAP: {
+		if ( setup_unmap(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_XCOPY: {
+		if ( setup_extended_copy(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_WUT:
+	    case OPT_ODX: {
+		if ( setup_write_using_token(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
+	    }
+	    case OPT_ZEROROD: {
+		if ( setup_write_using_token(sdp, sgp) ) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
 		sdp->zero_rod_flag = True;
-		goto eloop;
+		sdp->verbose = False;
+		continue;
+	    }
+	    /* SES Parameters. */
+	    case OPT_ELEMENT:
+	    case OPT_ELEMENT_INDEX: {
+		sdp->ses_element_index = (int)number(sdp, string, ANY_RADIX, &status, False);
+		sdp->ses_element_flag = True;
+		continue;
+	    }
+	    case OPT_ETCODE:
+	    case OPT_ELEMENT_TCODE: {
+		sdp->ses_element_type = (int)number(sdp, string, ANY_RADIX, &status, False);
+		continue;
+	    }
+	    case OPT_ESCODE:
+	    case OPT_ELEMENT_SCODE: {
+		sdp->ses_element_status = (int)number(sdp, string, ANY_RADIX, &status, False);
+		continue;
+	    }
+	    case OPT_ETYPE:
+	    case OPT_ELEMENT_TYPE: {
+		int status = SUCCESS;
+		sdp->ses_element_type = find_element_type(sdp, string, &status);
+		if (status == FAILURE) {
+		    Eprintf(sdp, "Did not find element type '%s'!\n", string);
+		    return( HandleExit(sdp, status) );
+		} else if (status == WARNING) {
+		    return( HandleExit(sdp, status) );
+		}
+		continue;
 	    }
-	    Eprintf(sdp, "Invalid enable keyword: %s\n", string);
-	    return ( HandleExit(sdp, FATAL_ERROR) );
-        }
-        if (match (&string, "disable=")) {
-dloop:
-            if (match(&string, ",")) {
-                goto dloop;
+	    case OPT_ESTATUS:
+	    case OPT_ELEMENT_STATUS: {
+		int status = SUCCESS;
+		sdp->ses_element_status = find_element_status(sdp, string, &status);
+		if (status == FAILURE) {
+		    Eprintf(sdp, "Did not find element status '%s'!\n", string);
+		    return( HandleExit(sdp, status) );
+		} else if (status == WARNING) {
+		    return( HandleExit(sdp, status) );
+		}
+		continue;
 	    }
-            if (*string == '\0') {
-                continue;
+	    case OPT_SES: {
+		uint8_t page = DIAG_ENCLOSURE_CONTROL_PAGE;
+		size_t data_length = RECEIVE_DIAGNOSTIC_MAX;
+		int status;
+		if (++i < argc) {
+		    uint8_t page = DIAG_STRING_IN_OUT_PAGE;
+		    string = argv[i];
+		    status = parse_ses_args(string, sdp);
+		} else {
+		    Eprintf(sdp, "Format is: ses {clear|set}={devoff|fail/fault|ident/locate|unlock}\n");
+		    status = FAILURE;
+		}
+		if (status == FAILURE) {
+		    return( HandleExit(sdp, status) );
+		}
+		/* This will be a read-modify-write operation. */
+		if (setup_receive_diagnostic(sdp, sgp, data_length, page)) {
+		    return( HandleExit(sdp, FAILURE) );
+		}
+		sdp->verbose = False;
+		continue;
 	    }
-            if (match(&string, "adapter")) {
-		sgp->flags = 0;
-                goto dloop;
-            }
-            if (match(&string, "async")) {
-                sdp->async = False;
-                goto dloop;
-            }
-	    if (match(&string, "bypass")) {
-		sdp->bypass = False;
-		goto dloop;
+	    case OPT_PAGE: {
+		int status = SUCCESS;
+		uint8_t opcode = sgp->cdb[0];
+		sdp->page_specified = True;
+		/* Note: Overloading page={hex|string} */
+		if ( (*string == '\0') || (isHexString(string) == False) ) {
+		    if (opcode == SOPC_INQUIRY) {
+			sdp->page_code = find_inquiry_page_code(sdp, string, &status);
+			if (status == FAILURE) {
+			    Eprintf(sdp, "Did not find Inquiry page '%s'!\n", string);
+			    return( HandleExit(sdp, status) );
+			} else if (status == WARNING) {
+			    return( HandleExit(sdp, status) );
+			}
+			sdp->verbose = False;
+			continue;
+		    } else if ((opcode == SOPC_LOG_SELECT) || (opcode == SOPC_LOG_SENSE)) {
+			sdp->page_code = find_log_page_code(sdp, string, &status);
+			if (status == FAILURE) {
+			    Eprintf(sdp, "Did not find diagnostic page '%s'!\n", string);
+			    return( HandleExit(sdp, status) );
+			} else if (status == WARNING) {
+			    return( HandleExit(sdp, status) );
+			}
+			sdp->verbose = False;
+			continue;
+		    } else if ( (opcode == SOPC_RECEIVE_DIAGNOSTIC) ||
+				(opcode == SOPC_SEND_DIAGNOSTIC) ) {
+			sdp->page_code = find_diagnostic_page_code(sdp, string, &status);
+			if (status == FAILURE) {
+			    Eprintf(sdp, "Did not find diagnostic page '%s'!\n", string);
+			    return( HandleExit(sdp, status) );
+			} else if (status == WARNING) {
+			    return( HandleExit(sdp, status) );
+			}
+			sdp->verbose = False;
+			continue;
+		    }
+		}
+		sdp->page_code = (uint8_t)number(sdp, string, HEX_RADIX, &status, False);
+		sdp->verbose = False;
+		continue;
 	    }
-	    if (match(&string, "compare")) {
-		sdp->compare_data = False;
-		goto dloop;
+	    case OPT_PATH: {
+		sgp->scsi_addr.scsi_path = (int)number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    if (match(&string, "image")) {
-		sdp->image_copy = False;
-		goto dloop;
+	    case OPT_PATTERN: {
+		size_t size = strlen(string);
+		/* Note: Added this parsing to match dt and keep my sanity! */
+		if ( (size == 3) && (match(&string, "iot") || match(&string, "IOT")) ) {
+		    sdp->iot_pattern = True;
+		    sdp->verbose = False;
+		} else {
+		    sdp->pattern = number(sdp, string, HEX_RADIX, &status, False);
+		}
+		sdp->user_pattern = True;
+		sdp->compare_data = True;
+		continue;
 	    }
-            if (match(&string, "debug")) {
-                sgp->debug = False;
-                goto dloop;
-            }
-            if (match(&string, "Debug")) {
-                DebugFlag = sdp->DebugFlag = False;
-                goto dloop;
-            }
-            if (match(&string, "expandvars")) {
-                ExpandVars = False;
-                goto dloop;
-            }
-            if (match(&string, "jdebug")) {
-                sdp->jDebugFlag = False;
-                goto dloop;
-            }
-	    if (match(&string, "mdebug")) {
-		mDebugFlag = False;
-		goto dloop;
+	    case OPT_PTYPE: {
+		int size = (int)strlen(string);
+		if ((size == 3) && match (&string, "iot") || match(&string, "IOT")) {
+		    sdp->iot_pattern = True;
+		    sdp->user_pattern = True;
+		    sdp->compare_data = True;
+		    sdp->verbose = False;
+		} else if (match (&string, "reduce")) {
+		    sdp->dr_pattern = True;
+		    sdp->user_pattern = True;
+		    sdp->compare_data = True;
+		    sdp->verbose = False;
+		} else if (match (&string, "random")) {
+		    sdp->rnd_pattern = True;
+		    sdp->user_pattern = True;
+		    sdp->compare_data = True;
+		    sdp->verbose = False;
+		} else {
+		    Eprintf(sdp, "Pattern types supported include: iot|IOT, random, or reduce!\n");
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
 	    }
-	    if (match(&string, "header")) {
-		sdp->logheader_flag = False;
-		goto dloop;
+	    case OPT_PIN: {
+		uint32_t value;
+		char *str, *token, *saveptr;
+		char *pin;
+		char *sep = " ";
+		if (strchr(string, ',')) {
+		    sep = ",";
+		}
+		sgp->data_dir = scsi_data_read; /* Receiving parameter data from device. */
+		sdp->pin_buffer = malloc_palign(sdp, strlen(string), 0);
+		sdp->pin_length = 0;
+		sdp->pin_data = True;
+		sdp->compare_data = True;
+		pin = sdp->pin_buffer;
+		str = strdup(string);
+		token = strtok_r(str, sep, &saveptr);
+		while (token != NULL) {
+		    value = number(sdp, token, HEX_RADIX, &status, False);
+		    if (value > 0xFF) {
+			Eprintf(sdp, "Parameter in byte value %#x is too large!\n", value);
+			Free(sdp, str);
+			return ( HandleExit(sdp, FATAL_ERROR) );
+		    }
+		    pin[sdp->pin_length++] = (uint8_t)value;
+		    token = strtok_r(NULL, sep, &saveptr);
+		}
+		Free(sdp, str);
+		continue;
 	    }
-            if (match(&string, "show_caching")) {
-                sdp->show_caching_flag = False;
-                goto dloop;
-            }
-	    if (match(&string, "show_header")) {
-		sdp->show_header_flag = False;
-		goto dloop;
+	    case OPT_POUT: {
+		uint32_t value;
+		char *str, *token, *saveptr;
+		char *pout;
+		char *sep = " ";
+		if (strchr(string, ',')) {
+		    sep = ",";
+		}
+		sgp->data_dir = scsi_data_write; /* Sending parameter data to device. */
+		sgp->data_buffer = malloc_palign(sdp, strlen(string), 0);
+		sgp->data_length = 0;
+		sdp->user_data = True;
+		pout = sgp->data_buffer;
+		str = strdup(string);
+		token = strtok_r(str, sep, &saveptr);
+		while (token != NULL) {
+		    value = number(sdp, token, HEX_RADIX, &status, False);
+		    if (value > 0xFF) {
+			Eprintf(sdp, "Parameter out byte value %#x is too large!\n", value);
+			Free(sdp, str);
+			return ( HandleExit(sdp, FATAL_ERROR) );
+		    }
+		    pout[sgp->data_length++] = (uint8_t)value;
+		    token = strtok_r(NULL, sep, &saveptr);
+		}
+		Free(sdp, str);
+		continue;
 	    }
-            if (match(&string, "json_pretty")) {
-                sdp->json_pretty = False;
-                goto dloop;
-            }
-            if (match(&string, "xdebug")) {
-                sdp->xDebugFlag = False;
-                goto dloop;
-            }
-	    if (match(&string, "decode")) {
-		sdp->decode_flag = False;
-		goto dloop;
+	    case OPT_QTAG: {
+		if (match (&string, "noq")) {
+		   sgp->qtag_type = SG_NO_Q; 
+		} else if (match (&string, "simple")) {
+		    sgp->qtag_type = SG_SIMPLE_Q; 
+		} else if (match (&string, "headha")) {
+		    sgp->qtag_type = SG_HEAD_HA_Q;
+		} else if (match (&string, "head")) {
+		    sgp->qtag_type = SG_HEAD_OF_Q; 
+		} else if (match (&string, "ordered")) {
+		    sgp->qtag_type = SG_ORDERED_Q;
+		} else {
+		    Eprintf(sdp, "Valid qtags are: 'noq', 'simple', 'head', 'ordered', or 'headha'.\n");
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
 	    }
-            if (match(&string, "dopen")) {
-                sgp->dopen = False;
-                goto dloop;
-            }
-            if (match(&string, "emit_all")) {
-                sdp->emit_all = False;
-                goto dloop;
-            }
-	    if (match(&string, "encode")) {
-		sdp->encode_flag = False;
-		goto dloop;
+	    case OPT_IOMODE: {
+		io_params_t *biop = &sdp->io_params[IO_INDEX_DSF];
+		scsi_generic_t *bsgp = &iop->sg;
+		if (match (&string, "copy")) {
+		    /* Read from the 1st device (our source). */
+		    if ( (sdp->bypass == False) && (sdp->op_type == UNDEFINED_OP) ) {
+			bsgp->cdb[0] = (uint8_t)sdp->scsi_read_type;
+			bsgp->data_dir = scsi_data_read;
+			sdp->op_type = SCSI_CDB_OP;
+		    }
+		    sdp->iomode = IOMODE_COPY;
+		} else if (match (&string, "mirror")) {
+		    /* Write to 1st device, and read from 2nd! */
+		    if ( (sdp->bypass == False) && (sdp->op_type == UNDEFINED_OP) ) {
+			bsgp->cdb[0] = (uint8_t)sdp->scsi_write_type;
+			bsgp->data_dir = scsi_data_write;
+			sdp->op_type = SCSI_CDB_OP;
+		    }
+		    sdp->iomode = IOMODE_MIRROR;
+		} else if (match (&string, "test")) {
+		    sdp->iomode = IOMODE_TEST;
+		} else if (match (&string, "verify")) {
+		    /* Read from the 1st device, and read/compare from 2nd. */
+		    if ( (sdp->bypass == False) && (sdp->op_type == UNDEFINED_OP) ) {
+			bsgp->cdb[0] = (uint8_t)sdp->scsi_read_type;
+			bsgp->data_dir = scsi_data_read;
+			sdp->op_type = SCSI_CDB_OP;
+		    }
+		    sdp->iomode = IOMODE_VERIFY;
+		} else {
+		    Eprintf(sdp, "The supported I/O modes are: copy, mirror, test, or verify.\n");
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		sdp->encode_flag = True;
+		sdp->verbose = False;
+		continue;
 	    }
-            if (match(&string, "errors")) {
-                sgp->errlog = False;
-                goto dloop;
-            }
-            if (match(&string, "genspt")) {
-                sdp->genspt_flag = False;
-                goto dloop;
-            }
-            if (match(&string, "header")) {
-                sdp->log_header_flag = False;
-                goto dloop;
-            }
-            if (match(&string, "mapscsi")) {
-                sgp->mapscsi = False;
-                goto dloop;
-            }
-            if (match(&string, "multi")) {
-		InteractiveFlag = False;
-                goto dloop;
-            }
-            if (match(&string, "pipes")) {
-                PipeModeFlag = False;
-		InteractiveFlag = True;
-                goto dloop;
-            }
-	    if (match(&string, "prewrite")) {
-		sdp->prewrite_flag = False;
-		goto dloop;
+	    case OPT_READTYPE: {
+		if (match (&string, "read6")) {
+		    sdp->scsi_read_type = scsi_read6_cdb;
+		} else if (match (&string, "read10")) {
+		    sdp->scsi_read_type = scsi_read10_cdb;
+		} else if (match (&string, "read16")) {
+		    sdp->scsi_read_type = scsi_read16_cdb;
+		} else {
+		    Eprintf(sdp, "The supported SCSI read types are: read6, read10, or read16.\n");
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
 	    }
-	    if (match(&string, "recovery")) {
-		sgp->recovery_flag = False;
-		goto dloop;
+	    case OPT_READLEN:
+	    case OPT_READLENGTH: {
+		sdp->scsi_read_length = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    if ( match(&string, "raw") || match(&string, "read_after_write") || match(&string, "read_immed") ) {
-		sdp->read_after_write = False;
-		goto dloop;
+	    case OPT_WRITETYPE: {
+		if (match (&string, "write6")) {
+		    sdp->scsi_write_type = scsi_write6_cdb;
+		} else if (match (&string, "write10")) {
+		    sdp->scsi_write_type = scsi_read10_cdb;
+		} else if (match (&string, "write16")) {
+		    sdp->scsi_write_type = scsi_write16_cdb;
+		} else if (match (&string, "writev16")) {
+		    sdp->scsi_write_type = scsi_writev16_cdb;
+		} else {
+		    Eprintf(sdp, "The supported SCSI write types are: write6, write10, write16, or writev16.\n");
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
 	    }
-	    if (match(&string, "scriptverify")) {
-		sdp->script_verify = False;
-		goto dloop;
+	    case OPT_WRITELEN:
+	    case OPT_WRITELENGTH: {
+		sdp->scsi_write_length = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    if (match(&string, "sata")) {
-		sdp->sata_device_flag = False;
-		goto dloop;
+	    case OPT_RANGES: {
+		sdp->range_count = number(sdp, string, ANY_RADIX, &status, False);
+		siop->range_count = sdp->range_count; /* per device for token xcopy. */
+		continue;
 	    }
-	    if (match(&string, "scsi")) {
-		sdp->scsi_info_flag = False;
-		goto dloop;
+	    case OPT_REPEAT:
+	    case OPT_PASSES: {
+		sdp->repeat_count = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    if (match(&string, "sense")) {
-		sdp->sense_flag = False;
-		goto dloop;
+	    case OPT_RECOVERY_DELAY: {
+		sdp->recovery_delay = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    if (match(&string, "unique")) {
-		sdp->unique_pattern = False;
-		goto dloop;
+	    case OPT_RECOVERY_RETRIES: {
+		sdp->recovery_limit = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    if (match(&string, "verbose")) {
-		sdp->verbose = False;
-		goto dloop;
+	    case OPT_RETRY: {
+		sdp->retry_limit = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    if (match(&string, "verify")) {
-		sdp->verify_data = False;
-		goto dloop;
+	    case OPT_RUNTIME: {
+		sdp->runtime = time_value(sdp, string);
+		continue;
 	    }
-	    if (match(&string, "warnings")) {
-		sdp->warnings_flag = False;
-		goto dloop;
+	    case OPT_SCRIPT: {
+		int status;
+		status = OpenScriptFile(sdp, string);
+		if (status == SUCCESS) {
+		    continue;
+		} else {
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
 	    }
-	    if (match(&string, "wait")) {
-		sdp->tci.wait_for_status = False;
-		goto dloop;
+	    case OPT_WORKLOAD: {
+		int status;
+		status = load_workload(sdp, string);
+		if (status == SUCCESS) {
+		    continue;
+		} else {
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
 	    }
-	    if (match(&string, "rrtiwut")) {
-		sdp->rrti_wut_flag = False;
-		goto dloop;
+	    case OPT_SEGMENTS: {
+		int segment_count = number(sdp, string, ANY_RADIX, &status, False);
+		if (!segment_count && !sdp->bypass) segment_count++;
+		sdp->segment_count = segment_count;
+		sdp->encode_flag = True;
+		continue;
 	    }
-	    if (match(&string, "zerorod")) {
-		sdp->zero_rod_flag = False;
-		goto dloop;
+	    case OPT_STATUS:
+	    case OPT_SCSI_STATUS: {
+		sgp->errlog = False;
+		sdp->tci.check_status = True;
+		if ( isalpha(*string) ) {
+		    int scsi_status = LookupScsiStatus(string);
+		    if (scsi_status >= 0) {
+			sdp->tci.exp_scsi_status = (uint8_t)scsi_status;
+		    } else {
+			Eprintf(sdp, "Invalid status name '%s'!\n", string);
+			return ( HandleExit(sdp, FATAL_ERROR) );
+		    }
+		} else {
+		    sdp->tci.exp_scsi_status = number(sdp, string, HEX_RADIX, &status, False);
+		}
+		continue;
 	    }
-	    Eprintf(sdp, "Invalid disable keyword: %s\n", string);
-	    return ( HandleExit(sdp, FATAL_ERROR) );
-        }
-	/*
-	 * Special options to help seed IOT pattern with multiple passes.
-	 */
-	if (match (&string, "iotpass=")) {
-	    int iot_pass = number(sdp, string, ANY_RADIX, &status, False);
-	    sdp->iot_seed *= iot_pass;
-	    sdp->iot_pattern = True;
-	    continue;
-	}
-	if (match (&string, "iotseed=")) {
-	    sdp->iot_seed = (uint32_t)number(sdp, string, HEX_RADIX, &status, False);
-	    sdp->iot_pattern = True;
-	    continue;
-	}
-	if (match (&string, "boff=")) {
-	    if (match(&string, "dec")) {
-		sdp->boff_format = DEC_FMT;
-	    } else if (match (&string, "hex")) {
-		sdp->boff_format = HEX_FMT;
-	    } else {
-		Eprintf(sdp, "Valid buffer offset formats are: dec or hex\n");
-		return ( HandleExit(sdp, FAILURE) );
+	    case OPT_SKEY:
+	    case OPT_SENSE_KEY: {
+		sgp->errlog = False;
+		sdp->tci.check_status = True;
+		if (sdp->tci.exp_scsi_status == SCSI_GOOD) {
+		    sdp->tci.exp_scsi_status = SCSI_CHECK_CONDITION;
+		}
+		if ( isalpha(*string) ) {
+		    int sense_key = LookupSenseKey(string);
+		    if (sense_key >= 0) {
+			sdp->tci.exp_sense_key = (uint8_t)sense_key;
+		    } else {
+			Eprintf(sdp, "Invalid sense key name '%s'!\n", string);
+			return ( HandleExit(sdp, FATAL_ERROR) );
+		    }
+		} else {
+		    sdp->tci.exp_sense_key = number(sdp, string, HEX_RADIX, &status, False);
+		}
+		continue;
 	    }
-	    continue;
-	}
-	if (match (&string, "datesep=")) {
-	    if (sdp->date_sep) free(sdp->date_sep);
-	    sdp->date_sep = strdup(string);
-	    continue;
-	}
-	if (match (&string, "timesep=")) {
-	    if (sdp->time_sep) free(sdp->time_sep);
-	    sdp->time_sep = strdup(string);
-	    continue;
-	}
-	if (match (&string, "dfmt=")) {
-	    if (match(&string, "byte")) {
-		sdp->data_format = BYTE_FMT;
-	    } else if (match (&string, "word")) {
-		sdp->data_format = WORD_FMT;
-	    } else {
-		Eprintf(sdp, "Valid data formats are: byte or word\n");
-		return ( HandleExit(sdp, FAILURE) );
+	    case OPT_ASC: {
+		sgp->errlog = False;
+		sdp->tci.check_status = True;
+		if (sdp->tci.exp_scsi_status == SCSI_GOOD) {
+		    sdp->tci.exp_scsi_status = SCSI_CHECK_CONDITION;
+		}
+		sdp->tci.exp_sense_asc = number(sdp, string, HEX_RADIX, &status, False);
+		continue;
 	    }
-	    continue;
-	}
-	if ( match(&string, "ofmt=") || match(&string, "output-format=")) {
-	    if (match(&string, "ascii")) {
-		sdp->output_format = ASCII_FMT;
-	    } else if (match (&string, "json")) {
-		sdp->output_format = JSON_FMT;
-	    } else {
-		Eprintf(sdp, "Valid data formats are: ascii or json\n");
-		return ( HandleExit(sdp, FAILURE) );
+	    case OPT_ASQ: {
+		sgp->errlog = False;
+		sdp->tci.check_status = True;
+		if (sdp->tci.exp_scsi_status == SCSI_GOOD) {
+		    sdp->tci.exp_scsi_status = SCSI_CHECK_CONDITION;
+		}
+		sdp->tci.exp_sense_asq = number(sdp, string, HEX_RADIX, &status, False);
+		continue;
 	    }
-	    if (sdp->log_prefix) {
-		Free(sdp, sdp->log_prefix);
+	    case OPT_RESID: {
+		sdp->tci.check_resid = True;
+		sdp->tci.exp_residual = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->log_prefix = strdup("");
-	    continue;
-	}
-	if ( match(&string, "rfmt=") || match(&string, "report-format=")) {
-	    if (match(&string, "brief")) {
-		sdp->report_format = REPORT_BRIEF;
-	    } else if (match (&string, "full")) {
-		sdp->report_format = REPORT_FULL;
-	    } else if (match (&string, "none")) {
-		sdp->report_format = REPORT_NONE;
-	    } else {
-		Eprintf(sdp, "Valid data formats are: brief or full\n");
-		return ( HandleExit(sdp, FAILURE) );
+	    case OPT_TRANSFER: {
+		sdp->tci.check_xfer = True;
+		sdp->tci.exp_transfer = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    continue;
-	}
-	if (match (&string, "keepalive=")) {
-	    if (sdp->keepalive) free(sdp->keepalive);
-	    sdp->keepalive = strdup(string);
-	    if (sdp->keepalive_time == 0) sdp->keepalive_time++;
-	    continue;
-	}
-	if (match (&string, "keepalivet=")) {
-	    sdp->keepalive_time = time_value(sdp, string);
-	    if (sdp->keepalive_time && (sdp->keepalive == NULL) ) {
-		sdp->keepalive = strdup(keepalive);	/* Set the default! */
+	    case OPT_SNAME: {
+		if (sdp->scsi_name && sdp->user_sname) free(sdp->scsi_name);
+		sgp->cdb_name = sdp->scsi_name = strdup(string);
+		sdp->user_sname = True;
+		continue;
 	    }
-	    continue;
-	}
-	if (match (&string, "onerr=")) {
-	    if (match (&string, "continue")) {
-		sdp->onerr = ONERR_CONTINUE;
-	    } else if (match (&string, "stop")) {
-		sdp->onerr = ONERR_STOP;
-	    } else {
-                Eprintf(sdp, "On error actions are 'continue' or 'stop'.\n");
-		return ( HandleExit(sdp, FATAL_ERROR) );
+	    case OPT_SLEEP: {
+		sdp->sleep_value = (uint32_t)time_value(sdp, string);
+		continue;
 	    }
-	    continue;
-	}
-        if (match (&string, "op=")) {
-            if ( match(&string, "ats") || match (&string, "abort_task_set")) {
-                sdp->op_type = ABORT_TASK_SET_OP;
-            } else if ( match(&string, "br") || match(&string, "bus_reset") ) {
-                sdp->op_type = BUS_RESET_OP;
-            } else if ( match(&string, "lr") || match(&string, "lun_reset") ) {
-                sdp->op_type = LUN_RESET_OP;
-            } else if ( match(&string, "bdr") || match(&string, "target_reset") ) {
-                sdp->op_type = TARGET_RESET_OP;
-            } else if ( match(&string, "scsi_cdb") ) {
-                sdp->op_type = SCSI_CDB_OP;
-            } else {
-                Eprintf(sdp, "Valid operations are: 'abort_task_set'(ats), 'bus_reset'(br), "
-			"'lun_reset'(lr), 'target_reset'(bdr) or 'scsi_cdb'.\n");
-		return ( HandleExit(sdp, FATAL_ERROR) );
-            }
-            continue;
-        }
-	/*
-	 * Start of Short Hand Commands: (ease of use, avoids specifying CDB's, etc)
-	 */
-	if ( match(&string, "copyparams") ) {
-	    if ( setup_receive_copy_results(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_MSLEEP: {
+		sdp->msleep_value = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "getlbastatus") ) {
-	    if ( setup_get_lba_status(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_USLEEP: {
+		sdp->usleep_value = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if (match (&string, "inquiry")) {
-	    size_t data_length = sizeof(inquiry_t);
-	    uint8_t page = 0;
-	    if ( setup_inquiry(sdp, sgp, data_length, page) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_SLICES: {
+		sdp->slices = number(sdp, string, ANY_RADIX, &status, False);
+		sdp->encode_flag = True;
+		continue;
 	    }
-	    sdp->verbose = False;
-            continue;
-        }
-	if (match (&string, "logsense")) {
-	    size_t data_length = LOG_SENSE_LENGTH_MAX;
-	    uint8_t page = 0;
-	    if ( setup_log_sense(sdp, sgp, data_length, page) ) {
-		return( HandleExit(sdp, FAILURE) );
-	    }
-	    sdp->verbose = False;
-            continue;
-        }
-	if (match (&string, "zerolog")) {
-	    uint8_t page = 0;
-	    if ( setup_zero_log(sdp, sgp, page) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_SLICE: {
+		sdp->slice_number = number(sdp, string, ANY_RADIX, &status, False);
+		sdp->encode_flag = True;
+		continue;
 	    }
-	    sdp->verbose = False;
-            continue;
-        }
-	if (match (&string, "readcapacity10")) {
-	    if ( setup_read_capacity10(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_TEST: {
+		send_diagnostic_cdb_t *cdb = (send_diagnostic_cdb_t *)sgp->cdb;
+		int status = SUCCESS;
+		if (++i < argc) {
+		    string = argv[i];
+		}
+		sdp->op_type = SCSI_CDB_OP;
+		cdb->opcode = SOPC_SEND_DIAGNOSTIC;
+		if ( match(&string, "abort") ) {
+		    cdb->self_test_code = AbortBackgroundSelfTest;
+		} else if ( match(&string, "self") ) {
+		    cdb->self_test = 1;
+		} else if ( match(&string, "bextended") ) {
+		    cdb->self_test_code = BackgroundExtendedSelfTest;
+		} else if ( match(&string, "bshort") ) {
+		    cdb->self_test_code = BackgroundShortSelfTest;
+		} else if ( match(&string, "extended") ) {
+		    cdb->self_test_code = ForgroundExtendedSelfTest;
+		} else if ( match(&string, "short") ) {
+		    cdb->self_test_code = ForgroundShortSelfTest;
+		} else {
+		    Eprintf(sdp, "Valid test keywords are: abort|self[test]|[b]short|[b]extended\n");
+		    status = FAILURE;
+		    return( HandleExit(sdp, status ) );
+		}
+		continue;
 	    }
-	    sdp->verbose = False;
-            continue;
-        }
-	if (match (&string, "readcapacity16")) {
-	    if ( setup_read_capacity16(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_THREADS: {
+		sdp->threads = number(sdp, string, ANY_RADIX, &status, False);
+		sdp->user_threads = True;
+		continue;
 	    }
-	    sdp->verbose = False;
-            continue;
-        }
-	if (match (&string, "requestsense")) {
-	    if ( setup_request_sense(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_TIMEOUT: {
+		sgp->timeout = (uint32_t)mstime_value(sdp, string);
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if (match (&string, "rtpg")) {
-	    if ( setup_rtpg(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    /* Options for token based xcopy. */
+	    case OPT_LISTID: {
+		iop->list_identifier = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	/* Generic receive diagnostic setup. */
-	if (match (&string, "rcvdiag")) {
-	    size_t data_length = RECEIVE_DIAGNOSTIC_MAX;
-	    uint8_t page = 0;
-	    if ( setup_receive_diagnostic(sdp, sgp, data_length, page) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_SLISTID: {
+		siop->list_identifier = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->verbose = False;
-            continue;
-        }
-	/* Generic send diagnostic setup. */
-	if (match (&string, "senddiag")) {
-	    size_t data_length = 0;
-	    uint8_t page = 0;
-	    if ( setup_send_diagnostic(sdp, sgp, page) ) {
-		return( HandleExit(sdp, FAILURE) );
-	    }
-            continue;
-        }
-	/* SES diagnostic page to return enclosure help text. */
-	if ( match(&string, "showhelp") ) {
-	    size_t data_length = RECEIVE_DIAGNOSTIC_MAX;
-	    if ( setup_receive_diagnostic(sdp, sgp, data_length, DIAG_HELP_TEXT_PAGE) ) {
-		return( HandleExit(sdp, FAILURE) );
-	    }
-	    sdp->verbose = False;
-            continue;
-        }
-	if ( match(&string, "read10") ) {
-	    if ( setup_read10(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_ROD_TIMEOUT: {
+		sdp->rod_inactivity_timeout = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "read16") ) {
-	    if ( setup_read16(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    /* Options for pack and unpack. */
+	    case OPT_UNPACK: {
+		/* Append, for multiple unpack options. */
+		if (sdp->unpack_format) {
+		    char *str = sdp->unpack_format;
+		    size_t len = strlen(str);
+		    char *dst = Malloc(sdp, (len + strlen(string) + 1) );
+		    if (dst == NULL) return(FAILURE);
+		    (void)strcat(dst, str);
+		    (void)strcat(dst, string);
+		    sdp->unpack_format = dst;
+		    Free(sdp, str);
+		} else {
+		    sdp->unpack_format = strdup(string);
+		}
+		/* Assume the log prefix is not required. */
+		if (sdp->log_prefix) {
+		    Free(sdp, sdp->log_prefix);
+		}
+		sdp->log_prefix = strdup("");
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "verify10") ) {
-	    if ( setup_verify10(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_UNPACK_FMT: {
+		if (match(&string, "dec")) {
+		    sdp->unpack_data_fmt = DEC_FMT;
+		} else if (match (&string, "hex")) {
+		    sdp->unpack_data_fmt = HEX_FMT;
+		} else {
+		    Eprintf(sdp, "Valid unpack data formats are: dec or hex\n");
+		    return ( HandleExit(sdp, FAILURE) );
+		}
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "verify16") ) {
-	    if ( setup_verify16(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_EXIT:
+	    case OPT_QUIT: {
+		ExitFlag = True;
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "verify10") ) {
-	    if ( setup_verify10(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_HELP: {
+		Help(sdp);
+		return ( HandleExit(sdp, SUCCESS) );
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "verify16") ) {
-	    if ( setup_verify16(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_SHOWOPCODES: {
+		char *opstr = NULL;
+		if (++i < argc) {
+		    opstr = argv[i];
+		}
+		ShowScsiOpcodes(sdp, opstr);
+		return ( HandleExit(sdp, SUCCESS) );
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "write10") ) {
-	    if ( setup_write10(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    /* ------------------------------------------------------------------------ */
+	    case OPT_ANALYZE: {
+		sdp->op_type = ANALYZE_TRACE_OP;
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "write16") ) {
-	    if ( setup_write16(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_BENCH_FILE: {
+		if (sdp->bench_file) free(sdp->bench_file);
+		sdp->bench_file = strdup(string);
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "writesame10") ) {
-	    if ( setup_write_same10(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_BENCH_THRESHOLD: {
+		sdp->bench_threshold = number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "writesame16") ) {
-	    if ( setup_write_same16(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_BASELINE: {
+		if (sdp->bench_baseline) free(sdp->bench_baseline);
+		sdp->bench_baseline = strdup(string);
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "unmap") ) {
-	    if ( setup_unmap(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_BENCH: {
+		sdp->op_type = BENCHMARK_OP;
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "xcopy") ) {
-	    if ( setup_extended_copy(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_SHOW: {
+		int status = SUCCESS;
+		if (++i < argc) {
+		    string = argv[i];
+		    if ( match(&string, "devices") || match(&string, "edt") ) {
+			sdp->recovery_flag = True;
+			sdp->report_format = REPORT_BRIEF;
+			if (++i < argc) {
+			    status = parse_show_devices_args(sdp, argv, argc, &i);
+			}
+		    } else if ( match(&string, "scsi") ) {
+			if (++i < argc) {
+			    status = parse_show_scsi_args(sdp, argv, argc, &i);
+			    return ( HandleExit(sdp, status) );
+			}
+			/* No defaults, keywords must be specified! */
+			Eprintf(sdp, "Valid show scsi keywords are: ascq|key|status|uec\n");
+			status = FAILURE;
+		    } else {
+			Eprintf(sdp, "Valid show keywords are: devices|edt|scsi\n");
+			status = FAILURE;
+		    }
+		} else {
+		    Eprintf(sdp, "Format is: show devices|scsi\n");
+		    status = FAILURE;
+		}
+		if (status == FAILURE) {
+		    return( HandleExit(sdp, status) );
+		}
+		sdp->op_type = SHOW_DEVICES_OP;
+		sdp->log_prefix = strdup("");
+		continue;
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "wut") || match(&string, "odx") ) {
-	    if ( setup_write_using_token(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    /*
+	     * Implement a few useful commands Scu supports. 
+	     */
+	    case OPT_EVAL: {
+		char *expr = concatenate_args(sdp, argc, argv, ++i);
+		if (expr) {
+		    uint64_t value;
+		    value = large_number(sdp, expr, ANY_RADIX, &status, False);
+		    show_expression(sdp, value);
+		    Free(sdp, expr);
+		}
+		return ( HandleExit(sdp, SUCCESS) );
+	    }
+	    case OPT_SYSTEM:
+	    case OPT_SHELL: {
+		char *cmd = concatenate_args(sdp, argc, argv, ++i);
+		if (cmd) {
+		    (void)DoSystemCommand(sdp, cmd);
+		    Free(sdp, cmd);
+		} else {
+		    (void)StartupShell(sdp, NULL);
+		}
+		return ( HandleExit(sdp, SUCCESS) );
 	    }
-	    sdp->verbose = False;
-	    continue;
-	}
-	if ( match(&string, "zerorod") ) {
-	    if ( setup_write_using_token(sdp, sgp) ) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_BANG: {
+		char *cmd = concatenate_args(sdp, argc, argv, i);
+		if (cmd) {
+		    (void)DoSystemCommand(sdp, (cmd + 1));
+		    Free(sdp, cmd);
+		}
+		return ( HandleExit(sdp, SUCCESS) );
 	    }
-            sdp->zero_rod_flag = True;
-	    sdp->verbose = False;
-	    continue;
-	}
-	/* SES Parameters. */
-	if ( match(&string, "element=") || match(&string, "element_index=") ) {
-	    sdp->ses_element_index = (int)number(sdp, string, ANY_RADIX, &status, False);
-	    sdp->ses_element_flag = True;
-	    continue;
-	}
-	if ( match(&string, "etcode=") || match(&string, "element_tcode=") ) {
-	    sdp->ses_element_type = (int)number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if ( match(&string, "escode=") || match(&string, "element_scode=") ) {
-	    sdp->ses_element_status = (int)number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if ( match(&string, "etype=") || match(&string, "element_type=") ) {
-	    int status = SUCCESS;
-	    sdp->ses_element_type = find_element_type(sdp, string, &status);
-	    if (status == FAILURE) {
-		Eprintf(sdp, "Did not find element type '%s'!\n", string);
-		return( HandleExit(sdp, status) );
-	    } else if (status == WARNING) {
-		return( HandleExit(sdp, status) );
+	    case OPT_VERSION: {
+		Version(sdp);
+		return ( HandleExit(sdp, SUCCESS) );
 	    }
-	    continue;
-	}
-	if ( match(&string, "estatus=") || match(&string, "element_status=") ) {
-	    int status = SUCCESS;
-	    sdp->ses_element_status = find_element_status(sdp, string, &status);
-	    if (status == FAILURE) {
-		Eprintf(sdp, "Did not find element status '%s'!\n", string);
-		return( HandleExit(sdp, status) );
-	    } else if (status == WARNING) {
-		return( HandleExit(sdp, status) );
+	    /*
+	     * I/O Options:
+	     */ 
+	    case OPT_BLOCKS: {
+		siop->cdb_blocks = large_number(sdp, string, ANY_RADIX, &status, False);
+		sdp->encode_flag = True;
+		sdp->verbose = False;
+		continue;
 	    }
-	    continue;
-	}
-	if (match(&string, "ses")) {
-	    uint8_t page = DIAG_ENCLOSURE_CONTROL_PAGE;
-	    size_t data_length = RECEIVE_DIAGNOSTIC_MAX;
-	    int status;
-	    if (++i < argc) {
-		uint8_t page = DIAG_STRING_IN_OUT_PAGE;
-                string = argv[i];
-		status = parse_ses_args(string, sdp);
-	    } else {
-		Eprintf(sdp, "Format is: ses {clear|set}={devoff|fail/fault|ident/locate|unlock}\n");
-		status = FAILURE;
+	    case OPT_BS: {
+		uint64_t bytes = large_number(sdp, string, ANY_RADIX, &status, False);
+		if (iop->device_size) {
+		    siop->cdb_blocks = howmany(bytes, iop->device_size);
+		}
+		sdp->encode_flag = True;
+		sdp->verbose = False;
+		continue;
 	    }
-	    if (status == FAILURE) {
-		return( HandleExit(sdp, status) );
+	    case OPT_CAW_LOCKS: {
+		sdp->caw_locks = (uint32_t)number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    /* This will be a read-modify-write operation. */
-	    if (setup_receive_diagnostic(sdp, sgp, data_length, page)) {
-		return( HandleExit(sdp, FAILURE) );
+	    case OPT_CAPACITY: {
+		siop->user_capacity = large_number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->verbose = False;
-            continue;
-        }
-        if (match (&string, "page=")) {
-	    int status = SUCCESS;
-	    uint8_t opcode = sgp->cdb[0];
-	    sdp->page_specified = True;
-	    /* Note: Overloading page={hex|string} */
-	    if ( (*string == '\0') || (isHexString(string) == False) ) {
-		if (opcode == SOPC_INQUIRY) {
-		    sdp->page_code = find_inquiry_page_code(sdp, string, &status);
-		    if (status == FAILURE) {
-			Eprintf(sdp, "Did not find Inquiry page '%s'!\n", string);
-			return( HandleExit(sdp, status) );
-		    } else if (status == WARNING) {
-			return( HandleExit(sdp, status) );
-		    }
-		    sdp->verbose = False;
-		    continue;
-		} else if ((opcode == SOPC_LOG_SELECT) || (opcode == SOPC_LOG_SENSE)) {
-		    sdp->page_code = find_log_page_code(sdp, string, &status);
-		    if (status == FAILURE) {
-			Eprintf(sdp, "Did not find diagnostic page '%s'!\n", string);
-			return( HandleExit(sdp, status) );
-		    } else if (status == WARNING) {
-			return( HandleExit(sdp, status) );
-		    }
-		    sdp->verbose = False;
-		    continue;
-		} else if ( (opcode == SOPC_RECEIVE_DIAGNOSTIC) ||
-			    (opcode == SOPC_SEND_DIAGNOSTIC) ) {
-		    sdp->page_code = find_diagnostic_page_code(sdp, string, &status);
-		    if (status == FAILURE) {
-			Eprintf(sdp, "Did not find diagnostic page '%s'!\n", string);
-			return( HandleExit(sdp, status) );
-		    } else if (status == WARNING) {
-			return( HandleExit(sdp, status) );
-		    }
-		    sdp->verbose = False;
-		    continue;
+	    case OPT_CAPACITYP: {
+		siop->capacity_percentage = (int)number(sdp, string, ANY_RADIX, &status, False);
+		if (siop->capacity_percentage > 100) {
+		    Eprintf(sdp, "The capacity percentage range is 0-100!\n");
+		    return ( HandleExit(sdp, FAILURE) );
 		}
+		continue;
 	    }
-	    sdp->page_code = (uint8_t)number(sdp, string, HEX_RADIX, &status, False);
-	    sdp->verbose = False;
-            continue;
-        }
-        if (match (&string, "path=")) {
-            sgp->scsi_addr.scsi_path = (int)number(sdp, string, ANY_RADIX, &status, False);
-            continue;
-        }
-	if (match (&string, "pattern=")) {
-	    size_t size = strlen(string);
-	    /* Note: Added this parsing to match dt and keep my sanity! */
-	    if ( (size == 3) && (match(&string, "iot") || match(&string, "IOT")) ) {
-		sdp->iot_pattern = True;
+	    case OPT_LIMIT: {
+		siop->data_limit = large_number(sdp, string, ANY_RADIX, &status, False);
+		sdp->encode_flag = True;
 		sdp->verbose = False;
-	    } else {
-		sdp->pattern = number(sdp, string, HEX_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->user_pattern = True;
-	    sdp->compare_data = True;
-	    continue;
-	}
-	if (match (&string, "ptype=")) {
-	    int size = (int)strlen(string);
-	    if ((size == 3) && match (&string, "iot") || match(&string, "IOT")) {
-		sdp->iot_pattern = True;
-		sdp->user_pattern = True;
-		sdp->compare_data = True;
-		sdp->verbose = False;
-	    } else {
-		Eprintf(sdp, "Pattern types supported include: iot|IOT only!\n");
-		return ( HandleExit(sdp, FATAL_ERROR) );
+	    case OPT_LOG: {
+		if (sdp->log_file) Free(sdp, sdp->log_file);
+		sdp->log_file = strdup(string);
+		sdp->logheader_flag = True;
+		continue;
 	    }
-	    continue;
-	}
-	if (match (&string, "pin=")) {
-	    uint32_t value;
-	    char *str, *token, *saveptr;
-	    char *pin;
-	    char *sep = " ";
-	    if (strchr(string, ',')) {
-		sep = ",";
-	    }
-	    sgp->data_dir = scsi_data_read; /* Receiving parameter data from device. */
-	    sdp->pin_buffer = malloc_palign(sdp, strlen(string), 0);
-	    sdp->pin_length = 0;
-	    sdp->pin_data = True;
-    	    sdp->compare_data = True;
-	    pin = sdp->pin_buffer;
-	    str = strdup(string);
-	    token = strtok_r(str, sep, &saveptr);
-	    while (token != NULL) {
-		value = number(sdp, token, HEX_RADIX, &status, False);
-		if (value > 0xFF) {
-		    Eprintf(sdp, "Parameter in byte value %#x is too large!\n", value);
-		    Free(sdp, str);
-		    return ( HandleExit(sdp, FATAL_ERROR) );
+	    case OPT_LOGPREFIX: {
+		if (sdp->log_prefix) Free(sdp, sdp->log_prefix);
+		if (match(&string, "gtod")) { /* Short hand! */
+		    sdp->log_prefix = strdup(DEFAULT_GTOD_LOG_PREFIX);
+		} else {
+		    sdp->log_prefix = strdup(string);
 		}
-		pin[sdp->pin_length++] = (uint8_t)value;
-		token = strtok_r(NULL, sep, &saveptr);
+		continue;
 	    }
-	    Free(sdp, str);
-	    continue;
-	}
-        if (match (&string, "pout=")) {
-            uint32_t value;
-            char *str, *token, *saveptr;
-            char *pout;
-	    char *sep = " ";
-	    if (strchr(string, ',')) {
-		sep = ",";
-	    }
-            sgp->data_dir = scsi_data_write; /* Sending parameter data to device. */
-            sgp->data_buffer = malloc_palign(sdp, strlen(string), 0);
-            sgp->data_length = 0;
-	    sdp->user_data = True;
-            pout = sgp->data_buffer;
-	    str = strdup(string);
-            token = strtok_r(str, sep, &saveptr);
-            while (token != NULL) {
-		value = number(sdp, token, HEX_RADIX, &status, False);
-		if (value > 0xFF) {
-		    Eprintf(sdp, "Parameter out byte value %#x is too large!\n", value);
-		    Free(sdp, str);
-		    return ( HandleExit(sdp, FATAL_ERROR) );
-		}
-                pout[sgp->data_length++] = (uint8_t)value;
-                token = strtok_r(NULL, sep, &saveptr);
-            }
-	    Free(sdp, str);
-            continue;
-        }
-        if (match (&string, "qtag=")) {
-            if (match (&string, "noq")) {
-               sgp->qtag_type = SG_NO_Q; 
-            } else if (match (&string, "simple")) {
-                sgp->qtag_type = SG_SIMPLE_Q; 
-	    } else if (match (&string, "headha")) {
-		sgp->qtag_type = SG_HEAD_HA_Q;
-            } else if (match (&string, "head")) {
-                sgp->qtag_type = SG_HEAD_OF_Q; 
-            } else if (match (&string, "ordered")) {
-                sgp->qtag_type = SG_ORDERED_Q;
-            } else {
-                Eprintf(sdp, "Valid qtags are: 'noq', 'simple', 'head', 'ordered', or 'headha'.\n");
-		return ( HandleExit(sdp, FATAL_ERROR) );
-            }
-            continue;
-        }
-	if (match (&string, "iomode=")) {
-	    io_params_t *biop = &sdp->io_params[IO_INDEX_DSF];
-	    scsi_generic_t *bsgp = &iop->sg;
-	    if (match (&string, "copy")) {
-		/* Read from the 1st device (our source). */
-		if ( (sdp->bypass == False) && (sdp->op_type == UNDEFINED_OP) ) {
-		    bsgp->cdb[0] = (uint8_t)sdp->scsi_read_type;
-		    bsgp->data_dir = scsi_data_read;
-		    sdp->op_type = SCSI_CDB_OP;
-		}
-		sdp->iomode = IOMODE_COPY;
-	    } else if (match (&string, "mirror")) {
-		/* Write to 1st device, and read from 2nd! */
-		if ( (sdp->bypass == False) && (sdp->op_type == UNDEFINED_OP) ) {
-		    bsgp->cdb[0] = (uint8_t)sdp->scsi_write_type;
-		    bsgp->data_dir = scsi_data_write;
-		    sdp->op_type = SCSI_CDB_OP;
-		}
-		sdp->iomode = IOMODE_MIRROR;
-	    } else if (match (&string, "test")) {
-		sdp->iomode = IOMODE_TEST;
-	    } else if (match (&string, "verify")) {
-		/* Read from the 1st device, and read/compare from 2nd. */
-		if ( (sdp->bypass == False) && (sdp->op_type == UNDEFINED_OP) ) {
-		    bsgp->cdb[0] = (uint8_t)sdp->scsi_read_type;
-		    bsgp->data_dir = scsi_data_read;
-		    sdp->op_type = SCSI_CDB_OP;
-		}
-		sdp->iomode = IOMODE_VERIFY;
-	    } else {
-		Eprintf(sdp, "The supported I/O modes are: copy, mirror, test, or verify.\n");
-		return ( HandleExit(sdp, FATAL_ERROR) );
+	    case OPT_LBA: {
+		siop->starting_lba = large_number(sdp, string, ANY_RADIX, &status, False);
+		siop->ending_lba = (siop->starting_lba + 1);
+		sdp->encode_flag = True;
+		continue;
 	    }
-	    sdp->encode_flag = True;
-	    sdp->verbose = False;
-	    continue;
-	}
-	if (match (&string, "readtype=")) {
-	    if (match (&string, "read6")) {
-		sdp->scsi_read_type = scsi_read6_cdb;
-	    } else if (match (&string, "read10")) {
-		sdp->scsi_read_type = scsi_read10_cdb;
-	    } else if (match (&string, "read16")) {
-		sdp->scsi_read_type = scsi_read16_cdb;
-	    } else {
-		Eprintf(sdp, "The supported SCSI read types are: read6, read10, or read16.\n");
-		return ( HandleExit(sdp, FATAL_ERROR) );
+	    case OPT_LBAMAP: {
+		if (sdp->lba_map_file) free(sdp->lba_map_file);
+		sdp->lba_map_file = strdup(string);
+		continue;
 	    }
-	    continue;
-	}
-        if ( match(&string, "readlen=") || match(&string, "readlength=") ) {
-            sdp->scsi_read_length = number(sdp, string, ANY_RADIX, &status, False);
-            continue;
-	}
-	if (match (&string, "writetype=")) {
-	    if (match (&string, "write6")) {
-		sdp->scsi_write_type = scsi_write6_cdb;
-	    } else if (match (&string, "write10")) {
-		sdp->scsi_write_type = scsi_read10_cdb;
-	    } else if (match (&string, "write16")) {
-		sdp->scsi_write_type = scsi_write16_cdb;
-	    } else if (match (&string, "writev16")) {
-		sdp->scsi_write_type = scsi_writev16_cdb;
-	    } else {
-		Eprintf(sdp, "The supported SCSI write types are: write6, write10, write16, or writev16.\n");
-		return ( HandleExit(sdp, FATAL_ERROR) );
+	    case OPT_MANIFEST: {
+		if (sdp->manifest_file) free(sdp->manifest_file);
+		sdp->manifest_file = strdup(string);
+		continue;
 	    }
-	    continue;
-	}
-	if ( match(&string, "writelen=") || match(&string, "writelength=") ) {
-	    sdp->scsi_write_length = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "ranges=")) {
-	    sdp->range_count = number(sdp, string, ANY_RADIX, &status, False);
-	    siop->range_count = sdp->range_count; /* per device for token xcopy. */
-	    continue;
-	}
-	if ( match(&string, "repeat=") || match(&string, "passes=") ) {
-	    sdp->repeat_count = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "recovery_delay=")) {
-	    sdp->recovery_delay = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "recovery_retries=")) {
-	    sdp->recovery_limit = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "retry=")) {
-	    sdp->retry_limit = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "runtime=")) {
-	    sdp->runtime = time_value(sdp, string);
-	    continue;
-	}
-	if (match (&string, "script=")) {
-	    int status;
-	    status = OpenScriptFile(sdp, string);
-	    if (status == SUCCESS) {
+	    case OPT_PITYPE: {
+		sdp->pi_type = (uint8_t)number(sdp, string, ANY_RADIX, &status, False);
+		if ( (sdp->pi_type < 1) || (sdp->pi_type > 3) ) {
+		    Eprintf(sdp, "The protection type range is 1-3!\n");
+		    return ( HandleExit(sdp, FAILURE) );
+		}
 		continue;
-	    } else {
-		return ( HandleExit(sdp, FATAL_ERROR) );
 	    }
-	}
-	if (match (&string, "segments=")) {
-	    int segment_count = number(sdp, string, ANY_RADIX, &status, False);
-	    if (!segment_count && !sdp->bypass) segment_count++;
-	    sdp->segment_count = segment_count;
-	    sdp->encode_flag = True;
-	    continue;
-	}
-        if ( match(&string, "status=") || match(&string, "scsi_status=") ) {
-	    sgp->errlog = False;
-	    sdp->tci.check_status = True;
-	    if ( isalpha(*string) ) {
-		int scsi_status = LookupScsiStatus(string);
-		if (scsi_status >= 0) {
-		    sdp->tci.exp_scsi_status = (uint8_t)scsi_status;
-		} else {
-		    Eprintf(sdp, "Invalid status name '%s'!\n", string);
-		    return ( HandleExit(sdp, FATAL_ERROR) );
+	    case OPT_RDPROTECT: {
+		sdp->rdprotect = (uint8_t)number(sdp, string, ANY_RADIX, &status, False);
+		if (sdp->rdprotect > 7) {
+		    Eprintf(sdp, "The RDPROTECT range is 0-7!\n");
+		    return ( HandleExit(sdp, FAILURE) );
 		}
-	    } else {
-		sdp->tci.exp_scsi_status = number(sdp, string, HEX_RADIX, &status, False);
+		continue;
 	    }
-	    continue;
-	}
-        if ( match(&string, "skey=") || match(&string, "sense_key=") ) {
-	    sgp->errlog = False;
-	    sdp->tci.check_status = True;
-	    if (sdp->tci.exp_scsi_status == SCSI_GOOD) {
-		sdp->tci.exp_scsi_status = SCSI_CHECK_CONDITION;
+	    case OPT_WRPROTECT: {
+		sdp->wrprotect = (uint8_t)number(sdp, string, ANY_RADIX, &status, False);
+		if (sdp->wrprotect > 7) {
+		    Eprintf(sdp, "The WRPROTECT range is 0-7!\n");
+		    return ( HandleExit(sdp, FAILURE) );
+		}
+		continue;
 	    }
-	    if ( isalpha(*string) ) {
-		int sense_key = LookupSenseKey(string);
-		if (sense_key >= 0) {
-		    sdp->tci.exp_sense_key = (uint8_t)sense_key;
+	    case OPT_APPTAG: {
+		if (match (&string, "none")) {
+		    sdp->pi_check_apptag = False;
 		} else {
-		    Eprintf(sdp, "Invalid sense key name '%s'!\n", string);
-		    return ( HandleExit(sdp, FATAL_ERROR) );
+		    sdp->pi_apptag = (uint16_t)number(sdp, string, ANY_RADIX, &status, False);
+		    sdp->pi_check_apptag = True;
 		}
-	    } else {
-		sdp->tci.exp_sense_key = number(sdp, string, HEX_RADIX, &status, False);
-	    }
-	    continue;
-	}
-	if (match (&string, "asc=")) {
-	    sgp->errlog = False;
-	    sdp->tci.check_status = True;
-	    if (sdp->tci.exp_scsi_status == SCSI_GOOD) {
-		sdp->tci.exp_scsi_status = SCSI_CHECK_CONDITION;
+		continue;
 	    }
-	    sdp->tci.exp_sense_asc = number(sdp, string, HEX_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "asq=")) {
-	    sgp->errlog = False;
-	    sdp->tci.check_status = True;
-	    if (sdp->tci.exp_scsi_status == SCSI_GOOD) {
-		sdp->tci.exp_scsi_status = SCSI_CHECK_CONDITION;
+	    case OPT_APPMASK: {
+		sdp->pi_appmask = (uint16_t)number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->tci.exp_sense_asq = number(sdp, string, HEX_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "resid=")) {
-	    sdp->tci.check_resid = True;
-	    sdp->tci.exp_residual = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "transfer=")) {
-	    sdp->tci.check_xfer = True;
-	    sdp->tci.exp_transfer = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-        if (match (&string, "sname=")) {
-	    if (sdp->scsi_name && sdp->user_sname) free(sdp->scsi_name);
-            sgp->cdb_name = sdp->scsi_name = strdup(string);
-	    sdp->user_sname = True;
-            continue;
-        }
-	if (match (&string, "sleep=")) {
-	    sdp->sleep_value = (uint32_t)time_value(sdp, string);
-	    continue;
-	}
-	if (match (&string, "msleep=")) {
-	    sdp->msleep_value = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "usleep=")) {
-	    sdp->usleep_value = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "slices=")) {
-	    sdp->slices = number(sdp, string, ANY_RADIX, &status, False);
-	    sdp->encode_flag = True;
-	    continue;
-	}
-	if (match (&string, "slice=")) {
-	    sdp->slice_number = number(sdp, string, ANY_RADIX, &status, False);
-	    sdp->encode_flag = True;
-	    continue;
-	}
-	if (match (&string, "test")) {
-	    send_diagnostic_cdb_t *cdb = (send_diagnostic_cdb_t *)sgp->cdb;
-	    int status = SUCCESS;
-	    if (++i < argc) {
-                string = argv[i];
-	    }
-	    sdp->op_type = SCSI_CDB_OP;
-	    cdb->opcode = SOPC_SEND_DIAGNOSTIC;
-	    if ( match(&string, "abort") ) {
-		cdb->self_test_code = AbortBackgroundSelfTest;
-	    } else if ( match(&string, "self") ) {
-		cdb->self_test = 1;
-	    } else if ( match(&string, "bextended") ) {
-		cdb->self_test_code = BackgroundExtendedSelfTest;
-	    } else if ( match(&string, "bshort") ) {
-		cdb->self_test_code = BackgroundShortSelfTest;
-	    } else if ( match(&string, "extended") ) {
-		cdb->self_test_code = ForgroundExtendedSelfTest;
-	    } else if ( match(&string, "short") ) {
-		cdb->self_test_code = ForgroundShortSelfTest;
-	    } else {
-		Eprintf(sdp, "Valid test keywords are: abort|self[test]|[b]short|[b]extended\n");
-		status = FAILURE;
-		return( HandleExit(sdp, status ) );
+	    case OPT_REFTAG: {
+		if (match (&string, "lba")) {
+		    sdp->pi_reftag_policy = PI_REFTAG_LBA;
+		} else if (match (&string, "none")) {
+		    sdp->pi_reftag_policy = PI_REFTAG_NONE;
+		} else {
+		    sdp->pi_reftag = (uint32_t)number(sdp, string, ANY_RADIX, &status, False);
+		    sdp->pi_reftag_policy = PI_REFTAG_FIXED;
+		}
+		continue;
 	    }
-            continue;
-	}
-	if (match (&string, "threads=")) {
-	    sdp->threads = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-        if (match (&string, "timeout=")) {
-            sgp->timeout = (uint32_t)mstime_value(sdp, string);
-            continue;
-        }
-	/* Options for token based xcopy. */
-	if (match (&string, "listid=")) {
-	    iop->list_identifier = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "slistid=")) {
-	    siop->list_identifier = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "rod_timeout=")) {
-	    sdp->rod_inactivity_timeout = number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	/* Options for pack and unpack. */
-	if (match (&string, "unpack=")) {
-	    /* Append, for multiple unpack options. */
-	    if (sdp->unpack_format) {
-		char *str = sdp->unpack_format;
-		size_t len = strlen(str);
-		char *dst = Malloc(sdp, (len + strlen(string) + 1) );
-		if (dst == NULL) return(FAILURE);
-		(void)strcat(dst, str);
-		(void)strcat(dst, string);
-		sdp->unpack_format = dst;
-		Free(sdp, str);
-	    } else {
-		sdp->unpack_format = strdup(string);
+	    case OPT_REPLAY: {
+		if (sdp->replay_file) free(sdp->replay_file);
+		sdp->replay_file = strdup(string);
+		sdp->op_type = SCSI_CDB_OP;
+		continue;
 	    }
-	    /* Assume the log prefix is not required. */
-	    if (sdp->log_prefix) {
-		Free(sdp, sdp->log_prefix);
+	    case OPT_REPLAY_SCALE: {
+		sdp->replay_scale = (uint32_t)number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    sdp->log_prefix = strdup("");
-	    continue;
-	}
-	if (match (&string, "unpack_fmt=")) {
-	    if (match(&string, "dec")) {
-		sdp->unpack_data_fmt = DEC_FMT;
-	    } else if (match (&string, "hex")) {
-		sdp->unpack_data_fmt = HEX_FMT;
-	    } else {
-		Eprintf(sdp, "Valid unpack data formats are: dec or hex\n");
-		return ( HandleExit(sdp, FAILURE) );
+	    case OPT_INJECT: {
+		if (parse_inject_fault(sdp, string) == FAILURE) {
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
 	    }
-	    continue;
-	}
-	if ( match (&string, "exit") || match (&string, "quit") ) {
-	    ExitFlag = True;
-	    continue;
-	}
-        if (match (&string, "help")) {
-            Help(sdp);
-	    return ( HandleExit(sdp, SUCCESS) );
-        }
-	if (match (&string,  "showopcodes")) {
-	    char *opstr = NULL;
-	    if (++i < argc) {
-                opstr = argv[i];
-	    }
-	    ShowScsiOpcodes(sdp, opstr);
-	    return ( HandleExit(sdp, SUCCESS) );
-	}
-	/* ------------------------------------------------------------------------ */
-	if ( match(&string, "show") ) {
-	    int status = SUCCESS;
-	    if (++i < argc) {
-                string = argv[i];
-		if ( match(&string, "devices") || match(&string, "edt") ) {
-		    sdp->recovery_flag = True;
-		    sdp->report_format = REPORT_BRIEF;
-		    if (++i < argc) {
-			status = parse_show_devices_args(sdp, argv, argc, &i);
-		    }
-		} else if ( match(&string, "scsi") ) {
-		    if (++i < argc) {
-			status = parse_show_scsi_args(sdp, argv, argc, &i);
-			return ( HandleExit(sdp, status) );
-		    }
-		    /* No defaults, keywords must be specified! */
-		    Eprintf(sdp, "Valid show scsi keywords are: ascq|key|status|uec\n");
-		    status = FAILURE;
-		} else {
-		    Eprintf(sdp, "Valid show keywords are: devices|edt|scsi\n");
-		    status = FAILURE;
+	    case OPT_INJECT_LATENCY: {
+		if (parse_inject_latency(sdp, string) == FAILURE) {
+		    return ( HandleExit(sdp, FATAL_ERROR) );
 		}
-	    } else {
-		Eprintf(sdp, "Format is: show devices|scsi\n");
-		status = FAILURE;
+		continue;
 	    }
-	    if (status == FAILURE) {
-		return( HandleExit(sdp, status) );
+	    case OPT_TRACE: {
+		if (sdp->trace_file) free(sdp->trace_file);
+		sdp->trace_file = strdup(string);
+		continue;
 	    }
-	    sdp->op_type = SHOW_DEVICES_OP;
-	    sdp->log_prefix = strdup("");
-	    continue;
-	}
-	/*
-	 * Implement a few useful commands Scu supports. 
-	 */
-	if (match (&string, "eval")) {
-	    char *expr = concatenate_args(sdp, argc, argv, ++i);
-	    if (expr) {
-		uint64_t value;
-		value = large_number(sdp, expr, ANY_RADIX, &status, False);
-		show_expression(sdp, value);
-		Free(sdp, expr);
-	    }
-	    return ( HandleExit(sdp, SUCCESS) );
-	}
-	if ( match(&string, "system") || match(&string, "shell") ) {
-	    char *cmd = concatenate_args(sdp, argc, argv, ++i);
-	    if (cmd) {
-		(void)DoSystemCommand(sdp, cmd);
-		Free(sdp, cmd);
-	    } else {
-		(void)StartupShell(sdp, NULL);
+	    case OPT_TRACE_RECORDS: {
+		sdp->trace_records = large_number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    return ( HandleExit(sdp, SUCCESS) );
-	}
-	if (match (&string, "!")) {
-	    char *cmd = concatenate_args(sdp, argc, argv, i);
-	    if (cmd) {
-		(void)DoSystemCommand(sdp, (cmd + 1));
-		Free(sdp, cmd);
+	    case OPT_MAXBAD: {
+		sdp->max_bad_blocks = (uint32_t)number(sdp, string, ANY_RADIX, &status, False);
+		continue;
 	    }
-	    return ( HandleExit(sdp, SUCCESS) );
-	}
-        if (match (&string, "version")) {
-            Version(sdp);
-	    return ( HandleExit(sdp, SUCCESS) );
-        }
-	/*
-	 * I/O Options:
-	 */ 
-	if (match (&string, "blocks=")) {
-	    siop->cdb_blocks = large_number(sdp, string, ANY_RADIX, &status, False);
-	    sdp->encode_flag = True;
-	    sdp->verbose = False;
-	    continue;
-	}
-	if (match (&string, "bs=")) {
-	    uint64_t bytes = large_number(sdp, string, ANY_RADIX, &status, False);
-	    if (iop->device_size) {
-		siop->cdb_blocks = howmany(bytes, iop->device_size);
+	    case OPT_STEP: {
+		siop->step_value = large_number(sdp, string, ANY_RADIX, &status, False);
+		sdp->encode_flag = True;
+		sdp->verbose = False;
+		continue;
 	    }
-	    sdp->encode_flag = True;
-	    sdp->verbose = False;
-	    continue;
-	}
-	if (match (&string, "capacity=")) {
-	    siop->user_capacity = large_number(sdp, string, ANY_RADIX, &status, False);
-	    continue;
-	}
-	if (match (&string, "capacityp=")) {
-	    siop->capacity_percentage = (int)number(sdp, string, ANY_RADIX, &status, False);
-            if (siop->capacity_percentage > 100) {
-                Eprintf(sdp, "The capacity percentage range is 0-100!\n");
-                return ( HandleExit(sdp, FAILURE) );
-            }
-	    continue;
-	}
-	if (match (&string, "limit=")) {
-	    siop->data_limit = large_number(sdp, string, ANY_RADIX, &status, False);
-	    sdp->encode_flag = True;
-	    sdp->verbose = False;
-	    continue;
-	}
-	if (match (&string, "log=")) {
-	    if (sdp->log_file) Free(sdp, sdp->log_file);
-	    sdp->log_file = strdup(string);
-	    sdp->logheader_flag = True;
-	    continue;
-	}
-	if (match (&string, "logprefix=")) {
-	    if (sdp->log_prefix) Free(sdp, sdp->log_prefix);
-	    if (match(&string, "gtod")) { /* Short hand! */
-		sdp->log_prefix = strdup(DEFAULT_GTOD_LOG_PREFIX);
-	    } else {
-		sdp->log_prefix = strdup(string);
+	    case OPT_STARTING: {
+		siop->user_starting_lba = True;
+		siop->starting_lba = large_number(sdp, string, ANY_RADIX, &status, False);
+		sdp->encode_flag = True;
+		sdp->verbose = False;
+		continue;
 	    }
-	    continue;
-	}
-	if (match (&string, "lba=")) {
-	    siop->starting_lba = large_number(sdp, string, ANY_RADIX, &status, False);
-	    siop->ending_lba = (siop->starting_lba + 1);
-	    sdp->encode_flag = True;
-	    continue;
-	}
-	if (match (&string, "maxbad=")) {
-	    sdp->max_bad_blocks = (uint32_t)number(sdp, string, ANY_RADIX, &status, False);
-            continue;
-        }
-	if (match (&string, "step=")) {
-	    siop->step_value = large_number(sdp, string, ANY_RADIX, &status, False);
-	    sdp->encode_flag = True;
-	    sdp->verbose = False;
-	    continue;
-	}
-	if (match (&string, "starting=")) {
-	    siop->user_starting_lba = True;
-	    siop->starting_lba = large_number(sdp, string, ANY_RADIX, &status, False);
-	    sdp->encode_flag = True;
-	    sdp->verbose = False;
-	    continue;
-	}
-	if (match (&string, "ending=")) {
-	    siop->ending_lba = large_number(sdp, string, ANY_RADIX, &status, False);
-	    sdp->encode_flag = True;
-	    sdp->verbose = False;
-	    continue;
-	}
-	if (match (&string, "rod_token=")) {
-	    if (sdp->rod_token_file) free(sdp->rod_token_file);
-	    sdp->rod_token_file = strdup(string);
-	    /* Used by Populate Token and Receive ROD Token Info. */
-	    sdp->decode_flag = True;
-	    sdp->encode_flag = True;
-	    continue;
-	}
-	/*
-	 * Job Control Options:
-	 */
-	if (match (&string, "jobs")) {
-	    job_id_t job_id = 0;
-	    char *job_tag = NULL;
-	    hbool_t verbose = False;
-
-	    if (*string == ':') {
-		string++;
-		if (match (&string, "full")) {
-		    verbose = True;
-		}
+	    case OPT_ENDING: {
+		siop->ending_lba = large_number(sdp, string, ANY_RADIX, &status, False);
+		sdp->encode_flag = True;
+		sdp->verbose = False;
+		continue;
 	    }
-	    if (*string != '\0') {
-		status = parse_job_args(sdp, string, &job_id, &job_tag, True);
-	    } else if (++i < argc) {
-		string = argv[i++];
-		status = parse_job_args(sdp, string, &job_id, &job_tag, True);
-		if (status == WARNING) --i;
+	    case OPT_ROD_TOKEN: {
+		if (sdp->rod_token_file) free(sdp->rod_token_file);
+		sdp->rod_token_file = strdup(string);
+		/* Used by Populate Token and Receive ROD Token Info. */
+		sdp->decode_flag = True;
+		sdp->encode_flag = True;
+		continue;
 	    }
-	    if (status == FAILURE) {
-		return ( HandleExit(sdp, status) );
+	    /*
+	     * Job Control Options:
+	     */
+	    case OPT_JOBS: {
+		job_id_t job_id = 0;
+		char *job_tag = NULL;
+		hbool_t verbose = False;
+
+		if (*string == ':') {
+		    string++;
+		    if (match (&string, "full")) {
+			verbose = True;
+		    }
+		}
+		if (*string != '\0') {
+		    status = parse_job_args(sdp, string, &job_id, &job_tag, True);
+		} else if (++i < argc) {
+		    string = argv[i++];
+		    status = parse_job_args(sdp, string, &job_id, &job_tag, True);
+		    if (status == WARNING) --i;
+		}
+		if (status == FAILURE) {
+		    return ( HandleExit(sdp, status) );
+		}
+		status = show_jobs(sdp, job_id, job_tag, verbose);
+		return ( HandleExit(sdp, SUCCESS) );
 	    }
-	    status = show_jobs(sdp, job_id, job_tag, verbose);
-	    return ( HandleExit(sdp, SUCCESS) );
-	}
-	if (match (&string, "tag=")) {
-	    if (sdp->job_tag) {
-		free(sdp->job_tag);
+	    case OPT_TAG: {
+		if (sdp->job_tag) {
+		    free(sdp->job_tag);
+		}
+		sdp->job_tag = strdup(string);
+		continue;
 	    }
-	    sdp->job_tag = strdup(string);
-	    continue;
-	}
-	if (match (&string, "wait")) {
-	    job_id_t job_id = 0;
-	    char *job_tag = NULL;
+	    case OPT_WAIT: {
+		job_id_t job_id = 0;
+		char *job_tag = NULL;
 	    
-	    status = SUCCESS;
-	    if (*string != '\0') {
-		status = parse_job_args(sdp, string, &job_id, &job_tag, True);
-	    } else if (++i < argc) {
-		string = argv[i++];
-		status = parse_job_args(sdp, string, &job_id, &job_tag, True);
-	    }
-	    if (status == FAILURE) {
+		status = SUCCESS;
+		if (*string != '\0') {
+		    status = parse_job_args(sdp, string, &job_id, &job_tag, True);
+		} else if (++i < argc) {
+		    string = argv[i++];
+		    status = parse_job_args(sdp, string, &job_id, &job_tag, True);
+		}
+		if (status == FAILURE) {
+		    return ( HandleExit(sdp, status) );
+		}
+		status = wait_for_jobs(sdp, job_id, job_tag);
+		workload_jobs_finished(sdp, job_tag);
 		return ( HandleExit(sdp, status) );
 	    }
-	    status = wait_for_jobs(sdp, job_id, job_tag);
-	    return ( HandleExit(sdp, status) );
-	}
-	/* End of jobs options. */
-	/* A simple way to set some environment variables for scripts! */
-	if ( match(&string, "$") && (p = strstr(string, "=")) ) {
-	    *p++ = '\0';
-	    // int setenv(const char *envname, const char *envval, int overwrite);
-	    if (setenv(string, p, TRUE)) {
-		Perror(sdp, "setenv() of envname=%s, envvar=%s failed!", string, p);
-		return ( HandleExit(sdp, FATAL_ERROR) );
+	    /* End of jobs options. */
+	    /* A simple way to set some environment variables for scripts! */
+	    case OPT_SETENV: {
+		if ( (p = strstr(string, "=")) == NULL) {
+		    break;
+		}
+		*p++ = '\0';
+		// int setenv(const char *envname, const char *envval, int overwrite);
+		if (setenv(string, p, TRUE)) {
+		    Perror(sdp, "setenv() of envname=%s, envvar=%s failed!", string, p);
+		    return ( HandleExit(sdp, FATAL_ERROR) );
+		}
+		continue;
 	    }
-	    continue;
+	    default:
+		break;
 	}
 	if (sdp->script_level) {
 	    int level = (sdp->script_level - 1);
@@ -4921,7 +6386,7 @@ ReadDataFile(
 int
 DoErrorControl(scsi_device_t *sdp, int status)
 {
-    if (CmdInterruptedFlag) return(FAILURE);
+    if (CmdInterrupted(sdp)) return(FAILURE);
     if ( (status == SUCCESS) || (status == WARNING) ) {
 	return(CONTINUE);
     }
@@ -4963,6 +6428,21 @@ do_common_thread_startup(scsi_device_t *sdp)
 	/* Log the header for the first thread.*/
 	log_header(sdp);
     }
+    if (sdp->trace_file) {
+	if ( (status = create_cmd_trace(sdp)) == FAILURE) {
+	    return(status);
+	}
+    }
+    if (sdp->job_tag) {
+	if ( (status = create_workload_stats(sdp)) == FAILURE) {
+	    return(status);
+	}
+    }
+    if (sdp->inject_data) {
+	if ( (status = create_inject_thread(sdp)) == FAILURE) {
+	    return(status);
+	}
+    }
     
     /* Display SCSI information, if enabled. */
     /* Logs to all thread logs, otherwise only 1st thread! */
@@ -5305,7 +6785,7 @@ init_pthread_attributes(scsi_device_t *sdp)
  * Return Value:
  *      Returns a pointer to the device information data structure.
  */
-static scsi_device_t *
+scsi_device_t *
 init_device_information(void)
 {
     scsi_device_t	*sdp;
@@ -5328,6 +6808,7 @@ init_device_information(void)
     sdp->efp = efp; // = stderr;
     sdp->ofp = ofp; // = stdout;
     sdp->dir_sep = DIRSEP;
+    sdp->cmd_interrupted = &CmdInterruptedFlag;
     sdp->file_sep = strdup(DEFAULT_FILE_SEP);
     sdp->file_postfix = strdup(DEFAULT_FILE_POSTFIX);
 
@@ -5440,10 +6921,44 @@ init_device_defaults(scsi_device_t *sdp)
     sdp->retry_limit	= RetryLimitDefault;
     sdp->rrti_wut_flag	= False;
     sdp->zero_rod_flag	= False;
+    sdp->sparse_flag	= False;
+    sdp->first_write_flag = False;
+    sdp->verify_offload	= False;
+    sdp->caw_locks	= 0;
+    sdp->caw_contention	= NULL;
+    sdp->caw_thread	= NULL;
+    sdp->manifest_file	= NULL;
+    sdp->crc_manifest	= NULL;
+    sdp->trace_file	= NULL;
+    sdp->bench_file	= NULL;
+    sdp->bench_baseline	= NULL;
+    sdp->bench_threshold = BENCH_THRESHOLD_DEFAULT;
+    sdp->trace_records	= CMD_TRACE_RECORDS;
+    sdp->cmd_trace	= NULL;
+    sdp->replay_file	= NULL;
+    sdp->replay_scale	= 100;
+    sdp->cmd_replay	= NULL;
+    sdp->workload_stats	= NULL;
+    sdp->inject_rule_count = 0;
+    sdp->inject_delay	= INJECT_DELAY_NONE;
+    sdp->inject_delay_min = 0;
+    sdp->inject_delay_max = 0;
+    sdp->inject_delay_percent = 100.0;
+    sdp->inject_data	= NULL;
+    sdp->inject_thread	= NULL;
+    sdp->pi_type	= 1;
+    sdp->rdprotect	= 0;
+    sdp->wrprotect	= 0;
+    sdp->pi_apptag	= 0;
+    sdp->pi_appmask	= 0xFFFF;
+    sdp->pi_check_apptag = False;
+    sdp->pi_reftag	= 0;
+    sdp->pi_reftag_policy = PI_REFTAG_LBA;
     sdp->runtime	= 0;
     sdp->din_file	= NULL;
     sdp->dout_file	= NULL;
     sdp->rod_token_file	= NULL;
+    sdp->lba_map_file	= NULL;
     sdp->iomode		= IOMODE_TEST;
     sdp->cmd_type	= CMD_TYPE_NONE;
     sdp->cgs_type	= CGS_TYPE_NONE;
@@ -5459,10 +6974,19 @@ init_device_defaults(scsi_device_t *sdp)
     sdp->threads	= ThreadsDefault;
     sdp->user_data	= False;
     sdp->user_pattern	= False;
+    sdp->user_threads	= False;
     sdp->compare_data	= CompareFlagDefault;
     sdp->image_copy	= ImageModeFlagDefault;
     sdp->json_pretty	= JsonPrettyFlagDefault;
     sdp->iot_seed	= IOT_SEED;
+    sdp->dr_pattern	= False;
+    sdp->compress_percent = 0;
+    sdp->dedupe_percent	= 0;
+    sdp->dedupe_unit	= DR_DEDUPE_UNIT;
+    sdp->dr_seed	= DR_SEED;
+    sdp->rnd_pattern	= False;
+    sdp->rnd_seed	= RND_SEED;
+    sdp->rnd_pass	= 0;
     sdp->iot_pattern	= False;
     sdp->range_count	= RangeCountDefault;
     sdp->segment_count	= SegmentCountDefault;
@@ -147,6 +147,9 @@
 #define DumpLimitDefault	KBYTE_SIZE
 #define ScriptLevels		5
 #define IOT_SEED		0x01010101 /* Default IOT pattern seed.	*/
+#define DR_SEED			0x9E3779B97F4A7C15ULL /* Data reduction seed. */
+#define DR_DEDUPE_UNIT		4096		/* The dedupe unit size.	*/
+#define RND_SEED		0x5DEECE66D1234567ULL /* Random pattern seed. */
 
 #define SataDeviceFlagDefault	False	/* Controls SATA ASCII decoding.*/
 #define SenseFlagDefault	True
@@ -286,7 +289,9 @@ typedef enum spt_op {
     SCAN_BUS_OP,
     RESUME_IO_OP,
     SUSPEND_IO_OP,
-    SHOW_DEVICES_OP
+    SHOW_DEVICES_OP,
+    ANALYZE_TRACE_OP,
+    BENCHMARK_OP
 } spt_op_t;
 
 /*
@@ -322,10 +327,438 @@ typedef struct scsi_information {
     //uint32_t	si_block_length;	/* The device block length.	*/
 } scsi_information_t;
 
+/*
+ * Get LBA Status Extent Information:
+ */
+typedef struct lba_extent {
+    uint64_t	starting_lba;		/* The starting logical block.	*/
+    uint64_t	extent_length;		/* The extent length (blocks).	*/
+    uint8_t	provisioning_status;	/* The provisioning status.	*/
+} lba_extent_t;
+
+/*
+ * Command Latency Statistics: (log-linear buckets, see spt_latency.c)
+ */
+#define LATENCY_SUB_BUCKETS	16	/* Sub-buckets per power of 2.	*/
+#define LATENCY_BUCKETS		(64 * LATENCY_SUB_BUCKETS)
+
+typedef struct latency_stats {
+    uint64_t	ls_count;		/* The number of commands.	*/
+    uint64_t	ls_bytes;		/* The bytes transferred.	*/
+    uint64_t	ls_total_usecs;		/* The total latency.		*/
+    uint64_t	ls_min_usecs;		/* The minimum latency.		*/
+    uint64_t	ls_max_usecs;		/* The maximum latency.		*/
+    uint64_t	ls_buckets[LATENCY_BUCKETS]; /* The latency histogram.	*/
+} latency_stats_t;
+
+/*
+ * Thin Provisioning First Write Classes:
+ */
+typedef enum thin_write_class {
+    THIN_WRITE_FRESH,			/* Write to deallocated blocks.	*/
+    THIN_WRITE_OVERWRITE,		/* Write to mapped blocks.	*/
+    THIN_WRITE_UNKNOWN,			/* Write to unknown status.	*/
+    THIN_WRITE_AFTER_UNMAP,		/* Rewrite after unmapping.	*/
+    THIN_WRITE_UNMAP,			/* The unmap commands.		*/
+    THIN_WRITE_CLASSES
+} thin_write_class_t;
+
+/*
+ * Data Verification Paths: (host read and compare vs. Verify(16) BYTCHK)
+ */
+typedef enum verify_path {
+    VERIFY_HOST_COMPARE,		/* Read and compare on host.	*/
+    VERIFY_TARGET_COMPARE,		/* Verify(16) compare on target.*/
+    VERIFY_PATHS
+} verify_path_t;
+
+typedef struct verify_stats {
+    uint64_t	vs_commands;		/* The verify operations.	*/
+    uint64_t	vs_bytes;		/* The bytes verified.		*/
+    uint64_t	vs_single_blocks;	/* BYTCHK=3 operations.		*/
+    uint64_t	vs_elapsed_usecs;	/* The elapsed verify time.	*/
+    uint64_t	vs_cpu_usecs;		/* The host CPU time used.	*/
+} verify_stats_t;
+
+/*
+ * Compare and Write (CAW) Contention Information:
+ */
+#define CAW_LOCK_MAGIC		"SPTCAWLK"
+
+typedef struct caw_lock_record {
+    char	clr_magic[8];		/* The lock record magic.	*/
+    uint8_t	clr_owner[4];		/* The owner thread number.	*/
+    uint8_t	clr_generation[8];	/* The owner lock generation.	*/
+    uint8_t	clr_timestamp[8];	/* The acquire time (usecs).	*/
+} caw_lock_record_t;
+
+typedef struct caw_stats {
+    uint64_t	cs_acquires;		/* Successful lock acquires.	*/
+    uint64_t	cs_miscompares;		/* Miscompares (lost races).	*/
+    uint64_t	cs_errors;		/* Other command errors.	*/
+    uint64_t	cs_max_attempts;	/* Maximum attempts to acquire.	*/
+    latency_stats_t cs_caw_latency;	/* Each CAW command latency.	*/
+    latency_stats_t cs_acquire_latency;	/* Latency including retries.	*/
+} caw_stats_t;
+
+typedef struct caw_contention {
+    pthread_mutex_t cc_lock;		/* The contention data lock.	*/
+    int		cc_references;		/* The thread references.	*/
+    int		cc_contenders;		/* The contending threads.	*/
+    int		cc_paths;		/* The device paths used.	*/
+    uint64_t	cc_start_usecs;		/* The starting time.		*/
+    caw_stats_t	cc_stats;		/* The merged thread statistics.*/
+} caw_contention_t;
+
+/*
+ * T10 Protection Information: (see spt_pi.c)
+ */
+#define PI_TUPLE_SIZE		8	/* Guard, application, reference.	*/
+#define PI_APP_TAG_ESCAPE	0xFFFF	/* Disables checking (types 1/2).	*/
+#define PI_REF_TAG_ESCAPE	0xFFFFFFFF /* With app escape, for type 3.	*/
+
+typedef enum pi_reftag_policy {
+    PI_REFTAG_LBA,			/* Lower 32 bits of the LBA.	*/
+    PI_REFTAG_FIXED,			/* User value (+ block offset).	*/
+    PI_REFTAG_NONE			/* Not checked by the host.	*/
+} pi_reftag_policy_t;
+
+typedef struct pi_tuple {
+    uint8_t	guard_tag[2];		/* CRC16-T10DIF of block data.	*/
+    uint8_t	application_tag[2];	/* The application tag.		*/
+    uint8_t	reference_tag[4];	/* The reference tag.		*/
+} pi_tuple_t;
+
+/*
+ * CRC32C Manifest Information: (see spt_manifest.c)
+ */
+#define CRC_MANIFEST_MAGIC	"SPTCRC32"
+#define CRC_MANIFEST_VERSION	1
+
+typedef struct crc_manifest_header {
+    char	cmh_magic[8];		/* The manifest magic string.	*/
+    uint32_t	cmh_version;		/* The manifest version.	*/
+    uint32_t	cmh_block_size;		/* The device block size.	*/
+    uint64_t	cmh_capacity;		/* The device capacity (blocks).*/
+    uint64_t	cmh_first_lba;		/* The first LBA written.	*/
+    uint64_t	cmh_last_lba;		/* The last LBA written.	*/
+    uint8_t	cmh_reserved[24];	/* Reserved (pad to 64 bytes).	*/
+} crc_manifest_header_t;
+
+typedef struct crc_manifest_stats {
+    uint64_t	cms_recorded;		/* The block CRC's recorded.	*/
+    uint64_t	cms_verified;		/* The block CRC's verified.	*/
+    uint64_t	cms_missing;		/* Blocks not in the manifest.	*/
+    uint64_t	cms_mismatches;		/* The block CRC mismatches.	*/
+    uint64_t	cms_bytes;		/* The bytes processed.		*/
+    uint64_t	cms_first_lba;		/* The first LBA recorded.	*/
+    uint64_t	cms_last_lba;		/* The last LBA recorded.	*/
+} crc_manifest_stats_t;
+
+typedef struct crc_manifest {
+    pthread_mutex_t cm_lock;		/* The manifest data lock.	*/
+    int		cm_references;		/* The thread references.	*/
+    char	*cm_file;		/* The manifest file name.	*/
+    hbool_t	cm_writing;		/* Recording (vs. verifying).	*/
+    HANDLE	cm_handle;		/* The manifest file handle.	*/
+    uint8_t	*cm_map;		/* The mapped manifest file.	*/
+    size_t	cm_map_size;		/* The mapped manifest size.	*/
+    crc_manifest_header_t *cm_header;	/* The manifest header.		*/
+    uint32_t	*cm_crcs;		/* The CRC's indexed by LBA.	*/
+    uint8_t	*cm_flags;		/* The valid CRC flags by LBA.	*/
+    uint64_t	cm_capacity;		/* The manifest capacity.	*/
+    uint64_t	cm_start_usecs;		/* The starting time.		*/
+    crc_manifest_stats_t cm_stats;	/* The merged thread statistics.*/
+} crc_manifest_t;
+
+/*
+ * Binary Command Trace Information: (see spt_trace.c)
+ */
+#define CMD_TRACE_MAGIC		"SPTTRACE"
+#define CMD_TRACE_VERSION	2
+#define CMD_TRACE_RECORDS	65536	/* Default ring size (records).	*/
+#define CMD_TRACE_PARAM_BYTES	64	/* Parameter data per record.	*/
+#define CMD_TRACE_PARAM_MAX	65536	/* Largest parameter data list.	*/
+#define CMD_TRACE_DEVICES	2	/* The device names recorded.	*/
+#define CMD_TRACE_DSF_SIZE	224	/* The device name size.	*/
+#define CMD_TRACE_CDB_SIZE	32	/* The largest CDB recorded.	*/
+
+#define REPLAY_LATE_USECS	1000	/* Replay is late threshold.	*/
+
+#define CTR_FLAG_OS_ERROR	0x01	/* The system call failed.	*/
+#define CTR_FLAG_SCSI_ERROR	0x02	/* The SCSI command failed.	*/
+#define CTR_FLAG_PARAM_DATA	0x04	/* The parameter data traced.	*/
+
+typedef struct cmd_trace_header {
+    char	cth_magic[8];		/* The trace file magic string.	*/
+    uint32_t	cth_version;		/* The trace file version.	*/
+    uint32_t	cth_record_size;	/* The size of each record.	*/
+    uint64_t	cth_record_limit;	/* The ring size (in records).	*/
+    uint64_t	cth_sequence;		/* The total records recorded.	*/
+    uint64_t	cth_start_usecs;	/* The trace start time.	*/
+    uint32_t	cth_thread_number;	/* The thread number.		*/
+    uint32_t	cth_devices;		/* The number of devices.	*/
+    uint64_t	cth_param_limit;	/* The parameter ring (bytes).	*/
+    uint64_t	cth_param_offset;	/* The total parameter bytes.	*/
+    char	cth_dsf[CMD_TRACE_DEVICES][CMD_TRACE_DSF_SIZE];
+} cmd_trace_header_t;
+
+typedef struct cmd_trace_record {
+    uint64_t	ctr_timestamp;		/* The command start (usecs).	*/
+    uint64_t	ctr_lba;		/* The logical block address.	*/
+    uint32_t	ctr_length;		/* The data length (bytes).	*/
+    uint32_t	ctr_resid;		/* The data residual (bytes).	*/
+    uint32_t	ctr_latency;		/* The command latency (usecs).	*/
+    uint16_t	ctr_thread;		/* The thread number.		*/
+    uint8_t	ctr_device;		/* The device index.		*/
+    uint8_t	ctr_cdb_size;		/* The CDB size.		*/
+    uint8_t	ctr_data_dir;		/* The data direction.		*/
+    uint8_t	ctr_scsi_status;	/* The SCSI status.		*/
+    uint8_t	ctr_sense_key;		/* The sense key.		*/
+    uint8_t	ctr_asc;		/* The additional sense code.	*/
+    uint8_t	ctr_ascq;		/* The sense code qualifier.	*/
+    uint8_t	ctr_flags;		/* The trace record flags.	*/
+    uint16_t	ctr_retries;		/* The recovery retries.	*/
+    uint16_t	ctr_host_status;	/* The host status.		*/
+    uint16_t	ctr_driver_status;	/* The driver status.		*/
+    uint32_t	ctr_os_error;		/* The OS error (if any).	*/
+    uint8_t	ctr_cdb[CMD_TRACE_CDB_SIZE]; /* The CDB bytes.		*/
+    uint64_t	ctr_param_offset;	/* The parameter data offset.	*/
+    uint32_t	ctr_param_length;	/* The parameter data length.	*/
+    uint32_t	ctr_reserved;		/* Reserved (pad to 96 bytes).	*/
+} cmd_trace_record_t;
+
+typedef struct cmd_trace {
+    char	*ct_file;		/* The trace file name.		*/
+    HANDLE	ct_handle;		/* The trace file handle.	*/
+    uint8_t	*ct_map;		/* The mapped trace file.	*/
+    size_t	ct_map_size;		/* The mapped trace size.	*/
+    cmd_trace_header_t *ct_header;	/* The trace file header.	*/
+    cmd_trace_record_t *ct_records;	/* The trace record ring.	*/
+    uint8_t	*ct_params;		/* The parameter data ring.	*/
+    /* Replay Information: */
+    uint64_t	ct_first;		/* The oldest record in ring.	*/
+    uint64_t	ct_count;		/* The records in the ring.	*/
+    uint64_t	ct_next;		/* The next record to replay.	*/
+    uint64_t	ct_base_usecs;		/* The first record timestamp.	*/
+    uint64_t	ct_pass_usecs;		/* The replay pass start time.	*/
+    uint64_t	ct_start_usecs;		/* The replay start time.	*/
+    uint8_t	*ct_buffer;		/* The replay data buffer.	*/
+    uint32_t	ct_buffer_size;		/* The replay buffer size.	*/
+    uint64_t	ct_replayed;		/* The commands replayed.	*/
+    uint64_t	ct_skipped;		/* Parameter data CDB's skipped.*/
+    uint64_t	ct_errors;		/* The commands that failed.	*/
+    uint64_t	ct_late;		/* The commands issued late.	*/
+    uint64_t	ct_max_late_usecs;	/* The maximum lateness (usecs).*/
+    uint64_t	ct_bytes;		/* The bytes transferred.	*/
+} cmd_trace_t;
+
+/*
+ * Workload Definitions: (see spt_workload.c)
+ */
+typedef struct workload_stats {
+    latency_stats_t ws_latency;		/* The command latency.		*/
+    uint64_t	ws_errors;		/* The commands that failed.	*/
+    uint64_t	ws_start_usecs;		/* The earliest thread start.	*/
+    int		ws_threads;		/* The threads merged.		*/
+    int		ws_group;		/* The workload group index.	*/
+} workload_stats_t;
+
+typedef struct workload_group {
+    char	*wg_name;		/* The group name.		*/
+    char	*wg_options;		/* The group spt options.	*/
+    int		wg_threads;		/* The group thread count.	*/
+    workload_stats_t wg_stats;		/* The merged phase statistics.	*/
+} workload_group_t;
+
+typedef struct workload_phase {
+    char	*wp_name;		/* The phase name.		*/
+    char	*wp_runtime;		/* The phase runtime.		*/
+    int		*wp_groups;		/* The group indexes to run.	*/
+    int		wp_group_count;		/* The number of groups to run.	*/
+} workload_phase_t;
+
+typedef struct workload {
+    char	*wl_file;		/* The workload file name.	*/
+    char	*wl_name;		/* The workload name.		*/
+    char	*wl_options;		/* Options common to all groups.*/
+    workload_group_t *wl_groups;	/* The thread groups.		*/
+    int		wl_group_count;		/* The number of thread groups.	*/
+    workload_phase_t *wl_phases;	/* The sequential phases.	*/
+    int		wl_phase_count;		/* The number of phases.	*/
+    int		wl_phase;		/* The phase being executed.	*/
+    pthread_mutex_t wl_lock;		/* Protects merged statistics.	*/
+    workload_stats_t wl_total;		/* The workload statistics.	*/
+} workload_t;
+
+/*
+ * Fault and Latency Injection Definitions: (see spt_inject.c)
+ */
+#define INJECT_MAX_RULES	8	/* The maximum injection rules.	*/
+
+typedef enum inject_fault {
+    INJECT_BUSY,			/* SCSI BUSY status.		*/
+    INJECT_QUEUE_FULL,			/* SCSI QUEUE FULL status.	*/
+    INJECT_UNIT_ATTENTION,		/* Unit Attention (reset).	*/
+    INJECT_NOT_READY,			/* Not Ready (becoming ready).	*/
+    INJECT_MEDIUM_ERROR,		/* Medium Error (unrecovered).	*/
+    INJECT_TRANSPORT,			/* Transport disrupted.		*/
+    INJECT_TIMEOUT,			/* Command timeout.		*/
+    INJECT_NONE				/* No fault (also the count).	*/
+} inject_fault_t;
+
+typedef enum inject_delay_type {
+    INJECT_DELAY_NONE,			/* No latency injected.		*/
+    INJECT_DELAY_FIXED,			/* A fixed latency.		*/
+    INJECT_DELAY_UNIFORM,		/* Uniform between min and max.	*/
+    INJECT_DELAY_EXPONENTIAL		/* Exponential with min mean.	*/
+} inject_delay_type_t;
+
+typedef struct inject_rule {
+    inject_fault_t ir_fault;		/* The fault to inject.		*/
+    double	ir_percent;		/* The percentage of commands.	*/
+    uint64_t	ir_starting_lba;	/* The starting LBA (if any).	*/
+    uint64_t	ir_ending_lba;		/* The ending LBA (inclusive).	*/
+} inject_rule_t;
+
+typedef struct inject_stats {
+    uint64_t	is_faults;		/* The faults injected.		*/
+    uint64_t	is_recovered;		/* Commands that then succeeded.*/
+    uint64_t	is_failed;		/* Commands that then failed.	*/
+    latency_stats_t is_latency;		/* The command latency.		*/
+} inject_stats_t;
+
+typedef struct inject_data {
+    pthread_mutex_t id_lock;		/* The injection data lock.	*/
+    int		id_references;		/* The thread references.	*/
+    int		id_threads;		/* The number of threads.	*/
+    uint64_t	id_start_usecs;		/* The starting time.		*/
+    uint64_t	id_delays;		/* The latencies injected.	*/
+    uint64_t	id_delay_usecs;		/* The total latency injected.	*/
+    inject_stats_t id_stats[INJECT_NONE+1]; /* The merged statistics.	*/
+} inject_data_t;
+
+typedef struct inject_thread {
+    uint64_t	it_random;		/* The random number state.	*/
+    inject_fault_t it_fault;		/* The first fault this command.*/
+    uint64_t	it_delays;		/* The latencies injected.	*/
+    uint64_t	it_delay_usecs;		/* The total latency injected.	*/
+    inject_stats_t it_stats[INJECT_NONE+1]; /* Per fault statistics.	*/
+} inject_thread_t;
+
+/*
+ * Emit Status Program Definitions: (see spt_fmt.c)
+ *
+ * Emit status formats are compiled once into a list of instructions, each
+ * either literal text or a keyword opcode, which is then executed for each
+ * command, rather than parsing the format string each time.
+ */
+#define EMIT_PROGRAMS		4	/* Compiled formats per device.	*/
+
+typedef enum emit_opcode {
+    EOP_TEXT, EOP_PROGNAME, EOP_THREAD, EOP_ADSF, EOP_DSF1, EOP_DSF,
+    EOP_SRCS, EOP_SRC1, EOP_SRC2, EOP_SRC, EOP_CDB, EOP_DIR, EOP_LENGTH,
+    EOP_STATUS_MSG, EOP_STATUS, EOP_SCSI_NAME, EOP_SCSI_MSG, EOP_SCSI_STATUS,
+    EOP_HOST_STATUS, EOP_HOST_MSG, EOP_DRIVER_STATUS, EOP_DRIVER_MSG,
+    EOP_SENSE_CODE, EOP_SENSE_MSG, EOP_RESID, EOP_TIMEOUT, EOP_BLOCKS,
+    EOP_STARTING, EOP_ENDING, EOP_CAPACITY, EOP_DEVICE_SIZE, EOP_DEALLOCATED,
+    EOP_MAPPED, EOP_ITERATIONS, EOP_OPERATIONS, EOP_XFER, EOP_TOTAL_BLOCKS,
+    EOP_TOTAL_OPERATIONS, EOP_TOTAL_BYTES, EOP_SENSE_DATA, EOP_CSPEC_DATA,
+    EOP_INFO_VALID, EOP_INFO_DATA, EOP_SENSE_KEY, EOP_SKEY_MSG, EOP_ILI,
+    EOP_EOM, EOP_FM, EOP_ASCQ_MSG, EOP_ASCQ, EOP_ASC, EOP_ASQ, EOP_FRU,
+    EOP_DATE, EOP_SECONDS, EOP_START_TIME, EOP_END_TIME, EOP_ELAPSED_TIME,
+    EOP_BPS, EOP_LBPS, EOP_KBPS, EOP_MBPS, EOP_IOPS, EOP_SPIO
+} emit_opcode_t;
+
+typedef struct emit_instr {
+    emit_opcode_t ei_opcode;		/* The instruction opcode.	*/
+    char	*ei_text;		/* The literal text (EOP_TEXT).	*/
+    size_t	ei_length;		/* The literal text length.	*/
+} emit_instr_t;
+
+typedef struct emit_program {
+    char	*ep_format;		/* The format compiled.		*/
+    hbool_t	ep_json_default;	/* The default JSON format.	*/
+    int		ep_count;		/* The instruction count.	*/
+    emit_instr_t *ep_instrs;		/* The instructions.		*/
+    char	*ep_text;		/* The literal text buffer.	*/
+} emit_program_t;
+
+/*
+ * Benchmark Definitions: (see spt_bench.c)
+ */
+#define BENCH_THRESHOLD_DEFAULT	25	/* Regression threshold (%).	*/
+
+/*
+ * Shared Library Definitions: (see the handle interface in spt.c)
+ *
+ * Note: The data pointer references a buffer owned by the handle, which
+ * remains valid until the next command or spt_close() of that handle.
+ */
+typedef struct spt_result {
+    int		sr_status;		/* The command exit status.	*/
+    uint8_t	sr_scsi_status;		/* The SCSI status code.	*/
+    uint8_t	sr_sense_key;		/* The sense key.		*/
+    uint8_t	sr_asc;			/* The additional sense code.	*/
+    uint8_t	sr_ascq;		/* The additional sense qual.	*/
+    uint32_t	sr_host_status;		/* The host status.		*/
+    uint32_t	sr_driver_status;	/* The driver status.		*/
+    uint32_t	sr_data_resid;		/* The data residual count.	*/
+    uint32_t	sr_data_length;		/* The data-in bytes returned.	*/
+    uint64_t	sr_duration;		/* The command time (usecs).	*/
+    uint8_t	*sr_data;		/* The data-in buffer (or NULL).*/
+    uint32_t	sr_sense_length;	/* The sense data length.	*/
+    uint8_t	sr_sense_data[RequestSenseDataLength]; /* The sense data.*/
+} spt_result_t;
+
+typedef enum spt_output {
+    SPT_OUTPUT_STDOUT = 1,		/* Standard output text.	*/
+    SPT_OUTPUT_STDERR = 2,		/* Standard error text.		*/
+    SPT_OUTPUT_EMIT = 3			/* Emit status text.		*/
+} spt_output_t;
+
+/* Called with each chunk of output as it's produced, serialized per handle. */
+typedef void (*spt_output_func_t)(void *arg, spt_output_t stream, char *buffer, int length);
+
+/*
+ * Emulated Device Definitions: (see spt_emulator.c)
+ */
+#define EMU_DSF_PREFIX		"emu:"	/* The emulated device prefix.	*/
+#define EMU_CHUNK_SIZE		MBYTE_SIZE /* The allocation chunk size.*/
+#define EMU_DEFAULT_SIZE	GBYTE_SIZE /* The default device size.	*/
+
+typedef struct emu_device {
+    struct emu_device *ed_next;		/* The next emulated device.	*/
+    char	*ed_dsf;		/* The device name (emu:...).	*/
+    uint64_t	ed_capacity;		/* The capacity (in blocks).	*/
+    uint32_t	ed_block_length;	/* The logical block length.	*/
+    uint32_t	ed_latency;		/* The media access latency.	*/
+    uint32_t	ed_chunk_blocks;	/* The blocks per chunk.	*/
+    uint64_t	ed_chunk_count;		/* The number of chunks.	*/
+    uint8_t	**ed_chunks;		/* The chunks (NULL = unmapped).*/
+    char	*ed_file;		/* The backing file (if any).	*/
+    HANDLE	ed_fd;			/* The backing file handle.	*/
+    uint32_t	ed_lun;			/* The emulated LUN number.	*/
+    pthread_mutex_t ed_lock;		/* Serializes media access.	*/
+} emu_device_t;
+
+typedef struct caw_thread {
+    struct io_params *ct_iop;		/* The device path used.	*/
+    scsi_generic_t *ct_sgp;		/* The CAW and read requests.	*/
+    uint8_t	*ct_locks;		/* Cached lock contents.	*/
+    uint8_t	*ct_buffer;		/* Compare and write buffer.	*/
+    uint64_t	ct_starting_lba;	/* The first lock LBA.		*/
+    uint32_t	ct_lock_blocks;		/* The blocks per lock.		*/
+    uint32_t	ct_lock_bytes;		/* The bytes per lock.		*/
+    uint64_t	ct_random;		/* The lock selection state.	*/
+    uint64_t	ct_generation;		/* The lock generation.		*/
+    caw_stats_t	ct_stats;		/* This threads statistics.	*/
+} caw_thread_t;
+
 /*
  * Per Device I/O Parameters:
  */ 
-typedef struct {
+typedef struct io_params {
     scsi_opcode_t *sop;			/* The SCSI opcode data.	*/
     vendor_id_t	vendor_id;		/* The vendor ID (internal).	*/
     product_id_t product_id;		/* The product ID (internal).	*/
@@ -361,6 +794,7 @@ typedef struct {
     uint64_t	block_limit;		/* Data transfer block limit.	*/
     uint64_t	blocks_transferred;	/* Request blocks transferred.	*/
     uint64_t	operations;		/* The SCSI operations executed.*/
+    uint64_t	cmd_latency;		/* Last command latency (usecs).*/
     uint64_t	total_blocks;		/* The total blocks transferred.*/
     uint64_t	total_transferred;	/* Total data bytes transferred.*/
     /* Token based xcopy Information: */
@@ -391,7 +825,33 @@ typedef struct {
     /* Get LBA Status Parameters: */
     uint64_t	deallocated_blocks;	/* Deallocated blocks (holes).	*/
     uint64_t	mapped_blocks;		/* The mapped blocks (data).	*/
+    uint64_t	anchored_blocks;	/* The anchored blocks.		*/
     uint64_t	total_lba_blocks;	/* Total LBA blocks processed.	*/
+    lba_extent_t *lba_extents;		/* The extents for this slice.	*/
+    uint32_t	lba_extent_count;	/* The number of extents.	*/
+    uint32_t	lba_extent_entries;	/* The extent entries allocated.*/
+
+    /* Sparse Copy/Verify Parameters: */
+    lba_extent_t *sparse_extents;	/* Cached Get LBA Status extents*/
+    uint32_t	sparse_extent_count;	/* The cached extent count.	*/
+    uint64_t	sparse_skipped_blocks;	/* Deallocated blocks skipped.	*/
+    uint64_t	sparse_unmapped_blocks;	/* Destination blocks unmapped.	*/
+
+    /* Thin Provisioning First Write Parameters: */
+    thin_write_class_t thin_write_class; /* The current write class.	*/
+    hbool_t	thin_write_unmapped;	/* Rewriting unmapped blocks.	*/
+    latency_stats_t *thin_write_stats;	/* Per class write statistics.	*/
+
+    /* T10 Protection Information Parameters: */
+    uint8_t	pi_protect;		/* The current CDB protect field.*/
+    uint32_t	pi_initial_reftag;	/* The initial reference tag.	*/
+    uint8_t	*pi_buffer;		/* Interleaved data + PI buffer.*/
+    uint32_t	pi_buffer_size;		/* The PI buffer size.		*/
+    void	*pi_saved_buffer;	/* The saved data buffer.	*/
+    uint32_t	pi_saved_length;	/* The saved data length.	*/
+
+    /* Data Verification Statistics: */
+    verify_stats_t verify_stats[VERIFY_PATHS]; /* Host vs. target compare. */
 
     /* Receive Copy Operating Parameters: (only what we use today) */
     uint16_t	max_segment_descriptors;/* Max segment desc count.	*/
@@ -420,6 +880,7 @@ typedef struct {
     hbool_t	warning_displayed;	/* Multiple warnings flag.	*/
 
     scsi_information_t *sip;		/* Various SCSI information.	*/
+    emu_device_t *emu_device;		/* The emulated device (if any).*/
 
     /* per device SCSI pass-through data */
     scsi_generic_t sg;			/* The SCSI generic data.	*/
@@ -485,6 +946,8 @@ typedef struct scsi_device {
     hbool_t	genspt_flag;		/* Generate spt command flag.	*/
     hbool_t	image_copy;		/* Image copy flag (strict).	*/
     hbool_t	iot_pattern;		/* IOT test pattern selected.	*/
+    hbool_t	dr_pattern;		/* Data reduction pattern.	*/
+    hbool_t	rnd_pattern;		/* Random pattern selected.	*/
     hbool_t	json_pretty;		/* JSON pretty output control.	*/
     hbool_t	log_header_flag;	/* The log header control flag.	*/
     hbool_t	prewrite_flag;		/* Prewrite data blocks flag.	*/
@@ -495,8 +958,15 @@ typedef struct scsi_device {
     hbool_t	unique_pattern;		/* Unique pattern per process.	*/
     hbool_t	user_data;		/* User defined data.		*/
     hbool_t	user_pattern;		/* User specified pattern.	*/
+    hbool_t	user_threads;		/* User specified threads.	*/
     uint32_t	iot_seed;		/* The default IOT seed value.  */
     uint32_t	iot_seed_per_pass;	/* The per pass IOT seed value.	*/
+    uint8_t	compress_percent;	/* Compressible data percentage.*/
+    uint8_t	dedupe_percent;		/* Duplicate block percentage.	*/
+    uint32_t	dedupe_unit;		/* The dedupe unit size (bytes).*/
+    uint64_t	dr_seed;		/* Data reduction pattern seed.	*/
+    uint64_t	rnd_seed;		/* The random pattern seed.	*/
+    uint32_t	rnd_pass;		/* The random pattern pass.	*/
     uint32_t	pattern;		/* The 32-bit pattern to use.	*/
     void	*pattern_buffer;	/* The pattern buffer.		*/
     /* Page Control Information: */
@@ -517,6 +987,8 @@ typedef struct scsi_device {
     hbool_t	warnings_flag;		/* Controls warning messages.	*/
     hbool_t	emit_all;		/* Emit status for all cmds.	*/
     char	*emit_status;		/* The emit status string.	*/
+    emit_program_t *emit_programs[EMIT_PROGRAMS]; /* Compiled formats.	*/
+    int		emit_program_next;	/* The next program to replace.	*/
     uint64_t	iterations;		/* The current iteration count.	*/
     uint64_t	random_seed;		/* Seed for random # generator.	*/
     uint64_t	repeat_count;		/* Repeat SCSI command count.	*/
@@ -612,12 +1084,52 @@ typedef struct scsi_device {
     hbool_t	rod_token_valid;	/* The ROD token is valid.	*/
     hbool_t     rrti_wut_flag;          /* RRTI after WUT control flag. */
     hbool_t	zero_rod_flag;		/* Zero ROD token control flag.	*/
+    hbool_t	sparse_flag;		/* Sparse copy/verify control.	*/
+    hbool_t	first_write_flag;	/* Thin first write benchmark.	*/
+    hbool_t	verify_offload;		/* Verify(16) with byte check.	*/
+    uint32_t	caw_locks;		/* CAW contention lock count.	*/
+    caw_contention_t *caw_contention;	/* Shared CAW contention data.	*/
+    caw_thread_t *caw_thread;		/* Per thread CAW information.	*/
+    uint8_t	pi_type;		/* The protection type (1-3).	*/
+    uint8_t	rdprotect;		/* The read protect field.	*/
+    uint8_t	wrprotect;		/* The write protect field.	*/
+    uint16_t	pi_apptag;		/* The application tag.		*/
+    uint16_t	pi_appmask;		/* The application tag mask.	*/
+    hbool_t	pi_check_apptag;	/* Check application tag flag.	*/
+    uint32_t	pi_reftag;		/* The fixed reference tag.	*/
+    pi_reftag_policy_t pi_reftag_policy; /* The reference tag policy.	*/
+    char	*manifest_file;		/* The CRC32C manifest file.	*/
+    crc_manifest_t *crc_manifest;	/* The shared CRC32C manifest.	*/
+    crc_manifest_stats_t manifest_stats; /* Per thread manifest stats.	*/
+    char	*bench_file;		/* The benchmark results file.	*/
+    char	*bench_baseline;	/* The benchmark baseline file.	*/
+    uint32_t	bench_threshold;	/* Regression threshold (%).	*/
+    char	*trace_file;		/* The binary trace file.	*/
+    uint64_t	trace_records;		/* The trace ring size.		*/
+    cmd_trace_t	*cmd_trace;		/* The per thread trace.	*/
+    char	*replay_file;		/* The trace file to replay.	*/
+    uint32_t	replay_scale;		/* Replay timing (percentage).	*/
+    cmd_trace_t	*cmd_replay;		/* The per thread replay.	*/
+    workload_stats_t *workload_stats;	/* The per thread workload stats.*/
+    inject_rule_t inject_rules[INJECT_MAX_RULES]; /* The fault injection rules.*/
+    int		inject_rule_count;	/* The number of injection rules.*/
+    inject_delay_type_t inject_delay;	/* The latency distribution.	*/
+    uint32_t	inject_delay_min;	/* The minimum (or mean) usecs.	*/
+    uint32_t	inject_delay_max;	/* The maximum latency usecs.	*/
+    double	inject_delay_percent;	/* The percentage of commands.	*/
+    inject_data_t *inject_data;		/* Shared injection statistics.	*/
+    inject_thread_t *inject_thread;	/* Per thread injection state.	*/
     uint8_t	*rod_token_data;	/* Copy of ROD token data.	*/
     uint32_t	rod_token_size;		/* Size of ROD token data.	*/
     uint32_t	rod_inactivity_timeout;	/* The ROD inactivity timeout.	*/
     uint8_t	*rrti_data_buffer;	/* The RRTI data buffer.	*/
     uint32_t	rrti_data_length;	/* The RRTI data length.	*/
     int		segment_count;		/* The number of segments.	*/
+    /*
+     * Get LBA Status Map Information:
+     */
+    char	*lba_map_file;		/* The LBA status map file.	*/
+    struct lba_status_map *lba_status_map; /* Map shared by slices.	*/
     /*
      * Unmap and Punch Hole Information:
      */ 
@@ -663,6 +1175,7 @@ typedef struct scsi_device {
      * Shared Library Parameters:
      */
     hbool_t     shared_library;         /* Shared library interface.    */
+    hbool_t     retain_device_info;     /* Keep device open and info.   */
     struct scsi_device *master_sdp;     /* The master device pointer.   */
     char        *stderr_buffer;         /* The callers' stderr buffer.  */
     char        *stderr_bufptr;         /* Updated stderr buffer ptr.   */
@@ -676,8 +1189,69 @@ typedef struct scsi_device {
     int         stdout_remaining;       /* The stdout bytes remaining.  */
     int         emit_status_length;     /* The emit status buffer length*/
     int         emit_status_remaining;  /* The emit bytes remaining.    */
+    spt_result_t *spt_result;           /* The callers' binary result.  */
+    uint8_t     *result_data;           /* The result data-in buffer.   */
+    uint32_t    result_data_size;       /* The result data buffer size. */
+    spt_output_func_t output_func;      /* The callers' output function.*/
+    void        *output_arg;            /* The output function argument.*/
+    pthread_mutex_t *output_lock;       /* Serializes output callbacks. */
+    volatile hbool_t *cmd_interrupted;  /* The command interrupted flag.*/
+    volatile hbool_t interrupted_flag;  /* Per handle interrupted flag. */
 } scsi_device_t;
 
+/*
+ * The command interrupted flag is global for the spt program, but each
+ * shared library handle has its' own, shared by the handle's threads.
+ */
+#define CmdInterrupted(sdp)	(*(sdp)->cmd_interrupted)
+
+/*
+ * Get LBA Status Map: (shared by all slices/threads)
+ *
+ * Each thread scans its' slice, then deposits its' extents into the map.
+ * Once all slices complete a pass, the last thread merges the extents,
+ * reports the totals, and writes the (optional) run-length map file.
+ */
+typedef struct lba_slice_map {
+    lba_extent_t *lm_extents;		/* The extents for this slice.	*/
+    uint32_t	lm_extent_count;	/* The number of extents.	*/
+    uint64_t	lm_passes;		/* The passes completed.	*/
+} lba_slice_map_t;
+
+typedef struct lba_status_map {
+    pthread_mutex_t lsm_lock;		/* Lock for map updates.	*/
+    int		lsm_references;		/* The thread references.	*/
+    uint32_t	lsm_slices;		/* The number of slices.	*/
+    uint64_t	lsm_reported;		/* The passes reported.		*/
+    uint32_t	lsm_device_size;	/* The device block size.	*/
+    clock_t	lsm_start_ticks;	/* The scan start time (ticks).	*/
+    lba_slice_map_t *lsm_maps;		/* Array of slice maps.		*/
+} lba_status_map_t;
+
+/*
+ * LBA Status Map File Format: (all fields are big-endian)
+ *
+ * The header is followed by extent count runs, with each run being the
+ * provisioning status followed by the run length in blocks. The runs are
+ * contiguous, so each runs' LBA is the sum of the previous run lengths.
+ */
+#define LBA_MAP_MAGIC	"SPTLBAMP"	/* The map file magic string.	*/
+#define LBA_MAP_VERSION	1		/* The map file version.	*/
+
+typedef struct lba_map_header {
+    char	lmh_magic[8];		/* The map file magic string.	*/
+    uint8_t	lmh_version[4];		/* The map file version.	*/
+    uint8_t	lmh_device_size[4];	/* The device block size.	*/
+    uint8_t	lmh_starting_lba[8];	/* The starting logical block.	*/
+    uint8_t	lmh_total_blocks[8];	/* The total blocks mapped.	*/
+    uint8_t	lmh_extent_count[8];	/* The number of extent runs.	*/
+} lba_map_header_t;
+
+typedef struct lba_map_run {
+    uint8_t	lmr_status;		/* The provisioning status.	*/
+    uint8_t	lmr_blocks[7];		/* The run length (in blocks).	*/
+} lba_map_run_t;
+
 typedef struct threads_info {
     int		ti_threads;	/* The number of active threads.	*/
     int		ti_finished;	/* The number of finished threads.	*/
@@ -714,6 +1288,13 @@ extern pthread_attr_t *tdattrp, *tjattrp;
 extern hbool_t DebugFlag, InteractiveFlag, mDebugFlag, PipeModeFlag;
 extern volatile hbool_t CmdInterruptedFlag;
 extern void cleanup_devices(scsi_device_t *sdp, hbool_t master);
+extern int execute_device_cdb(scsi_device_t *sdp, struct io_params *iop, scsi_generic_t *sgp);
+extern scsi_device_t *init_device_information(void);
+extern void init_device_defaults(scsi_device_t *sdp);
+extern int parse_args(scsi_device_t *sdp, int argc, char **argv);
+extern int open_devices(scsi_device_t *sdp);
+extern int close_devices(scsi_device_t *sdp, int starting_index);
+extern int process_cdb_params(scsi_device_t *sdp);
 /* Functions used for parsing. */
 extern int HandleExit(scsi_device_t *sdp, int status);
 extern hbool_t match(char **sptr, char *s);
@@ -759,6 +1340,8 @@ extern int setup_read10(scsi_device_t *sdp, scsi_generic_t *sgp);
 extern int setup_read16(scsi_device_t *sdp, scsi_generic_t *sgp);
 extern int setup_write10(scsi_device_t *sdp, scsi_generic_t *sgp);
 extern int setup_write16(scsi_device_t *sdp, scsi_generic_t *sgp);
+extern int setup_read32(scsi_device_t *sdp, scsi_generic_t *sgp);
+extern int setup_write32(scsi_device_t *sdp, scsi_generic_t *sgp);
 extern int setup_verify10(scsi_device_t *sdp, scsi_generic_t *sgp);
 extern int setup_verify16(scsi_device_t *sdp, scsi_generic_t *sgp);
 extern int setup_write_same10(scsi_device_t *sdp, scsi_generic_t *sgp);
@@ -772,6 +1355,7 @@ extern void init_swapped(      scsi_device_t   *sdp,
 
 /* spt_fmt.c */
 extern int FmtEmitStatus(scsi_device_t *sdp, io_params_t *uiop, scsi_generic_t *usgp, char *format, char *buffer);
+extern void release_emit_programs(scsi_device_t *sdp);
 extern char *FmtString(scsi_device_t *sdp, char *format, hbool_t filepath_flag);
 extern char *FmtUnpackString(scsi_device_t *sdp, char *format, unsigned char *data, size_t count);
 /* Consolidated into one function now. */
@@ -782,6 +1366,7 @@ extern char *FmtUnpackString(scsi_device_t *sdp, char *format, unsigned char *da
 /* spt_jobs.c */
 extern int initialize_jobs_data(scsi_device_t *sdp);
 extern int jobs_active(scsi_device_t *sdp);
+extern job_id_t get_next_job_id(scsi_device_t *sdp);
 extern int execute_job(scsi_device_t *msdp, threads_info_t *tip);
 extern int show_jobs(scsi_device_t *sdp, job_id_t job_id, char *job_tag, hbool_t verbose);
 extern int show_job_by_id(scsi_device_t *sdp, job_id_t job_id);
@@ -850,10 +1435,106 @@ extern void free_palign(scsi_device_t *sdp, void *pa_addr);
 
 /* scsi_opcodes.c */
 extern int GetCapacity(scsi_device_t *sdp, io_params_t *iop);
+extern int initialize_devices(scsi_device_t *sdp);
 extern int initialize_multiple_devices(scsi_device_t *sdp);
 extern int sanity_check_src_dst_devices(scsi_device_t *sdp);
 extern int initialize_slices(scsi_device_t *sdp);
 extern void initialize_slice(scsi_device_t *sdp, scsi_device_t *tsdp, uint32_t slice);
+extern hbool_t is_get_lba_status(scsi_generic_t *sgp);
+extern int create_lba_status_map(scsi_device_t *sdp);
+extern void release_lba_status_map(scsi_device_t *sdp);
+extern void thin_write_complete(scsi_device_t *sdp, io_params_t *iop);
+extern hbool_t is_caw_contention(scsi_device_t *sdp);
+extern int create_caw_contention(scsi_device_t *sdp);
+extern void release_caw_contention(scsi_device_t *sdp);
+extern int caw_contention_setup(scsi_device_t *sdp);
+extern int caw_contention_cycle(scsi_device_t *sdp);
+extern void caw_contention_finish(scsi_device_t *sdp);
+
+/* spt_latency.c */
+extern uint64_t get_usecs(void);
+extern uint64_t get_cpu_usecs(void);
+extern void init_latency_stats(latency_stats_t *lsp);
+extern void record_latency(latency_stats_t *lsp, uint64_t usecs, uint64_t bytes);
+extern void merge_latency_stats(latency_stats_t *lsp, latency_stats_t *slsp);
+extern uint64_t get_latency_percentile(latency_stats_t *lsp, double percentile);
+extern void report_latency_stats(scsi_device_t *sdp, char *header, latency_stats_t *lsp);
+
+/* spt_pi.c */
+extern uint16_t crc16_t10dif(uint16_t crc, void *buffer, size_t length);
+extern uint8_t pi_setup_flags(scsi_device_t *sdp, struct io_params *iop, uint8_t flags);
+extern uint32_t pi_expected_reftag(scsi_device_t *sdp, uint64_t lba);
+extern int pi_prepare_data(scsi_device_t *sdp, struct io_params *iop);
+extern int pi_complete_data(scsi_device_t *sdp, struct io_params *iop, int status);
+extern void pi_free_buffer(scsi_device_t *sdp, struct io_params *iop);
+
+/* spt_manifest.c */
+extern uint32_t crc32c(uint32_t crc, void *buffer, size_t length);
+extern int create_crc_manifest(scsi_device_t *sdp);
+extern void release_crc_manifest(scsi_device_t *sdp);
+extern int crc_manifest_complete(scsi_device_t *sdp, struct io_params *iop);
+
+/* spt_trace.c */
+extern int create_cmd_trace(scsi_device_t *sdp);
+extern void release_cmd_trace(scsi_device_t *sdp);
+extern void record_cmd_trace(scsi_device_t *sdp, struct io_params *iop, scsi_generic_t *sgp,
+			     uint64_t start_usecs, int error);
+extern cmd_trace_t *open_cmd_trace(scsi_device_t *sdp, char *trace_file);
+extern void close_cmd_trace(scsi_device_t *sdp, cmd_trace_t *ctp);
+extern int create_cmd_replay(scsi_device_t *sdp);
+extern int replay_cmd_trace(scsi_device_t *sdp);
+extern void release_cmd_replay(scsi_device_t *sdp);
+extern uint64_t trace_cdb_lba(scsi_generic_t *sgp);
+
+/* spt_emulator.c */
+extern int initialize_emulator(scsi_device_t *sdp);
+extern hbool_t is_emulated_device(char *dsf);
+extern int emu_open_device(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp);
+extern int emu_execute_cdb(scsi_device_t *sdp, emu_device_t *edp, scsi_generic_t *sgp);
+
+/* spt_inject.c */
+extern int parse_inject_fault(scsi_device_t *sdp, char *string);
+extern int parse_inject_latency(scsi_device_t *sdp, char *string);
+extern int create_inject_data(scsi_device_t *sdp);
+extern int create_inject_thread(scsi_device_t *sdp);
+extern int inject_execute_cdb(scsi_device_t *sdp, struct io_params *iop, scsi_generic_t *sgp);
+extern void record_inject_stats(scsi_device_t *sdp, struct io_params *iop, scsi_generic_t *sgp, int error);
+extern void release_inject_thread(scsi_device_t *sdp);
+
+/* spt_workload.c */
+extern int load_workload(scsi_device_t *sdp, char *workload_file);
+extern int create_workload_stats(scsi_device_t *sdp);
+extern void record_workload_stats(scsi_device_t *sdp, struct io_params *iop, scsi_generic_t *sgp, int error);
+extern void release_workload_stats(scsi_device_t *sdp);
+extern void workload_jobs_finished(scsi_device_t *sdp, char *job_tag);
+
+/* spt_analyze.c */
+extern int analyze_traces(scsi_device_t *sdp);
+
+/* spt_bench.c */
+extern int run_benchmarks(scsi_device_t *sdp);
+
+/* spt_pattern.c */
+extern uint64_t	init_drdata(	scsi_device_t	*sdp,
+				io_params_t	*iop,
+				void		*buffer,
+				uint32_t	count,
+				uint64_t	lba,
+				uint64_t	dr_seed);
+extern uint64_t	init_rnddata(	scsi_device_t	*sdp,
+				io_params_t	*iop,
+				void		*buffer,
+				uint32_t	count,
+				uint64_t	lba,
+				uint64_t	rnd_seed,
+				uint32_t	pass);
+extern int	verify_rnddata(	scsi_device_t	*sdp,
+				io_params_t	*iop,
+				void		*buffer,
+				uint32_t	count,
+				uint64_t	lba,
+				uint64_t	rnd_seed,
+				uint32_t	pass);
 
 /* spt_print.c */
 #include "spt_print.h"
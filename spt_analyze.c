@@ -0,0 +1,566 @@
+/****************************************************************************
+ *									    *
+ *			  COPYRIGHT (c) 1988 - 2026			    *
+ *			   This Software Provided			    *
+ *				     By					    *
+ *			  Robin's Nest Software Inc.			    *
+ *									    *
+ * Permission to use, copy, modify, distribute and sell this software and   *
+ * its documentation for any purpose and without fee is hereby granted,	    *
+ * provided that the above copyright notice appear in all copies and that   *
+ * both that copyright notice and this permission notice appear in the	    *
+ * supporting documentation, and that the name of the author not be used    *
+ * in advertising or publicity pertaining to distribution of the software   *
+ * without specific, written prior permission.				    *
+ *									    *
+ * THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE, 	    *
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN	    *
+ * NO EVENT SHALL HE BE LIABLE FOR ANY SPECIAL, INDIRECT OR CONSEQUENTIAL   *
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR    *
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS  *
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF   *
+ * THIS SOFTWARE.							    *
+ *									    *
+ ****************************************************************************/
+/*
+ * Module:	spt_analyze.c
+ * Author:	Robin T. Miller
+ * Date:	October 18th, 2026
+ *
+ * Description:
+ *	Offline analysis of binary command traces (spt analyze trace=file).
+ * The trace files are mapped read-only, and the records are divided among
+ * worker threads (one per CPU, or threads=value), each collecting its' own
+ * statistics, which are merged and reported as ASCII tables or JSON:
+ *
+ *	- per opcode latency percentiles
+ *	- throughput over time
+ *	- LBA versus latency heatmap
+ *	- error counts by SCSI status, and sense key/ASC
+ *
+ * Modification History:
+ */
+#include "spt.h"
+#include "parson.h"
+
+#define ANALYZE_OPCODES		256	/* The opcodes tracked.		*/
+#define ANALYZE_TIME_ROWS	20	/* Throughput over time rows.	*/
+#define ANALYZE_LBA_ROWS	16	/* The heatmap LBA rows.	*/
+#define ANALYZE_LATENCY_COLUMNS	8	/* The heatmap latency columns.	*/
+#define ANALYZE_SENSE_KEYS	16	/* The sense keys tracked.	*/
+#define ANALYZE_ASC_CODES	256	/* The sense codes tracked.	*/
+#define ANALYZE_MIN_RECORDS	65536	/* Minimum records per worker.	*/
+
+static uint64_t heatmap_limits[ANALYZE_LATENCY_COLUMNS - 1] = {
+    100, 500, 1000, 5000, 10000, 50000, 100000
+};
+static char *heatmap_titles[ANALYZE_LATENCY_COLUMNS] = {
+    "<100us", "<500us", "<1ms", "<5ms", "<10ms", "<50ms", "<100ms", ">=100ms"
+};
+
+typedef struct trace_analysis {
+    latency_stats_t *ta_opcode_stats[ANALYZE_OPCODES]; /* Allocated as seen. */
+    uint64_t	ta_records;		/* The records analyzed.	*/
+    uint64_t	ta_max_lba;		/* The maximum LBA seen.	*/
+    uint64_t	ta_time_commands[ANALYZE_TIME_ROWS]; /* Commands by time.	*/
+    uint64_t	ta_time_bytes[ANALYZE_TIME_ROWS]; /* Bytes by time.	*/
+    uint64_t	ta_heatmap[ANALYZE_LBA_ROWS][ANALYZE_LATENCY_COLUMNS];
+    uint64_t	ta_os_errors;		/* The system call failures.	*/
+    uint64_t	ta_scsi_status[256];	/* Counts by SCSI status.	*/
+    uint64_t	ta_sense[ANALYZE_SENSE_KEYS][ANALYZE_ASC_CODES];
+} trace_analysis_t;
+
+typedef struct trace_analyzer {
+    cmd_trace_t	**an_traces;		/* The mapped trace files.	*/
+    int		an_trace_count;		/* The number of trace files.	*/
+    uint64_t	an_records;		/* The total trace records.	*/
+    uint64_t	an_first_usecs;		/* The first record timestamp.	*/
+    uint64_t	an_last_usecs;		/* The last record timestamp.	*/
+    uint64_t	an_interval_usecs;	/* The time interval per row.	*/
+    uint64_t	an_lbas_per_row;	/* The LBA's per heatmap row.	*/
+    hbool_t	an_scan_lbas;		/* The first pass (LBA range).	*/
+} trace_analyzer_t;
+
+typedef struct analyze_worker {
+    pthread_t	aw_thread;		/* The worker thread.		*/
+    scsi_device_t *aw_sdp;		/* The device information.	*/
+    trace_analyzer_t *aw_anp;		/* The shared analyzer.		*/
+    uint64_t	aw_start;		/* The starting record.		*/
+    uint64_t	aw_end;			/* The ending record.		*/
+    trace_analysis_t aw_analysis;	/* The worker statistics.	*/
+} analyze_worker_t;
+
+/*
+ * get_cpu_count() - Get the number of online CPU's.
+ */
+static int
+get_cpu_count(void)
+{
+#if defined(WIN32)
+    SYSTEM_INFO system_info;
+
+    GetSystemInfo(&system_info);
+    return( (int)system_info.dwNumberOfProcessors );
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return( (cpus > 0) ? (int)cpus : 1 );
+#else /* !defined(WIN32) && !defined(_SC_NPROCESSORS_ONLN) */
+    return(1);
+#endif /* defined(WIN32) */
+}
+
+static void
+analyze_record(scsi_device_t *sdp, trace_analyzer_t *anp, trace_analysis_t *tap, cmd_trace_record_t *ctrp)
+{
+    latency_stats_t *lsp;
+    uint64_t bytes = 0;
+    int row, column;
+
+    tap->ta_records++;
+    lsp = tap->ta_opcode_stats[ctrp->ctr_cdb[0]];
+    if (lsp == NULL) {
+	lsp = tap->ta_opcode_stats[ctrp->ctr_cdb[0]] = Malloc(sdp, sizeof(*lsp));
+	if (lsp == NULL) return;
+    }
+    if ( (ctrp->ctr_flags == 0) && (ctrp->ctr_data_dir != scsi_data_none) ) {
+	bytes = (ctrp->ctr_length - ctrp->ctr_resid);
+    }
+    record_latency(lsp, ctrp->ctr_latency, bytes);
+
+    row = (int)((ctrp->ctr_timestamp - anp->an_first_usecs) / anp->an_interval_usecs);
+    row = min(row, ANALYZE_TIME_ROWS - 1);
+    tap->ta_time_commands[row]++;
+    tap->ta_time_bytes[row] += bytes;
+
+    row = (int)(ctrp->ctr_lba / anp->an_lbas_per_row);
+    row = min(row, ANALYZE_LBA_ROWS - 1);
+    for (column = 0; (column < (ANALYZE_LATENCY_COLUMNS - 1)); column++) {
+	if (ctrp->ctr_latency < heatmap_limits[column]) break;
+    }
+    tap->ta_heatmap[row][column]++;
+
+    if (ctrp->ctr_flags & CTR_FLAG_OS_ERROR) {
+	tap->ta_os_errors++;
+    } else if (ctrp->ctr_flags & CTR_FLAG_SCSI_ERROR) {
+	tap->ta_scsi_status[ctrp->ctr_scsi_status]++;
+	if (ctrp->ctr_sense_key || ctrp->ctr_asc) {
+	    tap->ta_sense[ctrp->ctr_sense_key & (ANALYZE_SENSE_KEYS - 1)][ctrp->ctr_asc]++;
+	}
+    }
+    return;
+}
+
+/*
+ * analyze_worker() - Analyze a range of records across the trace files.
+ *
+ * Note: The first pass only finds the maximum LBA, for the heatmap rows.
+ */
+static void *
+analyze_worker(void *arg)
+{
+    analyze_worker_t *awp = arg;
+    trace_analyzer_t *anp = awp->aw_anp;
+    trace_analysis_t *tap = &awp->aw_analysis;
+    cmd_trace_t *ctp;
+    cmd_trace_record_t *ctrp;
+    uint64_t base = 0, index, first, last;
+    int trace_index;
+
+    for (trace_index = 0; (trace_index < anp->an_trace_count); trace_index++) {
+	ctp = anp->an_traces[trace_index];
+	first = max(awp->aw_start, base);
+	last = min(awp->aw_end, (base + ctp->ct_count));
+	for (index = first; (index < last); index++) {
+	    ctrp = &ctp->ct_records[(ctp->ct_first + (index - base)) % ctp->ct_header->cth_record_limit];
+	    if (anp->an_scan_lbas == True) {
+		tap->ta_max_lba = max(tap->ta_max_lba, ctrp->ctr_lba);
+	    } else {
+		analyze_record(awp->aw_sdp, anp, tap, ctrp);
+	    }
+	}
+	base += ctp->ct_count;
+    }
+    return(NULL);
+}
+
+static int
+run_analyze_workers(scsi_device_t *sdp, analyze_worker_t *workers, int worker_count)
+{
+    int worker, pstatus, status = SUCCESS;
+
+    /* The first worker is ourselves, to avoid a thread with one worker. */
+    for (worker = 1; (worker < worker_count); worker++) {
+	pstatus = pthread_create(&workers[worker].aw_thread, NULL, analyze_worker, &workers[worker]);
+	if (pstatus != SUCCESS) {
+	    tPerror(sdp, pstatus, "pthread_create() failed");
+	    worker_count = worker;
+	    status = FAILURE;
+	    break;
+	}
+    }
+    (void)analyze_worker(&workers[0]);
+    for (worker = 1; (worker < worker_count); worker++) {
+	(void)pthread_join(workers[worker].aw_thread, NULL);
+    }
+    return(status);
+}
+
+static void
+merge_trace_analysis(trace_analysis_t *tap, trace_analysis_t *stap)
+{
+    int opcode, row, column, key, asc;
+
+    tap->ta_records += stap->ta_records;
+    for (opcode = 0; (opcode < ANALYZE_OPCODES); opcode++) {
+	if (stap->ta_opcode_stats[opcode] == NULL) continue;
+	if (tap->ta_opcode_stats[opcode] == NULL) {
+	    tap->ta_opcode_stats[opcode] = stap->ta_opcode_stats[opcode];
+	} else {
+	    merge_latency_stats(tap->ta_opcode_stats[opcode], stap->ta_opcode_stats[opcode]);
+	    free(stap->ta_opcode_stats[opcode]);
+	}
+	stap->ta_opcode_stats[opcode] = NULL;
+    }
+    for (row = 0; (row < ANALYZE_TIME_ROWS); row++) {
+	tap->ta_time_commands[row] += stap->ta_time_commands[row];
+	tap->ta_time_bytes[row] += stap->ta_time_bytes[row];
+    }
+    for (row = 0; (row < ANALYZE_LBA_ROWS); row++) {
+	for (column = 0; (column < ANALYZE_LATENCY_COLUMNS); column++) {
+	    tap->ta_heatmap[row][column] += stap->ta_heatmap[row][column];
+	}
+    }
+    tap->ta_os_errors += stap->ta_os_errors;
+    for (key = 0; (key < 256); key++) {
+	tap->ta_scsi_status[key] += stap->ta_scsi_status[key];
+    }
+    for (key = 0; (key < ANALYZE_SENSE_KEYS); key++) {
+	for (asc = 0; (asc < ANALYZE_ASC_CODES); asc++) {
+	    tap->ta_sense[key][asc] += stap->ta_sense[key][asc];
+	}
+    }
+    return;
+}
+
+static char *
+get_opcode_name(uint8_t opcode)
+{
+    unsigned char cdb[MAX_CDB];
+    scsi_opcode_t *sop;
+
+    memset(cdb, '\0', sizeof(cdb));
+    cdb[0] = opcode;
+    sop = ScsiOpcodeEntry(cdb, DTYPE_DIRECT);
+    return( (sop && sop->opname) ? sop->opname : "Unknown" );
+}
+
+static void
+report_trace_analysis(scsi_device_t *sdp, trace_analyzer_t *anp, trace_analysis_t *tap,
+		      int worker_count, uint64_t analyze_usecs)
+{
+    char buffer[LARGE_BUFFER_SIZE];
+    char count[SMALL_BUFFER_SIZE], lba[SMALL_BUFFER_SIZE];
+    uint64_t elapsed_usecs = (anp->an_last_usecs - anp->an_first_usecs);
+    double interval_secs = ((double)anp->an_interval_usecs / 1000000.0);
+    int opcode, row, column, key, asc;
+
+    PrintHeader(sdp, "Trace Analysis Summary");
+    PrintDecimal(sdp, "Trace Files", anp->an_trace_count, PNL);
+    PrintLongDec(sdp, "Trace Records", tap->ta_records, PNL);
+    (void)sprintf(buffer, "%.3f secs", ((double)elapsed_usecs / 1000000.0));
+    PrintAscii(sdp, "Trace Time Span", buffer, PNL);
+    PrintDecimal(sdp, "Analysis Workers", worker_count, PNL);
+    if (analyze_usecs) {
+	(void)sprintf(buffer, "%.3f secs, %.0f records/sec", ((double)analyze_usecs / 1000000.0),
+		      ((double)tap->ta_records / ((double)analyze_usecs / 1000000.0)));
+	PrintAscii(sdp, "Analysis Time", buffer, PNL);
+    }
+    Printf(sdp, "\n");
+
+    for (opcode = 0; (opcode < ANALYZE_OPCODES); opcode++) {
+	if (tap->ta_opcode_stats[opcode] == NULL) continue;
+	(void)sprintf(buffer, "Opcode 0x%02x (%s) Latency", opcode, get_opcode_name((uint8_t)opcode));
+	report_latency_stats(sdp, buffer, tap->ta_opcode_stats[opcode]);
+    }
+
+    PrintHeader(sdp, "Throughput Over Time");
+    Printf(sdp, "%12s %12s %12s %12s\n", "Offset(secs)", "Commands", "IOPS", "MB/sec");
+    for (row = 0; (row < ANALYZE_TIME_ROWS); row++) {
+	(void)sprintf(count, LUF, tap->ta_time_commands[row]);
+	Printf(sdp, "%12.3f %12s %12.1f %12.3f\n", (row * interval_secs), count,
+	       ((double)tap->ta_time_commands[row] / interval_secs),
+	       (((double)tap->ta_time_bytes[row] / (double)MBYTE_SIZE) / interval_secs));
+    }
+    Printf(sdp, "\n");
+
+    PrintHeader(sdp, "LBA versus Latency Heatmap");
+    Printf(sdp, "%16s", "Starting LBA");
+    for (column = 0; (column < ANALYZE_LATENCY_COLUMNS); column++) {
+	Print(sdp, " %10s", heatmap_titles[column]);
+    }
+    Print(sdp, "\n");
+    for (row = 0; (row < ANALYZE_LBA_ROWS); row++) {
+	(void)sprintf(lba, LUF, (row * anp->an_lbas_per_row));
+	Printf(sdp, "%16s", lba);
+	for (column = 0; (column < ANALYZE_LATENCY_COLUMNS); column++) {
+	    (void)sprintf(count, LUF, tap->ta_heatmap[row][column]);
+	    Print(sdp, " %10s", count);
+	}
+	Print(sdp, "\n");
+    }
+    Printf(sdp, "\n");
+
+    PrintHeader(sdp, "Error Breakdown");
+    PrintLongDec(sdp, "System Call Errors", tap->ta_os_errors, PNL);
+    for (key = 0; (key < 256); key++) {
+	if (tap->ta_scsi_status[key] == 0) continue;
+	(void)sprintf(buffer, "SCSI Status %#x (%s)", key, ScsiStatus((unsigned char)key));
+	PrintLongDec(sdp, buffer, tap->ta_scsi_status[key], PNL);
+    }
+    for (key = 0; (key < ANALYZE_SENSE_KEYS); key++) {
+	for (asc = 0; (asc < ANALYZE_ASC_CODES); asc++) {
+	    char *ascq_msg;
+	    if (tap->ta_sense[key][asc] == 0) continue;
+	    ascq_msg = ScsiAscqMsg((unsigned char)asc, 0);
+	    Printf(sdp, "Sense Key %d (%s), ASC %#x%s%s: " LUF "\n",
+		   key, SenseKeyMsg((uint8_t)key), asc,
+		   (ascq_msg) ? " - " : "", (ascq_msg) ? ascq_msg : "",
+		   tap->ta_sense[key][asc]);
+	}
+    }
+    Printf(sdp, "\n");
+    return;
+}
+
+static char *
+trace_analysis_json(scsi_device_t *sdp, trace_analyzer_t *anp, trace_analysis_t *tap, int worker_count)
+{
+    JSON_Value	*root_value, *value;
+    JSON_Object	*root_object, *object, *entry;
+    JSON_Array	*array, *columns;
+    char *json_string;
+    char text[SMALL_BUFFER_SIZE];
+    double interval_secs = ((double)anp->an_interval_usecs / 1000000.0);
+    int opcode, row, column, key, asc;
+
+    root_value = json_value_init_object();
+    if (root_value == NULL) return(NULL);
+    root_object = json_value_get_object(root_value);
+    value = json_value_init_object();
+    (void)json_object_set_value(root_object, "Trace Analysis", value);
+    object = json_value_get_object(value);
+
+    (void)json_object_set_number(object, "Trace Files", (double)anp->an_trace_count);
+    (void)json_object_set_number(object, "Trace Records", (double)tap->ta_records);
+    (void)json_object_set_number(object, "Trace Time Span", (double)(anp->an_last_usecs - anp->an_first_usecs) / 1000000.0);
+    (void)json_object_set_number(object, "Analysis Workers", (double)worker_count);
+
+    (void)json_object_set_value(object, "Opcodes", json_value_init_array());
+    array = json_object_get_array(object, "Opcodes");
+    for (opcode = 0; (opcode < ANALYZE_OPCODES); opcode++) {
+	latency_stats_t *lsp = tap->ta_opcode_stats[opcode];
+	if ( (lsp == NULL) || (lsp->ls_count == 0) ) continue;
+	value = json_value_init_object();
+	entry = json_value_get_object(value);
+	(void)sprintf(text, "0x%02x", opcode);
+	(void)json_object_set_string(entry, "Opcode", text);
+	(void)json_object_set_string(entry, "Name", get_opcode_name((uint8_t)opcode));
+	(void)json_object_set_number(entry, "Commands", (double)lsp->ls_count);
+	(void)json_object_set_number(entry, "Bytes", (double)lsp->ls_bytes);
+	(void)json_object_set_number(entry, "Minimum", (double)lsp->ls_min_usecs);
+	(void)json_object_set_number(entry, "Average", (double)(lsp->ls_total_usecs / lsp->ls_count));
+	(void)json_object_set_number(entry, "Maximum", (double)lsp->ls_max_usecs);
+	(void)json_object_set_number(entry, "p50", (double)get_latency_percentile(lsp, 50.0));
+	(void)json_object_set_number(entry, "p90", (double)get_latency_percentile(lsp, 90.0));
+	(void)json_object_set_number(entry, "p99", (double)get_latency_percentile(lsp, 99.0));
+	(void)json_object_set_number(entry, "p99.9", (double)get_latency_percentile(lsp, 99.9));
+	(void)json_array_append_value(array, value);
+    }
+
+    (void)json_object_set_value(object, "Throughput", json_value_init_array());
+    array = json_object_get_array(object, "Throughput");
+    for (row = 0; (row < ANALYZE_TIME_ROWS); row++) {
+	value = json_value_init_object();
+	entry = json_value_get_object(value);
+	(void)json_object_set_number(entry, "Offset", (row * interval_secs));
+	(void)json_object_set_number(entry, "Commands", (double)tap->ta_time_commands[row]);
+	(void)json_object_set_number(entry, "Bytes", (double)tap->ta_time_bytes[row]);
+	(void)json_array_append_value(array, value);
+    }
+
+    (void)json_object_set_value(object, "Heatmap", json_value_init_object());
+    entry = json_object_get_object(object, "Heatmap");
+    (void)json_object_set_value(entry, "Columns", json_value_init_array());
+    columns = json_object_get_array(entry, "Columns");
+    for (column = 0; (column < ANALYZE_LATENCY_COLUMNS); column++) {
+	(void)json_array_append_string(columns, heatmap_titles[column]);
+    }
+    (void)json_object_set_value(entry, "Rows", json_value_init_array());
+    array = json_object_get_array(entry, "Rows");
+    for (row = 0; (row < ANALYZE_LBA_ROWS); row++) {
+	JSON_Object *robject;
+	value = json_value_init_object();
+	robject = json_value_get_object(value);
+	(void)json_object_set_number(robject, "Starting LBA", (double)(row * anp->an_lbas_per_row));
+	(void)json_object_set_value(robject, "Counts", json_value_init_array());
+	columns = json_object_get_array(robject, "Counts");
+	for (column = 0; (column < ANALYZE_LATENCY_COLUMNS); column++) {
+	    (void)json_array_append_number(columns, (double)tap->ta_heatmap[row][column]);
+	}
+	(void)json_array_append_value(array, value);
+    }
+
+    (void)json_object_set_value(object, "Errors", json_value_init_object());
+    entry = json_object_get_object(object, "Errors");
+    (void)json_object_set_number(entry, "System Call Errors", (double)tap->ta_os_errors);
+    (void)json_object_set_value(entry, "SCSI Status", json_value_init_array());
+    array = json_object_get_array(entry, "SCSI Status");
+    for (key = 0; (key < 256); key++) {
+	JSON_Object *sobject;
+	if (tap->ta_scsi_status[key] == 0) continue;
+	value = json_value_init_object();
+	sobject = json_value_get_object(value);
+	(void)json_object_set_number(sobject, "Status", (double)key);
+	(void)json_object_set_string(sobject, "Name", ScsiStatus((unsigned char)key));
+	(void)json_object_set_number(sobject, "Count", (double)tap->ta_scsi_status[key]);
+	(void)json_array_append_value(array, value);
+    }
+    (void)json_object_set_value(entry, "Sense", json_value_init_array());
+    array = json_object_get_array(entry, "Sense");
+    for (key = 0; (key < ANALYZE_SENSE_KEYS); key++) {
+	for (asc = 0; (asc < ANALYZE_ASC_CODES); asc++) {
+	    JSON_Object *sobject;
+	    if (tap->ta_sense[key][asc] == 0) continue;
+	    value = json_value_init_object();
+	    sobject = json_value_get_object(value);
+	    (void)json_object_set_number(sobject, "Sense Key", (double)key);
+	    (void)json_object_set_number(sobject, "ASC", (double)asc);
+	    (void)json_object_set_number(sobject, "Count", (double)tap->ta_sense[key][asc]);
+	    (void)json_array_append_value(array, value);
+	}
+    }
+    if (sdp->json_pretty) {
+	json_string = json_serialize_to_string_pretty(root_value);
+    } else {
+	json_string = json_serialize_to_string(root_value);
+    }
+    json_value_free(root_value);
+    return(json_string);
+}
+
+/*
+ * analyze_traces() - Analyze one or more trace files (comma separated).
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE
+ */
+int
+analyze_traces(scsi_device_t *sdp)
+{
+    trace_analyzer_t analyzer, *anp = &analyzer;
+    analyze_worker_t *workers = NULL;
+    trace_analysis_t *tap;
+    cmd_trace_t *ctp;
+    char *files, *token, *saveptr;
+    uint64_t start_usecs, max_lba = 0, per_worker;
+    int trace_index, worker, worker_count = 0;
+    int status = SUCCESS;
+
+    if (sdp->trace_file == NULL) {
+	Eprintf(sdp, "Please specify the trace files to analyze via trace= option!\n");
+	return(FAILURE);
+    }
+    start_usecs = get_usecs();
+    memset(anp, '\0', sizeof(*anp));
+    files = strdup(sdp->trace_file);
+    for (token = strtok_r(files, ",", &saveptr); token; token = strtok_r(NULL, ",", &saveptr)) {
+	ctp = open_cmd_trace(sdp, token);
+	if (ctp == NULL) {
+	    status = FAILURE;
+	    goto cleanup;
+	}
+	anp->an_traces = realloc(anp->an_traces, (sizeof(*anp->an_traces) * (anp->an_trace_count + 1)));
+	anp->an_traces[anp->an_trace_count++] = ctp;
+	if (ctp->ct_count == 0) continue;
+	if ( (anp->an_records == 0) || (ctp->ct_base_usecs < anp->an_first_usecs) ) {
+	    anp->an_first_usecs = ctp->ct_base_usecs;
+	}
+	anp->an_last_usecs = max(anp->an_last_usecs,
+	    ctp->ct_records[(ctp->ct_first + ctp->ct_count - 1) % ctp->ct_header->cth_record_limit].ctr_timestamp);
+	anp->an_records += ctp->ct_count;
+    }
+    if (anp->an_records == 0) {
+	Eprintf(sdp, "The trace files have no records to analyze!\n");
+	status = FAILURE;
+	goto cleanup;
+    }
+    anp->an_interval_usecs = howmany((anp->an_last_usecs - anp->an_first_usecs) + 1, ANALYZE_TIME_ROWS);
+
+    /*
+     * Divide the records between the workers, but avoid tiny ranges.
+     */
+    worker_count = (sdp->threads > 1) ? (int)sdp->threads : get_cpu_count();
+    worker_count = (int)min((uint64_t)worker_count, howmany(anp->an_records, ANALYZE_MIN_RECORDS));
+    workers = Malloc(sdp, (sizeof(*workers) * worker_count));
+    if (workers == NULL) {
+	status = FAILURE;
+	goto cleanup;
+    }
+    per_worker = howmany(anp->an_records, worker_count);
+    for (worker = 0; (worker < worker_count); worker++) {
+	workers[worker].aw_sdp = sdp;
+	workers[worker].aw_anp = anp;
+	workers[worker].aw_start = (worker * per_worker);
+	workers[worker].aw_end = min(anp->an_records, ((worker + 1) * per_worker));
+    }
+    anp->an_scan_lbas = True;
+    status = run_analyze_workers(sdp, workers, worker_count);
+    if (status != SUCCESS) goto cleanup;
+    for (worker = 0; (worker < worker_count); worker++) {
+	max_lba = max(max_lba, workers[worker].aw_analysis.ta_max_lba);
+    }
+    anp->an_lbas_per_row = howmany(max_lba + 1, ANALYZE_LBA_ROWS);
+    anp->an_scan_lbas = False;
+    status = run_analyze_workers(sdp, workers, worker_count);
+    if (status != SUCCESS) goto cleanup;
+
+    tap = &workers[0].aw_analysis;
+    for (worker = 1; (worker < worker_count); worker++) {
+	merge_trace_analysis(tap, &workers[worker].aw_analysis);
+    }
+    if (sdp->output_format == JSON_FMT) {
+	char *json_string = trace_analysis_json(sdp, anp, tap, worker_count);
+	if (json_string) {
+	    PrintLines(sdp, json_string);
+	    Printnl(sdp);
+	    json_free_serialized_string(json_string);
+	} else {
+	    status = FAILURE;
+	}
+    } else {
+	report_trace_analysis(sdp, anp, tap, worker_count, (get_usecs() - start_usecs));
+    }
+
+cleanup:
+    if (workers) {
+	for (worker = 0; (worker < worker_count); worker++) {
+	    int opcode;
+	    for (opcode = 0; (opcode < ANALYZE_OPCODES); opcode++) {
+		if (workers[worker].aw_analysis.ta_opcode_stats[opcode]) {
+		    Free(sdp, workers[worker].aw_analysis.ta_opcode_stats[opcode]);
+		}
+	    }
+	}
+	Free(sdp, workers);
+    }
+    for (trace_index = 0; (trace_index < anp->an_trace_count); trace_index++) {
+	close_cmd_trace(sdp, anp->an_traces[trace_index]);
+    }
+    if (anp->an_traces) free(anp->an_traces);
+    free(files);
+    return(status);
+}
@@ -0,0 +1,653 @@
+/****************************************************************************
+ *									    *
+ *			  COPYRIGHT (c) 1988 - 2026			    *
+ *			   This Software Provided			    *
+ *				     By					    *
+ *			  Robin's Nest Software Inc.			    *
+ *									    *
+ * Permission to use, copy, modify, distribute and sell this software and   *
+ * its documentation for any purpose and without fee is hereby granted,	    *
+ * provided that the above copyright notice appear in all copies and that   *
+ * both that copyright notice and this permission notice appear in the	    *
+ * supporting documentation, and that the name of the author not be used    *
+ * in advertising or publicity pertaining to distribution of the software   *
+ * without specific, written prior permission.				    *
+ *									    *
+ * THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE, 	    *
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN	    *
+ * NO EVENT SHALL HE BE LIABLE FOR ANY SPECIAL, INDIRECT OR CONSEQUENTIAL   *
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR    *
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS  *
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF   *
+ * THIS SOFTWARE.							    *
+ *									    *
+ ****************************************************************************/
+/*
+ * Module:	spt_bench.c
+ * Author:	Robin T. Miller
+ * Date:	October 18th, 2026
+ *
+ * Description:
+ *	Benchmark spt's own overhead (spt bench), using the RAM emulated
+ * device so results do not depend on storage. Each micro benchmark calls
+ * one function repeatedly for a fixed time, and reports nanoseconds per
+ * call, then end to end IOPS is measured by running spt itself with
+ * 1, 2, 4, ... threads (threads=value sets the maximum).
+ *
+ *	Each benchmark is sampled several times, and the median is reported,
+ * so a single sample disturbed by the system does not look like a change.
+ *
+ *	bench_file=file		Save the results as JSON.
+ *	baseline=file		Compare with saved results, and fail when
+ *				any benchmark regresses by more than the
+ *				bench_threshold=percent. (Default: 25%)
+ *
+ *	Note: The function call overhead (a few nanoseconds) is included,
+ * and parse_args() includes resetting the defaults, as done per command.
+ *
+ * Modification History:
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Initial creation.
+ */
+#include "spt.h"
+#include "parson.h"
+#include "spt_version.h"
+
+#if defined(WIN32)
+#  define BENCH_NULL_DEVICE	"NUL"
+#else /* !defined(WIN32) */
+#  define BENCH_NULL_DEVICE	"/dev/null"
+#endif /* defined(WIN32) */
+
+#define BENCH_DEVICE		"dsf=emu:size=1g" /* The emulated device.	*/
+#define BENCH_USECS		100000		/* Time per micro sample.	*/
+#define BENCH_SAMPLES		5		/* Samples per benchmark.	*/
+#define BENCH_BATCH		1000		/* Iterations between timing.	*/
+#define BENCH_MAX_RESULTS	16		/* The maximum micro results.	*/
+#define BENCH_MAX_THREADS	4		/* Default maximum threads.	*/
+#define BENCH_DATA_SIZE		(64 * KBYTE_SIZE) /* Data buffer size.	*/
+#define BENCH_E2E_LENGTH	4096		/* End to end request size.	*/
+#define BENCH_E2E_LIMIT		GBYTE_SIZE	/* End to end per thread.	*/
+
+extern char *sptpath;
+extern char *emit_status_default;
+extern char *emit_status_default_json;
+extern int initialize_io_parameters(scsi_device_t *sdp, io_params_t *iop, uint64_t max_lba, uint64_t max_blocks);
+
+typedef struct bench_result {
+    char	*br_name;		/* The function benchmarked.	*/
+    uint64_t	br_iterations;		/* The number of calls.		*/
+    double	br_nsecs;		/* The nanoseconds per call.	*/
+} bench_result_t;
+
+typedef struct bench_e2e {
+    int		be_threads;		/* The number of threads.	*/
+    uint64_t	be_commands;		/* The commands executed.	*/
+    double	be_secs;		/* The elapsed seconds.		*/
+    double	be_iops;		/* The commands per second.	*/
+} bench_e2e_t;
+
+typedef struct bench_context {
+    scsi_device_t *bc_sdp;		/* The benchmark device.	*/
+    scsi_device_t *bc_psdp;		/* The parse_args() device.	*/
+    FILE	*bc_nfp;		/* The null device (LogMsg).	*/
+    uint8_t	*bc_buffer;		/* The data buffer.		*/
+    uint8_t	*bc_vbuffer;		/* The verify buffer.		*/
+    char	*bc_emit_buffer;	/* The emit status buffer.	*/
+    uint32_t	bc_counter;		/* The per call counter.	*/
+    bench_result_t bc_results[BENCH_MAX_RESULTS]; /* Micro results.	*/
+    int		bc_result_count;	/* The micro results count.	*/
+    bench_e2e_t	*bc_e2e;		/* The end to end results.	*/
+    int		bc_e2e_count;		/* The end to end results count.*/
+} bench_context_t;
+
+typedef int (*bench_func_t)(bench_context_t *bcp);
+
+/* Typical options, without device names (strdup'ed) to avoid leaks. */
+static char *bench_parse_argv[] = {
+    "cdb=28", "dir=read", "length=4k", "starting=0", "limit=1g", "threads=4",
+    "enable=recovery,sense", "recovery_delay=0", "timeout=30s", "ptype=iot"
+};
+static int bench_parse_argc = (sizeof(bench_parse_argv) / sizeof(char *));
+
+/* Common sense codes, both found and not found. */
+static uint8_t bench_ascq_table[][2] = {
+    { 0x04, 0x01 }, { 0x29, 0x00 }, { 0x11, 0x00 }, { 0x24, 0x00 },
+    { 0x3F, 0x0E }, { 0x55, 0x03 }, { 0x0E, 0x03 }, { 0xFE, 0xFE }
+};
+#define BENCH_ASCQ_ENTRIES	(sizeof(bench_ascq_table) / sizeof(bench_ascq_table[0]))
+
+static void
+bench_close_device(scsi_device_t *bsdp)
+{
+    io_params_t *iop = &bsdp->io_params[IO_INDEX_BASE];
+    scsi_generic_t *sgp = &iop->sg;
+
+    (void)close_devices(bsdp, IO_INDEX_BASE);
+    release_emit_programs(bsdp);
+    if (sgp->data_buffer) free_palign(bsdp, sgp->data_buffer);
+    if (sgp->sense_data) free_palign(bsdp, sgp->sense_data);
+    if (sgp->dsf) free(sgp->dsf);
+    if (bsdp->file_sep) free(bsdp->file_sep);
+    if (bsdp->file_postfix) free(bsdp->file_postfix);
+    free(bsdp);
+    return;
+}
+
+/*
+ * bench_open_device() - Setup a device for reads, as the main loop does.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	cdb_option = The CDB option (e.g. "cdb=28" or "read32").
+ */
+static scsi_device_t *
+bench_open_device(scsi_device_t *sdp, char *cdb_option)
+{
+    char *argv[] = { BENCH_DEVICE, cdb_option, "dir=read", "length=4k", "starting=0" };
+    scsi_device_t *bsdp;
+
+    bsdp = init_device_information();
+    if (bsdp == NULL) return(NULL);
+    init_device_defaults(bsdp);
+    if ( (parse_args(bsdp, (sizeof(argv) / sizeof(char *)), argv) != SUCCESS) ||
+	 (open_devices(bsdp) != SUCCESS) ||
+	 (process_cdb_params(bsdp) != SUCCESS) ) {
+	Eprintf(sdp, "Failed to setup the benchmark device for %s!\n", cdb_option);
+	bench_close_device(bsdp);
+	return(NULL);
+    }
+    return(bsdp);
+}
+
+/* ======================================================================== */
+
+static int
+bench_encode(bench_context_t *bcp)
+{
+    scsi_device_t *sdp = bcp->bc_sdp;
+    io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
+    int status;
+
+    status = (*iop->sop->encode)(sdp);
+    if (status == END_OF_DATA) {
+	iop->first_time = True;		/* Loop, as a_cdb() does. */
+	status = SUCCESS;
+    }
+    return(status);
+}
+
+static int
+bench_initialize_io_parameters(bench_context_t *bcp)
+{
+    scsi_device_t *sdp = bcp->bc_sdp;
+    io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
+
+    return( initialize_io_parameters(sdp, iop, SCSI_MAX_LBA10, SCSI_MAX_BLOCKS10) );
+}
+
+static int
+bench_init_iotdata(bench_context_t *bcp)
+{
+    scsi_device_t *sdp = bcp->bc_sdp;
+    io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
+
+    (void)init_iotdata(sdp, iop, bcp->bc_buffer, BENCH_DATA_SIZE, bcp->bc_counter++, sdp->iot_seed);
+    return(SUCCESS);
+}
+
+static int
+bench_verify_buffers(bench_context_t *bcp)
+{
+    return( VerifyBuffers(bcp->bc_sdp, bcp->bc_buffer, bcp->bc_vbuffer, BENCH_DATA_SIZE) );
+}
+
+static int
+bench_emit_status(bench_context_t *bcp)
+{
+    (void)FmtEmitStatus(bcp->bc_sdp, NULL, NULL, emit_status_default, bcp->bc_emit_buffer);
+    return(SUCCESS);
+}
+
+static int
+bench_emit_status_json(bench_context_t *bcp)
+{
+    (void)FmtEmitStatus(bcp->bc_sdp, NULL, NULL, emit_status_default_json, bcp->bc_emit_buffer);
+    return(SUCCESS);
+}
+
+static int
+bench_log_msg(bench_context_t *bcp)
+{
+    scsi_device_t *sdp = bcp->bc_sdp;
+
+    LogMsg(sdp, bcp->bc_nfp, logLevelInfo, 0,
+	   "Benchmark message %u for device %s\n", bcp->bc_counter++, sdp->io_params[IO_INDEX_BASE].sg.dsf);
+    return(SUCCESS);
+}
+
+static int
+bench_parse_args(bench_context_t *bcp)
+{
+    scsi_device_t *psdp = bcp->bc_psdp;
+
+    init_device_defaults(psdp);
+    return( parse_args(psdp, bench_parse_argc, bench_parse_argv) );
+}
+
+static int
+bench_ascq_msg(bench_context_t *bcp)
+{
+    uint8_t *entry = bench_ascq_table[bcp->bc_counter++ % BENCH_ASCQ_ENTRIES];
+
+    (void)ScsiAscqMsg(entry[0], entry[1]);
+    return(SUCCESS);
+}
+
+static int
+bench_compare_doubles(const void *p1, const void *p2)
+{
+    double d1 = *(const double *)p1, d2 = *(const double *)p2;
+
+    return( (d1 < d2) ? -1 : (d1 > d2) ? 1 : 0 );
+}
+
+/*
+ * bench_median() - Get the median of the samples (sorted in place).
+ */
+static double
+bench_median(double *samples, int count)
+{
+    qsort(samples, (size_t)count, sizeof(*samples), bench_compare_doubles);
+    if (count % 2) {
+	return(samples[count / 2]);
+    }
+    return( (samples[(count / 2) - 1] + samples[count / 2]) / 2.0 );
+}
+
+/*
+ * bench_micro() - Time one function, in batches, for a fixed time.
+ *
+ * Description:
+ *	The function is timed BENCH_SAMPLES times, and the median time per
+ * call is reported.
+ */
+static int
+bench_micro(scsi_device_t *sdp, bench_context_t *bcp, char *name, bench_func_t func)
+{
+    bench_result_t *brp;
+    uint64_t start_usecs, elapsed_usecs, sample_iterations, iterations = 0;
+    double samples[BENCH_SAMPLES];
+    int batch, sample;
+
+    if (bcp->bc_result_count == BENCH_MAX_RESULTS) {
+	Eprintf(sdp, "The maximum benchmark results (%d) exceeded!\n", BENCH_MAX_RESULTS);
+	return(FAILURE);
+    }
+    /* Warm up, and verify the function works before timing it. */
+    if ( (*func)(bcp) != SUCCESS) {
+	Eprintf(sdp, "The %s benchmark failed!\n", name);
+	return(FAILURE);
+    }
+    for (sample = 0; (sample < BENCH_SAMPLES); sample++) {
+	sample_iterations = 0;
+	start_usecs = get_usecs();
+	do {
+	    for (batch = 0; (batch < BENCH_BATCH); batch++) {
+		(void)(*func)(bcp);
+	    }
+	    sample_iterations += BENCH_BATCH;
+	    elapsed_usecs = (get_usecs() - start_usecs);
+	} while ( (elapsed_usecs < BENCH_USECS) && (CmdInterrupted(sdp) == False) );
+	samples[sample] = (((double)elapsed_usecs * 1000.0) / (double)sample_iterations);
+	iterations += sample_iterations;
+	if (CmdInterrupted(sdp) == True) {
+	    sample++;
+	    break;
+	}
+    }
+
+    brp = &bcp->bc_results[bcp->bc_result_count++];
+    brp->br_name = name;
+    brp->br_iterations = iterations;
+    brp->br_nsecs = bench_median(samples, sample);
+    return(SUCCESS);
+}
+
+static int
+bench_encode_functions(scsi_device_t *sdp, bench_context_t *bcp)
+{
+    static struct {
+	char	*cdb_option;
+	char	*name;
+    } encodes[] = {
+	{ "cdb=08",	"random_rw6_encode"	},
+	{ "cdb=28",	"random_rw10_encode"	},
+	{ "cdb=88",	"random_rw16_encode"	},
+	{ "read32",	"random_rw32_encode"	}
+    };
+    int index, status = SUCCESS;
+
+    for (index = 0; (index < (int)(sizeof(encodes) / sizeof(encodes[0]))); index++) {
+	if ( (bcp->bc_sdp = bench_open_device(sdp, encodes[index].cdb_option)) == NULL) {
+	    return(FAILURE);
+	}
+	status = bench_micro(sdp, bcp, encodes[index].name, bench_encode);
+	if (status == SUCCESS) {
+	    if (strcmp(encodes[index].cdb_option, "cdb=28") == 0) {
+		/* Note: These use the Read(10) device, for the dsf, etc. */
+		status = bench_micro(sdp, bcp, "initialize_io_parameters", bench_initialize_io_parameters);
+		if (status == SUCCESS) {
+		    status = bench_micro(sdp, bcp, "init_iotdata", bench_init_iotdata);
+		}
+		if (status == SUCCESS) {
+		    memcpy(bcp->bc_vbuffer, bcp->bc_buffer, BENCH_DATA_SIZE);
+		    status = bench_micro(sdp, bcp, "VerifyBuffers", bench_verify_buffers);
+		}
+		if (status == SUCCESS) {
+		    status = bench_micro(sdp, bcp, "FmtEmitStatus", bench_emit_status);
+		}
+		if (status == SUCCESS) {
+		    status = bench_micro(sdp, bcp, "FmtEmitStatus (JSON)", bench_emit_status_json);
+		}
+		if (status == SUCCESS) {
+		    status = bench_micro(sdp, bcp, "LogMsg", bench_log_msg);
+		}
+	    }
+	}
+	bench_close_device(bcp->bc_sdp);
+	bcp->bc_sdp = NULL;
+	if (status != SUCCESS) break;
+    }
+    return(status);
+}
+
+/*
+ * bench_end_to_end() - Run spt reading the emulated device, with threads.
+ *
+ * Note: Each thread reads the same range, and the process startup time is
+ * included, which is small compared to the commands executed. The median
+ * of BENCH_SAMPLES runs is reported.
+ */
+static int
+bench_end_to_end(scsi_device_t *sdp, bench_context_t *bcp, int threads)
+{
+    bench_e2e_t *bep = &bcp->bc_e2e[bcp->bc_e2e_count];
+    char cmdline[STRING_BUFFER_SIZE];
+    double samples[BENCH_SAMPLES];
+    uint64_t start_usecs;
+    int sample, status;
+
+    (void)sprintf(cmdline, "%s %s cdb=28 dir=read length=%u starting=0 limit=" LUF " threads=%d > %s 2>&1",
+		  sptpath, BENCH_DEVICE, BENCH_E2E_LENGTH, (uint64_t)BENCH_E2E_LIMIT, threads, BENCH_NULL_DEVICE);
+    if (sdp->DebugFlag) {
+	Printf(sdp, "DEBUG: Executing: %s\n", cmdline);
+    }
+    for (sample = 0; (sample < BENCH_SAMPLES); ) {
+	start_usecs = get_usecs();
+	status = DoSystemCommand(sdp, cmdline);
+	if (status != SUCCESS) {
+	    Eprintf(sdp, "The end to end benchmark failed with status %d!\n", status);
+	    Eprintf(sdp, "Command: %s\n", cmdline);
+	    return(FAILURE);
+	}
+	samples[sample++] = ((double)(get_usecs() - start_usecs) / 1000000.0);
+	if (CmdInterrupted(sdp) == True) break;
+    }
+    bep->be_threads = threads;
+    bep->be_secs = bench_median(samples, sample);
+    bep->be_commands = ((uint64_t)threads * (BENCH_E2E_LIMIT / BENCH_E2E_LENGTH));
+    bep->be_iops = ((double)bep->be_commands / bep->be_secs);
+    bcp->bc_e2e_count++;
+    return(SUCCESS);
+}
+
+/* ======================================================================== */
+
+static JSON_Value *
+bench_results_json(scsi_device_t *sdp, bench_context_t *bcp)
+{
+    JSON_Value	*root_value, *value;
+    JSON_Object	*root_object, *object, *entry;
+    JSON_Array	*array;
+    int index;
+
+    root_value = json_value_init_object();
+    root_object = json_value_get_object(root_value);
+    value = json_value_init_object();
+    (void)json_object_set_value(root_object, "Benchmark", value);
+    object = json_value_get_object(value);
+    (void)json_object_set_string(object, "Version", ToolRevision);
+
+    (void)json_object_set_value(object, "Micro", json_value_init_array());
+    array = json_object_get_array(object, "Micro");
+    for (index = 0; (index < bcp->bc_result_count); index++) {
+	bench_result_t *brp = &bcp->bc_results[index];
+	value = json_value_init_object();
+	entry = json_value_get_object(value);
+	(void)json_object_set_string(entry, "Name", brp->br_name);
+	(void)json_object_set_number(entry, "Iterations", (double)brp->br_iterations);
+	(void)json_object_set_number(entry, "Nanoseconds", brp->br_nsecs);
+	(void)json_array_append_value(array, value);
+    }
+    (void)json_object_set_value(object, "End to End", json_value_init_array());
+    array = json_object_get_array(object, "End to End");
+    for (index = 0; (index < bcp->bc_e2e_count); index++) {
+	bench_e2e_t *bep = &bcp->bc_e2e[index];
+	value = json_value_init_object();
+	entry = json_value_get_object(value);
+	(void)json_object_set_number(entry, "Threads", (double)bep->be_threads);
+	(void)json_object_set_number(entry, "Commands", (double)bep->be_commands);
+	(void)json_object_set_number(entry, "Seconds", bep->be_secs);
+	(void)json_object_set_number(entry, "IOPS", bep->be_iops);
+	(void)json_array_append_value(array, value);
+    }
+    return(root_value);
+}
+
+static void
+report_bench_results(scsi_device_t *sdp, bench_context_t *bcp)
+{
+    char count[SMALL_BUFFER_SIZE];
+    int index;
+
+    PrintHeader(sdp, "Micro Benchmarks");
+    Printf(sdp, "%-28s %14s %12s\n", "Function", "Calls", "ns/call");
+    for (index = 0; (index < bcp->bc_result_count); index++) {
+	bench_result_t *brp = &bcp->bc_results[index];
+	(void)sprintf(count, LUF, brp->br_iterations);
+	Printf(sdp, "%-28s %14s %12.1f\n", brp->br_name, count, brp->br_nsecs);
+    }
+
+    PrintHeader(sdp, "End to End Benchmarks");
+    Printf(sdp, "%8s %14s %10s %14s\n", "Threads", "Commands", "Seconds", "IOPS");
+    for (index = 0; (index < bcp->bc_e2e_count); index++) {
+	bench_e2e_t *bep = &bcp->bc_e2e[index];
+	(void)sprintf(count, LUF, bep->be_commands);
+	Printf(sdp, "%8d %14s %10.3f %14.1f\n", bep->be_threads, count, bep->be_secs, bep->be_iops);
+    }
+    Printf(sdp, "\n");
+    return;
+}
+
+/*
+ * bench_compare() - Compare the results with the baseline file.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE (regressions or baseline errors)
+ */
+static int
+bench_compare(scsi_device_t *sdp, bench_context_t *bcp)
+{
+    JSON_Value	*root_value;
+    JSON_Object	*root_object, *entry;
+    JSON_Array	*micro, *e2e;
+    double	base, current, change;
+    char	name[SMALL_BUFFER_SIZE];
+    size_t	count, element;
+    int		index, regressions = 0;
+
+    root_value = json_parse_file(sdp->bench_baseline);
+    if (root_value == NULL) {
+	Eprintf(sdp, "Failed to parse the baseline file %s!\n", sdp->bench_baseline);
+	return(FAILURE);
+    }
+    root_object = json_value_get_object(root_value);
+    micro = json_object_dotget_array(root_object, "Benchmark.Micro");
+    e2e = json_object_dotget_array(root_object, "Benchmark.End to End");
+
+    PrintHeader(sdp, "Benchmark Comparison");
+    PrintAscii(sdp, "Baseline File", sdp->bench_baseline, PNL);
+    PrintDecimal(sdp, "Regression Threshold (%)", sdp->bench_threshold, PNL);
+    Printf(sdp, "\n");
+    Printf(sdp, "%-28s %14s %14s %9s  %s\n", "Benchmark", "Baseline", "Current", "Change", "Status");
+
+    /* Micro benchmarks regress when slower (more ns/call). */
+    for (index = 0; (index < bcp->bc_result_count); index++) {
+	bench_result_t *brp = &bcp->bc_results[index];
+	base = 0.0;
+	count = (micro) ? json_array_get_count(micro) : 0;
+	for (element = 0; (element < count); element++) {
+	    const char *ename;
+	    entry = json_array_get_object(micro, element);
+	    ename = json_object_get_string(entry, "Name");
+	    if (ename && (strcmp(ename, brp->br_name) == 0)) {
+		base = json_object_get_number(entry, "Nanoseconds");
+		break;
+	    }
+	}
+	current = brp->br_nsecs;
+	if (base == 0.0) {
+	    Printf(sdp, "%-28s %14s %14.1f %9s  %s\n", brp->br_name, "-", current, "-", "new");
+	    continue;
+	}
+	change = (((current - base) * 100.0) / base);
+	if (change > (double)sdp->bench_threshold) regressions++;
+	Printf(sdp, "%-28s %14.1f %14.1f %+8.1f%%  %s\n", brp->br_name, base, current, change,
+	       (change > (double)sdp->bench_threshold) ? "REGRESSION" : "ok");
+    }
+
+    /* End to end benchmarks regress when slower (fewer IOPS). */
+    for (index = 0; (index < bcp->bc_e2e_count); index++) {
+	bench_e2e_t *bep = &bcp->bc_e2e[index];
+	base = 0.0;
+	count = (e2e) ? json_array_get_count(e2e) : 0;
+	for (element = 0; (element < count); element++) {
+	    entry = json_array_get_object(e2e, element);
+	    if ((int)json_object_get_number(entry, "Threads") == bep->be_threads) {
+		base = json_object_get_number(entry, "IOPS");
+		break;
+	    }
+	}
+	(void)sprintf(name, "IOPS (%d thread%s)", bep->be_threads, (bep->be_threads > 1) ? "s" : "");
+	current = bep->be_iops;
+	if (base == 0.0) {
+	    Printf(sdp, "%-28s %14s %14.1f %9s  %s\n", name, "-", current, "-", "new");
+	    continue;
+	}
+	change = (((current - base) * 100.0) / base);
+	if (-change > (double)sdp->bench_threshold) regressions++;
+	Printf(sdp, "%-28s %14.1f %14.1f %+8.1f%%  %s\n", name, base, current, change,
+	       (-change > (double)sdp->bench_threshold) ? "REGRESSION" : "ok");
+    }
+    Printf(sdp, "\n");
+    json_value_free(root_value);
+    if (regressions) {
+	Eprintf(sdp, "%d benchmark%s regressed by more than %u%%!\n",
+		regressions, (regressions > 1) ? "s" : "", sdp->bench_threshold);
+	return(FAILURE);
+    }
+    return(SUCCESS);
+}
+
+/*
+ * run_benchmarks() - Run the micro and end to end benchmarks.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE
+ */
+int
+run_benchmarks(scsi_device_t *sdp)
+{
+    bench_context_t context, *bcp = &context;
+    JSON_Value *root_value = NULL;
+    int threads, max_threads;
+    int status = SUCCESS;
+
+    memset(bcp, '\0', sizeof(*bcp));
+    max_threads = (sdp->user_threads == True) ? (int)sdp->threads : BENCH_MAX_THREADS;
+    if (max_threads < 1) max_threads = 1;
+    bcp->bc_nfp = fopen(BENCH_NULL_DEVICE, "w");
+    if (bcp->bc_nfp == NULL) {
+	Perror(sdp, "fopen() of %s failed", BENCH_NULL_DEVICE);
+	return(FAILURE);
+    }
+    bcp->bc_buffer = malloc_palign(sdp, BENCH_DATA_SIZE, 0);
+    bcp->bc_vbuffer = malloc_palign(sdp, BENCH_DATA_SIZE, 0);
+    bcp->bc_emit_buffer = Malloc(sdp, DEF_LOG_BUFSIZE);
+    bcp->bc_psdp = init_device_information();
+    bcp->bc_e2e = Malloc(sdp, (sizeof(*bcp->bc_e2e) * (max_threads + 1)));
+    if ( (bcp->bc_buffer == NULL) || (bcp->bc_vbuffer == NULL) ||
+	 (bcp->bc_emit_buffer == NULL) || (bcp->bc_psdp == NULL) || (bcp->bc_e2e == NULL) ) {
+	status = FAILURE;
+	goto cleanup;
+    }
+
+    status = bench_encode_functions(sdp, bcp);
+    if (status == SUCCESS) {
+	status = bench_micro(sdp, bcp, "parse_args", bench_parse_args);
+    }
+    if (status == SUCCESS) {
+	status = bench_micro(sdp, bcp, "ScsiAscqMsg", bench_ascq_msg);
+    }
+    for (threads = 1; (status == SUCCESS) && (CmdInterrupted(sdp) == False); threads *= 2) {
+	if (threads > max_threads) {
+	    if ((threads / 2) == max_threads) break;
+	    threads = max_threads;	/* Not a power of 2. */
+	}
+	status = bench_end_to_end(sdp, bcp, threads);
+	if (threads == max_threads) break;
+    }
+    if (status != SUCCESS) goto cleanup;
+
+    root_value = bench_results_json(sdp, bcp);
+    if (sdp->output_format == JSON_FMT) {
+	char *json_string = (sdp->json_pretty) ? json_serialize_to_string_pretty(root_value)
+					       : json_serialize_to_string(root_value);
+	if (json_string) {
+	    PrintLines(sdp, json_string);
+	    Printnl(sdp);
+	    json_free_serialized_string(json_string);
+	}
+    } else {
+	report_bench_results(sdp, bcp);
+    }
+    if (sdp->bench_file) {
+	if (json_serialize_to_file_pretty(root_value, sdp->bench_file) != JSONSuccess) {
+	    Eprintf(sdp, "Failed to write the benchmark results to %s!\n", sdp->bench_file);
+	    status = FAILURE;
+	}
+    }
+    if (sdp->bench_baseline) {
+	if (bench_compare(sdp, bcp) != SUCCESS) {
+	    status = FAILURE;
+	}
+    }
+
+cleanup:
+    if (root_value) json_value_free(root_value);
+    if (bcp->bc_psdp) {
+	bcp->bc_psdp->io_params[IO_INDEX_BASE].sg.dsf = NULL;
+	bench_close_device(bcp->bc_psdp);
+    }
+    if (bcp->bc_e2e) Free(sdp, bcp->bc_e2e);
+    if (bcp->bc_emit_buffer) Free(sdp, bcp->bc_emit_buffer);
+    if (bcp->bc_vbuffer) free_palign(sdp, bcp->bc_vbuffer);
+    if (bcp->bc_buffer) free_palign(sdp, bcp->bc_buffer);
+    (void)fclose(bcp->bc_nfp);
+    return(status);
+}
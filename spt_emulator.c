@@ -0,0 +1,1508 @@
+/****************************************************************************
+ *									    *
+ *			  COPYRIGHT (c) 1988 - 2026			    *
+ *			   This Software Provided			    *
+ *				     By					    *
+ *			  Robin's Nest Software Inc.			    *
+ *									    *
+ * Permission to use, copy, modify, distribute and sell this software and   *
+ * its documentation for any purpose and without fee is hereby granted,	    *
+ * provided that the above copyright notice appear in all copies and that   *
+ * both that copyright notice and this permission notice appear in the	    *
+ * supporting documentation, and that the name of the author not be used    *
+ * in advertising or publicity pertaining to distribution of the software   *
+ * without specific, written prior permission.				    *
+ *									    *
+ * THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE, 	    *
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN	    *
+ * NO EVENT SHALL HE BE LIABLE FOR ANY SPECIAL, INDIRECT OR CONSEQUENTIAL   *
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR    *
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS  *
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF   *
+ * THIS SOFTWARE.							    *
+ *									    *
+ ****************************************************************************/
+/*
+ * Module:	spt_emulator.c
+ * Author:	Robin T. Miller
+ * Date:	October 18th, 2026
+ *
+ * Description:
+ *	A RAM backed emulated block device, selected via dsf=emu:[options],
+ * where the options are comma separated:
+ *
+ *	size=value	The device capacity. (Default: 1g, or the file size)
+ *	bs=value	The logical block length. (Default: 512)
+ *	latency=value	The media access latency (usecs). (Default: 0)
+ *	file=path	Back the device with a sparse file. (persistent)
+ *
+ *	Memory is allocated in chunks when first written, and unmapping
+ * an entire chunk frees it, so large thin devices are inexpensive. Devices
+ * with the same name are shared, by threads and by later commands.
+ *
+ *	File backed devices are extended sparsely to the device size. Unmap
+ * punches holes, and Get LBA Status reports holes via SEEK_DATA/SEEK_HOLE,
+ * so multi-terabyte thin LUNs only consume the space actually written.
+ *
+ *	Extended Copy (LID1 block to block), Populate Token, Write Using
+ * Token, and their Receive Copy Results/ROD Token Information are handled
+ * between emulated devices, using copy_file_range() when both devices are
+ * file backed. Note: ROD tokens reference the source blocks, and are not
+ * point in time snapshots, which is sufficient for exercising spt.
+ *
+ *	This permits testing spt's own I/O paths (encode, IOT, verify, stats)
+ * on systems without storage. CDB's are executed by ExecuteCdb(), which
+ * already overrides libExecuteCdb() via execute_cdb, so recovery, latency,
+ * and trace recording behave as with real devices.
+ *
+ * Modification History:
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add sparse file backed devices, and extended copy/token operations.
+ */
+#include "spt.h"
+
+#if defined(WIN32)
+#  define EMU_NULL_DEVICE	"NUL"
+#else /* !defined(WIN32) */
+#  define EMU_NULL_DEVICE	"/dev/null"
+#endif /* defined(WIN32) */
+
+#define EMU_MAX_TRANSFER	(16 * MBYTE_SIZE) /* Max transfer (bytes).	*/
+#define EMU_MAX_CAW_BLOCKS	255		/* Max compare and write.	*/
+#define EMU_MAX_UNMAP_DESCS	256		/* Max unmap descriptors.	*/
+#define EMU_VPD_BUFFER_SIZE	256		/* Inquiry/VPD buffer size.	*/
+#define EMU_DESIGNATOR_LENGTH	16		/* The NAA designator length.	*/
+#define EMU_MAX_CSCD_DESCS	16		/* Max xcopy CSCD descriptors.	*/
+#define EMU_MAX_SEGMENT_DESCS	64		/* Max xcopy segment descs.	*/
+#define EMU_MAX_RANGE_DESCS	64		/* Max token range descriptors.	*/
+#define EMU_MAX_TOKEN_BYTES	(256 * MBYTE_SIZE) /* Max token transfer size.	*/
+#define EMU_MAX_TOKENS		256		/* Max outstanding ROD tokens.	*/
+#define EMU_COPY_RESULTS	64		/* Copy results saved for RRTI.	*/
+#define EMU_ROD_TYPE_PIT	0x00800000	/* Point in time copy ROD type.	*/
+#define EMU_CSCD_DESC_LENGTH	32		/* The CSCD descriptor length.	*/
+#define EMU_RANGE_DESC_LENGTH	16		/* The range descriptor length.	*/
+#define EMU_TRANSFER_BLOCKS	0xF1		/* Transfer count in blocks.	*/
+
+#if defined(__linux__) && defined(__GLIBC__)
+#  if (__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 27))
+#    define EMU_COPY_FILE_RANGE	1		/* copy_file_range() exists.	*/
+#  endif
+#endif /* defined(__linux__) && defined(__GLIBC__) */
+
+/* Additional sense codes used. */
+#define ASC_INVALID_OPCODE	0x20		/* Invalid command opcode.	*/
+#define ASC_LBA_OUT_OF_RANGE	0x21		/* LBA out of range.		*/
+#define ASC_INVALID_FIELD_CDB	0x24		/* Invalid field in CDB.	*/
+#define ASC_INVALID_FIELD_PARAM	0x26		/* Invalid field in parameters.	*/
+#define ASC_MISCOMPARE		0x1D		/* Miscompare during verify.	*/
+#define ASC_WRITE_ERROR		0x0C		/* Write error.			*/
+#define ASC_READ_ERROR		0x11		/* Unrecovered read error.	*/
+#define ASC_COPY_TARGET		0x0D		/* Copy target device error.	*/
+#define ASC_INVALID_TOKEN	0x23		/* Invalid token operation.	*/
+#define ASC_RESOURCE_FAILURE	0x55		/* System resource failure.	*/
+
+/*
+ * ROD tokens created by Populate Token, and used by Write Using Token.
+ */
+typedef struct emu_token {
+    struct emu_token *et_next;		/* The next token.		*/
+    uint64_t	et_id;			/* The token identifier.	*/
+    emu_device_t *et_device;		/* The source device.		*/
+    uint32_t	et_range_count;		/* The range descriptor count.	*/
+    uint8_t	*et_ranges;		/* The range descriptors.	*/
+} emu_token_t;
+
+/*
+ * The copy operation results, returned by Receive ROD Token Information.
+ */
+typedef struct emu_copy_result {
+    emu_device_t *er_device;		/* The device copy executed on.	*/
+    uint32_t	er_list_identifier;	/* The list identifier.		*/
+    uint8_t	er_service_action;	/* The copy service action.	*/
+    uint8_t	er_copy_status;		/* The copy operation status.	*/
+    uint64_t	er_transfer_count;	/* The blocks transferred.	*/
+    uint64_t	er_token_id;		/* The ROD token (populate).	*/
+} emu_copy_result_t;
+
+static emu_device_t *emu_devices = NULL;	/* The emulated devices.	*/
+static pthread_mutex_t emu_lock;		/* Protects the device list.	*/
+static uint32_t emu_luns = 0;			/* The emulated LUN count.	*/
+static emu_token_t *emu_tokens = NULL;		/* The ROD tokens (newest 1st).	*/
+static uint32_t emu_token_count = 0;		/* The ROD token count.		*/
+static uint64_t emu_token_id = 0;		/* The last ROD token ID.	*/
+static emu_copy_result_t emu_results[EMU_COPY_RESULTS]; /* Copy results.	*/
+static uint32_t emu_result_index = 0;		/* The next copy result.	*/
+
+int
+initialize_emulator(scsi_device_t *sdp)
+{
+    int status;
+
+    if ( (status = pthread_mutex_init(&emu_lock, NULL)) != SUCCESS) {
+	tPerror(sdp, status, "pthread_mutex_init() of emulator lock failed!");
+    }
+    return(status);
+}
+
+hbool_t
+is_emulated_device(char *dsf)
+{
+    return( (dsf && (strncmp(dsf, EMU_DSF_PREFIX, sizeof(EMU_DSF_PREFIX) - 1) == 0)) ? True : False );
+}
+
+/*
+ * parse_emu_options() - Parse the emulated device options (after emu:).
+ */
+/*
+ * emu_open_file() - Open (or create) the sparse backing file.
+ *
+ * Description:
+ *	Without a size, an existing file's size is used. The file is then
+ * extended (sparsely) to the device size, but never truncated.
+ */
+static int
+emu_open_file(scsi_device_t *sdp, emu_device_t *edp, uint64_t *size, hbool_t size_flag)
+{
+    uint64_t file_size;
+
+    edp->ed_fd = os_open_file(edp->ed_file, (O_RDWR | O_CREAT), 0644);
+    if (edp->ed_fd == INVALID_HANDLE_VALUE) {
+	os_perror(sdp, "Failed to open emulated device file %s", edp->ed_file);
+	return(FAILURE);
+    }
+    file_size = os_get_file_size(edp->ed_file, edp->ed_fd);
+    if (file_size == (uint64_t)-1) file_size = 0;
+    if ( (size_flag == False) && file_size ) {
+	*size = file_size;
+    }
+    if (file_size < *size) {
+	if (os_truncate_file(edp->ed_fd, (Offset_t)*size) != SUCCESS) {
+	    os_perror(sdp, "Failed to extend emulated device file %s to " LUF " bytes",
+		      edp->ed_file, *size);
+	    return(FAILURE);
+	}
+    }
+    return(SUCCESS);
+}
+
+static int
+parse_emu_options(scsi_device_t *sdp, emu_device_t *edp, char *options)
+{
+    char *opts, *token, *saveptr, *string;
+    uint64_t size = EMU_DEFAULT_SIZE;
+    hbool_t size_flag = False;
+    int status = SUCCESS;
+
+    edp->ed_block_length = BLOCK_SIZE;
+    opts = strdup(options);
+    for (token = strtok_r(opts, ",", &saveptr); token; token = strtok_r(NULL, ",", &saveptr)) {
+	string = token;
+	if (match(&string, "size=")) {
+	    size = large_number(sdp, string, ANY_RADIX, &status, True);
+	    size_flag = True;
+	} else if (match(&string, "bs=")) {
+	    edp->ed_block_length = (uint32_t)number(sdp, string, ANY_RADIX, &status, True);
+	} else if (match(&string, "latency=")) {
+	    edp->ed_latency = (uint32_t)number(sdp, string, ANY_RADIX, &status, True);
+	} else if (match(&string, "file=")) {
+	    FreeStr(sdp, edp->ed_file);
+	    edp->ed_file = strdup(string);
+	} else {
+	    Eprintf(sdp, "Unknown emulated device option '%s', valid are: size=, bs=, latency=, file=\n", token);
+	    status = FAILURE;
+	}
+	if (status != SUCCESS) break;
+    }
+    free(opts);
+    if (status != SUCCESS) return(FAILURE);
+    /* Chunks must hold whole blocks. */
+    if ( (edp->ed_block_length < BLOCK_SIZE) || (edp->ed_block_length > EMU_CHUNK_SIZE) ||
+	 (edp->ed_block_length & (edp->ed_block_length - 1)) ) {
+	Eprintf(sdp, "The emulated block length must be a power of 2, from %u to %u bytes!\n",
+		BLOCK_SIZE, EMU_CHUNK_SIZE);
+	return(FAILURE);
+    }
+    if (edp->ed_file) {
+	if (emu_open_file(sdp, edp, &size, size_flag) != SUCCESS) return(FAILURE);
+    }
+    edp->ed_capacity = (size / edp->ed_block_length);
+    if (edp->ed_capacity == 0) {
+	Eprintf(sdp, "The emulated device size must be at least one block!\n");
+	return(FAILURE);
+    }
+    edp->ed_chunk_blocks = (EMU_CHUNK_SIZE / edp->ed_block_length);
+    edp->ed_chunk_count = howmany(edp->ed_capacity, edp->ed_chunk_blocks);
+    return(SUCCESS);
+}
+
+/*
+ * destroy_emu_device() - Free a partially created emulated device.
+ */
+static void
+destroy_emu_device(scsi_device_t *sdp, emu_device_t *edp)
+{
+    if (edp->ed_fd != INVALID_HANDLE_VALUE) {
+	(void)os_close_file(edp->ed_fd);
+    }
+    FreeStr(sdp, edp->ed_file);
+    if (edp->ed_chunks) {
+	Free(sdp, edp->ed_chunks);
+    }
+    Free(sdp, edp);
+    return;
+}
+
+static emu_device_t *
+create_emu_device(scsi_device_t *sdp, char *dsf)
+{
+    emu_device_t *edp;
+    int status;
+
+    edp = Malloc(sdp, sizeof(*edp));
+    if (edp == NULL) return(NULL);
+    edp->ed_fd = INVALID_HANDLE_VALUE;
+    if (parse_emu_options(sdp, edp, (dsf + sizeof(EMU_DSF_PREFIX) - 1)) != SUCCESS) {
+	destroy_emu_device(sdp, edp);
+	return(NULL);
+    }
+    if (edp->ed_file == NULL) {
+	edp->ed_chunks = Malloc(sdp, (size_t)(sizeof(*edp->ed_chunks) * edp->ed_chunk_count));
+	if (edp->ed_chunks == NULL) {
+	    destroy_emu_device(sdp, edp);
+	    return(NULL);
+	}
+    }
+    if ( (status = pthread_mutex_init(&edp->ed_lock, NULL)) != SUCCESS) {
+	tPerror(sdp, status, "pthread_mutex_init() of emulated device lock failed!");
+	destroy_emu_device(sdp, edp);
+	return(NULL);
+    }
+    edp->ed_dsf = strdup(dsf);
+    edp->ed_lun = emu_luns++;
+    if (sdp->DebugFlag) {
+	Printf(sdp, "Created emulated device %s, " LUF " blocks of %u bytes, latency %u usecs%s%s\n",
+	       dsf, edp->ed_capacity, edp->ed_block_length, edp->ed_latency,
+	       (edp->ed_file) ? ", file " : "", (edp->ed_file) ? edp->ed_file : "");
+    }
+    return(edp);
+}
+
+/*
+ * emu_open_device() - Open (find or create) an emulated device.
+ *
+ * Description:
+ *	The emulated device is shared by name. Since the handle is dup'ed
+ * for threads and closed via the OS functions, the null device is opened,
+ * but all CDB's are executed by the emulator.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	iop = The I/O parameters.
+ *	sgp = The SCSI generic information.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE
+ */
+int
+emu_open_device(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp)
+{
+    emu_device_t *edp;
+
+    (void)pthread_mutex_lock(&emu_lock);
+    for (edp = emu_devices; edp; edp = edp->ed_next) {
+	if (strcmp(edp->ed_dsf, sgp->dsf) == 0) break;
+    }
+    if (edp == NULL) {
+	if ( (edp = create_emu_device(sdp, sgp->dsf)) ) {
+	    edp->ed_next = emu_devices;
+	    emu_devices = edp;
+	}
+    }
+    (void)pthread_mutex_unlock(&emu_lock);
+    if (edp == NULL) return(FAILURE);
+
+    sgp->fd = os_open_file(EMU_NULL_DEVICE, O_RDWR, 0);
+    if (sgp->fd == INVALID_HANDLE_VALUE) {
+	os_perror(sdp, "Failed to open %s for emulated device %s", EMU_NULL_DEVICE, sgp->dsf);
+	return(FAILURE);
+    }
+    iop->emu_device = edp;
+    return(SUCCESS);
+}
+
+/*
+ * emu_designator() - Format the NAA designator (VPD page 0x83).
+ */
+static void
+emu_designator(emu_device_t *edp, uint8_t *designator)
+{
+    memset(designator, '\0', EMU_DESIGNATOR_LENGTH);
+    designator[0] = 0x60;		/* NAA IEEE Registered Extended. */
+    memcpy(&designator[4], "SPTEMU", 6);
+    htos(&designator[12], edp->ed_lun, 4);
+    return;
+}
+
+/*
+ * emu_find_designator() - Find the emulated device for a copy designator.
+ */
+static emu_device_t *
+emu_find_designator(uint8_t *designator, uint32_t designator_length)
+{
+    uint8_t emu_designator_id[EMU_DESIGNATOR_LENGTH];
+    emu_device_t *edp;
+
+    if (designator_length != EMU_DESIGNATOR_LENGTH) return(NULL);
+    (void)pthread_mutex_lock(&emu_lock);
+    for (edp = emu_devices; edp; edp = edp->ed_next) {
+	emu_designator(edp, emu_designator_id);
+	if (memcmp(emu_designator_id, designator, EMU_DESIGNATOR_LENGTH) == 0) break;
+    }
+    (void)pthread_mutex_unlock(&emu_lock);
+    return(edp);
+}
+
+/*
+ * Lock the source and destination devices, always in the same order.
+ */
+static void
+emu_lock_devices(emu_device_t *sedp, emu_device_t *dedp)
+{
+    if (sedp == dedp) {
+	(void)pthread_mutex_lock(&sedp->ed_lock);
+    } else if (sedp < dedp) {
+	(void)pthread_mutex_lock(&sedp->ed_lock);
+	(void)pthread_mutex_lock(&dedp->ed_lock);
+    } else {
+	(void)pthread_mutex_lock(&dedp->ed_lock);
+	(void)pthread_mutex_lock(&sedp->ed_lock);
+    }
+    return;
+}
+
+static void
+emu_unlock_devices(emu_device_t *sedp, emu_device_t *dedp)
+{
+    if (sedp != dedp) {
+	(void)pthread_mutex_unlock(&dedp->ed_lock);
+    }
+    (void)pthread_mutex_unlock(&sedp->ed_lock);
+    return;
+}
+
+/* ======================================================================== */
+
+static int
+emu_check_condition(scsi_generic_t *sgp, uint8_t sense_key, uint8_t asc, uint8_t ascq, uint64_t info)
+{
+    uint8_t *sense = sgp->sense_data;
+    uint32_t sense_length = 18;
+
+    sgp->scsi_status = SCSI_CHECK_CONDITION;
+    sgp->error = True;
+    sgp->data_resid = sgp->data_length;
+    if ( (sense == NULL) || (sgp->sense_length < sense_length) ) {
+	return(SUCCESS);
+    }
+    memset(sense, '\0', sense_length);
+    sense[0] = 0x70;				/* Current error, fixed format.	*/
+    sense[2] = sense_key;
+    sense[7] = (uint8_t)(sense_length - 8);	/* Additional sense length.	*/
+    sense[12] = asc;
+    sense[13] = ascq;
+    if (info) {
+	sense[0] |= 0x80;			/* Information field valid.	*/
+	htos(&sense[3], (uint32_t)info, 4);
+    }
+    sgp->sense_valid = True;
+    sgp->sense_resid = (sgp->sense_length - sense_length);
+    return(SUCCESS);
+}
+
+static int
+emu_illegal_request(scsi_generic_t *sgp, uint8_t asc)
+{
+    return( emu_check_condition(sgp, SKV_ILLEGAL_REQUEST, asc, 0, 0) );
+}
+
+/*
+ * emu_media_error() - Report a media access failure.
+ */
+static int
+emu_media_error(scsi_device_t *sdp, emu_device_t *edp, scsi_generic_t *sgp)
+{
+    if (edp->ed_file) {
+	os_perror(sdp, "I/O to emulated device file %s failed", edp->ed_file);
+	return( emu_check_condition(sgp, SKV_MEDIUM_ERROR,
+				    (sgp->data_dir == scsi_data_write) ? ASC_WRITE_ERROR : ASC_READ_ERROR, 0, 0) );
+    }
+    Eprintf(sdp, "Unable to allocate memory for emulated device %s!\n", edp->ed_dsf);
+    return( emu_check_condition(sgp, SKV_HARDWARE_ERROR, ASC_RESOURCE_FAILURE, 0, 0) );
+}
+
+/*
+ * emu_transfer_data() - Return command data, limited by allocation length.
+ */
+static int
+emu_transfer_data(scsi_generic_t *sgp, uint8_t *data, uint32_t length, uint32_t allocation_length)
+{
+    uint32_t count = min(length, min(allocation_length, sgp->data_length));
+
+    if (count) {
+	memcpy(sgp->data_buffer, data, count);
+    }
+    sgp->data_resid = (sgp->data_length - count);
+    sgp->data_transferred = count;
+    return(SUCCESS);
+}
+
+/*
+ * File backed media functions:
+ */
+static int
+emu_file_io(emu_device_t *edp, hbool_t write_flag, uint64_t lba, uint64_t blocks, uint8_t *buffer)
+{
+    Offset_t offset = (Offset_t)(lba * edp->ed_block_length);
+    size_t bytes = (size_t)(blocks * edp->ed_block_length);
+    ssize_t count;
+
+    while (bytes) {
+	if (write_flag == True) {
+	    count = os_pwrite_file(edp->ed_fd, buffer, bytes, offset);
+	} else {
+	    count = os_pread_file(edp->ed_fd, buffer, bytes, offset);
+	}
+	if (count < 0) return(FAILURE);
+	if (count == 0) {
+	    if (write_flag == True) return(FAILURE);
+	    memset(buffer, '\0', bytes);	/* Beyond end of file. */
+	    break;
+	}
+	buffer += count;
+	offset += count;
+	bytes -= count;
+    }
+    return(SUCCESS);
+}
+
+static int
+emu_file_unmap(emu_device_t *edp, uint64_t lba, uint64_t blocks)
+{
+    uint8_t *zeroes;
+    uint64_t count;
+    int status = SUCCESS;
+
+#if defined(FALLOC_FL_PUNCH_HOLE)
+    if (fallocate(edp->ed_fd, (FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE),
+		  (Offset_t)(lba * edp->ed_block_length),
+		  (Offset_t)(blocks * edp->ed_block_length)) == SUCCESS) {
+	return(SUCCESS);
+    }
+#endif /* defined(FALLOC_FL_PUNCH_HOLE) */
+    /* Without hole punching, write zeroes (LBPRZ). */
+    if ( (zeroes = calloc(1, EMU_CHUNK_SIZE)) == NULL) return(FAILURE);
+    while ( blocks && (status == SUCCESS) ) {
+	count = min(blocks, (uint64_t)edp->ed_chunk_blocks);
+	status = emu_file_io(edp, True, lba, count, zeroes);
+	lba += count;
+	blocks -= count;
+    }
+    free(zeroes);
+    return(status);
+}
+
+/*
+ * Media access functions: (called with the device lock held)
+ */
+static int
+emu_read_media(emu_device_t *edp, uint64_t lba, uint64_t blocks, uint8_t *buffer)
+{
+    uint64_t chunk;
+    uint32_t offset, count;
+
+    if (edp->ed_file) {
+	return( emu_file_io(edp, False, lba, blocks, buffer) );
+    }
+    while (blocks) {
+	chunk = (lba / edp->ed_chunk_blocks);
+	offset = (uint32_t)(lba % edp->ed_chunk_blocks);
+	count = (uint32_t)min(blocks, (uint64_t)(edp->ed_chunk_blocks - offset));
+	if (edp->ed_chunks[chunk]) {
+	    memcpy(buffer, edp->ed_chunks[chunk] + ((size_t)offset * edp->ed_block_length),
+		   ((size_t)count * edp->ed_block_length));
+	} else {
+	    memset(buffer, '\0', ((size_t)count * edp->ed_block_length));
+	}
+	buffer += ((size_t)count * edp->ed_block_length);
+	lba += count;
+	blocks -= count;
+    }
+    return(SUCCESS);
+}
+
+static int
+emu_write_media(emu_device_t *edp, uint64_t lba, uint64_t blocks, uint8_t *buffer)
+{
+    uint64_t chunk;
+    uint32_t offset, count;
+
+    if (edp->ed_file) {
+	return( emu_file_io(edp, True, lba, blocks, buffer) );
+    }
+    while (blocks) {
+	chunk = (lba / edp->ed_chunk_blocks);
+	offset = (uint32_t)(lba % edp->ed_chunk_blocks);
+	count = (uint32_t)min(blocks, (uint64_t)(edp->ed_chunk_blocks - offset));
+	if (edp->ed_chunks[chunk] == NULL) {
+	    edp->ed_chunks[chunk] = Malloc(NULL, EMU_CHUNK_SIZE);
+	    if (edp->ed_chunks[chunk] == NULL) return(FAILURE);
+	}
+	memcpy(edp->ed_chunks[chunk] + ((size_t)offset * edp->ed_block_length), buffer,
+	       ((size_t)count * edp->ed_block_length));
+	buffer += ((size_t)count * edp->ed_block_length);
+	lba += count;
+	blocks -= count;
+    }
+    return(SUCCESS);
+}
+
+static int
+emu_unmap_media(emu_device_t *edp, uint64_t lba, uint64_t blocks)
+{
+    uint64_t chunk;
+    uint32_t offset, count;
+
+    if (edp->ed_file) {
+	return( emu_file_unmap(edp, lba, blocks) );
+    }
+    while (blocks) {
+	chunk = (lba / edp->ed_chunk_blocks);
+	offset = (uint32_t)(lba % edp->ed_chunk_blocks);
+	count = (uint32_t)min(blocks, (uint64_t)(edp->ed_chunk_blocks - offset));
+	if (edp->ed_chunks[chunk]) {
+	    if (count == edp->ed_chunk_blocks) {
+		Free(NULL, edp->ed_chunks[chunk]);
+		edp->ed_chunks[chunk] = NULL;
+	    } else { /* Unmapped blocks read as zeroes (LBPRZ). */
+		memset(edp->ed_chunks[chunk] + ((size_t)offset * edp->ed_block_length), '\0',
+		       ((size_t)count * edp->ed_block_length));
+	    }
+	}
+	lba += count;
+	blocks -= count;
+    }
+    return(SUCCESS);
+}
+
+/*
+ * emu_compare_media() - Compare media with data.
+ *
+ * Outputs:
+ *	offset = The byte offset of the first miscompare, or -1 if the data matches.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE (media read failed)
+ */
+static int
+emu_compare_media(emu_device_t *edp, uint64_t lba, uint64_t blocks, uint8_t *buffer,
+		  hbool_t one_block, int64_t *offset)
+{
+    uint8_t *media = malloc(edp->ed_block_length);
+    uint64_t block;
+    uint32_t byte;
+    int status = SUCCESS;
+
+    *offset = -1;
+    if (media == NULL) return(FAILURE);
+    for (block = 0; (block < blocks); block++) {
+	uint8_t *data = (one_block == True) ? buffer : (buffer + (block * edp->ed_block_length));
+	if ( (status = emu_read_media(edp, (lba + block), 1, media)) != SUCCESS) break;
+	if (memcmp(media, data, edp->ed_block_length) == 0) continue;
+	for (byte = 0; (byte < edp->ed_block_length); byte++) {
+	    if (media[byte] != data[byte]) break;
+	}
+	*offset = (int64_t)((block * edp->ed_block_length) + byte);
+	break;
+    }
+    free(media);
+    return(status);
+}
+
+/*
+ * emu_get_extent() - Get the mapped or deallocated extent starting at an LBA.
+ *
+ * Outputs:
+ *	state = The provisioning status (0 = mapped, 1 = deallocated).
+ *
+ * Return Value:
+ *	The extent length in blocks (limited to 32 bits, for the descriptor).
+ */
+static uint64_t
+emu_get_extent(emu_device_t *edp, uint64_t lba, uint8_t *state)
+{
+    uint64_t blocks = 0;
+
+    if (edp->ed_file) {
+#if defined(SEEK_DATA)
+	Offset_t offset = (Offset_t)(lba * edp->ed_block_length);
+	Offset_t data, hole;
+
+	data = os_seek_file(edp->ed_fd, offset, SEEK_DATA);
+	if ( (data == (Offset_t)-1) && (errno == ENXIO) ) {
+	    *state = 1;			/* A hole to the end of file. */
+	    blocks = (edp->ed_capacity - lba);
+	} else if ( (data != (Offset_t)-1) &&
+		    (((data - offset) / edp->ed_block_length) > 0) ) {
+	    *state = 1;
+	    blocks = ((data - offset) / edp->ed_block_length);
+	} else if (data != (Offset_t)-1) {
+	    /* Note: A partially allocated block is reported as mapped. */
+	    hole = os_seek_file(edp->ed_fd, data, SEEK_HOLE);
+	    if (hole > offset) {
+		*state = 0;
+		blocks = howmany((uint64_t)(hole - offset), edp->ed_block_length);
+	    }
+	}
+#endif /* defined(SEEK_DATA) */
+	if (blocks == 0) {		/* Unsupported, report mapped. */
+	    *state = 0;
+	    blocks = (edp->ed_capacity - lba);
+	}
+    } else {
+	uint64_t chunk = (lba / edp->ed_chunk_blocks);
+	*state = (edp->ed_chunks[chunk]) ? 0 : 1;
+	/* Coalesce chunks in the same state. */
+	while ( (chunk < edp->ed_chunk_count) &&
+		(((edp->ed_chunks[chunk]) ? 0 : 1) == *state) &&
+		((blocks + edp->ed_chunk_blocks) <= 0xFFFFFFFF) ) {
+	    blocks += (edp->ed_chunk_blocks - ((lba + blocks) % edp->ed_chunk_blocks));
+	    chunk++;
+	}
+    }
+    blocks = min(blocks, (edp->ed_capacity - lba));
+    return( min(blocks, (uint64_t)0xFFFFFFFF) );
+}
+
+/*
+ * emu_copy_data() - Copy mapped blocks between (or within) emulated devices.
+ */
+static int
+emu_copy_data(emu_device_t *sedp, uint64_t slba, emu_device_t *dedp, uint64_t dlba,
+	      uint64_t blocks, uint8_t **buffer)
+{
+    uint64_t count;
+    int status = SUCCESS;
+
+#if defined(EMU_COPY_FILE_RANGE)
+    if (sedp->ed_file && dedp->ed_file) {
+	loff_t soffset = (loff_t)(slba * sedp->ed_block_length);
+	loff_t doffset = (loff_t)(dlba * dedp->ed_block_length);
+	uint64_t bytes = (blocks * sedp->ed_block_length);
+	ssize_t result;
+
+	while (bytes) {
+	    result = copy_file_range(sedp->ed_fd, &soffset, dedp->ed_fd, &doffset, (size_t)bytes, 0);
+	    if (result <= 0) break;
+	    bytes -= result;
+	}
+	if (bytes == 0) return(SUCCESS);
+	/* Not supported (EXDEV, ENOSYS, etc), so copy the remaining blocks. */
+	count = (((blocks * sedp->ed_block_length) - bytes) / sedp->ed_block_length);
+	slba += count;
+	dlba += count;
+	blocks -= count;
+    }
+#endif /* defined(EMU_COPY_FILE_RANGE) */
+    if ( (*buffer == NULL) && ((*buffer = malloc(EMU_CHUNK_SIZE)) == NULL) ) return(FAILURE);
+    while ( blocks && (status == SUCCESS) ) {
+	count = min(blocks, (uint64_t)(EMU_CHUNK_SIZE / sedp->ed_block_length));
+	status = emu_read_media(sedp, slba, count, *buffer);
+	if (status == SUCCESS) {
+	    status = emu_write_media(dedp, dlba, count, *buffer);
+	}
+	slba += count;
+	dlba += count;
+	blocks -= count;
+    }
+    return(status);
+}
+
+/*
+ * emu_copy_media() - Copy blocks between (or within) emulated devices.
+ *
+ * Description:
+ *	The block lengths must match. The source is walked by extent, so only
+ * mapped blocks are copied, and source holes are deallocated in the target
+ * (unless already deallocated), keeping sparse devices sparse. File backed
+ * devices use the kernel copy_file_range(), which shares extents on file
+ * systems supporting this, otherwise the data is copied via a bounce buffer.
+ */
+static int
+emu_copy_media(emu_device_t *sedp, uint64_t slba, emu_device_t *dedp, uint64_t dlba, uint64_t blocks)
+{
+    uint8_t *buffer = NULL;
+    uint64_t extent, dextent;
+    uint8_t state, dstate;
+    int status = SUCCESS;
+
+    while ( blocks && (status == SUCCESS) ) {
+	extent = min(emu_get_extent(sedp, slba, &state), blocks);
+	if (state == 0) {
+	    status = emu_copy_data(sedp, slba, dedp, dlba, extent, &buffer);
+	} else {
+	    dextent = emu_get_extent(dedp, dlba, &dstate);
+	    if ( (dstate == 0) || (dextent < extent) ) {
+		status = emu_unmap_media(dedp, dlba, extent);
+	    }
+	}
+	slba += extent;
+	dlba += extent;
+	blocks -= extent;
+    }
+    if (buffer) free(buffer);
+    return(status);
+}
+
+/* ======================================================================== */
+
+static int
+emu_inquiry(emu_device_t *edp, scsi_generic_t *sgp)
+{
+    uint8_t data[EMU_VPD_BUFFER_SIZE];
+    uint32_t allocation_length = (uint32_t)stoh(&sgp->cdb[3], 2);
+    uint8_t page = sgp->cdb[2];
+    uint32_t length;
+
+    memset(data, '\0', sizeof(data));
+    if ( (sgp->cdb[1] & 0x01) == 0) {	/* Standard Inquiry data. */
+	if (page) return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+	data[0] = DTYPE_DIRECT;
+	data[2] = 0x06;			/* SPC-4 */
+	data[3] = 0x02;			/* Response data format. */
+	data[5] = 0x08;			/* Third party copy (TPC). */
+	data[7] = 0x02;			/* Command queuing. */
+	memcpy(&data[8], "SPT     ", 8);
+	memcpy(&data[16], "EMULATED DEVICE ", 16);
+	memcpy(&data[32], "0001", 4);
+	length = 36;
+	data[4] = (uint8_t)(length - 5);
+	return( emu_transfer_data(sgp, data, length, allocation_length) );
+    }
+    data[1] = page;
+    switch (page) {
+	case 0x00:			/* Supported VPD pages. */
+	    data[4] = 0x00; data[5] = 0x80; data[6] = 0x83; data[7] = 0x8F;
+	    data[8] = 0xB0; data[9] = 0xB1; data[10] = 0xB2;
+	    length = 11;
+	    break;
+	case 0x80:			/* Unit serial number. */
+	    (void)sprintf((char *)&data[4], "SPTEMU%06u", edp->ed_lun);
+	    length = (uint32_t)(4 + strlen((char *)&data[4]));
+	    break;
+	case 0x83:			/* Device identification. */
+	    data[4] = 0x01;		/* Binary code set. */
+	    data[5] = 0x03;		/* LUN association, NAA designator. */
+	    data[7] = EMU_DESIGNATOR_LENGTH;
+	    emu_designator(edp, &data[8]);
+	    length = (8 + EMU_DESIGNATOR_LENGTH);
+	    break;
+	case 0x8F:			/* Third party copy. */
+	    htos(&data[4], 0x0000, 2);	/* Block device ROD token limits. */
+	    htos(&data[6], 0x20, 2);
+	    htos(&data[14], EMU_MAX_RANGE_DESCS, 2);
+	    htos(&data[24], (EMU_MAX_TOKEN_BYTES / edp->ed_block_length), 8);
+	    htos(&data[32], (EMU_MAX_TOKEN_BYTES / edp->ed_block_length), 8);
+	    length = 40;
+	    break;
+	case 0xB0:			/* Block limits. */
+	    data[5] = EMU_MAX_CAW_BLOCKS;
+	    htos(&data[6], 1, 2);
+	    htos(&data[8], (EMU_MAX_TRANSFER / edp->ed_block_length), 4);
+	    htos(&data[12], edp->ed_chunk_blocks, 4);
+	    htos(&data[20], 0xFFFFFFFF, 4);
+	    htos(&data[24], EMU_MAX_UNMAP_DESCS, 4);
+	    htos(&data[28], edp->ed_chunk_blocks, 4);
+	    htos(&data[32], 0x80000000, 4);	/* UGAVALID, aligned at LBA 0. */
+	    htos(&data[36], edp->ed_capacity, 8);
+	    length = 64;
+	    break;
+	case 0xB1:			/* Block device characteristics. */
+	    htos(&data[4], 1, 2);	/* Non-rotating medium. */
+	    length = 64;
+	    break;
+	case 0xB2:			/* Logical block provisioning. */
+	    data[5] = 0xE4;		/* LBPU, LBPWS, LBPWS10, LBPRZ = 001b */
+	    data[6] = 0x02;		/* Thin provisioned. */
+	    length = 8;
+	    break;
+	default:
+	    return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+    }
+    htos(&data[2], (length - 4), 2);
+    return( emu_transfer_data(sgp, data, length, allocation_length) );
+}
+
+static int
+emu_read_capacity(emu_device_t *edp, scsi_generic_t *sgp, hbool_t capacity16)
+{
+    uint8_t data[32];
+    uint64_t last_lba = (edp->ed_capacity - 1);
+
+    memset(data, '\0', sizeof(data));
+    if (capacity16 == False) {
+	htos(&data[0], min(last_lba, (uint64_t)0xFFFFFFFF), 4);
+	htos(&data[4], edp->ed_block_length, 4);
+	return( emu_transfer_data(sgp, data, 8, 8) );
+    }
+    htos(&data[0], last_lba, 8);
+    htos(&data[8], edp->ed_block_length, 4);
+    data[14] = 0xC0;			/* LBPME and LBPRZ. */
+    return( emu_transfer_data(sgp, data, sizeof(data), (uint32_t)stoh(&sgp->cdb[10], 4)) );
+}
+
+/*
+ * emu_get_lba_status() - Report mapped and deallocated extents.
+ */
+static int
+emu_get_lba_status(emu_device_t *edp, scsi_generic_t *sgp)
+{
+    uint64_t lba = stoh(&sgp->cdb[2], 8);
+    uint32_t allocation_length = (uint32_t)stoh(&sgp->cdb[10], 4);
+    uint32_t max_descriptors, descriptors = 0;
+    uint8_t *data, *dp;
+    uint64_t blocks;
+    uint8_t state = 0;
+    int status;
+
+    if (lba >= edp->ed_capacity) {
+	return( emu_illegal_request(sgp, ASC_LBA_OUT_OF_RANGE) );
+    }
+    max_descriptors = (allocation_length > 8) ? ((allocation_length - 8) / 16) : 0;
+    data = malloc(8 + ((size_t)max(max_descriptors, 1) * 16));
+    if (data == NULL) return(FAILURE);
+    memset(data, '\0', 8);
+    dp = &data[8];
+    (void)pthread_mutex_lock(&edp->ed_lock);
+    while ( (lba < edp->ed_capacity) && (descriptors < max_descriptors) ) {
+	blocks = emu_get_extent(edp, lba, &state);
+	memset(dp, '\0', 16);
+	htos(&dp[0], lba, 8);
+	htos(&dp[8], blocks, 4);
+	dp[12] = state;
+	dp += 16;
+	descriptors++;
+	lba += blocks;
+    }
+    (void)pthread_mutex_unlock(&edp->ed_lock);
+    htos(&data[0], ((descriptors * 16) + 4), 4);
+    status = emu_transfer_data(sgp, data, (8 + (descriptors * 16)), allocation_length);
+    free(data);
+    return(status);
+}
+
+static int
+emu_unmap(scsi_device_t *sdp, emu_device_t *edp, scsi_generic_t *sgp)
+{
+    uint8_t *data = sgp->data_buffer;
+    uint32_t parameter_length = (uint32_t)stoh(&sgp->cdb[7], 2);
+    uint32_t descriptor_length, descriptor;
+    uint64_t lba, blocks;
+    int status = SUCCESS;
+
+    if (parameter_length == 0) return(SUCCESS);
+    if ( (parameter_length < 8) || (sgp->data_length < parameter_length) ) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+    }
+    descriptor_length = (uint32_t)min(stoh(&data[2], 2), (uint64_t)(parameter_length - 8));
+    if ( (descriptor_length / 16) > EMU_MAX_UNMAP_DESCS) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_PARAM) );
+    }
+    /* Validate all descriptors, before unmapping any. */
+    for (descriptor = 0; (descriptor < (descriptor_length / 16)); descriptor++) {
+	lba = stoh(&data[8 + (descriptor * 16)], 8);
+	blocks = stoh(&data[16 + (descriptor * 16)], 4);
+	if ( (lba + blocks) > edp->ed_capacity) {
+	    return( emu_illegal_request(sgp, ASC_LBA_OUT_OF_RANGE) );
+	}
+    }
+    (void)pthread_mutex_lock(&edp->ed_lock);
+    for (descriptor = 0; (descriptor < (descriptor_length / 16)) && (status == SUCCESS); descriptor++) {
+	lba = stoh(&data[8 + (descriptor * 16)], 8);
+	blocks = stoh(&data[16 + (descriptor * 16)], 4);
+	status = emu_unmap_media(edp, lba, blocks);
+    }
+    (void)pthread_mutex_unlock(&edp->ed_lock);
+    if (status != SUCCESS) {
+	return( emu_media_error(sdp, edp, sgp) );
+    }
+    return(SUCCESS);
+}
+
+/*
+ * emu_media_access() - Execute read, write, verify, write same, and CAW.
+ */
+static int
+emu_media_access(scsi_device_t *sdp, emu_device_t *edp, scsi_generic_t *sgp)
+{
+    uint8_t *cdb = sgp->cdb;
+    uint8_t *buffer = sgp->data_buffer;
+    uint64_t lba, blocks, bytes, data_bytes;
+    uint8_t opcode = cdb[0];
+    uint8_t bytchk = 0;
+    hbool_t unmap = False, ndob = False;
+    int64_t offset;
+    int status = SUCCESS;
+
+    switch (opcode) {
+	case 0x08: case 0x0A:		/* Read(6) / Write(6) */
+	    lba = ((uint64_t)(cdb[1] & 0x1F) << 16) | stoh(&cdb[2], 2);
+	    blocks = (cdb[4]) ? cdb[4] : 256;
+	    break;
+	case 0x28: case 0x2A:		/* Read(10) / Write(10) */
+	case 0x2F: case 0x41:		/* Verify(10) / Write Same(10) */
+	    lba = stoh(&cdb[2], 4);
+	    blocks = stoh(&cdb[7], 2);
+	    break;
+	case 0x89:			/* Compare and Write */
+	    lba = stoh(&cdb[2], 8);
+	    blocks = cdb[13];
+	    break;
+	default:			/* Read(16), Write(16), Verify(16), Write Same(16) */
+	    lba = stoh(&cdb[2], 8);
+	    blocks = stoh(&cdb[10], 4);
+	    break;
+    }
+    /* Not formatted with protection information, so reject the protect field. */
+    if ( (opcode != 0x08) && (opcode != 0x0A) && (cdb[1] & 0xE0) ) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+    }
+    if ( (opcode == 0x2F) || (opcode == 0x8F) ) {
+	bytchk = ((cdb[1] >> 1) & 0x03);
+    } else if ( (opcode == 0x41) || (opcode == 0x93) ) {
+	unmap = (cdb[1] & 0x08) ? True : False;
+	ndob = ((opcode == 0x93) && (cdb[1] & 0x01)) ? True : False;
+	if (blocks == 0) {		/* Write to the end of the medium. */
+	    blocks = (lba < edp->ed_capacity) ? (edp->ed_capacity - lba) : 0;
+	}
+    }
+    if ( (lba >= edp->ed_capacity) || (blocks > (edp->ed_capacity - lba)) ) {
+	return( emu_illegal_request(sgp, ASC_LBA_OUT_OF_RANGE) );
+    }
+    bytes = (blocks * edp->ed_block_length);
+    /* The data transferred, for write same and compare and write. */
+    if ( (opcode == 0x41) || (opcode == 0x93) || (bytchk == 3) ) {
+	data_bytes = (ndob == True) ? 0 : edp->ed_block_length;
+    } else if (opcode == 0x89) {
+	if (blocks > EMU_MAX_CAW_BLOCKS) {
+	    return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+	}
+	data_bytes = (bytes * 2);
+    } else if ( (opcode == 0x2F) || (opcode == 0x8F) ) {
+	data_bytes = (bytchk) ? bytes : 0;
+    } else {
+	data_bytes = bytes;
+    }
+    if ( data_bytes && ((buffer == NULL) || (sgp->data_length < data_bytes)) ) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+    }
+    /* Write same with unmap, deallocates when the data is zero. */
+    if ( (unmap == True) && (ndob == False) ) {
+	uint32_t byte;
+	for (byte = 0; (byte < edp->ed_block_length); byte++) {
+	    if (buffer[byte]) break;
+	}
+	unmap = (byte == edp->ed_block_length) ? True : False;
+    }
+
+    if (edp->ed_latency) {
+	os_usleep(edp->ed_latency);
+    }
+    (void)pthread_mutex_lock(&edp->ed_lock);
+    switch (opcode) {
+	case 0x08: case 0x28: case 0x88:	/* Read(6/10/16) */
+	    status = emu_read_media(edp, lba, blocks, buffer);
+	    break;
+	case 0x0A: case 0x2A: case 0x8A:	/* Write(6/10/16) */
+	    status = emu_write_media(edp, lba, blocks, buffer);
+	    break;
+	case 0x2F: case 0x8F:			/* Verify(10/16) */
+	    if (bytchk == 0) break;
+	    status = emu_compare_media(edp, lba, blocks, buffer, (bytchk == 3) ? True : False, &offset);
+	    if ( (status == SUCCESS) && (offset >= 0) ) {
+		(void)emu_check_condition(sgp, SKV_MISCOMPARE, ASC_MISCOMPARE, 0, (uint64_t)offset);
+	    }
+	    break;
+	case 0x41: case 0x93:			/* Write Same(10/16) */
+	    if ( (unmap == True) || (ndob == True) ) {
+		status = emu_unmap_media(edp, lba, blocks);
+	    } else {
+		uint64_t block;
+		for (block = 0; (block < blocks) && (status == SUCCESS); block++) {
+		    status = emu_write_media(edp, (lba + block), 1, buffer);
+		}
+	    }
+	    break;
+	case 0x89:				/* Compare and Write */
+	    status = emu_compare_media(edp, lba, blocks, buffer, False, &offset);
+	    if (status != SUCCESS) {
+		break;
+	    } else if (offset >= 0) {
+		(void)emu_check_condition(sgp, SKV_MISCOMPARE, ASC_MISCOMPARE, 0, (uint64_t)offset);
+	    } else {
+		status = emu_write_media(edp, lba, blocks, (buffer + bytes));
+	    }
+	    break;
+    }
+    (void)pthread_mutex_unlock(&edp->ed_lock);
+    if (status != SUCCESS) {
+	return( emu_media_error(sdp, edp, sgp) );
+    }
+    if (sgp->error == False) {
+	sgp->data_transferred = (uint32_t)min(data_bytes, (uint64_t)sgp->data_length);
+	sgp->data_resid = (sgp->data_length - sgp->data_transferred);
+    }
+    return(SUCCESS);
+}
+
+/* ======================================================================== */
+
+/*
+ * Copy Offload Functions:
+ */
+static void
+emu_record_result(emu_device_t *edp, uint32_t list_identifier, uint8_t service_action,
+		  uint8_t copy_status, uint64_t transfer_count, uint64_t token_id)
+{
+    emu_copy_result_t *erp;
+
+    (void)pthread_mutex_lock(&emu_lock);
+    erp = &emu_results[emu_result_index++ % EMU_COPY_RESULTS];
+    erp->er_device = edp;
+    erp->er_list_identifier = list_identifier;
+    erp->er_service_action = service_action;
+    erp->er_copy_status = copy_status;
+    erp->er_transfer_count = transfer_count;
+    erp->er_token_id = token_id;
+    (void)pthread_mutex_unlock(&emu_lock);
+    return;
+}
+
+static void
+emu_build_token(emu_device_t *edp, uint64_t token_id, uint8_t *token)
+{
+    memset(token, '\0', ROD_TOKEN_SIZE);
+    htos(&token[0], EMU_ROD_TYPE_PIT, 4);
+    htos(&token[6], (ROD_TOKEN_SIZE - 8), 2);
+    htos(&token[8], token_id, 8);
+    emu_designator(edp, &token[16]);
+    return;
+}
+
+/*
+ * emu_check_ranges() - Validate range descriptors, returning the total blocks.
+ */
+static int
+emu_check_ranges(emu_device_t *edp, uint8_t *ranges, uint32_t range_count, uint64_t *total_blocks)
+{
+    uint64_t lba, blocks;
+    uint32_t range;
+
+    *total_blocks = 0;
+    for (range = 0; (range < range_count); range++) {
+	lba = stoh(&ranges[range * EMU_RANGE_DESC_LENGTH], 8);
+	blocks = stoh(&ranges[(range * EMU_RANGE_DESC_LENGTH) + 8], 4);
+	if ( (lba >= edp->ed_capacity) || (blocks > (edp->ed_capacity - lba)) ) {
+	    return(FAILURE);
+	}
+	*total_blocks += blocks;
+    }
+    return(SUCCESS);
+}
+
+/*
+ * emu_extended_copy() - Extended Copy (LID1), block to block segments.
+ */
+static int
+emu_extended_copy(scsi_device_t *sdp, emu_device_t *edp, scsi_generic_t *sgp)
+{
+    uint8_t *data = sgp->data_buffer;
+    uint32_t parameter_length = (uint32_t)stoh(&sgp->cdb[10], 4);
+    emu_device_t *cscds[EMU_MAX_CSCD_DESCS];
+    emu_device_t *sedp, *dedp;
+    uint32_t cscd_length, segment_length, segment_end;
+    uint32_t cscd, cscd_count, offset, length, segments;
+    uint64_t blocks, slba, dlba;
+    uint8_t *dp;
+    int pass, status = SUCCESS;
+
+    if (parameter_length == 0) return(SUCCESS);
+    if ( (parameter_length < 16) || (data == NULL) || (sgp->data_length < parameter_length) ) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+    }
+    cscd_length = (uint32_t)stoh(&data[2], 2);
+    segment_length = (uint32_t)stoh(&data[8], 4);
+    cscd_count = (cscd_length / EMU_CSCD_DESC_LENGTH);
+    segment_end = (16 + cscd_length + segment_length);
+    if ( stoh(&data[12], 4) || (segment_end > parameter_length) ||
+	 (cscd_length % EMU_CSCD_DESC_LENGTH) || (cscd_count > EMU_MAX_CSCD_DESCS) ) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_PARAM) );
+    }
+    /* Only identification descriptors for emulated devices are reachable. */
+    for (cscd = 0; (cscd < cscd_count); cscd++) {
+	dp = &data[16 + (cscd * EMU_CSCD_DESC_LENGTH)];
+	if (dp[0] != TARGET_CSCD_TYPE_CODE_IDENTIFICATION) {
+	    return( emu_illegal_request(sgp, ASC_INVALID_FIELD_PARAM) );
+	}
+	if ( (cscds[cscd] = emu_find_designator(&dp[8], dp[7])) == NULL) {
+	    return( emu_check_condition(sgp, SKV_COPY_ABORTED, ASC_COPY_TARGET, 0x02, 0) );
+	}
+    }
+    /* Validate all segments (pass 0), before copying any (pass 1). */
+    for (pass = 0; (pass < 2) && (status == SUCCESS); pass++) {
+	segments = 0;
+	for (offset = (16 + cscd_length); (offset < segment_end); offset += length) {
+	    dp = &data[offset];
+	    length = (uint32_t)(4 + stoh(&dp[2], 2));
+	    if ( (dp[0] != SEGMENT_DESC_TYPE_COPY_BLOCK_TO_BLOCK) || ((offset + length) > segment_end) ||
+		 (stoh(&dp[4], 2) >= cscd_count) || (stoh(&dp[6], 2) >= cscd_count) ||
+		 (++segments > EMU_MAX_SEGMENT_DESCS) ) {
+		return( emu_illegal_request(sgp, ASC_INVALID_FIELD_PARAM) );
+	    }
+	    sedp = cscds[stoh(&dp[4], 2)];
+	    dedp = cscds[stoh(&dp[6], 2)];
+	    blocks = stoh(&dp[10], 2);
+	    slba = stoh(&dp[12], 8);
+	    dlba = stoh(&dp[20], 8);
+	    if (sedp->ed_block_length != dedp->ed_block_length) {
+		return( emu_illegal_request(sgp, ASC_INVALID_FIELD_PARAM) );
+	    }
+	    if ( (slba + blocks > sedp->ed_capacity) || (dlba + blocks > dedp->ed_capacity) ) {
+		return( emu_illegal_request(sgp, ASC_LBA_OUT_OF_RANGE) );
+	    }
+	    if ( (pass == 0) || (blocks == 0) ) continue;
+	    emu_lock_devices(sedp, dedp);
+	    status = emu_copy_media(sedp, slba, dedp, dlba, blocks);
+	    emu_unlock_devices(sedp, dedp);
+	    if (status != SUCCESS) {
+		(void)emu_media_error(sdp, dedp, sgp);
+		return( emu_check_condition(sgp, SKV_COPY_ABORTED, ASC_COPY_TARGET, 0x01, 0) );
+	    }
+	}
+    }
+    return(status);
+}
+
+/*
+ * emu_populate_token() - Create a ROD token for the source ranges.
+ */
+static int
+emu_populate_token(emu_device_t *edp, scsi_generic_t *sgp)
+{
+    uint8_t *data = sgp->data_buffer;
+    uint32_t list_identifier = (uint32_t)stoh(&sgp->cdb[6], 4);
+    uint32_t parameter_length = (uint32_t)stoh(&sgp->cdb[10], 4);
+    uint32_t range_length, range_count;
+    uint64_t total_blocks;
+    emu_token_t *etp, **etpp;
+
+    if ( (parameter_length < 16) || (data == NULL) || (sgp->data_length < parameter_length) ) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+    }
+    range_length = (uint32_t)stoh(&data[14], 2);
+    range_count = (range_length / EMU_RANGE_DESC_LENGTH);
+    if ( (range_count == 0) || (range_count > EMU_MAX_RANGE_DESCS) ||
+	 ((16 + range_length) > parameter_length) ) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_PARAM) );
+    }
+    if (emu_check_ranges(edp, &data[16], range_count, &total_blocks) != SUCCESS) {
+	return( emu_illegal_request(sgp, ASC_LBA_OUT_OF_RANGE) );
+    }
+    if ( (total_blocks * edp->ed_block_length) > EMU_MAX_TOKEN_BYTES) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_PARAM) );
+    }
+    etp = malloc(sizeof(*etp) + (range_count * EMU_RANGE_DESC_LENGTH));
+    if (etp == NULL) {
+	return( emu_check_condition(sgp, SKV_HARDWARE_ERROR, ASC_RESOURCE_FAILURE, 0, 0) );
+    }
+    etp->et_device = edp;
+    etp->et_range_count = range_count;
+    etp->et_ranges = (uint8_t *)(etp + 1);
+    memcpy(etp->et_ranges, &data[16], (range_count * EMU_RANGE_DESC_LENGTH));
+
+    (void)pthread_mutex_lock(&emu_lock);
+    etp->et_id = ++emu_token_id;
+    etp->et_next = emu_tokens;
+    emu_tokens = etp;
+    /* Expire the oldest token, when at our limit. */
+    if (++emu_token_count > EMU_MAX_TOKENS) {
+	for (etpp = &emu_tokens; (*etpp)->et_next; etpp = &(*etpp)->et_next) ;
+	free(*etpp);
+	*etpp = NULL;
+	emu_token_count--;
+    }
+    (void)pthread_mutex_unlock(&emu_lock);
+    emu_record_result(edp, list_identifier, 0x10, COPY_STATUS_SUCCESS, total_blocks, etp->et_id);
+    return(SUCCESS);
+}
+
+/*
+ * emu_write_using_token() - Copy the token data to the destination ranges.
+ */
+static int
+emu_write_using_token(scsi_device_t *sdp, emu_device_t *edp, scsi_generic_t *sgp)
+{
+    uint8_t *data = sgp->data_buffer;
+    uint32_t list_identifier = (uint32_t)stoh(&sgp->cdb[6], 4);
+    uint32_t parameter_length = (uint32_t)stoh(&sgp->cdb[10], 4);
+    uint32_t header_length = (16 + ROD_TOKEN_SIZE + 8);
+    uint32_t range_length, range_count, range;
+    uint32_t src_count = 0, src_index = 0;
+    uint64_t total_blocks, transfer_count = 0, rod_offset;
+    uint64_t lba, blocks, src_lba = 0, src_blocks = 0, count;
+    uint8_t *token, *ranges, *src_ranges = NULL;
+    emu_device_t *sedp = NULL;
+    emu_token_t *etp, **etpp;
+    hbool_t zero_rod;
+    int status = SUCCESS;
+
+    if ( (parameter_length < header_length) || (data == NULL) || (sgp->data_length < parameter_length) ) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+    }
+    rod_offset = stoh(&data[8], 8);
+    token = &data[16];
+    range_length = (uint32_t)stoh(&data[header_length - 2], 2);
+    range_count = (range_length / EMU_RANGE_DESC_LENGTH);
+    ranges = &data[header_length];
+    if ( (range_count == 0) || (range_count > EMU_MAX_RANGE_DESCS) ||
+	 ((header_length + range_length) > parameter_length) ) {
+	return( emu_illegal_request(sgp, ASC_INVALID_FIELD_PARAM) );
+    }
+    if (emu_check_ranges(edp, ranges, range_count, &total_blocks) != SUCCESS) {
+	return( emu_illegal_request(sgp, ASC_LBA_OUT_OF_RANGE) );
+    }
+    zero_rod = (stoh(&token[0], 4) == ZERO_ROD_TOKEN_TYPE) ? True : False;
+    if (zero_rod == False) {
+	/* Copy the source ranges, since the token may be deleted or expire. */
+	(void)pthread_mutex_lock(&emu_lock);
+	for (etpp = &emu_tokens; (etp = *etpp); etpp = &etp->et_next) {
+	    if (etp->et_id == stoh(&token[8], 8)) break;
+	}
+	if ( etp && (stoh(&token[0], 4) == EMU_ROD_TYPE_PIT) &&
+	     (src_ranges = malloc(etp->et_range_count * EMU_RANGE_DESC_LENGTH)) ) {
+	    sedp = etp->et_device;
+	    src_count = etp->et_range_count;
+	    memcpy(src_ranges, etp->et_ranges, (src_count * EMU_RANGE_DESC_LENGTH));
+	    if (data[2] & 0x02) {	/* Delete token. */
+		*etpp = etp->et_next;
+		free(etp);
+		emu_token_count--;
+	    }
+	}
+	(void)pthread_mutex_unlock(&emu_lock);
+	if ( (sedp == NULL) || (sedp->ed_block_length != edp->ed_block_length) ) {
+	    free(src_ranges);
+	    emu_record_result(edp, list_identifier, 0x11, COPY_STATUS_FAIL, 0, 0);
+	    return( emu_check_condition(sgp, SKV_ILLEGAL_REQUEST, ASC_INVALID_TOKEN, 0x06, 0) );
+	}
+	/* Position to the offset into the ROD. */
+	for (src_index = 0; (src_index < src_count); src_index++) {
+	    src_blocks = stoh(&src_ranges[(src_index * EMU_RANGE_DESC_LENGTH) + 8], 4);
+	    if (rod_offset < src_blocks) break;
+	    rod_offset -= src_blocks;
+	}
+	if (src_index < src_count) {
+	    src_lba = (stoh(&src_ranges[src_index * EMU_RANGE_DESC_LENGTH], 8) + rod_offset);
+	    src_blocks -= rod_offset;
+	} else {
+	    src_blocks = 0;
+	}
+    }
+
+    for (range = 0; (range < range_count); range++) {
+	lba = stoh(&ranges[range * EMU_RANGE_DESC_LENGTH], 8);
+	blocks = stoh(&ranges[(range * EMU_RANGE_DESC_LENGTH) + 8], 4);
+	if (zero_rod == True) {		/* Zeroes are deallocated (LBPRZ). */
+	    (void)pthread_mutex_lock(&edp->ed_lock);
+	    status = emu_unmap_media(edp, lba, blocks);
+	    (void)pthread_mutex_unlock(&edp->ed_lock);
+	    if (status != SUCCESS) break;
+	    transfer_count += blocks;
+	    continue;
+	}
+	while (blocks) {
+	    if (src_blocks == 0) {	/* Advance to the next source range. */
+		if (++src_index >= src_count) break;
+		src_lba = stoh(&src_ranges[src_index * EMU_RANGE_DESC_LENGTH], 8);
+		src_blocks = stoh(&src_ranges[(src_index * EMU_RANGE_DESC_LENGTH) + 8], 4);
+		continue;
+	    }
+	    count = min(blocks, src_blocks);
+	    emu_lock_devices(sedp, edp);
+	    status = emu_copy_media(sedp, src_lba, edp, lba, count);
+	    emu_unlock_devices(sedp, edp);
+	    if (status != SUCCESS) break;
+	    src_lba += count;
+	    src_blocks -= count;
+	    lba += count;
+	    blocks -= count;
+	    transfer_count += count;
+	}
+	if (blocks) break;		/* Source exhausted or failure. */
+    }
+    free(src_ranges);
+    if (status != SUCCESS) {
+	emu_record_result(edp, list_identifier, 0x11, COPY_STATUS_FAIL, transfer_count, 0);
+	(void)emu_media_error(sdp, edp, sgp);
+	return( emu_check_condition(sgp, SKV_COPY_ABORTED, ASC_COPY_TARGET, 0x01, 0) );
+    }
+    emu_record_result(edp, list_identifier, 0x11,
+		      (transfer_count < total_blocks) ? COPY_STATUS_SUCCESS_RESID : COPY_STATUS_SUCCESS,
+		      transfer_count, 0);
+    return(SUCCESS);
+}
+
+/*
+ * emu_receive_copy_results() - Copy operating parameters, or ROD token information.
+ */
+static int
+emu_receive_copy_results(emu_device_t *edp, scsi_generic_t *sgp)
+{
+    uint8_t data[32 + 6 + ROD_TOKEN_SIZE];
+    uint32_t list_identifier = (uint32_t)stoh(&sgp->cdb[2], 4);
+    uint32_t allocation_length = (uint32_t)stoh(&sgp->cdb[10], 4);
+    emu_copy_result_t result, *erp = NULL;
+    uint32_t index, length;
+
+    memset(data, '\0', sizeof(data));
+    switch (sgp->cdb[1] & 0x1F) {
+	case RECEIVE_COPY_RESULTS_SVACT_OPERATING_PARAMETERS:
+	    data[4] = 0x01;		/* Supports no list identifier. */
+	    htos(&data[8], EMU_MAX_CSCD_DESCS, 2);
+	    htos(&data[10], EMU_MAX_SEGMENT_DESCS, 2);
+	    htos(&data[12], ((EMU_MAX_CSCD_DESCS * EMU_CSCD_DESC_LENGTH) +
+			     (EMU_MAX_SEGMENT_DESCS * sizeof(xcopy_b2b_seg_desc_t))), 4);
+	    htos(&data[16], min(((uint64_t)0xFFFF * edp->ed_block_length), (uint64_t)EMU_MAX_TOKEN_BYTES), 4);
+	    data[43] = 2;		/* Implemented descriptor types. */
+	    data[44] = SEGMENT_DESC_TYPE_COPY_BLOCK_TO_BLOCK;
+	    data[45] = TARGET_CSCD_TYPE_CODE_IDENTIFICATION;
+	    length = 46;
+	    break;
+
+	case RECEIVE_ROD_TOKEN_INFORMATION:
+	    (void)pthread_mutex_lock(&emu_lock);
+	    for (index = 0; (index < min(emu_result_index, EMU_COPY_RESULTS)); index++) {
+		erp = &emu_results[(emu_result_index - index - 1) % EMU_COPY_RESULTS];
+		if ( (erp->er_device == edp) && (erp->er_list_identifier == list_identifier) ) break;
+		erp = NULL;
+	    }
+	    if (erp) result = *erp;
+	    (void)pthread_mutex_unlock(&emu_lock);
+	    if (erp == NULL) {
+		return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+	    }
+	    data[4] = result.er_service_action;
+	    data[5] = result.er_copy_status;
+	    data[15] = EMU_TRANSFER_BLOCKS;
+	    htos(&data[16], result.er_transfer_count, 8);
+	    length = (32 + 6);
+	    if ( (result.er_service_action == 0x10) && (result.er_copy_status == COPY_STATUS_SUCCESS) ) {
+		htos(&data[32], (ROD_TOKEN_SIZE + 2), 4);
+		emu_build_token(edp, result.er_token_id, &data[38]);
+		length += ROD_TOKEN_SIZE;
+	    }
+	    break;
+
+	default:
+	    return( emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB) );
+    }
+    htos(&data[0], (length - 4), 4);
+    return( emu_transfer_data(sgp, data, length, allocation_length) );
+}
+
+/*
+ * emu_execute_cdb() - Execute a CDB on an emulated device.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	edp = The emulated device.
+ *	sgp = The SCSI generic information.
+ *
+ * Return Value:
+ *	SUCCESS, or FAILURE if the "system call" failed.
+ *	SCSI errors are reported via the SCSI status and sense data.
+ */
+int
+emu_execute_cdb(scsi_device_t *sdp, emu_device_t *edp, scsi_generic_t *sgp)
+{
+    uint8_t *cdb = sgp->cdb;
+    int status = SUCCESS;
+
+    sgp->error = False;
+    sgp->scsi_status = SCSI_GOOD;
+    sgp->data_resid = sgp->data_length;
+    sgp->data_transferred = 0;
+
+    switch (cdb[0]) {
+	case 0x00:			/* Test Unit Ready */
+	    sgp->data_resid = 0;
+	    break;
+	case 0x12:			/* Inquiry */
+	    status = emu_inquiry(edp, sgp);
+	    break;
+	case 0x25:			/* Read Capacity(10) */
+	    status = emu_read_capacity(edp, sgp, False);
+	    break;
+	case 0x9E:			/* Service Action In(16) */
+	    if ((cdb[1] & 0x1F) == 0x10) {
+		status = emu_read_capacity(edp, sgp, True);
+	    } else if ((cdb[1] & 0x1F) == 0x12) {
+		status = emu_get_lba_status(edp, sgp);
+	    } else {
+		status = emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB);
+	    }
+	    break;
+	case 0x42:			/* Unmap */
+	    status = emu_unmap(sdp, edp, sgp);
+	    if ( (status == SUCCESS) && (sgp->error == False) ) {
+		sgp->data_resid = 0;
+	    }
+	    break;
+	case 0x08: case 0x28: case 0x88:	/* Read(6/10/16) */
+	case 0x0A: case 0x2A: case 0x8A:	/* Write(6/10/16) */
+	case 0x2F: case 0x8F:			/* Verify(10/16) */
+	case 0x41: case 0x93:			/* Write Same(10/16) */
+	case 0x89:				/* Compare and Write */
+	    status = emu_media_access(sdp, edp, sgp);
+	    break;
+	case 0x83:			/* Third Party Copy Out */
+	    if (edp->ed_latency) {
+		os_usleep(edp->ed_latency);
+	    }
+	    switch (cdb[1] & 0x1F) {
+		case 0x00:		/* Extended Copy (LID1) */
+		    status = emu_extended_copy(sdp, edp, sgp);
+		    break;
+		case 0x10:		/* Populate Token */
+		    status = emu_populate_token(edp, sgp);
+		    break;
+		case 0x11:		/* Write Using Token */
+		    status = emu_write_using_token(sdp, edp, sgp);
+		    break;
+		default:
+		    status = emu_illegal_request(sgp, ASC_INVALID_FIELD_CDB);
+		    break;
+	    }
+	    if ( (status == SUCCESS) && (sgp->error == False) ) {
+		sgp->data_resid = 0;
+	    }
+	    break;
+	case 0x84:			/* Third Party Copy In */
+	    status = emu_receive_copy_results(edp, sgp);
+	    break;
+	default:
+	    status = emu_illegal_request(sgp, ASC_INVALID_OPCODE);
+	    break;
+    }
+    return(status);
+}
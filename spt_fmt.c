@@ -32,6 +32,11 @@
  *
  * Modification History:
  *
+ * October 18th, 2026 by Robin T. Miller
+ *      Compile emit status formats once into a program of opcodes, rather
+ * than parsing the format for every command, and add a fast path for the
+ * default JSON format. Also fix "%bytes", which consumed only "%byt".
+ * 
  * May 15th, 2020 by Robin T. MIller
  *      Add format strings for individual date and time fields for more
  * flexible formatting and add support for date/time field separators.
@@ -79,6 +84,15 @@ uint64_t get_total_operations(scsi_device_t *sdp, time_t *secs);
 
 int verify_unpack_range(scsi_device_t *sdp, int offset, int size, int limit);
 
+static emit_program_t *compile_emit_program(scsi_device_t *sdp, char *format);
+static void free_emit_program(scsi_device_t *sdp, emit_program_t *epp);
+static emit_program_t *get_emit_program(scsi_device_t *sdp, char *format);
+static int execute_emit_program(scsi_device_t *sdp, emit_program_t *epp,
+				io_params_t *iop, scsi_generic_t *sgp, char *buffer);
+static int FmtEmitStatusJson(scsi_device_t *sdp, char *buffer);
+
+extern char *emit_status_default_json;
+
 /*
  * FmtEmitStatus() - Format the Exit Status String.
  *
@@ -155,16 +169,16 @@ int verify_unpack_range(scsi_device_t *sdp, int offset, int size, int limit);
  *
  * Outputs:
  *	Returns the formatted buffer length.
+ *
+ * Note: The format is compiled once (see compile_emit_program()), and the
+ * default JSON format, used with enable=emit_all, has its own fast path.
  */
 int
 FmtEmitStatus(scsi_device_t *sdp, io_params_t *uiop, scsi_generic_t *usgp, char *format, char *buffer)
 {
-    char    *from = format;
-    char    *to = buffer;
-    ssize_t length = strlen(format);
     io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
     scsi_generic_t *sgp = &iop->sg;
-    scsi_sense_t *ssp = sgp->sense_data;
+    emit_program_t *epp;
 
     /* Allow caller to select the initial iop and sgp. */
     if (uiop) {
@@ -174,543 +188,657 @@ FmtEmitStatus(scsi_device_t *sdp, io_params_t *uiop, scsi_generic_t *usgp, char
     if (usgp) {
 	sgp = usgp;
     }
-    while (length-- > 0) {
-	int slen = 0;
-	/*
-	 * Parse format control keywords:
-	 */
+    epp = get_emit_program(sdp, format);
+    if (epp == NULL) {
+	*buffer = '\0';
+	return(0);
+    }
+    if (epp->ep_json_default == True) {
+	return( FmtEmitStatusJson(sdp, buffer) );
+    }
+    return( execute_emit_program(sdp, epp, iop, sgp, buffer) );
+}
+
+/*
+ * Emit status keywords, in the order checked (longer keywords first).
+ */
+typedef struct emit_keyword {
+    char		*ek_keyword;	/* The keyword (without '%').	*/
+    size_t		ek_length;	/* The keyword length.		*/
+    emit_opcode_t	ek_opcode;	/* The keyword opcode.		*/
+} emit_keyword_t;
+
+#define EMIT_KEYWORD(keyword, opcode)	{ keyword, (sizeof(keyword) - 1), opcode }
+
+static emit_keyword_t emit_keywords[] = {
+    EMIT_KEYWORD("progname",		EOP_PROGNAME),
+    EMIT_KEYWORD("thread",		EOP_THREAD),
+    EMIT_KEYWORD("adsf",		EOP_ADSF),
+    EMIT_KEYWORD("dsf1",		EOP_DSF1),
+    EMIT_KEYWORD("dsf",			EOP_DSF),
+    EMIT_KEYWORD("dst",			EOP_DSF),
+    EMIT_KEYWORD("srcs",		EOP_SRCS),
+    EMIT_KEYWORD("src1",		EOP_SRC1),
+    EMIT_KEYWORD("src2",		EOP_SRC2),
+    EMIT_KEYWORD("src",			EOP_SRC),
+    EMIT_KEYWORD("cdb",			EOP_CDB),
+    EMIT_KEYWORD("dir",			EOP_DIR),
+    EMIT_KEYWORD("length",		EOP_LENGTH),
+    EMIT_KEYWORD("status_msg",		EOP_STATUS_MSG),
+    EMIT_KEYWORD("status",		EOP_STATUS),
+    EMIT_KEYWORD("scsi_name",		EOP_SCSI_NAME),
+    EMIT_KEYWORD("scsi_msg",		EOP_SCSI_MSG),
+    EMIT_KEYWORD("scsi_status",		EOP_SCSI_STATUS),
+    EMIT_KEYWORD("host_status",		EOP_HOST_STATUS),
+    EMIT_KEYWORD("host_msg",		EOP_HOST_MSG),
+    EMIT_KEYWORD("driver_status",	EOP_DRIVER_STATUS),
+    EMIT_KEYWORD("driver_msg",		EOP_DRIVER_MSG),
+    EMIT_KEYWORD("sense_code",		EOP_SENSE_CODE),
+    EMIT_KEYWORD("sense_msg",		EOP_SENSE_MSG),
+    EMIT_KEYWORD("resid",		EOP_RESID),
+    EMIT_KEYWORD("timeout",		EOP_TIMEOUT),
+    EMIT_KEYWORD("blocks",		EOP_BLOCKS),
+    EMIT_KEYWORD("starting",		EOP_STARTING),
+    EMIT_KEYWORD("ending",		EOP_ENDING),
+    EMIT_KEYWORD("capacity",		EOP_CAPACITY),
+    EMIT_KEYWORD("device_size",		EOP_DEVICE_SIZE),
+    EMIT_KEYWORD("deallocated",		EOP_DEALLOCATED),
+    EMIT_KEYWORD("mapped",		EOP_MAPPED),
+    EMIT_KEYWORD("iterations",		EOP_ITERATIONS),
+    EMIT_KEYWORD("operations",		EOP_OPERATIONS),
+    EMIT_KEYWORD("xfer",		EOP_XFER),
+    EMIT_KEYWORD("bytes",		EOP_XFER),
+    EMIT_KEYWORD("total_blocks",	EOP_TOTAL_BLOCKS),
+    EMIT_KEYWORD("total_operations",	EOP_TOTAL_OPERATIONS),
+    EMIT_KEYWORD("total_xfer",		EOP_TOTAL_BYTES),
+    EMIT_KEYWORD("total_bytes",		EOP_TOTAL_BYTES),
+    EMIT_KEYWORD("sense_data",		EOP_SENSE_DATA),
+    EMIT_KEYWORD("cspec_data",		EOP_CSPEC_DATA),
+    EMIT_KEYWORD("info_valid",		EOP_INFO_VALID),
+    EMIT_KEYWORD("info_data",		EOP_INFO_DATA),
+    EMIT_KEYWORD("sense_key",		EOP_SENSE_KEY),
+    EMIT_KEYWORD("skey_msg",		EOP_SKEY_MSG),
+    EMIT_KEYWORD("ili",			EOP_ILI),
+    EMIT_KEYWORD("eom",			EOP_EOM),
+    EMIT_KEYWORD("fm",			EOP_FM),
+    EMIT_KEYWORD("ascq_msg",		EOP_ASCQ_MSG),
+    EMIT_KEYWORD("ascq",		EOP_ASCQ),
+    EMIT_KEYWORD("asc",			EOP_ASC),
+    EMIT_KEYWORD("asq",			EOP_ASQ),
+    EMIT_KEYWORD("fru",			EOP_FRU),
+    /* Time Keywords: */
+    EMIT_KEYWORD("date",		EOP_DATE),
+    EMIT_KEYWORD("seconds",		EOP_SECONDS),
+    EMIT_KEYWORD("start_time",		EOP_START_TIME),
+    EMIT_KEYWORD("end_time",		EOP_END_TIME),
+    EMIT_KEYWORD("elapsed_time",	EOP_ELAPSED_TIME),
+    /* Performance Keywords: */
+    EMIT_KEYWORD("bps",			EOP_BPS),
+    EMIT_KEYWORD("lbps",		EOP_LBPS),
+    EMIT_KEYWORD("kbps",		EOP_KBPS),
+    EMIT_KEYWORD("mbps",		EOP_MBPS),
+    EMIT_KEYWORD("iops",		EOP_IOPS),
+    EMIT_KEYWORD("spio",		EOP_SPIO),
+    { NULL,	0,	EOP_TEXT }
+};
+
+static void
+add_emit_text(emit_program_t *epp, char *text, size_t length)
+{
+    emit_instr_t *eip;
+
+    if (length) {
+	eip = &epp->ep_instrs[epp->ep_count++];
+	eip->ei_opcode = EOP_TEXT;
+	eip->ei_text = text;
+	eip->ei_length = length;
+    }
+    return;
+}
+
+/*
+ * compile_emit_program() - Compile an Emit Status Format.
+ *
+ * Description:
+ *	The format is parsed once, as FmtEmitStatus() used to do for every
+ * call. Keywords become opcodes, and the text between them (with the \n
+ * and \t escapes expanded) is copied to the program text buffer.
+ *
+ * Inputs:
+ *	sdp = The SCSI device pointer.
+ *	format = The emit status format string.
+ *
+ * Return Value:
+ *	Returns the compiled program or NULL if no memory.
+ */
+static emit_program_t *
+compile_emit_program(scsi_device_t *sdp, char *format)
+{
+    emit_program_t *epp;
+    emit_keyword_t *ekp;
+    char *from = format, *text, *literal;
+    int keywords = 0;
+
+    while ( (from = strchr(from, '%')) ) {
+	keywords++; from++;
+    }
+    epp = Malloc(sdp, sizeof(*epp));
+    if (epp == NULL) return(NULL);
+    epp->ep_format = strdup(format);
+    /* Each keyword may be preceded by text, plus any trailing text. */
+    epp->ep_instrs = Malloc(sdp, (sizeof(emit_instr_t) * ((keywords * 2) + 1)) );
+    epp->ep_text = Malloc(sdp, (strlen(format) + 1));
+    if ( (epp->ep_format == NULL) || (epp->ep_instrs == NULL) || (epp->ep_text == NULL) ) {
+	free_emit_program(sdp, epp);
+	return(NULL);
+    }
+    epp->ep_json_default = (strcmp(format, emit_status_default_json) == 0);
+    from = format;
+    text = literal = epp->ep_text;
+    while (*from) {
 	if (*from == '%') {
-	    char *key = (from + 1);
 	    /*
 	     * The approach taken is to allow upper or lower case.
 	     */
-	    if (strncasecmp(key, "progname", 8) == 0) {
-		slen = Sprintf(to, "%s", OurName);
-		to += slen;
-		from += 9;
-		length -= 8;
-		continue;
-	    } else if (strncasecmp(key, "thread", 6) == 0) {
-		slen = Sprintf(to, "%d", sdp->thread_number);
-		to += slen;
-		from += 7;
-		length -= 6;
-		continue;
-	    } else if (strncasecmp(key, "adsf", 4) == 0) {
+	    for (ekp = emit_keywords; ekp->ek_keyword; ekp++) {
+		if (strncasecmp((from + 1), ekp->ek_keyword, ekp->ek_length) == 0) {
+		    break;
+		}
+	    }
+	    if (ekp->ek_keyword) {
+		add_emit_text(epp, literal, (text - literal));
+		epp->ep_instrs[epp->ep_count++].ei_opcode = ekp->ek_opcode;
+		literal = text;
+		from += (ekp->ek_length + 1);
+	    } else {
+		*text++ = *from++;	/* Not a keyword, so copy the '%'. */
+	    }
+	} else if (*from == '\\') {
+	    if (*(from + 1) == 'n') {
+		*text++ = '\n';
+	    } else if (*(from + 1) == 't') {
+		*text++ = '\t';
+	    } else {
+		/*
+		 * Other escapes are copied as is. A trailing '\' is kept, just
+		 * as FmtEmitStatus() did (it copied the '\' and the NULL).
+		 */
+		*text++ = *from;
+		if (*(from + 1) == '\0') break;
+		*text++ = *(from + 1);
+	    }
+	    from += 2;
+	} else {
+	    *text++ = *from++;
+	}
+    }
+    add_emit_text(epp, literal, (text - literal));
+    return(epp);
+}
+
+static void
+free_emit_program(scsi_device_t *sdp, emit_program_t *epp)
+{
+    if (epp->ep_format) free(epp->ep_format);
+    if (epp->ep_instrs) Free(sdp, epp->ep_instrs);
+    if (epp->ep_text) Free(sdp, epp->ep_text);
+    Free(sdp, epp);
+    return;
+}
+
+/*
+ * get_emit_program() - Get the Compiled Program for a Format.
+ *
+ * Note: The format is compared, rather than its address, since formats are
+ * often freed and reallocated (e.g. emit=), so the address may be reused.
+ */
+static emit_program_t *
+get_emit_program(scsi_device_t *sdp, char *format)
+{
+    emit_program_t *epp;
+    int index;
+
+    for (index = 0; (index < EMIT_PROGRAMS); index++) {
+	epp = sdp->emit_programs[index];
+	if (epp && (strcmp(epp->ep_format, format) == 0) ) {
+	    return(epp);
+	}
+    }
+    epp = compile_emit_program(sdp, format);
+    if (epp == NULL) return(NULL);
+    index = sdp->emit_program_next;
+    if (sdp->emit_programs[index]) {
+	free_emit_program(sdp, sdp->emit_programs[index]);
+    }
+    sdp->emit_programs[index] = epp;
+    sdp->emit_program_next = ((index + 1) % EMIT_PROGRAMS);
+    return(epp);
+}
+
+void
+release_emit_programs(scsi_device_t *sdp)
+{
+    int index;
+
+    for (index = 0; (index < EMIT_PROGRAMS); index++) {
+	if (sdp->emit_programs[index]) {
+	    free_emit_program(sdp, sdp->emit_programs[index]);
+	    sdp->emit_programs[index] = NULL;
+	}
+    }
+    sdp->emit_program_next = 0;
+    return;
+}
+
+/*
+ * Formatting functions shared by the emit program and JSON fast path.
+ */
+static int
+emit_cdb(char *to, scsi_generic_t *sgp)
+{
+    char *bp = to;
+    int i;
+
+    for (i = 0; (i < sgp->cdb_size); i++) {
+	bp += Sprintf(bp, "%02x ",  sgp->cdb[i]);
+    }
+    if (i) {
+	bp--; *bp = '\0';
+    }
+    return( (int)(bp - to) );
+}
+
+static char *
+emit_dir(scsi_generic_t *sgp)
+{
+    if (sgp->data_dir == scsi_data_none) {
+	return("none");
+    } else if (sgp->data_dir == scsi_data_read) {
+	return("read");
+    } else if (sgp->data_dir == scsi_data_write) {
+	return("write");
+    } else {
+	return("");
+    }
+}
+
+static char *
+emit_status_msg(scsi_device_t *sdp)
+{
+    if (sdp->status == SUCCESS) {
+	return("SUCCESS");
+    } else if (sdp->status == FAILURE) {
+	return("FAILURE");
+    } else {
+	return("<unknown>");
+    }
+}
+
+static int
+emit_sense_data(char *to, scsi_generic_t *sgp, scsi_sense_t *ssp)
+{
+    unsigned char *bp = sgp->sense_data;
+    int sense_len = (ssp) ? (8 + ssp->addl_sense_len) : 8;
+    char *tp = to;
+
+    if (bp) {
+	while (sense_len--) {
+	    tp += Sprintf(tp, "%02x ", *bp++);
+	}
+	--tp; *tp = '\0'; /* remove last space */
+    }
+    return( (int)(tp - to) );
+}
+
+static int
+emit_elapsed_time(char *to, scsi_device_t *sdp)
+{
+    clock_t et;
+
+    if (sdp->end_ticks) {
+	et = (sdp->end_ticks - sdp->start_ticks);
+    } else {
+	et = get_elapsed_ticks(sdp);
+    }
+    if (!sdp->start_ticks) et = 0;
+    return( FormatElapstedTime(to, et) );
+}
+
+static int
+emit_time(char *to, time_t *timep)
+{
+    char time_buffer[32];
+
+    memset(time_buffer, '\0', sizeof(time_buffer));
+    os_ctime(timep, time_buffer, sizeof(time_buffer));
+    return( Sprintf(to, "%s", time_buffer) );
+}
+
+/*
+ * execute_emit_program() - Execute an Emit Status Program.
+ *
+ * Inputs:
+ *	sdp = The SCSI device pointer.
+ *	epp = The compiled emit program.
+ *	iop = The initial I/O parameters.
+ *	sgp = The initial SCSI generic pointer.
+ *	buffer = Buffer for formatted message.
+ *
+ * Outputs:
+ *	Returns the formatted buffer length.
+ */
+static int
+execute_emit_program(scsi_device_t *sdp, emit_program_t *epp,
+		     io_params_t *iop, scsi_generic_t *sgp, char *buffer)
+{
+    emit_instr_t *eip, *eip_end = &epp->ep_instrs[epp->ep_count];
+    scsi_sense_t *ssp = sgp->sense_data;
+    char *to = buffer;
+
+    for (eip = epp->ep_instrs; (eip < eip_end); eip++) {
+
+	switch (eip->ei_opcode) {
+
+	    case EOP_TEXT:
+		memcpy(to, eip->ei_text, eip->ei_length);
+		to += eip->ei_length;
+		break;
+
+	    case EOP_PROGNAME:
+		to += Sprintf(to, "%s", OurName);
+		break;
+
+	    case EOP_THREAD:
+		to += Sprintf(to, "%d", sdp->thread_number);
+		break;
+
+	    case EOP_ADSF:
 		if (sgp->adsf) {
-		    slen = Sprintf(to, "%s", sgp->adsf);
-		    to += slen;
+		    to += Sprintf(to, "%s", sgp->adsf);
 		}
-		from += 5;
-		length -= 4;
-		continue;
-	    } else if (strncasecmp(key, "dsf1", 4) == 0) {
-		/* Switch to dsf1. (mirror device) */
-		iop = &sdp->io_params[IO_INDEX_DSF1];
-		sgp = &iop->sg;
-		ssp = sgp->sense_data;
-		if (sgp->dsf) {
-		    slen = Sprintf(to, "%s", sgp->dsf);
-		    to += slen;
+		break;
+
+	    case EOP_DSF1:	/* Switch to dsf1. (mirror device) */
+	    case EOP_DSF:	/* Switch to dsf (default device). */
+	    case EOP_SRC1:	/* Switch to source device 1. */
+	    case EOP_SRC2:	/* Switch to source device 2. */
+	    case EOP_SRC: {	/* Switch to source device 0. */
+		int device_index;
+		if (eip->ei_opcode == EOP_DSF1) {
+		    device_index = IO_INDEX_DSF1;
+		} else if (eip->ei_opcode == EOP_DSF) {
+		    device_index = IO_INDEX_BASE;
+		} else if (eip->ei_opcode == EOP_SRC1) {
+		    device_index = (IO_INDEX_SRC + 1);
+		} else if (eip->ei_opcode == EOP_SRC2) {
+		    device_index = (IO_INDEX_SRC + 2);
+		} else {
+		    device_index = IO_INDEX_SRC;
 		}
-		from += 5;
-		length -= 4;
-		continue;
-	    } else if ( (strncasecmp(key, "dsf", 3) == 0) ||
-			(strncasecmp(key, "dst", 3) == 0) ) {
-		/* Switch to dsf (default device). */
-		iop = &sdp->io_params[IO_INDEX_BASE];
+		iop = &sdp->io_params[device_index];
 		sgp = &iop->sg;
 		ssp = sgp->sense_data;
 		if (sgp->dsf) {
-		    slen = Sprintf(to, "%s", sgp->dsf);
-		    to += slen;
+		    to += Sprintf(to, "%s", sgp->dsf);
 		}
-		from += 4;
-		length -= 3;
-		continue;
-	    } else if (strncasecmp(key, "srcs", 4) == 0) {
+		break;
+	    }
+	    case EOP_SRCS: {
 		int device_index = IO_INDEX_SRC;
 		
 		for (; (device_index < sdp->io_devices); device_index++) {
 		    io_params_t *siop = &sdp->io_params[device_index];
 		    scsi_generic_t *ssgp = &siop->sg;
-		    slen = Sprintf(to, "%s%s", ssgp->dsf,
-				   ((device_index + 1) < sdp->io_devices) ? " " : "");
-		    to += slen;
-		}
-		from += 5;
-		length -= 4;
-		continue;
-	    } else if (strncasecmp(key, "src1", 4) == 0) {
-		/* Switch to source device 1. */
-		iop = &sdp->io_params[IO_INDEX_SRC + 1];
-		sgp = &iop->sg;
-		ssp = sgp->sense_data;
-		if (sgp->dsf) {
-		    slen = Sprintf(to, "%s", sgp->dsf);
-		    to += slen;
+		    to += Sprintf(to, "%s%s", ssgp->dsf,
+				  ((device_index + 1) < sdp->io_devices) ? " " : "");
 		}
-		from += 5;
-		length -= 4;
-		continue;
-	    } else if (strncasecmp(key, "src2", 4) == 0) {
-		/* Switch to source device 2. */
-		iop = &sdp->io_params[IO_INDEX_SRC + 2];
-		sgp = &iop->sg;
-		ssp = sgp->sense_data;
-		if (sgp->dsf) {
-		    slen = Sprintf(to, "%s", sgp->dsf);
-		    to += slen;
-		}
-		from += 5;
-		length -= 4;
-		continue;
-	    } else if (strncasecmp(key, "src", 3) == 0) {
-		/* Switch to source device 0. */
-		iop = &sdp->io_params[IO_INDEX_SRC];
-		sgp = &iop->sg;
-		ssp = sgp->sense_data;
-		if (sgp->dsf) {
-		    slen = Sprintf(to, "%s", sgp->dsf);
-		    to += slen;
-		}
-		from += 4;
-		length -= 3;
-		continue;
-	    } else if (strncasecmp(key,  "cdb",  3) == 0) {
-		int i;
-		for (i = 0; (i < sgp->cdb_size); i++) {
-		    slen = Sprintf(to, "%02x ",  sgp->cdb[i]);
-		    to += slen;
-		}
-		if (i) {
-		    slen--; to--; *to = '\0';
-		}
-		from += 4;
-		length -= 3;
-		continue;
-	    } else if (strncasecmp(key,  "dir",  3) == 0) {
-		if (sgp->data_dir == scsi_data_none) {
-		    slen = Sprintf(to, "%s", "none");
-		} else if (sgp->data_dir == scsi_data_read) {
-		    slen = Sprintf(to, "%s", "read");
-		} else if (sgp->data_dir == scsi_data_write) {
-		    slen = Sprintf(to, "%s", "write");
-		} else {
-		    slen = 0;
-		}
-		to += slen;
-		from += 4;
-		length -= 3;
-		continue;
-	    } else if (strncasecmp(key,  "length",  6) == 0) {
+		break;
+	    }
+	    case EOP_CDB:
+		to += emit_cdb(to, sgp);
+		break;
+
+	    case EOP_DIR:
+		to += Sprintf(to, "%s", emit_dir(sgp));
+		break;
+
+	    case EOP_LENGTH:
 		to += Sprintf(to, "%u",  sgp->data_length);
-		from += 7;
-		length -= 6;
-		continue;
-	    } else if (strncasecmp(key, "status_msg", 10) == 0) {
-		char *status_msg;
-		if (sdp->status == SUCCESS) {
-		    status_msg = "SUCCESS";
-		} else if (sdp->status == FAILURE) {
-		    status_msg = "FAILURE";
-		} else {
-		    status_msg = "<unknown>";
-		}
-		slen = Sprintf(to, "%s", status_msg);
-		to += slen;
-		from += 11;
-		length -= 10;
-		continue;
-	    } else if (strncasecmp(key, "status", 6) == 0) {
-		slen = Sprintf(to, "%d", sdp->status);
-		to += slen;
-		from += 7;
-		length -= 6;
-		continue;
-	    } else if (strncasecmp(key, "scsi_name", 9) == 0) {
-		if (sdp->scsi_name) {
-		    slen = Sprintf(to, "%s", sdp->scsi_name);
-		} else {
-		    slen = Sprintf(to, "%s", "<unknown>");
-		}
-		to += slen;
-		from += 10;
-		length -= 9;
-		continue;
-	    } else if (strncasecmp(key, "scsi_msg", 8) == 0) {
-		char *scsi_msg = ScsiStatus(sgp->scsi_status);
-		slen = Sprintf(to, "%s", scsi_msg);
-		to += slen;
-		from += 9;
-		length -= 8;
-		continue;
-	    } else if (strncasecmp(key, "scsi_status", 11) == 0) {
-		slen = Sprintf(to, "%x", sgp->scsi_status);
-		to += slen;
-		from += 12;
-		length -= 11;
-		continue;
-	    } else if (strncasecmp(key, "host_status", 11) == 0) {
-		slen = Sprintf(to, "%x", sgp->host_status);
-		to += slen;
-		from += 12;
-		length -= 11;
-		continue;
-	    } else if (strncasecmp(key, "host_msg", 8) == 0) {
-		char *host_msg = os_host_status_msg(sgp);
-		slen = Sprintf(to, "%s", host_msg);
-		to += slen;
-		from += 9;
-		length -= 8;
-		continue;
-	    } else if (strncasecmp(key, "driver_status", 13) == 0) {
-		slen = Sprintf(to, "%x", sgp->driver_status);
-		to += slen;
-		from += 14;
-		length -= 13;
-		continue;
-	    } else if (strncasecmp(key, "driver_msg", 10) == 0) {
-		char *driver_msg = os_driver_status_msg(sgp);
-		slen = Sprintf(to, "%s", driver_msg);
-		to += slen;
-		from += 11;
-		length -= 10;
-		continue;
-	    } else if (strncasecmp(key, "sense_code", 10) == 0) {
+		break;
+
+	    case EOP_STATUS_MSG:
+		to += Sprintf(to, "%s", emit_status_msg(sdp));
+		break;
+
+	    case EOP_STATUS:
+		to += Sprintf(to, "%d", sdp->status);
+		break;
+
+	    case EOP_SCSI_NAME:
+		to += Sprintf(to, "%s", (sdp->scsi_name) ? sdp->scsi_name : "<unknown>");
+		break;
+
+	    case EOP_SCSI_MSG:
+		to += Sprintf(to, "%s", ScsiStatus(sgp->scsi_status));
+		break;
+
+	    case EOP_SCSI_STATUS:
+		to += Sprintf(to, "%x", sgp->scsi_status);
+		break;
+
+	    case EOP_HOST_STATUS:
+		to += Sprintf(to, "%x", sgp->host_status);
+		break;
+
+	    case EOP_HOST_MSG:
+		to += Sprintf(to, "%s", os_host_status_msg(sgp));
+		break;
+
+	    case EOP_DRIVER_STATUS:
+		to += Sprintf(to, "%x", sgp->driver_status);
+		break;
+
+	    case EOP_DRIVER_MSG:
+		to += Sprintf(to, "%s", os_driver_status_msg(sgp));
+		break;
+
+	    case EOP_SENSE_CODE: {
 		uint8_t error_code = (ssp) ? ssp->error_code : 0;
-		slen = Sprintf(to, "%x", error_code);
-		to += slen;
-		from += 11;
-		length -= 10;
-		continue;
-	    } else if (strncasecmp(key, "sense_msg", 9) == 0) {
+		to += Sprintf(to, "%x", error_code);
+		break;
+	    }
+	    case EOP_SENSE_MSG: {
 		char *sense_msgp = (ssp) ? SenseCodeMsg(ssp->error_code) : "None";
-		slen = Sprintf(to, "%s", sense_msgp);
-		to += slen;
-		from += 10;
-		length -= 9;
-		continue;
-	    } else if (strncasecmp(key, "resid", 5) == 0) {
-		slen = Sprintf(to, "%u", sgp->data_resid);
-		to += slen;
-		from += 6;
-		length -= 5;
-		continue;
-	    } else if (strncasecmp(key, "timeout", 7) == 0) {
-		slen = Sprintf(to, "%u", sgp->timeout);
-		to += slen;
-		from += 8;
-		length -= 7;
-		continue;
-	    } else if (strncasecmp(key, "blocks", 6) == 0) {
+		to += Sprintf(to, "%s", sense_msgp);
+		break;
+	    }
+	    case EOP_RESID:
+		to += Sprintf(to, "%u", sgp->data_resid);
+		break;
+
+	    case EOP_TIMEOUT:
+		to += Sprintf(to, "%u", sgp->timeout);
+		break;
+
+	    case EOP_BLOCKS: {
 		uint64_t blocks_transferred = 0;
 		if (iop->cdb_blocks) {
 		    blocks_transferred = iop->cdb_blocks;
 		} else if (iop->device_size) {
 		    blocks_transferred = howmany(sgp->data_transferred, iop->device_size);
 		}
-		slen = Sprintf(to, LUF, blocks_transferred);
-		to += slen;
-		from += 7;
-		length -= 6;
-		continue;
-	    } else if (strncasecmp(key, "starting", 8) == 0) {
-		slen = Sprintf(to, LUF, iop->starting_lba);
-		to += slen;
-		from += 9;
-		length -= 8;
-		continue;
-	    } else if (strncasecmp(key, "ending", 6) == 0) {
-		slen = Sprintf(to, LUF, iop->ending_lba);
-		to += slen;
-		from += 7;
-		length -= 6;
-		continue;
-	    } else if (strncasecmp(key, "capacity", 8) == 0) {
-		slen = Sprintf(to, LUF, iop->device_capacity);
-		to += slen;
-		from += 9;
-		length -= 8;
-		continue;
-	    } else if (strncasecmp(key, "device_size", 11) == 0) {
-		slen = Sprintf(to, "%u", iop->device_size);
-		to += slen;
-		from += 12;
-		length -= 11;
-		continue;
-	    } else if (strncasecmp(key, "deallocated", 11) == 0) {
-		slen = Sprintf(to, LUF, iop->deallocated_blocks);
-		to += slen;
-		from += 12;
-		length -= 11;
-		continue;
-	    } else if (strncasecmp(key, "mapped", 6) == 0) {
-		slen = Sprintf(to, LUF, iop->mapped_blocks);
-		to += slen;
-		from += 7;
-		length -= 6;
-		continue;
-	    } else if (strncasecmp(key,  "iterations",  10) == 0) {
-		slen = Sprintf(to, LUF, sdp->iterations);
-		to += slen;
-		from += 11;
-		length -= 10;
-		continue;
-	    } else if (strncasecmp(key,  "operations",  10) == 0) {
-		slen = Sprintf(to, LUF, iop->operations);
-		to += slen;
-		from += 11;
-		length -= 10;
-		continue;
-	    } else if (strncasecmp(key, "xfer", 4) == 0) {
-		//slen = Sprintf(to, "%u", (sgp->data_length - sgp->data_resid));
-		slen = Sprintf(to, "%u", sgp->data_transferred);
-		to += slen;
-		from += 5;
-		length -= 4;
-		continue;
-	    } else if (strncasecmp(key, "bytes", 5) == 0) {
-		slen = Sprintf(to, "%u", sgp->data_transferred);
-		to += slen;
-		from += 4;
-		length -= 5;
-		continue;
-	    } else if (strncasecmp(key, "total_blocks", 12) == 0) {
-		uint64_t total_blocks = 0;
-		total_blocks = get_total_blocks_transferred(sdp, NULL);
-		slen = Sprintf(to, LUF, total_blocks);
-		to += slen;
-		from += 13;
-		length -= 12;
-		continue;
-	    } else if (strncasecmp(key, "total_operations", 16) == 0) {
-		uint64_t total_operations = 0;
-		total_operations = get_total_operations(sdp, NULL);
-		slen = Sprintf(to, LUF, total_operations);
-		to += slen;
-		from += 17;
-		length -= 16;
-		continue;
-	    } else if (strncasecmp(key, "total_xfer", 10) == 0) {
-		uint64_t total_bytes = 0;
-		total_bytes = get_total_bytes_transferred(sdp, NULL);
-		slen = Sprintf(to, LUF, total_bytes);
-		to += slen;
-		from += 11;
-		length -= 10;
-		continue;
-	    } else if (strncasecmp(key, "total_bytes", 11) == 0) {
-		uint64_t total_bytes = 0;
-		total_bytes = get_total_bytes_transferred(sdp, NULL);
-		slen = Sprintf(to, LUF, total_bytes);
-		to += slen;
-		from += 12;
-		length -= 11;
-		continue;
-	    } else if (strncasecmp(key, "sense_data", 10) == 0) {
-		unsigned char *bp = sgp->sense_data;
-		int sense_len = (ssp) ? (8 + ssp->addl_sense_len) : 8;
-		if (bp) {
-		    while (sense_len--) {
-			slen = Sprintf(to, "%02x ", *bp++);
-			to += slen;
-		    }
-		    --to; *to = '\0'; /* remove last space */
-		}
-		from += 11;
-		length -= 10;
-		continue;
-	    } else if (strncasecmp(key, "cspec_data", 10) == 0) {
+		to += Sprintf(to, LUF, blocks_transferred);
+		break;
+	    }
+	    case EOP_STARTING:
+		to += Sprintf(to, LUF, iop->starting_lba);
+		break;
+
+	    case EOP_ENDING:
+		to += Sprintf(to, LUF, iop->ending_lba);
+		break;
+
+	    case EOP_CAPACITY:
+		to += Sprintf(to, LUF, iop->device_capacity);
+		break;
+
+	    case EOP_DEVICE_SIZE:
+		to += Sprintf(to, "%u", iop->device_size);
+		break;
+
+	    case EOP_DEALLOCATED:
+		to += Sprintf(to, LUF, iop->deallocated_blocks);
+		break;
+
+	    case EOP_MAPPED:
+		to += Sprintf(to, LUF, iop->mapped_blocks);
+		break;
+
+	    case EOP_ITERATIONS:
+		to += Sprintf(to, LUF, sdp->iterations);
+		break;
+
+	    case EOP_OPERATIONS:
+		to += Sprintf(to, LUF, iop->operations);
+		break;
+
+	    case EOP_XFER:
+		to += Sprintf(to, "%u", sgp->data_transferred);
+		break;
+
+	    case EOP_TOTAL_BLOCKS:
+		to += Sprintf(to, LUF, get_total_blocks_transferred(sdp, NULL));
+		break;
+
+	    case EOP_TOTAL_OPERATIONS:
+		to += Sprintf(to, LUF, get_total_operations(sdp, NULL));
+		break;
+
+	    case EOP_TOTAL_BYTES:
+		to += Sprintf(to, LUF, get_total_bytes_transferred(sdp, NULL));
+		break;
+
+	    case EOP_SENSE_DATA:
+		to += emit_sense_data(to, sgp, ssp);
+		break;
+
+	    case EOP_CSPEC_DATA: {
 		uint64_t cmd_spec_value = 0;
 		if (ssp) {
 		    GetSenseCmdSpecific(ssp, &cmd_spec_value);
 		}
-		slen = Sprintf(to, LUF, cmd_spec_value);
-		to += slen;
-		from += 11;
-		length -= 10;
-		continue;
-	    } else if (strncasecmp(key, "info_valid", 10) == 0) {
+		to += Sprintf(to, LUF, cmd_spec_value);
+		break;
+	    }
+	    case EOP_INFO_VALID:
+	    case EOP_INFO_DATA: {
 		uint8_t info_valid = 0;
 		uint64_t info_value = 0;
 		if (ssp) {
 		    GetSenseInformation(ssp, &info_valid, &info_value);
 		}
-		slen = Sprintf(to, "%u", info_valid);
-		to += slen;
-		from += 11;
-		length -= 10;
-		continue;
-	    } else if (strncasecmp(key, "info_data", 9) == 0) {
-		uint8_t info_valid = 0;
-		uint64_t info_value = 0;
-		if (ssp) {
-		    GetSenseInformation(ssp, &info_valid, &info_value);
+		if (eip->ei_opcode == EOP_INFO_VALID) {
+		    to += Sprintf(to, "%u", info_valid);
+		} else {
+		    to += Sprintf(to, LUF, info_value);
 		}
-		slen = Sprintf(to, LUF, info_value);
-		to += slen;
-		from += 10;
-		length -= 9;
-		continue;
-	    } else if (strncasecmp(key, "sense_key", 9) == 0) {
+		break;
+	    }
+	    case EOP_SENSE_KEY:
+	    case EOP_SKEY_MSG:
+	    case EOP_ASCQ_MSG:
+	    case EOP_ASCQ:
+	    case EOP_ASC:
+	    case EOP_ASQ: {
 		uint8_t sense_key = 0, asc = 0, asq = 0;
 		if (ssp) {
 		    GetSenseErrors(ssp, &sense_key, &asc, &asq);
 		}
-		slen = Sprintf(to, "%x", sense_key);
-		to += slen;
-		from += 10;
-		length -= 9;
-		continue;
-	    } else if (strncasecmp(key, "skey_msg", 8) == 0) {
-		uint8_t sense_key = 0, asc = 0, asq = 0;
-		char *skey_msg = "None";
-		if (ssp) {
-		    GetSenseErrors(ssp, &sense_key, &asc, &asq);
-		    skey_msg = SenseKeyMsg(sense_key);
+		if (eip->ei_opcode == EOP_SENSE_KEY) {
+		    to += Sprintf(to, "%x", sense_key);
+		} else if (eip->ei_opcode == EOP_SKEY_MSG) {
+		    to += Sprintf(to, "%s", (ssp) ? SenseKeyMsg(sense_key) : "None");
+		} else if (eip->ei_opcode == EOP_ASCQ_MSG) {
+		    to += Sprintf(to, "%s", (ssp) ? ScsiAscqMsg(asc, asq) : "None");
+		} else if (eip->ei_opcode == EOP_ASCQ) {
+		    to += Sprintf(to, "%02x%02x", asc, asq);
+		} else if (eip->ei_opcode == EOP_ASC) {
+		    to += Sprintf(to, "%02x", asc);
+		} else {
+		    to += Sprintf(to, "%02x", asq);
 		}
-		slen = Sprintf(to, "%s", skey_msg);
-		to += slen;
-		from += 9;
-		length -= 8;
-		continue;
-	    } else if (strncasecmp(key, "ili", 3) == 0) {
+		break;
+	    }
+	    case EOP_ILI: {
 		uint8_t illegal_length = (ssp) ? ssp->illegal_length : 0;
-		slen = Sprintf(to, "%u", illegal_length);
-		to += slen;
-		from += 4;
-		length -= 3;
-		continue;
-	    } else if (strncasecmp(key, "eom", 3) == 0) {
+		to += Sprintf(to, "%u", illegal_length);
+		break;
+	    }
+	    case EOP_EOM: {
 		uint8_t end_of_medium = (ssp) ? ssp->end_of_medium : 0;
-		slen = Sprintf(to, "%u", end_of_medium);
-		to += slen;
-		from += 4;
-		length -= 3;
-		continue;
-	    } else if (strncasecmp(key, "fm", 2) == 0) {
+		to += Sprintf(to, "%u", end_of_medium);
+		break;
+	    }
+	    case EOP_FM: {
 		uint8_t file_mark = (ssp) ? ssp->file_mark : 0;
-		slen = Sprintf(to, "%u", file_mark);
-		to += slen;
-		from += 3;
-		length -= 2;
-		continue;
-	    } else if (strncasecmp(key, "ascq_msg", 8) == 0) {
-		uint8_t sense_key = 0, asc = 0, asq = 0;
-		char *ascq_msg = "None";
-		if (ssp) {
-		    GetSenseErrors(ssp, &sense_key, &asc, &asq);
-		    ascq_msg = ScsiAscqMsg(asc, asq);
-		}
-		slen = Sprintf(to, "%s", ascq_msg);
-		to += slen;
-		from += 9;
-		length -= 8;
-		continue;
-	    } else if (strncasecmp(key, "ascq", 4) == 0) {
-		uint8_t sense_key = 0, asc = 0, asq = 0;
-		if (ssp) {
-		    GetSenseErrors(ssp, &sense_key, &asc, &asq);
-		}
-		slen = Sprintf(to, "%02x%02x", asc, asq);
-		to += slen;
-		from += 5;
-		length -= 4;
-		continue;
-	    } else if (strncasecmp(key, "asc", 3) == 0) {
-		uint8_t sense_key = 0, asc = 0, asq = 0;
-		if (ssp) {
-		    GetSenseErrors(ssp, &sense_key, &asc, &asq);
-		}
-		slen = Sprintf(to, "%02x", asc);
-		to += slen;
-		from += 4;
-		length -= 3;
-		continue;
-	    } else if (strncasecmp(key, "asq", 3) == 0) {
-		uint8_t sense_key = 0, asc = 0, asq = 0;
-		if (ssp) {
-		    GetSenseErrors(ssp, &sense_key, &asc, &asq);
-		}
-		slen = Sprintf(to, "%02x", asq);
-		to += slen;
-		from += 4;
-		length -= 3;
-		continue;
-	    } else if (strncasecmp(key, "fru", 3) == 0) {
+		to += Sprintf(to, "%u", file_mark);
+		break;
+	    }
+	    case EOP_FRU: {
 		uint8_t fru_code = 0;
 		if (ssp) {
 		    GetSenseFruCode(ssp, &fru_code);
 		}
-		slen = Sprintf(to, "%x", fru_code);
-		to += slen;
-		from += 4;
-		length -= 3;
-		continue;
+		to += Sprintf(to, "%x", fru_code);
+		break;
+	    }
 	    /*
 	     * Time Keywords:
 	     */
-	    } else if (strncasecmp(key, "date", 4) == 0) {
-		char time_buffer[32];
+	    case EOP_DATE: {
 		time_t current_time = time((time_t *) 0);
-		memset(time_buffer, '\0', sizeof(time_buffer));
-		os_ctime(&current_time, time_buffer, sizeof(time_buffer));
-		to += Sprintf(to, "%s", time_buffer);
-		from += 5;
-		length -= 4;
-		continue;
-	    } else if (strncasecmp(key, "seconds", 7) == 0) {
+		to += emit_time(to, &current_time);
+		break;
+	    }
+	    case EOP_SECONDS: {
 		time_t secs = get_elapsed_time(sdp);
 		to += Sprintf(to, "%d", secs);
-		from += 8;
-		length -= 7;
-		continue;
-	    } else if (strncasecmp(key, "start_time", 10) == 0) {
-		char time_buffer[32];
-		memset(time_buffer, '\0', sizeof(time_buffer));
-		os_ctime(&sdp->start_time, time_buffer, sizeof(time_buffer));
-		to += Sprintf(to, "%s", time_buffer);
-		from += 11;
-		length -= 10;
-		continue;
-	    } else if (strncasecmp(key, "end_time", 8) == 0) {
-		char time_buffer[32];
-		memset(time_buffer, '\0', sizeof(time_buffer));
-		os_ctime(&sdp->end_time, time_buffer, sizeof(time_buffer));
-		to += Sprintf(to, "%s", time_buffer);
-		from += 9;
-		length -= 8;
-		continue;
-	    } else if (strncasecmp(key, "elapsed_time", 12) == 0) {
-		clock_t et;
-		if (sdp->end_ticks) {
-		    et = (sdp->end_ticks - sdp->start_ticks);
-		} else {
-		    et = get_elapsed_ticks(sdp);
-		}
-		if (!sdp->start_ticks) et = 0;
-		to += FormatElapstedTime(to, et);
-		from += 13;
-		length -= 12;
-		continue;
+		break;
+	    }
+	    case EOP_START_TIME:
+		to += emit_time(to, &sdp->start_time);
+		break;
+
+	    case EOP_END_TIME:
+		to += emit_time(to, &sdp->end_time);
+		break;
+
+	    case EOP_ELAPSED_TIME:
+		to += emit_elapsed_time(to, sdp);
+		break;
 	    /*
 	     * Performance Keywords:
 	     */
-	    } else if (strncasecmp(key, "bps", 3) == 0) {
+	    case EOP_BPS:
+	    case EOP_KBPS:
+	    case EOP_MBPS: {
 		time_t		secs;
 		uint64_t	bytes;
+		double		divisor = 1.0;
 		bytes = get_total_bytes_transferred(sdp, &secs);
+		if (eip->ei_opcode == EOP_KBPS) {
+		    divisor = (double)KBYTE_SIZE;
+		} else if (eip->ei_opcode == EOP_MBPS) {
+		    divisor = (double)MBYTE_SIZE;
+		}
 		if (secs) {
-		    to += Sprintf(to, "%.3f", ((double)bytes / (double)secs));
+		    to += Sprintf(to, "%.3f", ((double)bytes / divisor) / secs);
 		} else {
 		    to += Sprintf(to, "0.000");
 		}
-		length -= 3;
-		from += 4;
-		continue;
-	    } else if (strncasecmp(key, "lbps", 4) == 0) {
+		break;
+	    }
+	    case EOP_LBPS: {
 		time_t		secs;
 		uint64_t	blocks;
 		blocks = get_total_blocks_transferred(sdp, &secs);
@@ -719,34 +847,9 @@ FmtEmitStatus(scsi_device_t *sdp, io_params_t *uiop, scsi_generic_t *usgp, char
 		} else {
 		    to += Sprintf(to, "0.000");
 		}
-		length -= 4;
-		from += 5;
-		continue;
-	    } else if (strncasecmp(key, "kbps", 4) == 0) {
-		time_t		secs;
-		uint64_t	bytes;
-		bytes = get_total_bytes_transferred(sdp, &secs);
-		if (secs) {
-		    to += Sprintf(to, "%.3f", ((double)bytes / (double)KBYTE_SIZE) / secs);
-		} else {
-		    to += Sprintf(to, "0.000");
-		}
-		length -= 4;
-		from += 5;
-		continue;
-	    } else if (strncasecmp(key, "mbps", 4) == 0) {
-		time_t		secs;
-		uint64_t	bytes;
-		bytes = get_total_bytes_transferred(sdp, &secs);
-		if (secs) {
-		    to += Sprintf(to, "%.3f", ((double)bytes / (double)MBYTE_SIZE) / secs);
-		} else {
-		    to += Sprintf(to, "0.000");
-		}
-		length -= 4;
-		from += 5;
-		continue;
-	    } else if (strncasecmp(key, "iops", 4) == 0) {
+		break;
+	    }
+	    case EOP_IOPS: {
 		time_t secs;
 		uint64_t operations = get_total_operations(sdp, &secs);
 		if (secs) {
@@ -754,10 +857,9 @@ FmtEmitStatus(scsi_device_t *sdp, io_params_t *uiop, scsi_generic_t *usgp, char
 		} else {
 		    to += Sprintf(to, "0.000");
 		}
-		length -= 4;
-		from += 5;
-		continue;
-	    } else if (strncasecmp(key, "spio", 4) == 0) {
+		break;
+	    }
+	    case EOP_SPIO: {
 		time_t secs;
 		uint64_t operations = get_total_operations(sdp, &secs);
 		if (operations) {
@@ -765,39 +867,118 @@ FmtEmitStatus(scsi_device_t *sdp, io_params_t *uiop, scsi_generic_t *usgp, char
 		} else {
 		    to += Sprintf(to, "0.0000");
 		}
-		length -= 4;
-		from += 5;
-		continue;
-	    } else {
-		*to++ = *from++;
-		continue;
+		break;
 	    }
-	} else if (*from == '\\') { /* not '%' */
-	    switch (*(from + 1)) {
-		case 'n': {
-		  to += Sprintf(to, "\n");
-		  break;
-		}
-		case 't': {
-		  to += Sprintf(to, "\t");
-		  break;
-		}
-		default: {
-		  *to++ = *from;
-		  *to++ = *(from + 1);
-		  break;
-		}
-	    } /* end switch */
-	    length--;
-	    from += 2;
-	    continue;
-	} else { /* not '%' or '\\' */
-	    *to++ = *from++;
-	    continue;
-	} /* end if '%' */
-    } /* while (length-- > 0) */
+	} /* end switch (eip->ei_opcode) */
+    }
     *to = '\0';	      /* NULL terminate! */
-    return ( (int)strlen(buffer) );
+    return( (int)(to - buffer) );
+}
+
+/*
+ * FmtEmitStatusJson() - Format the Default JSON Emit Status.
+ *
+ * Description:
+ *	This is a fast path for emit_status_default_json, which formats the
+ * fixed set of fields with one Sprintf(), and gets the sense errors once.
+ * The output must match what the compiled program would produce!
+ *
+ * Note: The format starts with %thread then %dsf, which switches to the
+ * base device, so the callers iop and sgp are not used.
+ */
+static int
+FmtEmitStatusJson(scsi_device_t *sdp, char *buffer)
+{
+    io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
+    scsi_generic_t *sgp = &iop->sg;
+    scsi_sense_t *ssp = sgp->sense_data;
+    uint8_t sense_key = 0, asc = 0, asq = 0;
+    char cdb[(MAX_CDB * 3) + 1];
+    char sense_data[((8 + 255) * 3) + 1];
+    char elapsed_time[SMALL_BUFFER_SIZE];
+    char start_time[32], end_time[32];
+
+    if (ssp) {
+	GetSenseErrors(ssp, &sense_key, &asc, &asq);
+    }
+    *cdb = *sense_data = '\0';
+    (void)emit_cdb(cdb, sgp);
+    (void)emit_sense_data(sense_data, sgp, ssp);
+    (void)emit_elapsed_time(elapsed_time, sdp);
+    (void)emit_time(start_time, &sdp->start_time);
+    (void)emit_time(end_time, &sdp->end_time);
+
+    return( Sprintf(buffer, "{\n"
+		    "    \"Thread\": %d,\n"
+		    "    \"Device Name\": \"%s\",\n"
+		    "    \"Block Length\": %u,\n"
+		    "    \"Capacity\": " LUF ",\n"
+		    "    \"Starting LBA\": " LUF ",\n"
+		    "    \"Ending LBA\": " LUF ",\n"
+		    "    \"SCSI Name\": \"%s\",\n"
+		    "    \"SCSI CDB\": \"%s\",\n"
+		    "    \"Data Direction\": \"%s\",\n"
+		    "    \"Data Length\": %u,\n"
+		    "    \"Exit Status\": %d,\n"
+		    "    \"Exit Status Msg\": \"%s\",\n"
+		    "    \"Host Status\": %x,\n"
+		    "    \"Host Status Msg\": \"%s\",\n"
+		    "    \"Driver Status\": %x,\n"
+		    "    \"Driver Status Msg\": \"%s\",\n"
+		    "    \"SCSI Status\": %x,\n"
+		    "    \"SCSI Status Msg\": \"%s\",\n"
+		    "    \"Sense Code\": %x,\n"
+		    "    \"Sense Code Msg\": \"%s\",\n"
+		    "    \"Sense Key\": %x,\n"
+		    "    \"Sense Key Msg\": \"%s\",\n"
+		    "    \"asc\": \"%02x\",\n"
+		    "    \"asq\": \"%02x\",\n"
+		    "    \"ascq_Msg\": \"%s\",\n"
+		    "    \"Bytes Transferred\": %u,\n"
+		    "    \"Residual\": %u,\n"
+		    "    \"Iterations\": " LUF ",\n"
+		    "    \"Total Bytes\": " LUF ",\n"
+		    "    \"Total Blocks\": " LUF ",\n"
+		    "    \"Total Operations\": " LUF ",\n"
+		    "    \"Sense Data\": \"%s\",\n"
+		    "    \"Elapsed Time\": \"%s\",\n"
+		    "    \"Starting Time\": \"%s\",\n"
+		    "    \"Ending Time\": \"%s\"\n"
+		    "}",
+		    sdp->thread_number,
+		    (sgp->dsf) ? sgp->dsf : "",
+		    iop->device_size,
+		    iop->device_capacity,
+		    iop->starting_lba,
+		    iop->ending_lba,
+		    (sdp->scsi_name) ? sdp->scsi_name : "<unknown>",
+		    cdb,
+		    emit_dir(sgp),
+		    sgp->data_length,
+		    sdp->status,
+		    emit_status_msg(sdp),
+		    sgp->host_status,
+		    os_host_status_msg(sgp),
+		    sgp->driver_status,
+		    os_driver_status_msg(sgp),
+		    sgp->scsi_status,
+		    ScsiStatus(sgp->scsi_status),
+		    (ssp) ? ssp->error_code : 0,
+		    (ssp) ? SenseCodeMsg(ssp->error_code) : "None",
+		    sense_key,
+		    (ssp) ? SenseKeyMsg(sense_key) : "None",
+		    asc, asq,
+		    (ssp) ? ScsiAscqMsg(asc, asq) : "None",
+		    sgp->data_transferred,
+		    sgp->data_resid,
+		    sdp->iterations,
+		    get_total_bytes_transferred(sdp, NULL),
+		    get_total_blocks_transferred(sdp, NULL),
+		    get_total_operations(sdp, NULL),
+		    sense_data,
+		    elapsed_time,
+		    start_time,
+		    end_time) );
 }
 
 clock_t
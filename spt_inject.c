@@ -0,0 +1,596 @@
+/****************************************************************************
+ *									    *
+ *			  COPYRIGHT (c) 1988 - 2026			    *
+ *			   This Software Provided			    *
+ *				     By					    *
+ *			  Robin's Nest Software Inc.			    *
+ *									    *
+ * Permission to use, copy, modify, distribute and sell this software and   *
+ * its documentation for any purpose and without fee is hereby granted,	    *
+ * provided that the above copyright notice appear in all copies and that   *
+ * both that copyright notice and this permission notice appear in the	    *
+ * supporting documentation, and that the name of the author not be used    *
+ * in advertising or publicity pertaining to distribution of the software   *
+ * without specific, written prior permission.				    *
+ *									    *
+ * THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE, 	    *
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN	    *
+ * NO EVENT SHALL HE BE LIABLE FOR ANY SPECIAL, INDIRECT OR CONSEQUENTIAL   *
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR    *
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS  *
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF   *
+ * THIS SOFTWARE.							    *
+ *									    *
+ ****************************************************************************/
+/*
+ * Module:	spt_inject.c
+ * Author:	Robin T. Miller
+ * Date:	October 18th, 2026
+ *
+ * Description:
+ *	Fault and latency injection, to exercise and measure error recovery
+ * (recovery_delay=, recovery_retries=, restart, onerr=) without depending
+ * on misbehaving hardware. The injection is done inside ExecuteCdb(), which
+ * libscsi already calls via execute_cdb, so each injected fault follows the
+ * same retry path as a real device error.
+ *
+ *	inject=fault[:percent][@lba[-lba]]	(up to 8 rules)
+ *
+ *	Faults: busy, qfull, ua, notready, medium, transport, timeout
+ *
+ *	The percent defaults to 100, and may be fractional (e.g. 0.1). When
+ * an LBA range is specified, only commands whose CDB LBA is within the range
+ * are candidates. Transport errors are reported as DID_TRANSPORT_DISRUPTED,
+ * and timeouts wait the command timeout then report DID_TIME_OUT, using the
+ * Linux host status values (which other OS's do not retry).
+ *
+ *	inject_latency={fixed:usecs|uniform:min-max|exp:mean}[:percent]
+ *
+ *	Latency is added before the real command is executed. When all
+ * threads finish, the cost of each recovery path is reported, including
+ * the added latency, the share of thread time lost, and the percentiles.
+ *
+ * Modification History:
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Initial creation.
+ */
+#include "spt.h"
+
+/*
+ * Note: These are the Linux host status values, which os_is_retriable()
+ * handles, and are only defined in scsilib-linux.c.
+ */
+#define INJECT_DID_TIME_OUT		0x03	/* Command timed out.		*/
+#define INJECT_DID_TRANSPORT_DISRUPTED	0x0E	/* Transport disrupted.		*/
+
+#define INJECT_SENSE_LENGTH		18	/* Fixed format sense length.	*/
+#define INJECT_LN2			0.69314718055994530942
+
+typedef struct inject_fault_entry {
+    char		*ife_name;	/* The option name.		*/
+    char		*ife_msg;	/* The report name.		*/
+    inject_fault_t	ife_fault;	/* The fault type.		*/
+} inject_fault_entry_t;
+
+static inject_fault_entry_t inject_fault_table[] = {
+    { "busy",		"Busy",			INJECT_BUSY		},
+    { "qfull",		"Queue Full",		INJECT_QUEUE_FULL	},
+    { "ua",		"Unit Attention",	INJECT_UNIT_ATTENTION	},
+    { "notready",	"Not Ready",		INJECT_NOT_READY	},
+    { "medium",		"Medium Error",		INJECT_MEDIUM_ERROR	},
+    { "transport",	"Transport Disrupted",	INJECT_TRANSPORT	},
+    { "timeout",	"Timeout",		INJECT_TIMEOUT		},
+    { "none",		"No Fault",		INJECT_NONE		}
+};
+
+/*
+ * parse_inject_percent() - Parse an optional percentage.
+ */
+static int
+parse_inject_percent(scsi_device_t *sdp, char *string, double *percent)
+{
+    char *eptr;
+
+    *percent = strtod(string, &eptr);
+    if ( (eptr == string) || (*eptr != '\0') ||
+	 (*percent <= 0.0) || (*percent > 100.0) ) {
+	Eprintf(sdp, "Invalid injection percentage '%s', valid range is (0-100]!\n", string);
+	return(FAILURE);
+    }
+    return(SUCCESS);
+}
+
+/*
+ * parse_inject_fault() - Parse inject=fault[:percent][@lba[-lba]]
+ */
+int
+parse_inject_fault(scsi_device_t *sdp, char *string)
+{
+    inject_fault_entry_t *ifep;
+    inject_rule_t *irp;
+    char buffer[MEDIUM_BUFFER_SIZE];
+    char *lba_str, *percent_str, *end_str;
+    int status = SUCCESS;
+
+    if (sdp->inject_rule_count == INJECT_MAX_RULES) {
+	Eprintf(sdp, "The maximum injection rules (%d) exceeded!\n", INJECT_MAX_RULES);
+	return(FAILURE);
+    }
+    (void)strncpy(buffer, string, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    if ( (lba_str = strchr(buffer, '@')) ) {
+	*lba_str++ = '\0';
+    }
+    if ( (percent_str = strchr(buffer, ':')) ) {
+	*percent_str++ = '\0';
+    }
+    for (ifep = inject_fault_table; (ifep->ife_fault != INJECT_NONE); ifep++) {
+	if (strcmp(buffer, ifep->ife_name) == 0) break;
+    }
+    if (ifep->ife_fault == INJECT_NONE) {
+	Eprintf(sdp, "Invalid fault '%s', valid faults are: busy, qfull, ua, notready, medium, transport, timeout\n",
+		buffer);
+	return(FAILURE);
+    }
+    irp = &sdp->inject_rules[sdp->inject_rule_count];
+    irp->ir_fault = ifep->ife_fault;
+    irp->ir_percent = 100.0;
+    irp->ir_starting_lba = 0;
+    irp->ir_ending_lba = SCSI_MAX_LBA16;
+    if (percent_str) {
+	if (parse_inject_percent(sdp, percent_str, &irp->ir_percent) == FAILURE) {
+	    return(FAILURE);
+	}
+    }
+    if (lba_str) {
+	if ( (end_str = strchr(lba_str, '-')) ) {
+	    *end_str++ = '\0';
+	}
+	irp->ir_starting_lba = large_number(sdp, lba_str, ANY_RADIX, &status, True);
+	if ( (status == SUCCESS) && end_str ) {
+	    irp->ir_ending_lba = large_number(sdp, end_str, ANY_RADIX, &status, True);
+	} else {
+	    irp->ir_ending_lba = irp->ir_starting_lba;
+	}
+	if (status != SUCCESS) return(FAILURE);
+	if (irp->ir_ending_lba < irp->ir_starting_lba) {
+	    Eprintf(sdp, "The ending LBA (" LUF ") is less than the starting LBA (" LUF ")!\n",
+		    irp->ir_ending_lba, irp->ir_starting_lba);
+	    return(FAILURE);
+	}
+    }
+    sdp->inject_rule_count++;
+    return(SUCCESS);
+}
+
+/*
+ * parse_inject_latency() - Parse inject_latency=type:usecs[-usecs][:percent]
+ */
+int
+parse_inject_latency(scsi_device_t *sdp, char *string)
+{
+    char buffer[MEDIUM_BUFFER_SIZE];
+    char *value_str, *percent_str, *max_str;
+    int status = SUCCESS;
+
+    (void)strncpy(buffer, string, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    sdp->inject_delay = INJECT_DELAY_NONE;
+    sdp->inject_delay_min = sdp->inject_delay_max = 0;
+    sdp->inject_delay_percent = 100.0;
+    if (strcmp(buffer, "none") == 0) {
+	return(SUCCESS);
+    }
+    if ( (value_str = strchr(buffer, ':')) == NULL) {
+	Eprintf(sdp, "Invalid injection latency '%s', format is {fixed:usecs|uniform:min-max|exp:mean}[:percent]\n",
+		string);
+	return(FAILURE);
+    }
+    *value_str++ = '\0';
+    if ( (percent_str = strchr(value_str, ':')) ) {
+	*percent_str++ = '\0';
+	if (parse_inject_percent(sdp, percent_str, &sdp->inject_delay_percent) == FAILURE) {
+	    return(FAILURE);
+	}
+    }
+    if ( (max_str = strchr(value_str, '-')) ) {
+	*max_str++ = '\0';
+    }
+    if (strcmp(buffer, "fixed") == 0) {
+	sdp->inject_delay = INJECT_DELAY_FIXED;
+    } else if (strcmp(buffer, "uniform") == 0) {
+	sdp->inject_delay = INJECT_DELAY_UNIFORM;
+    } else if ( (strcmp(buffer, "exp") == 0) || (strcmp(buffer, "exponential") == 0) ) {
+	sdp->inject_delay = INJECT_DELAY_EXPONENTIAL;
+    } else {
+	Eprintf(sdp, "Invalid latency distribution '%s', valid types are: fixed, uniform, exp\n", buffer);
+	return(FAILURE);
+    }
+    sdp->inject_delay_min = number(sdp, value_str, ANY_RADIX, &status, True);
+    if (status != SUCCESS) return(FAILURE);
+    if (sdp->inject_delay == INJECT_DELAY_UNIFORM) {
+	if (max_str == NULL) {
+	    Eprintf(sdp, "The uniform latency requires a range, min-max usecs!\n");
+	    return(FAILURE);
+	}
+	sdp->inject_delay_max = number(sdp, max_str, ANY_RADIX, &status, True);
+	if (status != SUCCESS) return(FAILURE);
+	if (sdp->inject_delay_max < sdp->inject_delay_min) {
+	    Eprintf(sdp, "The maximum latency (%u) is less than the minimum latency (%u)!\n",
+		    sdp->inject_delay_max, sdp->inject_delay_min);
+	    return(FAILURE);
+	}
+    } else {
+	sdp->inject_delay_max = sdp->inject_delay_min;
+    }
+    return(SUCCESS);
+}
+
+/*
+ * create_inject_data() - Create the shared injection statistics.
+ *
+ * Note: Called by the main thread, before the threads are started.
+ */
+int
+create_inject_data(scsi_device_t *sdp)
+{
+    inject_data_t *idp;
+    int fault, status;
+
+    sdp->inject_data = NULL;
+    if ( (sdp->inject_rule_count == 0) && (sdp->inject_delay == INJECT_DELAY_NONE) ) {
+	return(SUCCESS);
+    }
+    idp = Malloc(sdp, sizeof(*idp));
+    if (idp == NULL) return(FAILURE);
+    if ( (status = pthread_mutex_init(&idp->id_lock, NULL)) != SUCCESS) {
+	tPerror(sdp, status, "pthread_mutex_init() of injection lock failed!");
+	Free(sdp, idp);
+	return(FAILURE);
+    }
+    for (fault = 0; (fault <= INJECT_NONE); fault++) {
+	init_latency_stats(&idp->id_stats[fault].is_latency);
+    }
+    idp->id_references = sdp->threads;
+    idp->id_threads = sdp->threads;
+    idp->id_start_usecs = get_usecs();
+    sdp->inject_data = idp;
+    return(SUCCESS);
+}
+
+/*
+ * create_inject_thread() - Create the per thread injection state.
+ */
+int
+create_inject_thread(scsi_device_t *sdp)
+{
+    inject_thread_t *itp;
+    int fault;
+
+    itp = Malloc(sdp, sizeof(*itp));
+    if (itp == NULL) return(FAILURE);
+    for (fault = 0; (fault <= INJECT_NONE); fault++) {
+	init_latency_stats(&itp->it_stats[fault].is_latency);
+    }
+    itp->it_random = (sdp->random_seed + sdp->thread_number);
+    itp->it_fault = INJECT_NONE;
+    sdp->inject_thread = itp;
+    return(SUCCESS);
+}
+
+/*
+ * inject_random() - Return a random value in the range [0, 1).
+ */
+static double
+inject_random(inject_thread_t *itp)
+{
+    itp->it_random = (itp->it_random * 6364136223846793005ULL) + 1442695040888963407ULL;
+    return( (double)(itp->it_random >> 11) / 9007199254740992.0 );
+}
+
+static hbool_t
+inject_chance(inject_thread_t *itp, double percent)
+{
+    if (percent >= 100.0) return(True);
+    return( ((inject_random(itp) * 100.0) < percent) ? True : False );
+}
+
+/*
+ * inject_exponential() - Return an exponentially distributed latency.
+ *
+ * Note: The natural log is calculated here, to avoid requiring libm.
+ * With u = m * 2^e (m in [1,2)), ln(u) = e*ln(2) + 2*atanh((m-1)/(m+1)).
+ */
+static uint32_t
+inject_exponential(inject_thread_t *itp, uint32_t mean)
+{
+    double u = 1.0 - inject_random(itp);	/* The range (0, 1]. */
+    double t, t2, ln_u;
+    int exponent = 0;
+
+    while (u < 1.0) {
+	u *= 2.0;
+	exponent--;
+    }
+    t = (u - 1.0) / (u + 1.0);
+    t2 = (t * t);
+    ln_u = (exponent * INJECT_LN2) +
+	    (2.0 * t * (1.0 + t2 * (1.0/3.0 + t2 * (1.0/5.0 + t2 * (1.0/7.0 + t2 / 9.0)))));
+    return( (uint32_t)(-ln_u * (double)mean) );
+}
+
+static uint32_t
+inject_latency(scsi_device_t *sdp, inject_thread_t *itp)
+{
+    switch (sdp->inject_delay) {
+	case INJECT_DELAY_FIXED:
+	    return(sdp->inject_delay_min);
+	case INJECT_DELAY_UNIFORM:
+	    return( sdp->inject_delay_min +
+		    (uint32_t)(inject_random(itp) * (double)(sdp->inject_delay_max - sdp->inject_delay_min + 1)) );
+	case INJECT_DELAY_EXPONENTIAL:
+	    return( inject_exponential(itp, sdp->inject_delay_min) );
+	default:
+	    return(0);
+    }
+}
+
+static void
+inject_check_condition(scsi_generic_t *sgp, uint8_t sense_key, uint8_t asc, uint8_t ascq)
+{
+    uint8_t *sense = sgp->sense_data;
+
+    sgp->scsi_status = SCSI_CHECK_CONDITION;
+    if ( (sense == NULL) || (sgp->sense_length < INJECT_SENSE_LENGTH) ) {
+	return;
+    }
+    memset(sense, '\0', INJECT_SENSE_LENGTH);
+    sense[0] = 0x70;				/* Current error, fixed format.	*/
+    sense[2] = sense_key;
+    sense[7] = (uint8_t)(INJECT_SENSE_LENGTH - 8); /* Additional sense length. */
+    sense[12] = asc;
+    sense[13] = ascq;
+    sgp->sense_valid = True;
+    sgp->sense_resid = (sgp->sense_length - INJECT_SENSE_LENGTH);
+    return;
+}
+
+/*
+ * inject_fault() - Complete the command with the fault specified.
+ */
+static void
+inject_fault(scsi_generic_t *sgp, inject_fault_t fault)
+{
+    /* Clear the previous attempts' status, so only this fault is reported. */
+    sgp->scsi_status = SCSI_GOOD;
+    sgp->host_status = sgp->driver_status = 0;
+    sgp->sense_valid = False;
+    if (sgp->sense_data && sgp->sense_length) {
+	memset(sgp->sense_data, '\0', sgp->sense_length);
+	sgp->sense_resid = sgp->sense_length;
+    }
+    switch (fault) {
+	case INJECT_BUSY:
+	    sgp->scsi_status = SCSI_BUSY;
+	    break;
+	case INJECT_QUEUE_FULL:
+	    sgp->scsi_status = SCSI_QUEUE_FULL;
+	    break;
+	case INJECT_UNIT_ATTENTION:
+	    inject_check_condition(sgp, SKV_UNIT_ATTENTION, ASC_POWER_ON_RESET, 0x00);
+	    break;
+	case INJECT_NOT_READY:
+	    /* Logical unit is in process of becoming ready. */
+	    inject_check_condition(sgp, SKV_NOT_READY, ASC_NOT_READY, 0x01);
+	    break;
+	case INJECT_MEDIUM_ERROR:
+	    /* Unrecovered read error. */
+	    inject_check_condition(sgp, SKV_MEDIUM_ERROR, 0x11, 0x00);
+	    break;
+	case INJECT_TRANSPORT:
+	    sgp->host_status = INJECT_DID_TRANSPORT_DISRUPTED;
+	    break;
+	case INJECT_TIMEOUT:
+	    os_msleep(sgp->timeout);
+	    sgp->host_status = INJECT_DID_TIME_OUT;
+	    break;
+	default:
+	    break;
+    }
+    sgp->data_resid = sgp->data_length;
+    sgp->error = True;
+    return;
+}
+
+/*
+ * inject_execute_cdb() - Execute a CDB, injecting faults or latency.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	iop = The I/O parameters.
+ *	sgp = The SCSI generic information.
+ *
+ * Return Value:
+ *	Returns the OS pass-through status (0/-1).
+ */
+int
+inject_execute_cdb(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp)
+{
+    inject_thread_t *itp = sdp->inject_thread;
+    inject_rule_t *irp;
+    uint64_t lba = 0;
+    uint32_t usecs;
+    hbool_t lba_valid = False;
+    int rule;
+
+    /* The first attempt starts a new command. */
+    if (sgp->recovery_retries == 0) {
+	itp->it_fault = INJECT_NONE;
+    }
+    for (rule = 0, irp = sdp->inject_rules; (rule < sdp->inject_rule_count); rule++, irp++) {
+	if ( irp->ir_starting_lba || (irp->ir_ending_lba != SCSI_MAX_LBA16) ) {
+	    if (lba_valid == False) {
+		lba = trace_cdb_lba(sgp);
+		lba_valid = True;
+	    }
+	    if ( (lba < irp->ir_starting_lba) || (lba > irp->ir_ending_lba) ) continue;
+	}
+	if (inject_chance(itp, irp->ir_percent) == False) continue;
+	if (itp->it_fault == INJECT_NONE) {
+	    itp->it_fault = irp->ir_fault;
+	}
+	itp->it_stats[irp->ir_fault].is_faults++;
+	if (sdp->debug_flag == True) {
+	    Printf(sdp, "DEBUG: Injecting %s fault on %s, retry #%u\n",
+		   inject_fault_table[irp->ir_fault].ife_msg, sgp->cdb_name, sgp->recovery_retries);
+	}
+	inject_fault(sgp, irp->ir_fault);
+	return(SUCCESS);
+    }
+    if ( (sdp->inject_delay != INJECT_DELAY_NONE) &&
+	 (inject_chance(itp, sdp->inject_delay_percent) == True) ) {
+	if ( (usecs = inject_latency(sdp, itp)) ) {
+	    os_usleep(usecs);
+	}
+	itp->it_delays++;
+	itp->it_delay_usecs += usecs;
+    }
+    return( execute_device_cdb(sdp, iop, sgp) );
+}
+
+/*
+ * record_inject_stats() - Record the command latency by its' first fault.
+ *
+ * Note: The latency includes retries and recovery delays, so this is the
+ * cost of each recovery path, compared to the commands without faults.
+ */
+void
+record_inject_stats(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp, int error)
+{
+    inject_thread_t *itp = sdp->inject_thread;
+    inject_stats_t *isp = &itp->it_stats[itp->it_fault];
+    uint64_t bytes = 0;
+
+    if ( (error == FAILURE) || (sgp->error == True) ) {
+	isp->is_failed++;
+    } else {
+	if (itp->it_fault != INJECT_NONE) {
+	    isp->is_recovered++;
+	}
+	if (sgp->data_dir != scsi_data_none) {
+	    bytes = (sgp->data_length - sgp->data_resid);
+	}
+    }
+    record_latency(&isp->is_latency, iop->cmd_latency, bytes);
+    itp->it_fault = INJECT_NONE;
+    return;
+}
+
+static void
+report_inject_data(scsi_device_t *sdp, inject_data_t *idp)
+{
+    inject_stats_t *isp, *clean = &idp->id_stats[INJECT_NONE];
+    latency_stats_t total;
+    uint64_t end_usecs = get_usecs();
+    uint64_t thread_usecs, clean_avg = 0, lost_usecs, average;
+    double secs = ((double)(end_usecs - idp->id_start_usecs) / 1000000.0);
+    char buffer[LARGE_BUFFER_SIZE];
+    int fault;
+
+    init_latency_stats(&total);
+    for (fault = 0; (fault <= INJECT_NONE); fault++) {
+	merge_latency_stats(&total, &idp->id_stats[fault].is_latency);
+    }
+    if (clean->is_latency.ls_count) {
+	clean_avg = (clean->is_latency.ls_total_usecs / clean->is_latency.ls_count);
+    }
+    thread_usecs = ((end_usecs - idp->id_start_usecs) * idp->id_threads);
+
+    PrintHeader(sdp, "Fault and Latency Injection");
+    PrintDecimal(sdp, "Number of Threads", idp->id_threads, PNL);
+    PrintLongDec(sdp, "Number of Commands", total.ls_count, PNL);
+    (void)FormatElapstedTime(buffer, (clock_t)(secs * hertz));
+    PrintAscii(sdp, "Elapsed Time", buffer, PNL);
+    if (secs > 0.0) {
+	(void)sprintf(buffer, "%.3f Mbytes/sec, %.3f IOPS",
+		      (((double)total.ls_bytes / (double)MBYTE_SIZE) / secs),
+		      ((double)total.ls_count / secs));
+	PrintAscii(sdp, "Total Throughput", buffer, PNL);
+    }
+    if (idp->id_delays) {
+	PrintLongDec(sdp, "Latencies Injected", idp->id_delays, PNL);
+	(void)sprintf(buffer, LUF " usecs", (idp->id_delay_usecs / idp->id_delays));
+	PrintAscii(sdp, "Average Injected Latency", buffer, PNL);
+    }
+    Printf(sdp, "\n");
+
+    for (fault = 0; (fault < INJECT_NONE); fault++) {
+	isp = &idp->id_stats[fault];
+	if (isp->is_faults == 0) continue;
+	(void)sprintf(buffer, "%s Recovery", inject_fault_table[fault].ife_msg);
+	PrintHeader(sdp, buffer);
+	PrintLongDec(sdp, "Faults Injected", isp->is_faults, PNL);
+	PrintLongDec(sdp, "Commands Recovered", isp->is_recovered, PNL);
+	PrintLongDec(sdp, "Commands Failed", isp->is_failed, PNL);
+	if (isp->is_latency.ls_count) {
+	    average = (isp->is_latency.ls_total_usecs / isp->is_latency.ls_count);
+	    lost_usecs = (average > clean_avg) ? ((average - clean_avg) * isp->is_latency.ls_count) : 0;
+	    (void)sprintf(buffer, LUF " usecs per command", (average > clean_avg) ? (average - clean_avg) : 0);
+	    PrintAscii(sdp, "Added Latency", buffer, PNL);
+	    (void)sprintf(buffer, "%.3f secs (%.2f%% of thread time)",
+			  ((double)lost_usecs / 1000000.0),
+			  (thread_usecs) ? (((double)lost_usecs * 100.0) / (double)thread_usecs) : 0.0);
+	    PrintAscii(sdp, "Throughput Cost", buffer, PNL);
+	}
+	Printf(sdp, "\n");
+	(void)sprintf(buffer, "%s Command Latency", inject_fault_table[fault].ife_msg);
+	report_latency_stats(sdp, buffer, &isp->is_latency);
+    }
+    report_latency_stats(sdp, "No Fault Command Latency", &clean->is_latency);
+    return;
+}
+
+/*
+ * release_inject_thread() - Merge this threads' statistics, and release.
+ *
+ * Description:
+ *	The last thread reports the merged statistics, and frees the data.
+ */
+void
+release_inject_thread(scsi_device_t *sdp)
+{
+    inject_thread_t *itp = sdp->inject_thread;
+    inject_data_t *idp = sdp->inject_data;
+    inject_stats_t *isp, *sisp;
+    int fault, references;
+
+    sdp->inject_thread = NULL;
+    sdp->inject_data = NULL;
+    if (idp == NULL) {
+	if (itp) Free(sdp, itp);
+	return;
+    }
+    (void)pthread_mutex_lock(&idp->id_lock);
+    if (itp) {
+	for (fault = 0; (fault <= INJECT_NONE); fault++) {
+	    isp = &idp->id_stats[fault];
+	    sisp = &itp->it_stats[fault];
+	    isp->is_faults += sisp->is_faults;
+	    isp->is_recovered += sisp->is_recovered;
+	    isp->is_failed += sisp->is_failed;
+	    merge_latency_stats(&isp->is_latency, &sisp->is_latency);
+	}
+	idp->id_delays += itp->it_delays;
+	idp->id_delay_usecs += itp->it_delay_usecs;
+    }
+    references = --idp->id_references;
+    (void)pthread_mutex_unlock(&idp->id_lock);
+    if (itp) Free(sdp, itp);
+    if (references) return;
+
+    report_inject_data(sdp, idp);
+    (void)pthread_mutex_destroy(&idp->id_lock);
+    Free(sdp, idp);
+    return;
+}
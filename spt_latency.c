@@ -0,0 +1,235 @@
+/****************************************************************************
+ *									    *
+ *			  COPYRIGHT (c) 1988 - 2026			    *
+ *			   This Software Provided			    *
+ *				     By					    *
+ *			  Robin's Nest Software Inc.			    *
+ *									    *
+ * Permission to use, copy, modify, distribute and sell this software and   *
+ * its documentation for any purpose and without fee is hereby granted,	    *
+ * provided that the above copyright notice appear in all copies and that   *
+ * both that copyright notice and this permission notice appear in the	    *
+ * supporting documentation, and that the name of the author not be used    *
+ * in advertising or publicity pertaining to distribution of the software   *
+ * without specific, written prior permission.				    *
+ *									    *
+ * THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE, 	    *
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN	    *
+ * NO EVENT SHALL HE BE LIABLE FOR ANY SPECIAL, INDIRECT OR CONSEQUENTIAL   *
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR    *
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS  *
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF   *
+ * THIS SOFTWARE.							    *
+ *									    *
+ ****************************************************************************/
+/*
+ * Module:	spt_latency.c
+ * Author:	Robin T. Miller
+ * Date:	October 18th, 2026
+ *
+ * Description:
+ *	Command latency statistics, kept in log-linear buckets so percentiles
+ * can be reported without saving each sample. Each power of two is divided
+ * into LATENCY_SUB_BUCKETS, so the bucket error is less than 1/16th.
+ *
+ * Modification History:
+ */
+#include "spt.h"
+
+/*
+ * get_usecs() - Get the current time in microseconds.
+ *
+ * Note: This time is only used for intervals, so the monotonic clock is
+ * used (where available), so latencies are not affected by time changes.
+ */
+uint64_t
+get_usecs(void)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == SUCCESS) {
+	return( ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000) );
+    }
+#endif /* defined(CLOCK_MONOTONIC) */
+    {
+	struct timeval tv;
+
+	(void)gettimeofday(&tv, NULL);
+	return( ((uint64_t)tv.tv_sec * 1000000) + (uint64_t)tv.tv_usec );
+    }
+}
+
+/*
+ * get_cpu_usecs() - Get this threads' CPU time (user + system) in microseconds.
+ *
+ * Note: Where thread CPU times are not available, process times are used.
+ */
+uint64_t
+get_cpu_usecs(void)
+{
+#if defined(WIN32)
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+
+    if (GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time,
+		       &kernel_time, &user_time) == False) {
+	return(0);
+    }
+    /* These times are in 100 nanosecond units. */
+    return( ((((uint64_t)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime) +
+	     (((uint64_t)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime)) / 10 );
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != SUCCESS) {
+	return(0);
+    }
+    return( ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000) );
+#else /* !defined(WIN32) && !defined(CLOCK_THREAD_CPUTIME_ID) */
+    struct tms tms;
+
+    (void)times(&tms);
+    return( ((uint64_t)(tms.tms_utime + tms.tms_stime) * 1000000) / hertz );
+#endif /* defined(WIN32) */
+}
+
+static int
+latency_bucket(uint64_t usecs)
+{
+    int msb = 0;
+    uint64_t value = usecs;
+
+    if (usecs < LATENCY_SUB_BUCKETS) {
+	return( (int)usecs );
+    }
+    while (value >>= 1) msb++;
+    /* The top bits after the MSB select the sub-bucket. */
+    return( ((msb - 3) * LATENCY_SUB_BUCKETS) +
+	    (int)((usecs >> (msb - 4)) & (LATENCY_SUB_BUCKETS - 1)) );
+}
+
+static uint64_t
+latency_bucket_value(int bucket)
+{
+    int msb, sub;
+
+    if (bucket < LATENCY_SUB_BUCKETS) {
+	return( (uint64_t)bucket );
+    }
+    msb = (bucket / LATENCY_SUB_BUCKETS) + 3;
+    sub = (bucket % LATENCY_SUB_BUCKETS);
+    /* Return the upper bound of this bucket. */
+    return( ((uint64_t)(LATENCY_SUB_BUCKETS + sub + 1) << (msb - 4)) - 1 );
+}
+
+void
+init_latency_stats(latency_stats_t *lsp)
+{
+    memset(lsp, '\0', sizeof(*lsp));
+    return;
+}
+
+void
+record_latency(latency_stats_t *lsp, uint64_t usecs, uint64_t bytes)
+{
+    if ( (lsp->ls_count == 0) || (usecs < lsp->ls_min_usecs) ) {
+	lsp->ls_min_usecs = usecs;
+    }
+    if (usecs > lsp->ls_max_usecs) {
+	lsp->ls_max_usecs = usecs;
+    }
+    lsp->ls_count++;
+    lsp->ls_bytes += bytes;
+    lsp->ls_total_usecs += usecs;
+    lsp->ls_buckets[latency_bucket(usecs)]++;
+    return;
+}
+
+void
+merge_latency_stats(latency_stats_t *lsp, latency_stats_t *slsp)
+{
+    int bucket;
+
+    if (slsp->ls_count == 0) return;
+    if ( (lsp->ls_count == 0) || (slsp->ls_min_usecs < lsp->ls_min_usecs) ) {
+	lsp->ls_min_usecs = slsp->ls_min_usecs;
+    }
+    if (slsp->ls_max_usecs > lsp->ls_max_usecs) {
+	lsp->ls_max_usecs = slsp->ls_max_usecs;
+    }
+    lsp->ls_count += slsp->ls_count;
+    lsp->ls_bytes += slsp->ls_bytes;
+    lsp->ls_total_usecs += slsp->ls_total_usecs;
+    for (bucket = 0; (bucket < LATENCY_BUCKETS); bucket++) {
+	lsp->ls_buckets[bucket] += slsp->ls_buckets[bucket];
+    }
+    return;
+}
+
+/*
+ * get_latency_percentile() - Get the latency for a percentile (0-100).
+ */
+uint64_t
+get_latency_percentile(latency_stats_t *lsp, double percentile)
+{
+    uint64_t target, count = 0;
+    double rank;
+    int bucket;
+
+    if (lsp->ls_count == 0) return(0);
+    /* Nearest rank: ceil(count * percentile / 100), clamped to [1, count]. */
+    rank = (((double)lsp->ls_count * percentile) / 100.0);
+    target = (uint64_t)rank;
+    if ((double)target < rank) target++;
+    if (target == 0) target = 1;
+    if (target > lsp->ls_count) target = lsp->ls_count;
+    for (bucket = 0; (bucket < LATENCY_BUCKETS); bucket++) {
+	count += lsp->ls_buckets[bucket];
+	if (count >= target) {
+	    return( min(latency_bucket_value(bucket), lsp->ls_max_usecs) );
+	}
+    }
+    return(lsp->ls_max_usecs);
+}
+
+/*
+ * report_latency_stats() - Report latency and throughput statistics.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	header = The header for these statistics.
+ *	lsp = The latency statistics.
+ *
+ * Note: Throughput is based on the command time, not the elapsed time.
+ */
+void
+report_latency_stats(scsi_device_t *sdp, char *header, latency_stats_t *lsp)
+{
+    char buffer[LARGE_BUFFER_SIZE];
+
+    PrintHeader(sdp, header);
+    PrintLongDec(sdp, "Number of Commands", lsp->ls_count, PNL);
+    if (lsp->ls_count == 0) {
+	Printf(sdp, "\n");
+	return;
+    }
+    if (lsp->ls_bytes) {
+	PrintLongDec(sdp, "Total Bytes Transferred", lsp->ls_bytes, PNL);
+    }
+    (void)sprintf(buffer, LUF " / " LUF " / " LUF " usecs",
+		  lsp->ls_min_usecs, (lsp->ls_total_usecs / lsp->ls_count), lsp->ls_max_usecs);
+    PrintAscii(sdp, "Latency Min/Avg/Max", buffer, PNL);
+    (void)sprintf(buffer, LUF " / " LUF " / " LUF " / " LUF " usecs",
+		  get_latency_percentile(lsp, 50.0), get_latency_percentile(lsp, 90.0),
+		  get_latency_percentile(lsp, 99.0), get_latency_percentile(lsp, 99.9));
+    PrintAscii(sdp, "Latency p50/p90/p99/p99.9", buffer, PNL);
+    if (lsp->ls_bytes && lsp->ls_total_usecs) {
+	double secs = ((double)lsp->ls_total_usecs / 1000000.0);
+	(void)sprintf(buffer, "%.3f Mbytes/sec, %.3f IOPS",
+		      (((double)lsp->ls_bytes / (double)MBYTE_SIZE) / secs),
+		      ((double)lsp->ls_count / secs));
+	PrintAscii(sdp, "Command Throughput", buffer, PNL);
+    }
+    Printf(sdp, "\n");
+    return;
+}
@@ -1414,7 +1414,7 @@ log_page_decode(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp, log_p
 	int param_entry_length = 0;
 	char *param_str = NULL;
 
-	if (CmdInterruptedFlag == True)	break;
+	if (CmdInterrupted(sdp) == True)	break;
 	if (sdp->report_format == REPORT_FULL) Printf(sdp, "\n");
 	offset = PrintLogParameterHeader(sdp, hdr, phdr, offset);
 
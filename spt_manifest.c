@@ -0,0 +1,533 @@
+/****************************************************************************
+ *									    *
+ *			  COPYRIGHT (c) 1988 - 2026			    *
+ *			   This Software Provided			    *
+ *				     By					    *
+ *			  Robin's Nest Software Inc.			    *
+ *									    *
+ * Permission to use, copy, modify, distribute and sell this software and   *
+ * its documentation for any purpose and without fee is hereby granted,	    *
+ * provided that the above copyright notice appear in all copies and that   *
+ * both that copyright notice and this permission notice appear in the	    *
+ * supporting documentation, and that the name of the author not be used    *
+ * in advertising or publicity pertaining to distribution of the software   *
+ * without specific, written prior permission.				    *
+ *									    *
+ * THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE, 	    *
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN	    *
+ * NO EVENT SHALL HE BE LIABLE FOR ANY SPECIAL, INDIRECT OR CONSEQUENTIAL   *
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR    *
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS  *
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF   *
+ * THIS SOFTWARE.							    *
+ *									    *
+ ****************************************************************************/
+/*
+ * Module:	spt_manifest.c
+ * Author:	Robin T. Miller
+ * Date:	October 18th, 2026
+ *
+ * Description:
+ *	Per-block CRC32C manifest support (manifest=file). When writing, the
+ * CRC32C of each block written is saved in a memory mapped file, indexed
+ * by LBA. When reading, each block found in the manifest is checked, so
+ * data can be verified later without knowing the pattern or IOT seed.
+ *
+ *	The manifest file layout is a header, followed by a 32-bit CRC for
+ * every block of the device, then a byte per block to flag valid CRC's.
+ * The file is created sparse, so only the areas written consume space.
+ * Note: The CRC's are stored in host byte order.
+ *
+ * Modification History:
+ */
+#include "spt.h"
+
+#if !defined(WIN32)
+#  include <sys/mman.h>
+#endif /* !defined(WIN32) */
+
+/*
+ * The SSE4.2 CRC32 instruction is used when the CPU supports it, which is
+ * determined at run time, so the same binary runs on all x86-64 CPU's.
+ */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  define CRC32C_HARDWARE
+#  define CRC32C_TARGET		__attribute__((target("sse4.2")))
+#  include <nmmintrin.h>
+#elif defined(_M_X64)
+#  define CRC32C_HARDWARE
+#  define CRC32C_TARGET
+#  include <intrin.h>
+#  include <nmmintrin.h>
+#endif /* defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) */
+
+#define CRC32C_POLYNOMIAL	0x82F63B78	/* Castagnoli (reflected).	*/
+#define MANIFEST_MAX_ERRORS	10		/* Mismatches reported/command.	*/
+
+/* Slicing by 8 tables, used when SSE4.2 instructions are not available. */
+static uint32_t crc32c_table[8][256];
+static hbool_t crc32c_hardware = False;
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static void
+crc32c_init(void)
+{
+    uint32_t crc;
+    int i, j;
+
+#if defined(CRC32C_HARDWARE)
+#  if defined(_M_X64)
+    {
+	int cpu_info[4];
+	__cpuid(cpu_info, 1);
+	crc32c_hardware = (cpu_info[2] & (1 << 20)) ? True : False;
+    }
+#  else /* !defined(_M_X64) */
+    __builtin_cpu_init();
+    crc32c_hardware = __builtin_cpu_supports("sse4.2") ? True : False;
+#  endif /* defined(_M_X64) */
+    if (crc32c_hardware == True) return;
+#endif /* defined(CRC32C_HARDWARE) */
+    for (i = 0; (i < 256); i++) {
+	crc = (uint32_t)i;
+	for (j = 0; (j < 8); j++) {
+	    crc = (crc & 1) ? ((crc >> 1) ^ CRC32C_POLYNOMIAL) : (crc >> 1);
+	}
+	crc32c_table[0][i] = crc;
+    }
+    for (i = 0; (i < 256); i++) {
+	crc = crc32c_table[0][i];
+	for (j = 1; (j < 8); j++) {
+	    crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+	    crc32c_table[j][i] = crc;
+	}
+    }
+    return;
+}
+
+#if defined(CRC32C_HARDWARE)
+
+static CRC32C_TARGET uint32_t
+crc32c_sse42(uint32_t crc, uint8_t *bptr, size_t length)
+{
+    uint64_t crc64;
+
+    while ( length && ((uintptr_t)bptr & 7) ) {
+	crc = _mm_crc32_u8(crc, *bptr++);
+	length--;
+    }
+    crc64 = crc;
+    for (; (length >= 8); length -= 8, bptr += 8) {
+	crc64 = _mm_crc32_u64(crc64, *(uint64_t *)bptr);
+    }
+    crc = (uint32_t)crc64;
+    while (length--) {
+	crc = _mm_crc32_u8(crc, *bptr++);
+    }
+    return(crc);
+}
+
+#endif /* defined(CRC32C_HARDWARE) */
+
+/*
+ * crc32c() - Calculate the CRC32C (Castagnoli) of a buffer.
+ *
+ * Inputs:
+ *	crc = The starting CRC (0 for a new buffer).
+ *	buffer = The data buffer.
+ *	length = The data length.
+ *
+ * Return Value:
+ *	The updated CRC.
+ */
+uint32_t
+crc32c(uint32_t crc, void *buffer, size_t length)
+{
+    uint8_t *bptr = buffer;
+
+    (void)pthread_once(&crc32c_once, crc32c_init);
+    crc = ~crc;
+#if defined(CRC32C_HARDWARE)
+    if (crc32c_hardware == True) {
+	return( ~crc32c_sse42(crc, bptr, length) );
+    }
+#endif /* defined(CRC32C_HARDWARE) */
+    for (; (length >= 8); length -= 8, bptr += 8) {
+	uint32_t low = crc ^ ((uint32_t)bptr[0] | ((uint32_t)bptr[1] << 8) |
+			      ((uint32_t)bptr[2] << 16) | ((uint32_t)bptr[3] << 24));
+	crc = crc32c_table[7][low & 0xff] ^ crc32c_table[6][(low >> 8) & 0xff] ^
+	      crc32c_table[5][(low >> 16) & 0xff] ^ crc32c_table[4][low >> 24] ^
+	      crc32c_table[3][bptr[4]] ^ crc32c_table[2][bptr[5]] ^
+	      crc32c_table[1][bptr[6]] ^ crc32c_table[0][bptr[7]];
+    }
+    while (length--) {
+	crc = crc32c_table[0][(crc ^ *bptr++) & 0xff] ^ (crc >> 8);
+    }
+    return(~crc);
+}
+
+/* ======================================================================== */
+
+static int
+map_manifest_file(scsi_device_t *sdp, crc_manifest_t *cmp, size_t map_size)
+{
+#if defined(WIN32)
+    HANDLE map_handle;
+
+    map_handle = CreateFileMapping(cmp->cm_handle, NULL,
+				   (cmp->cm_writing) ? PAGE_READWRITE : PAGE_READONLY,
+				   (DWORD)((uint64_t)map_size >> 32), (DWORD)map_size, NULL);
+    if (map_handle == NULL) {
+	Fprintf(sdp, "Failed to create mapping for manifest file %s, error %u\n",
+		cmp->cm_file, GetLastError());
+	return(FAILURE);
+    }
+    cmp->cm_map = MapViewOfFile(map_handle,
+				(cmp->cm_writing) ? FILE_MAP_WRITE : FILE_MAP_READ,
+				0, 0, map_size);
+    (void)CloseHandle(map_handle);
+    if (cmp->cm_map == NULL) {
+	Fprintf(sdp, "Failed to map manifest file %s, error %u\n",
+		cmp->cm_file, GetLastError());
+	return(FAILURE);
+    }
+#else /* !defined(WIN32) */
+    cmp->cm_map = mmap(NULL, map_size,
+		       (cmp->cm_writing) ? (PROT_READ|PROT_WRITE) : PROT_READ,
+		       MAP_SHARED, cmp->cm_handle, (off_t)0);
+    if (cmp->cm_map == MAP_FAILED) {
+	cmp->cm_map = NULL;
+	os_perror(sdp, "Failed to map manifest file %s", cmp->cm_file);
+	return(FAILURE);
+    }
+#endif /* defined(WIN32) */
+    cmp->cm_map_size = map_size;
+    return(SUCCESS);
+}
+
+static void
+unmap_manifest_file(scsi_device_t *sdp, crc_manifest_t *cmp)
+{
+    if (cmp->cm_map) {
+#if defined(WIN32)
+	if (cmp->cm_writing) {
+	    (void)FlushViewOfFile(cmp->cm_map, cmp->cm_map_size);
+	}
+	(void)UnmapViewOfFile(cmp->cm_map);
+#else /* !defined(WIN32) */
+	if (cmp->cm_writing) {
+	    if (msync(cmp->cm_map, cmp->cm_map_size, MS_SYNC) < 0) {
+		os_perror(sdp, "Failed to sync manifest file %s", cmp->cm_file);
+	    }
+	}
+	(void)munmap(cmp->cm_map, cmp->cm_map_size);
+#endif /* defined(WIN32) */
+	cmp->cm_map = NULL;
+    }
+    if (cmp->cm_handle != INVALID_HANDLE_VALUE) {
+	(void)os_close_file(cmp->cm_handle);
+	cmp->cm_handle = INVALID_HANDLE_VALUE;
+    }
+    return;
+}
+
+static hbool_t
+is_valid_manifest(crc_manifest_header_t *cmhp)
+{
+    return( ( (memcmp(cmhp->cmh_magic, CRC_MANIFEST_MAGIC, sizeof(cmhp->cmh_magic)) == 0) &&
+	      (cmhp->cmh_version == CRC_MANIFEST_VERSION) ) ? True : False );
+}
+
+/*
+ * open_manifest_file() - Open (or create) and map the manifest file.
+ *
+ * Description:
+ *	When writing, an existing manifest for the same device geometry is
+ * updated, otherwise a new (sparse) manifest is created. When reading, the
+ * manifest must exist, and match the device block size.
+ */
+static int
+open_manifest_file(scsi_device_t *sdp, crc_manifest_t *cmp, io_params_t *iop)
+{
+    crc_manifest_header_t *cmhp;
+    Offset_t file_size;
+    uint64_t blocks;
+    size_t map_size;
+    int oflags = (cmp->cm_writing) ? (O_RDWR|O_CREAT) : O_RDONLY;
+    int status;
+
+    cmp->cm_handle = os_open_file(cmp->cm_file, oflags, FILE_CREATE_MODE);
+    if (cmp->cm_handle == INVALID_HANDLE_VALUE) {
+	os_perror(sdp, "Failed to open manifest file %s", cmp->cm_file);
+	return(FAILURE);
+    }
+    file_size = os_seek_file(cmp->cm_handle, (Offset_t)0, SEEK_END);
+    if ( (file_size == (Offset_t)-1) ||
+	 (os_seek_file(cmp->cm_handle, (Offset_t)0, SEEK_SET) == (Offset_t)-1) ) {
+	os_perror(sdp, "Failed to seek manifest file %s", cmp->cm_file);
+	return(FAILURE);
+    }
+    if (cmp->cm_writing) {
+	crc_manifest_header_t header;
+	hbool_t create = True;
+	blocks = iop->device_capacity;
+	map_size = (size_t)(sizeof(header) + (blocks * sizeof(uint32_t)) + blocks);
+	if ((size_t)file_size >= sizeof(header)) {
+	    if (os_read_file(cmp->cm_handle, &header, sizeof(header)) == sizeof(header)) {
+		if ( (is_valid_manifest(&header) == True) &&
+		     (header.cmh_block_size == iop->device_size) &&
+		     (header.cmh_capacity == blocks) ) {
+		    create = False;
+		}
+	    }
+	}
+	if (create == True) {
+	    /* Truncate to zero first, so stale CRC's are discarded. */
+	    if ( (os_truncate_file(cmp->cm_handle, (Offset_t)0) < 0) ||
+		 (os_truncate_file(cmp->cm_handle, (Offset_t)map_size) < 0) ) {
+		os_perror(sdp, "Failed to size manifest file %s", cmp->cm_file);
+		return(FAILURE);
+	    }
+	}
+	status = map_manifest_file(sdp, cmp, map_size);
+	if (status != SUCCESS) return(status);
+	cmhp = cmp->cm_header = (crc_manifest_header_t *)cmp->cm_map;
+	if (create == True) {
+	    memcpy(cmhp->cmh_magic, CRC_MANIFEST_MAGIC, sizeof(cmhp->cmh_magic));
+	    cmhp->cmh_version = CRC_MANIFEST_VERSION;
+	    cmhp->cmh_block_size = iop->device_size;
+	    cmhp->cmh_capacity = blocks;
+	    cmhp->cmh_first_lba = blocks;
+	    cmhp->cmh_last_lba = 0;
+	}
+    } else {
+	if ((size_t)file_size < sizeof(*cmhp)) {
+	    Eprintf(sdp, "The manifest file %s is too small, size " LUF " bytes!\n",
+		    cmp->cm_file, (uint64_t)file_size);
+	    return(FAILURE);
+	}
+	status = map_manifest_file(sdp, cmp, (size_t)file_size);
+	if (status != SUCCESS) return(status);
+	cmhp = cmp->cm_header = (crc_manifest_header_t *)cmp->cm_map;
+	blocks = cmhp->cmh_capacity;
+	map_size = (size_t)(sizeof(*cmhp) + (blocks * sizeof(uint32_t)) + blocks);
+	if ( (is_valid_manifest(cmhp) == False) || ((size_t)file_size < map_size) ) {
+	    Eprintf(sdp, "The file %s is NOT a valid CRC manifest!\n", cmp->cm_file);
+	    return(FAILURE);
+	}
+	if (cmhp->cmh_block_size != iop->device_size) {
+	    Eprintf(sdp, "The manifest block size (%u) does NOT match the device block size (%u)!\n",
+		    cmhp->cmh_block_size, iop->device_size);
+	    return(FAILURE);
+	}
+    }
+    cmp->cm_crcs = (uint32_t *)(cmp->cm_map + sizeof(*cmhp));
+    cmp->cm_flags = (uint8_t *)(cmp->cm_crcs + blocks);
+    cmp->cm_capacity = blocks;
+    return(SUCCESS);
+}
+
+/*
+ * create_crc_manifest() - Create the manifest shared by all threads.
+ *
+ * Description:
+ *	This is called before slices are setup, so when verifying without
+ * a starting LBA or data limit, the range written is used, and divided
+ * amongst the slices for parallel verification.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE
+ */
+int
+create_crc_manifest(scsi_device_t *sdp)
+{
+    io_params_t *iop = &sdp->io_params[IO_INDEX_BASE];
+    scsi_generic_t *sgp = &iop->sg;
+    crc_manifest_t *cmp;
+    int status;
+
+    sdp->crc_manifest = NULL;
+    if (sdp->manifest_file == NULL) {
+	return(SUCCESS);
+    }
+    if ( (sdp->iomode != IOMODE_TEST) ||
+	 ((sgp->data_dir != scsi_data_read) && (sgp->data_dir != scsi_data_write)) ) {
+	Eprintf(sdp, "The manifest option requires a read or write CDB!\n");
+	return(FAILURE);
+    }
+    /* The manifest is indexed by LBA, so always encode the LBA range. */
+    sdp->encode_flag = True;
+    status = initialize_devices(sdp);
+    if (status != SUCCESS) return(status);
+    cmp = Malloc(sdp, sizeof(*cmp));
+    if (cmp == NULL) return(FAILURE);
+    cmp->cm_handle = INVALID_HANDLE_VALUE;
+    cmp->cm_file = strdup(sdp->manifest_file);
+    cmp->cm_writing = (sgp->data_dir == scsi_data_write) ? True : False;
+    status = open_manifest_file(sdp, cmp, iop);
+    if (status == SUCCESS) {
+	if ( (status = pthread_mutex_init(&cmp->cm_lock, NULL)) != SUCCESS) {
+	    tPerror(sdp, status, "pthread_mutex_init() of manifest lock failed!");
+	    status = FAILURE;
+	}
+    }
+    if (status != SUCCESS) {
+	unmap_manifest_file(sdp, cmp);
+	free(cmp->cm_file);
+	Free(sdp, cmp);
+	return(status);
+    }
+    if ( (cmp->cm_writing == False) &&
+	 (iop->starting_lba == 0) && (iop->data_limit == 0) && (iop->block_limit == 0) &&
+	 (cmp->cm_header->cmh_first_lba <= cmp->cm_header->cmh_last_lba) ) {
+	iop->starting_lba = cmp->cm_header->cmh_first_lba;
+	iop->block_limit = (cmp->cm_header->cmh_last_lba - cmp->cm_header->cmh_first_lba + 1);
+	iop->data_limit = (iop->block_limit * iop->device_size);
+    }
+    cmp->cm_start_usecs = get_usecs();
+    sdp->crc_manifest = cmp;
+    return(SUCCESS);
+}
+
+static void
+report_crc_manifest(scsi_device_t *sdp, crc_manifest_t *cmp)
+{
+    crc_manifest_stats_t *cmsp = &cmp->cm_stats;
+    double secs = ((double)(get_usecs() - cmp->cm_start_usecs) / 1000000.0);
+    char buffer[LARGE_BUFFER_SIZE];
+
+    PrintHeader(sdp, "CRC32C Manifest Statistics");
+    PrintAscii(sdp, "Manifest File", cmp->cm_file, PNL);
+    PrintAscii(sdp, "Manifest Mode", (cmp->cm_writing) ? "write" : "verify", PNL);
+    PrintDecimal(sdp, "Block Size", cmp->cm_header->cmh_block_size, PNL);
+    if (cmp->cm_writing) {
+	PrintLongDec(sdp, "Blocks Recorded", cmsp->cms_recorded, PNL);
+    } else {
+	PrintLongDec(sdp, "Blocks Verified", cmsp->cms_verified, PNL);
+	PrintLongDec(sdp, "Blocks Not in Manifest", cmsp->cms_missing, PNL);
+	PrintLongDec(sdp, "CRC Mismatches", cmsp->cms_mismatches, PNL);
+    }
+    if (cmp->cm_header->cmh_first_lba <= cmp->cm_header->cmh_last_lba) {
+	(void)sprintf(buffer, LUF " - " LUF,
+		      cmp->cm_header->cmh_first_lba, cmp->cm_header->cmh_last_lba);
+	PrintAscii(sdp, "Manifest LBA Range", buffer, PNL);
+    }
+    if ( (secs > 0.0) && cmsp->cms_bytes) {
+	(void)sprintf(buffer, "%.3f Mbytes/sec",
+		      (((double)cmsp->cms_bytes / (double)MBYTE_SIZE) / secs));
+	PrintAscii(sdp, "Manifest Throughput", buffer, PNL);
+    }
+    /* Report the implementation selected at run time. */
+    (void)pthread_once(&crc32c_once, crc32c_init);
+    PrintAscii(sdp, "CRC32C Implementation",
+	       (crc32c_hardware == True) ? "SSE4.2" : "slice-by-8", PNL);
+    Printf(sdp, "\n");
+    return;
+}
+
+/*
+ * release_crc_manifest() - Release a thread reference to the manifest.
+ *
+ * Description:
+ *	Each thread merges its' statistics, and the last thread updates the
+ * LBA range written, reports the statistics, and unmaps the manifest.
+ */
+void
+release_crc_manifest(scsi_device_t *sdp)
+{
+    crc_manifest_t *cmp = sdp->crc_manifest;
+    crc_manifest_stats_t *cmsp = &sdp->manifest_stats;
+    int references;
+
+    if (cmp == NULL) return;
+    sdp->crc_manifest = NULL;
+    (void)pthread_mutex_lock(&cmp->cm_lock);
+    cmp->cm_stats.cms_recorded += cmsp->cms_recorded;
+    cmp->cm_stats.cms_verified += cmsp->cms_verified;
+    cmp->cm_stats.cms_missing += cmsp->cms_missing;
+    cmp->cm_stats.cms_mismatches += cmsp->cms_mismatches;
+    cmp->cm_stats.cms_bytes += cmsp->cms_bytes;
+    if (cmsp->cms_recorded) {
+	if (cmsp->cms_first_lba < cmp->cm_header->cmh_first_lba) {
+	    cmp->cm_header->cmh_first_lba = cmsp->cms_first_lba;
+	}
+	if (cmsp->cms_last_lba > cmp->cm_header->cmh_last_lba) {
+	    cmp->cm_header->cmh_last_lba = cmsp->cms_last_lba;
+	}
+    }
+    references = --cmp->cm_references;
+    (void)pthread_mutex_unlock(&cmp->cm_lock);
+    if (references) return;
+
+    report_crc_manifest(sdp, cmp);
+    unmap_manifest_file(sdp, cmp);
+    (void)pthread_mutex_destroy(&cmp->cm_lock);
+    free(cmp->cm_file);
+    Free(sdp, cmp);
+    return;
+}
+
+/*
+ * crc_manifest_complete() - Record or verify CRC's after a read or write.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	iop = The I/O parameters. (current LBA is the LBA just transferred)
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE (CRC mismatch)
+ */
+int
+crc_manifest_complete(scsi_device_t *sdp, io_params_t *iop)
+{
+    crc_manifest_t *cmp = sdp->crc_manifest;
+    crc_manifest_stats_t *cmsp = &sdp->manifest_stats;
+    scsi_generic_t *sgp = &iop->sg;
+    uint8_t *bptr = sgp->data_buffer;
+    uint32_t block_size = iop->device_size;
+    uint32_t blocks, block, crc, errors = 0;
+    uint64_t lba;
+
+    if ( (cmp == NULL) || (block_size == 0) ||
+	 ((sgp->data_dir != scsi_data_read) && (sgp->data_dir != scsi_data_write)) ) {
+	return(SUCCESS);
+    }
+    blocks = (sgp->data_transferred / block_size);
+    if ( (iop->current_lba + blocks) > cmp->cm_capacity ) {
+	Eprintf(sdp, "LBA " LUF " is beyond the manifest capacity (" LUF " blocks)!\n",
+		(iop->current_lba + blocks - 1), cmp->cm_capacity);
+	return(FAILURE);
+    }
+    cmsp->cms_bytes += ((uint64_t)blocks * block_size);
+    for (block = 0; (block < blocks); block++, bptr += block_size) {
+	lba = (iop->current_lba + block);
+	crc = crc32c(0, bptr, block_size);
+	if (cmp->cm_writing) {
+	    cmp->cm_crcs[lba] = crc;
+	    cmp->cm_flags[lba] = True;
+	    if ( (cmsp->cms_recorded == 0) || (lba < cmsp->cms_first_lba) ) {
+		cmsp->cms_first_lba = lba;
+	    }
+	    if (lba > cmsp->cms_last_lba) {
+		cmsp->cms_last_lba = lba;
+	    }
+	    cmsp->cms_recorded++;
+	} else if (cmp->cm_flags[lba] == False) {
+	    cmsp->cms_missing++;
+	} else if (cmp->cm_crcs[lba] == crc) {
+	    cmsp->cms_verified++;
+	} else {
+	    cmsp->cms_mismatches++;
+	    if (errors++ < MANIFEST_MAX_ERRORS) {
+		Fprintf(sdp, "CRC32C mismatch at LBA " LUF ", expected 0x%08x, received 0x%08x\n",
+			lba, cmp->cm_crcs[lba], crc);
+	    }
+	}
+    }
+    if (errors) {
+	ReportCdbDeviceInformation(sdp, sgp);
+	Fprintf(sdp, "%u of %u blocks failed manifest CRC verification!\n", errors, blocks);
+	return(FAILURE);
+    }
+    return(SUCCESS);
+}
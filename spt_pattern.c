@@ -0,0 +1,302 @@
+/****************************************************************************
+ *									    *
+ *			  COPYRIGHT (c) 1988 - 2026			    *
+ *			   This Software Provided			    *
+ *				     By					    *
+ *			  Robin's Nest Software Inc.			    *
+ *									    *
+ * Permission to use, copy, modify, distribute and sell this software and   *
+ * its documentation for any purpose and without fee is hereby granted,	    *
+ * provided that the above copyright notice appear in all copies and that   *
+ * both that copyright notice and this permission notice appear in the	    *
+ * supporting documentation, and that the name of the author not be used    *
+ * in advertising or publicity pertaining to distribution of the software   *
+ * without specific, written prior permission.				    *
+ *									    *
+ * THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE, 	    *
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN	    *
+ * NO EVENT SHALL HE BE LIABLE FOR ANY SPECIAL, INDIRECT OR CONSEQUENTIAL   *
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR    *
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS  *
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF   *
+ * THIS SOFTWARE.							    *
+ *									    *
+ ****************************************************************************/
+/*
+ * Module:	spt_pattern.c
+ * Author:	Robin T. Miller
+ * Date:	October 18th, 2026
+ *
+ * Description:
+ *	Data reduction pattern generator. Storage arrays which compress and
+ * dedupe inline make IOT and 32-bit patterns unrealistic, since those are
+ * either highly compressible or never duplicated. This pattern produces
+ * blocks with a target compressible percentage (compress=) and a target
+ * duplicate block percentage (dedupe=).
+ *
+ *	Each block is generated only from the pattern seed and its LBA, so
+ * any thread can regenerate the expected data for verification, and the
+ * same seed always reproduces the same data.
+ *
+ *	The random pattern (ptype=random) is a keyed counter mode stream of
+ * (seed, LBA, pass), so it looks random to the array (no compression or
+ * dedupe benefit), and is verified by recomputing each block, without a
+ * pattern buffer or manifest.
+ *
+ * Modification History:
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Make the dedupe choice per dedupe unit (dedupe_unit=), not per block.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add the random pattern, verified by recomputing block contents.
+ * 
+ */
+#include "spt.h"
+
+#define DR_CHUNK_SIZE	512	/* Compressible chunk size.	*/
+#define DR_DEDUPE_POOL	1024	/* Duplicate block contents.	*/
+#define DR_GOLDEN_GAMMA	0x9E3779B97F4A7C15ULL
+
+/*
+ * dr_mix64() - The SplitMix64 finalizer, to scramble a 64-bit value.
+ */
+static uint64_t
+dr_mix64(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return(value ^ (value >> 31));
+}
+
+/*
+ * dr_block_seed() - Get the content seed for a block.
+ *
+ * Description:
+ *	The duplicate or unique choice is made once per dedupe unit (LBA
+ * aligned), since arrays dedupe in units larger than a block (4k or 8k).
+ * Duplicate units select their content from a small pool, so the array
+ * sees the same unit many times. Unique units are seeded by unit number.
+ * Once the data written is much larger than the pool, the array dedupe
+ * savings approach the dedupe percentage.
+ *
+ *	Each block within the unit is seeded by its offset in the unit, so
+ * the unit is duplicated, but its blocks differ from each other.
+ */
+static uint64_t
+dr_block_seed(scsi_device_t *sdp, io_params_t *iop, uint64_t lba, uint64_t dr_seed)
+{
+    uint64_t unit_blocks = (sdp->dedupe_unit / iop->device_size);
+    uint64_t unit, hash, seed;
+
+    if (unit_blocks == 0) unit_blocks = 1;
+    unit = (lba / unit_blocks);
+    hash = dr_mix64(dr_seed ^ dr_mix64(unit));
+    if ( (hash % 100) < sdp->dedupe_percent ) {
+	seed = dr_mix64(dr_seed + ((hash >> 32) % DR_DEDUPE_POOL));
+    } else {
+	seed = hash;
+    }
+    return( dr_mix64(seed + ((lba % unit_blocks) * DR_GOLDEN_GAMMA)) );
+}
+
+/*
+ * dr_init_block() - Initialize one block of data reduction pattern.
+ *
+ * Description:
+ *	Each chunk of the block starts with random data (incompressible),
+ * and the compressible percentage of the chunk is zero filled. Spreading
+ * this across chunks keeps the ratio for any array compression size.
+ */
+static void
+dr_init_block(scsi_device_t *sdp, uint8_t *bptr, uint32_t bsize, uint64_t state)
+{
+    uint32_t chunk, random_bytes, i;
+    uint64_t value;
+
+    for (; (bsize > 0); bsize -= chunk, bptr += chunk) {
+	chunk = min(bsize, DR_CHUNK_SIZE);
+	random_bytes = (uint32_t)((chunk * (100 - sdp->compress_percent)) / 100);
+	for (i = 0; (i < random_bytes); i += sizeof(value)) {
+	    state += DR_GOLDEN_GAMMA;
+	    value = dr_mix64(state);
+	    memcpy(bptr + i, &value, min(sizeof(value), (size_t)(random_bytes - i)));
+	}
+	if (random_bytes < chunk) {
+	    memset(bptr + random_bytes, '\0', (chunk - random_bytes));
+	}
+    }
+    return;
+}
+
+/*
+ * init_drdata() - Initialize buffer with the data reduction pattern.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	iop = The I/O parameters.
+ *	buffer = The data buffer.
+ *	count = The data length.
+ *	lba = The starting logical block.
+ *	dr_seed = The data reduction seed.
+ *
+ * Return Value:
+ *	The next logical block.
+ */
+uint64_t
+init_drdata(
+	scsi_device_t	*sdp,
+	io_params_t	*iop,
+	void		*buffer,
+	uint32_t	count,
+	uint64_t	lba,
+	uint64_t	dr_seed)
+{
+    uint8_t *bptr = buffer;
+    uint32_t bsize;
+
+    while (count > 0) {
+	bsize = min(count, iop->device_size);
+	dr_init_block(sdp, bptr, bsize, dr_block_seed(sdp, iop, lba, dr_seed));
+	bptr += bsize;
+	count -= bsize;
+	lba++;
+    }
+    return(lba);
+}
+
+/* ======================================================================== */
+
+/*
+ * rnd_block_key() - Get the random pattern key for a block.
+ */
+static uint64_t
+rnd_block_key(uint64_t lba, uint64_t rnd_seed, uint32_t pass)
+{
+    return( dr_mix64(rnd_seed ^ dr_mix64(lba ^ dr_mix64((uint64_t)pass + DR_GOLDEN_GAMMA))) );
+}
+
+/*
+ * rnd_block_word() - Get a word of random pattern.
+ *
+ * Description:
+ *	Each word is the hash of the block key plus its counter, so words
+ * do not depend on each other, and the compiler is free to vectorize.
+ */
+#define rnd_block_word(key, index)	dr_mix64((key) + (((uint64_t)(index) + 1) * DR_GOLDEN_GAMMA))
+
+static void
+rnd_init_block(uint8_t *bptr, uint32_t bsize, uint64_t key)
+{
+    uint64_t *wptr = (uint64_t *)bptr;
+    uint32_t i, words = (bsize / sizeof(uint64_t));
+    uint64_t value;
+
+    for (i = 0; (i < words); i++) {
+	wptr[i] = rnd_block_word(key, i);
+    }
+    if (bsize % sizeof(uint64_t)) {
+	value = rnd_block_word(key, words);
+	memcpy(bptr + (words * sizeof(uint64_t)), &value, (bsize % sizeof(uint64_t)));
+    }
+    return;
+}
+
+/*
+ * init_rnddata() - Initialize buffer with the random pattern.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	iop = The I/O parameters.
+ *	buffer = The data buffer (must be 8 byte aligned).
+ *	count = The data length.
+ *	lba = The starting logical block.
+ *	rnd_seed = The random pattern seed.
+ *	pass = The pass number.
+ *
+ * Return Value:
+ *	The next logical block.
+ */
+uint64_t
+init_rnddata(
+	scsi_device_t	*sdp,
+	io_params_t	*iop,
+	void		*buffer,
+	uint32_t	count,
+	uint64_t	lba,
+	uint64_t	rnd_seed,
+	uint32_t	pass)
+{
+    uint8_t *bptr = buffer;
+    uint32_t bsize;
+
+    while (count > 0) {
+	bsize = min(count, iop->device_size);
+	rnd_init_block(bptr, bsize, rnd_block_key(lba, rnd_seed, pass));
+	bptr += bsize;
+	count -= bsize;
+	lba++;
+    }
+    return(lba);
+}
+
+/*
+ * verify_rnddata() - Verify buffer with the random pattern.
+ *
+ * Description:
+ *	Each block is compared against its recomputed contents. Only when
+ * a block miscompares, is the expected block generated so the normal data
+ * compare error is reported.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	iop = The I/O parameters.
+ *	buffer = The data buffer read (must be 8 byte aligned).
+ *	count = The data length.
+ *	lba = The starting logical block.
+ *	rnd_seed = The random pattern seed.
+ *	pass = The pass number.
+ *
+ * Return Value:
+ *	Returns SUCCESS / FAILURE = Data Ok / Compare Error.
+ */
+int
+verify_rnddata(
+	scsi_device_t	*sdp,
+	io_params_t	*iop,
+	void		*buffer,
+	uint32_t	count,
+	uint64_t	lba,
+	uint64_t	rnd_seed,
+	uint32_t	pass)
+{
+    uint8_t *bptr = buffer;
+    uint64_t *wptr, key;
+    uint32_t bsize, i, words;
+    int status = SUCCESS;
+
+    while (count > 0) {
+	bsize = min(count, iop->device_size);
+	key = rnd_block_key(lba, rnd_seed, pass);
+	wptr = (uint64_t *)bptr;
+	words = (bsize / sizeof(uint64_t));
+	for (i = 0; (i < words); i++) {
+	    if (wptr[i] != rnd_block_word(key, i)) break;
+	}
+	if ( (i < words) || (bsize % sizeof(uint64_t)) ) {
+	    uint8_t *expected = malloc_palign(sdp, bsize, 0);
+	    if (expected == NULL) return(FAILURE);
+	    rnd_init_block(expected, bsize, key);
+	    status = VerifyBuffers(sdp, bptr, expected, bsize);
+	    if (status == FAILURE) {
+		Fprintf(sdp, "The miscompared logical block is " LUF " (" LXF "), pass %u\n", lba, lba, pass);
+	    }
+	    free_palign(sdp, expected);
+	    if (status == FAILURE) break;
+	}
+	bptr += bsize;
+	count -= bsize;
+	lba++;
+    }
+    return(status);
+}
@@ -0,0 +1,320 @@
+/****************************************************************************
+ *									    *
+ *			  COPYRIGHT (c) 1988 - 2026			    *
+ *			   This Software Provided			    *
+ *				     By					    *
+ *			  Robin's Nest Software Inc.			    *
+ *									    *
+ * Permission to use, copy, modify, distribute and sell this software and   *
+ * its documentation for any purpose and without fee is hereby granted,	    *
+ * provided that the above copyright notice appear in all copies and that   *
+ * both that copyright notice and this permission notice appear in the	    *
+ * supporting documentation, and that the name of the author not be used    *
+ * in advertising or publicity pertaining to distribution of the software   *
+ * without specific, written prior permission.				    *
+ *									    *
+ * THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE, 	    *
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN	    *
+ * NO EVENT SHALL HE BE LIABLE FOR ANY SPECIAL, INDIRECT OR CONSEQUENTIAL   *
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR    *
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS  *
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF   *
+ * THIS SOFTWARE.							    *
+ *									    *
+ ****************************************************************************/
+/*
+ * Module:	spt_pi.c
+ * Author:	Robin T. Miller
+ * Date:	October 18th, 2026
+ *
+ * Description:
+ *	T10 Protection Information (PI/DIF) support. When the read or write
+ * protect field is set (rdprotect= or wrprotect=), each block transferred
+ * is followed by an 8 byte PI tuple (guard, application, and reference
+ * tags). The user data buffer is unchanged, since the data is interleaved
+ * with generated PI before writes, and the PI is checked and removed after
+ * reads, so the normal data verification still applies.
+ *
+ * Modification History:
+ */
+#include "spt.h"
+
+#define CRC16_T10DIF_POLYNOMIAL	0x8BB7	/* The T10 DIF CRC polynomial.	*/
+#define PI_MAX_ERRORS		10	/* PI errors reported/command.	*/
+
+/*
+ * Slicing by 8 tables, table[n] is the CRC of a byte followed by n zeroes.
+ */
+static uint16_t crc16_table[8][256];
+static pthread_once_t crc16_once = PTHREAD_ONCE_INIT;
+
+static void
+crc16_init(void)
+{
+    uint16_t crc;
+    int i, j;
+
+    for (i = 0; (i < 256); i++) {
+	crc = (uint16_t)(i << 8);
+	for (j = 0; (j < 8); j++) {
+	    crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ CRC16_T10DIF_POLYNOMIAL) : (uint16_t)(crc << 1);
+	}
+	crc16_table[0][i] = crc;
+    }
+    for (i = 0; (i < 256); i++) {
+	crc = crc16_table[0][i];
+	for (j = 1; (j < 8); j++) {
+	    crc = (uint16_t)((crc << 8) ^ crc16_table[0][crc >> 8]);
+	    crc16_table[j][i] = crc;
+	}
+    }
+    return;
+}
+
+/*
+ * crc16_t10dif() - Calculate the T10 DIF guard tag (CRC16) of a buffer.
+ *
+ * Inputs:
+ *	crc = The starting CRC (0 for a new block).
+ *	buffer = The data buffer.
+ *	length = The data length.
+ *
+ * Return Value:
+ *	The updated CRC.
+ */
+uint16_t
+crc16_t10dif(uint16_t crc, void *buffer, size_t length)
+{
+    uint8_t *bptr = buffer;
+
+    (void)pthread_once(&crc16_once, crc16_init);
+    for (; (length >= 8); length -= 8, bptr += 8) {
+	crc ^= (uint16_t)((bptr[0] << 8) | bptr[1]);
+	crc = crc16_table[7][crc >> 8] ^ crc16_table[6][crc & 0xff] ^
+	      crc16_table[5][bptr[2]] ^ crc16_table[4][bptr[3]] ^
+	      crc16_table[3][bptr[4]] ^ crc16_table[2][bptr[5]] ^
+	      crc16_table[1][bptr[6]] ^ crc16_table[0][bptr[7]];
+    }
+    while (length--) {
+	crc = (uint16_t)((crc << 8) ^ crc16_table[0][(crc >> 8) ^ *bptr++]);
+    }
+    return(crc);
+}
+
+/* ======================================================================== */
+
+/*
+ * pi_expected_reftag() - Get the initial reference tag for an LBA.
+ */
+uint32_t
+pi_expected_reftag(scsi_device_t *sdp, uint64_t lba)
+{
+    if (sdp->pi_reftag_policy == PI_REFTAG_FIXED) {
+	return(sdp->pi_reftag);
+    }
+    return( (uint32_t)lba );
+}
+
+/*
+ * pi_setup_flags() - Setup the protect field for the next CDB.
+ *
+ * Description:
+ *	Called by the read/write encoders, after the LBA is set, to set the
+ * RDPROTECT or WRPROTECT field (if specified), and to save the protect
+ * field and initial reference tag, used when transferring the PI data.
+ * Note: A protect field set in the user's CDB is honored too.
+ *
+ * Return Value:
+ *	The updated CDB flags byte.
+ */
+uint8_t
+pi_setup_flags(scsi_device_t *sdp, io_params_t *iop, uint8_t flags)
+{
+    scsi_generic_t *sgp = &iop->sg;
+    uint8_t protect = 0;
+
+    /* Note: Verify CDB's use these bits for VRPROTECT, so leave as is. */
+    if (sgp->data_dir == scsi_data_read) {
+	protect = sdp->rdprotect;
+    } else if (sgp->data_dir == scsi_data_write) {
+	protect = sdp->wrprotect;
+    } else {
+	iop->pi_protect = 0;
+	return(flags);
+    }
+    if (protect) {
+	flags = (uint8_t)((flags & ~SCSI_PROTECT_MASK) | (protect << SCSI_PROTECT_SHIFT));
+    }
+    iop->pi_protect = ((flags & SCSI_PROTECT_MASK) >> SCSI_PROTECT_SHIFT);
+    iop->pi_initial_reftag = pi_expected_reftag(sdp, iop->current_lba);
+    return(flags);
+}
+
+static uint32_t
+pi_block_reftag(scsi_device_t *sdp, io_params_t *iop, uint32_t block)
+{
+    /* Type 3 reference tags do not increment. */
+    if (sdp->pi_type == 3) {
+	return(iop->pi_initial_reftag);
+    }
+    return(iop->pi_initial_reftag + block);
+}
+
+/*
+ * pi_prepare_data() - Interleave data and PI, before executing the CDB.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE
+ */
+int
+pi_prepare_data(scsi_device_t *sdp, io_params_t *iop)
+{
+    scsi_generic_t *sgp = &iop->sg;
+    uint32_t block_size = iop->device_size;
+    uint32_t blocks, block, pi_length;
+    uint8_t *dptr, *pptr;
+    pi_tuple_t *ptp;
+
+    if ( (iop->pi_protect == 0) || (block_size == 0) || (sgp->data_length == 0) ) {
+	return(SUCCESS);
+    }
+    blocks = (sgp->data_length / block_size);
+    pi_length = (blocks * (block_size + PI_TUPLE_SIZE));
+    if (iop->pi_buffer_size < pi_length) {
+	if (iop->pi_buffer) {
+	    free_palign(sdp, iop->pi_buffer);
+	}
+	iop->pi_buffer_size = 0;
+	iop->pi_buffer = malloc_palign(sdp, pi_length, 0);
+	if (iop->pi_buffer == NULL) return(FAILURE);
+	iop->pi_buffer_size = pi_length;
+    }
+    if (sgp->data_dir == scsi_data_write) {
+	dptr = sgp->data_buffer;
+	pptr = iop->pi_buffer;
+	for (block = 0; (block < blocks); block++) {
+	    memcpy(pptr, dptr, block_size);
+	    ptp = (pi_tuple_t *)(pptr + block_size);
+	    HtoS(ptp->guard_tag, crc16_t10dif(0, dptr, block_size));
+	    HtoS(ptp->application_tag, sdp->pi_apptag);
+	    HtoS(ptp->reference_tag, pi_block_reftag(sdp, iop, block));
+	    dptr += block_size;
+	    pptr += (block_size + PI_TUPLE_SIZE);
+	}
+    }
+    iop->pi_saved_buffer = sgp->data_buffer;
+    iop->pi_saved_length = sgp->data_length;
+    sgp->data_buffer = iop->pi_buffer;
+    sgp->data_length = pi_length;
+    return(SUCCESS);
+}
+
+static void
+pi_report_error(scsi_device_t *sdp, char *tag_name, uint64_t lba, uint32_t expected, uint32_t received)
+{
+    Fprintf(sdp, "PI %s mismatch at LBA " LUF ", expected 0x%x, received 0x%x\n",
+	    tag_name, lba, expected, received);
+    return;
+}
+
+/*
+ * pi_check_data() - Check PI tuples, and remove them from read data.
+ */
+static int
+pi_check_data(scsi_device_t *sdp, io_params_t *iop, uint32_t blocks)
+{
+    scsi_generic_t *sgp = &iop->sg;
+    uint32_t block_size = iop->device_size;
+    uint8_t *dptr = sgp->data_buffer;
+    uint8_t *pptr = iop->pi_buffer;
+    uint32_t block, errors = 0;
+    uint32_t app_tag, ref_tag, expected_ref;
+    uint16_t guard;
+    uint64_t lba;
+    pi_tuple_t *ptp;
+
+    for (block = 0; (block < blocks); block++) {
+	lba = (iop->current_lba + block);
+	ptp = (pi_tuple_t *)(pptr + block_size);
+	app_tag = (uint32_t)StoH(ptp->application_tag);
+	ref_tag = (uint32_t)StoH(ptp->reference_tag);
+	memcpy(dptr, pptr, block_size);
+	dptr += block_size;
+	pptr += (block_size + PI_TUPLE_SIZE);
+	/* Honor the escape values, which disable checking. */
+	if (app_tag == PI_APP_TAG_ESCAPE) {
+	    if ( (sdp->pi_type != 3) || (ref_tag == PI_REF_TAG_ESCAPE) ) {
+		continue;
+	    }
+	}
+	guard = crc16_t10dif(0, (dptr - block_size), block_size);
+	if (guard != (uint16_t)StoH(ptp->guard_tag)) {
+	    if (errors++ < PI_MAX_ERRORS) {
+		pi_report_error(sdp, "guard tag", lba, guard, (uint32_t)StoH(ptp->guard_tag));
+	    }
+	}
+	if ( sdp->pi_check_apptag &&
+	     ((app_tag ^ sdp->pi_apptag) & sdp->pi_appmask) ) {
+	    if (errors++ < PI_MAX_ERRORS) {
+		pi_report_error(sdp, "application tag", lba, sdp->pi_apptag, app_tag);
+	    }
+	}
+	expected_ref = pi_block_reftag(sdp, iop, block);
+	if ( (sdp->pi_reftag_policy != PI_REFTAG_NONE) && (ref_tag != expected_ref) ) {
+	    if (errors++ < PI_MAX_ERRORS) {
+		pi_report_error(sdp, "reference tag", lba, expected_ref, ref_tag);
+	    }
+	}
+    }
+    if (errors) {
+	ReportCdbDeviceInformation(sdp, sgp);
+	Fprintf(sdp, "Detected %u protection information errors, in %u blocks!\n", errors, blocks);
+	return(FAILURE);
+    }
+    return(SUCCESS);
+}
+
+/*
+ * pi_complete_data() - Restore the data buffer, after executing the CDB.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	iop = The I/O parameters.
+ *	status = The CDB execution status.
+ *
+ * Return Value:
+ *	The CDB status, or FAILURE if PI checks failed.
+ */
+int
+pi_complete_data(scsi_device_t *sdp, io_params_t *iop, int status)
+{
+    scsi_generic_t *sgp = &iop->sg;
+    uint32_t blocks;
+
+    if (iop->pi_saved_buffer == NULL) {
+	return(status);
+    }
+    blocks = (sgp->data_transferred / (iop->device_size + PI_TUPLE_SIZE));
+    sgp->data_buffer = iop->pi_saved_buffer;
+    sgp->data_length = iop->pi_saved_length;
+    iop->pi_saved_buffer = NULL;
+    /* Report the user data transferred, without the PI. */
+    sgp->data_transferred = (blocks * iop->device_size);
+    if ( (status == SUCCESS) && (sgp->data_dir == scsi_data_read) ) {
+	status = pi_check_data(sdp, iop, blocks);
+    }
+    return(status);
+}
+
+void
+pi_free_buffer(scsi_device_t *sdp, io_params_t *iop)
+{
+    if (iop->pi_buffer) {
+	free_palign(sdp, iop->pi_buffer);
+	iop->pi_buffer = NULL;
+    }
+    iop->pi_buffer_size = 0;
+    iop->pi_saved_buffer = NULL;
+    iop->pi_protect = 0;
+    return;
+}
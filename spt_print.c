@@ -32,6 +32,10 @@
  *
  * Modification History:
  * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add PrintOutput() to stream shared library output to the callers'
+ * function, rather than truncating it in a fixed size buffer.
+ * 
  * August 12th, 2016 by Robin T. Miller
  *      When dumping buffers via DumpFieldsOffset(), honor the buffer offset
  * format of dec or hex. The field width remains 6 with leading zeros.
@@ -289,7 +293,9 @@ PrintLogs(scsi_device_t *sdp, FILE *fp, char *buffer)
         status = Fputs(buffer, sdp->job->ji_job_logfp);
     } else if (sdp->shared_library && (sdp->log_opened == False) ) {
         int slen = (int)strlen(buffer);
-        if (sdp->efp == fp) {
+        if ( PrintOutput(sdp, (sdp->efp == fp) ? SPT_OUTPUT_STDERR : SPT_OUTPUT_STDOUT, buffer) ) {
+            ; /* Streamed to the callers' function. */
+        } else if (sdp->efp == fp) {
             if (sdp->stderr_remaining < slen) {
                 slen = sdp->stderr_remaining;
             }
@@ -312,6 +318,32 @@ PrintLogs(scsi_device_t *sdp, FILE *fp, char *buffer)
     return(status);
 }
 
+/*
+ * PrintOutput() - Pass output to the shared library callers' function.
+ *
+ * Description:
+ *	Threads use the masters' function, which is cleared when the command
+ * completes, so async jobs don't call back after the caller has returned.
+ *
+ * Return Value:
+ *	Returns True if the output was consumed, otherwise False.
+ */
+hbool_t
+PrintOutput(scsi_device_t *sdp, spt_output_t stream, char *buffer)
+{
+    scsi_device_t *msdp = (sdp->master_sdp) ? sdp->master_sdp : sdp;
+    hbool_t consumed = False;
+
+    if (sdp->output_lock == NULL) return(consumed);
+    (void)pthread_mutex_lock(sdp->output_lock);
+    if (msdp->output_func) {
+        (*msdp->output_func)(msdp->output_arg, stream, buffer, (int)strlen(buffer));
+        consumed = True;
+    }
+    (void)pthread_mutex_unlock(sdp->output_lock);
+    return(consumed);
+}
+
 /*
  * Function to print error message (with ERROR: prefix).
  */
@@ -801,7 +833,7 @@ PrintFields(scsi_device_t *sdp, uint8_t *bptr, int length)
     int count = 0;
 
     while (count < length) {
-	if (CmdInterruptedFlag == True)	break;
+	if (CmdInterrupted(sdp) == True)	break;
 	if ((++count % field_entrys) == 0) {
 	    Print(sdp, "%02x\n", *bptr++);
 	    if (count < length)	PrintAscii(sdp, "", "", DNL);
@@ -825,7 +857,7 @@ PrintHAFields(scsi_device_t *sdp, uint8_t *bptr, int length)
     abufp = abp = (u_char *)Malloc(sdp, (field_entrys + 1));
     if (abufp == NULL) return;
     while (count < length) {
-	if (CmdInterruptedFlag == True)	break;
+	if (CmdInterrupted(sdp) == True)	break;
 	data = *bptr++;
 	Print(sdp, "%02x ", data);
 	abp += Sprintf((char *)abp, "%c", isprint((int)data) ? data : ' ');
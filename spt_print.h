@@ -77,6 +77,7 @@ extern int AcquirePrintLock(scsi_device_t *sdp);
 extern int ReleasePrintLock(scsi_device_t *sdp);
 
 extern int PrintLogs(scsi_device_t *sdp, FILE *fp, char *buffer);
+extern hbool_t PrintOutput(scsi_device_t *sdp, spt_output_t stream, char *buffer);
 extern char *fmtmsg_prefix(scsi_device_t *sdp, char *bp, int flags, logLevel_t level);
 extern void LogMsg(scsi_device_t *sdp, FILE *fp, enum logLevel level, int flags, char *fmtstr, ...);
 extern void SystemLog(scsi_device_t *sdp, int priority, char *format, ...);
@@ -240,7 +240,11 @@ get_scsi_information(scsi_device_t *sdp, io_params_t *iop)
     sgp->warn_on_error = True;
     opened_device = False;
     if (sgp->fd == INVALID_HANDLE_VALUE) {
-	status = os_open_device(sgp);
+	if (is_emulated_device(sgp->dsf) == True) {
+	    status = emu_open_device(sdp, iop, sgp);
+	} else {
+	    status = os_open_device(sgp);
+	}
 	if (status) return(status);
 	opened_device = True;
     }
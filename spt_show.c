@@ -32,6 +32,17 @@
  * 
  * Modification History:
  * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add show-cache=, show-ttl=, and show-refresh options, for the
+ * persistent device inventory cache.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add show-mode={scsi|sysfs} option, to discover devices via sysfs.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add show-threads= and show-timeout= options, to control the number
+ * of device discovery threads and the per device timeout.
+ * 
  * April 3rd, 2021 by Robin T. Miller
  *      Add support for Solaris.
  * 
@@ -212,6 +223,39 @@ parse_show_devices_args(scsi_device_t *sdp, char **argv, int argc, int *arg_inde
 	    sfp->target_port = strdup(string);
 	    continue;
 	}
+	if ( match(&string, "show-threads=") || match(&string, "sthreads=") ) {
+	    sfp->discovery_threads = (int)number(sdp, string, ANY_RADIX, &status, False);
+	    if (status == FAILURE) return( HandleExit(sdp, status) );
+	    continue;
+	}
+	if ( match(&string, "show-timeout=") || match(&string, "stimeout=") ) {
+	    sfp->discovery_timeout = (unsigned int)mstime_value(sdp, string);
+	    continue;
+	}
+	if ( match(&string, "show-mode=") || match(&string, "smode=") ) {
+	    if ( match(&string, "sysfs") ) {
+		sfp->discovery_sysfs = True;
+	    } else if ( match(&string, "scsi") ) {
+		sfp->discovery_sysfs = False;
+	    } else {
+		Eprintf(sdp, "Valid show modes are: scsi or sysfs\n");
+		return( HandleExit(sdp, FAILURE) );
+	    }
+	    continue;
+	}
+	if ( match(&string, "show-cache=") || match(&string, "scache=") ) {
+	    if (sfp->cache_file) free(sfp->cache_file);
+	    sfp->cache_file = strdup(string);
+	    continue;
+	}
+	if ( match(&string, "show-ttl=") || match(&string, "sttl=") ) {
+	    sfp->cache_ttl = (unsigned int)time_value(sdp, string);
+	    continue;
+	}
+	if ( match(&string, "show-refresh") || match(&string, "srefresh") ) {
+	    sfp->cache_refresh = True;
+	    continue;
+	}
 	if ( match(&string, "show-fields=") || match(&string, "sflds=") || match(&string, "fields=")) {
 	    if (sdp->show_fields) free(sdp->show_fields);
 	    sdp->show_fields = strdup(string);
@@ -983,5 +1027,14 @@ FreeScsiFilters(scsi_device_t *sdp, scsi_filters_t *sfp)
 	free(sdp->show_format);
 	sdp->show_format = NULL;
     }
+    sfp->discovery_threads = 0;
+    sfp->discovery_timeout = 0;
+    sfp->discovery_sysfs = False;
+    if (sfp->cache_file) {
+	Free(sdp, sfp->cache_file);
+	sfp->cache_file = NULL;
+    }
+    sfp->cache_ttl = 0;
+    sfp->cache_refresh = False;
     return;
 }
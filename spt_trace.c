@@ -0,0 +1,693 @@
+/****************************************************************************
+ *									    *
+ *			  COPYRIGHT (c) 1988 - 2026			    *
+ *			   This Software Provided			    *
+ *				     By					    *
+ *			  Robin's Nest Software Inc.			    *
+ *									    *
+ * Permission to use, copy, modify, distribute and sell this software and   *
+ * its documentation for any purpose and without fee is hereby granted,	    *
+ * provided that the above copyright notice appear in all copies and that   *
+ * both that copyright notice and this permission notice appear in the	    *
+ * supporting documentation, and that the name of the author not be used    *
+ * in advertising or publicity pertaining to distribution of the software   *
+ * without specific, written prior permission.				    *
+ *									    *
+ * THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE, 	    *
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN	    *
+ * NO EVENT SHALL HE BE LIABLE FOR ANY SPECIAL, INDIRECT OR CONSEQUENTIAL   *
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR    *
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS  *
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF   *
+ * THIS SOFTWARE.							    *
+ *									    *
+ ****************************************************************************/
+/*
+ * Module:	spt_trace.c
+ * Author:	Robin T. Miller
+ * Date:	October 18th, 2026
+ *
+ * Description:
+ *	Binary per command trace capture. Each thread writes fixed size
+ * records to its' own memory mapped ring file (trace=file), so recording
+ * is a copy into mapped memory with no locks or system calls, and may be
+ * left enabled during production like loads. When the ring wraps, the
+ * oldest records are overwritten, and the header sequence is the total
+ * number of records, so the trace is analyzed afterwards.
+ *
+ *	A trace is replayed (replay=file) by each thread from its' own trace
+ * file, so the original concurrency is reproduced with the same threads.
+ * The original inter-arrival times are honored, or scaled (replay_scale=).
+ *
+ *	Media writes are replayed with the data pattern, but the parameter
+ * data of other data out CDB's (e.g. Unmap, Extended Copy) is saved in a
+ * byte ring following the records, so these CDB's are replayed as well.
+ *
+ * Modification History:
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Trace the parameter data of data out CDB's, so they are replayed.
+ * 
+ * October 18th, 2026 by Robin T. Miller
+ *      Add trace replay, with original timing and concurrency.
+ * 
+ */
+#include "spt.h"
+
+#if !defined(WIN32)
+#  include <sys/mman.h>
+#endif /* !defined(WIN32) */
+
+/* ======================================================================== */
+
+static int
+map_trace_file(scsi_device_t *sdp, cmd_trace_t *ctp, size_t map_size, hbool_t writable)
+{
+#if defined(WIN32)
+    HANDLE map_handle;
+
+    map_handle = CreateFileMapping(ctp->ct_handle, NULL,
+				   (writable) ? PAGE_READWRITE : PAGE_READONLY,
+				   (DWORD)((uint64_t)map_size >> 32), (DWORD)map_size, NULL);
+    if (map_handle == NULL) {
+	Fprintf(sdp, "Failed to create mapping for trace file %s, error %u\n",
+		ctp->ct_file, GetLastError());
+	return(FAILURE);
+    }
+    ctp->ct_map = MapViewOfFile(map_handle, (writable) ? FILE_MAP_WRITE : FILE_MAP_READ,
+				0, 0, map_size);
+    (void)CloseHandle(map_handle);
+    if (ctp->ct_map == NULL) {
+	Fprintf(sdp, "Failed to map trace file %s, error %u\n",
+		ctp->ct_file, GetLastError());
+	return(FAILURE);
+    }
+#else /* !defined(WIN32) */
+    ctp->ct_map = mmap(NULL, map_size, (writable) ? (PROT_READ|PROT_WRITE) : PROT_READ,
+		       MAP_SHARED, ctp->ct_handle, (off_t)0);
+    if (ctp->ct_map == MAP_FAILED) {
+	ctp->ct_map = NULL;
+	os_perror(sdp, "Failed to map trace file %s", ctp->ct_file);
+	return(FAILURE);
+    }
+#endif /* defined(WIN32) */
+    ctp->ct_map_size = map_size;
+    return(SUCCESS);
+}
+
+static void
+unmap_trace_file(scsi_device_t *sdp, cmd_trace_t *ctp, hbool_t writable)
+{
+    if (ctp->ct_map) {
+#if defined(WIN32)
+	if (writable) {
+	    (void)FlushViewOfFile(ctp->ct_map, ctp->ct_map_size);
+	}
+	(void)UnmapViewOfFile(ctp->ct_map);
+#else /* !defined(WIN32) */
+	if (writable) {
+	    if (msync(ctp->ct_map, ctp->ct_map_size, MS_SYNC) < 0) {
+		os_perror(sdp, "Failed to sync trace file %s", ctp->ct_file);
+	    }
+	}
+	(void)munmap(ctp->ct_map, ctp->ct_map_size);
+#endif /* defined(WIN32) */
+	ctp->ct_map = NULL;
+    }
+    if (ctp->ct_handle != INVALID_HANDLE_VALUE) {
+	(void)os_close_file(ctp->ct_handle);
+	ctp->ct_handle = INVALID_HANDLE_VALUE;
+    }
+    return;
+}
+
+/*
+ * make_trace_file_name() - Make this threads' trace file name.
+ *
+ * Description:
+ *	With multiple threads, the trace file name is made unique the same
+ * as log files, unless the user specified their own format with "%".
+ */
+static char *
+make_trace_file_name(scsi_device_t *sdp, char *trace_file)
+{
+    char tracefmt[STRING_BUFFER_SIZE];
+
+    strcpy(tracefmt, trace_file);
+    if ( (sdp->threads > 1) && (strstr(trace_file, "%") == NULL) ) {
+	strcat(tracefmt, sdp->file_sep);
+	strcat(tracefmt, sdp->file_postfix);
+    }
+    return( FmtLogFile(sdp, tracefmt, True) );
+}
+
+/*
+ * is_media_write() - Determine if a CDB is a media write.
+ *
+ * Note: Media writes are replayed with the data pattern, so their data is
+ * not traced, only the parameter data of other data out CDB's is traced.
+ */
+static hbool_t
+is_media_write(uint8_t *cdb)
+{
+    switch (cdb[0]) {
+	case SOPC_WRITE_6:
+	case SOPC_WRITE_10:
+	case SOPC_WRITE_12:
+	case SOPC_WRITE_16:
+	case SOPC_WRITE_VERIFY_10:
+	case SOPC_WRITE_VERIFY_12:
+	case SOPC_WRITE_AND_VERIFY_16:
+	case SOPC_WRITE_SAME:
+	case SOPC_WRITE_SAME_16:
+	    return(True);
+	case SOPC_VARIABLE_LENGTH:
+	    return( (stoh(&cdb[8], sizeof(uint16_t)) == SVA_WRITE_32) ? True : False );
+	default:
+	    return(False);
+    }
+}
+
+/*
+ * copy_trace_params() - Copy parameter data to/from the parameter ring.
+ *
+ * Inputs:
+ *	ctp = The command trace.
+ *	offset = The parameter data offset (total bytes).
+ *	buffer = The parameter data buffer.
+ *	length = The parameter data length.
+ *	to_ring = True to copy to the ring, False to copy from the ring.
+ */
+static void
+copy_trace_params(cmd_trace_t *ctp, uint64_t offset, uint8_t *buffer, uint32_t length, hbool_t to_ring)
+{
+    uint64_t limit = ctp->ct_header->cth_param_limit;
+    uint32_t ring_offset, count;
+
+    while (length) {
+	ring_offset = (uint32_t)(offset % limit);
+	count = (uint32_t)min((uint64_t)length, (limit - ring_offset));
+	if (to_ring) {
+	    memcpy(&ctp->ct_params[ring_offset], buffer, count);
+	} else {
+	    memcpy(buffer, &ctp->ct_params[ring_offset], count);
+	}
+	offset += count;
+	buffer += count;
+	length -= count;
+    }
+    return;
+}
+
+/*
+ * create_cmd_trace() - Create this threads' command trace file.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE
+ */
+int
+create_cmd_trace(scsi_device_t *sdp)
+{
+    cmd_trace_t *ctp;
+    cmd_trace_header_t *cthp;
+    size_t map_size;
+    int device_index;
+    int status;
+
+    if (sdp->trace_records == 0) {
+	sdp->trace_records = CMD_TRACE_RECORDS;
+    }
+    ctp = Malloc(sdp, sizeof(*ctp));
+    if (ctp == NULL) return(FAILURE);
+    ctp->ct_handle = INVALID_HANDLE_VALUE;
+
+    ctp->ct_file = make_trace_file_name(sdp, sdp->trace_file);
+    sdp->cmd_trace = ctp;
+
+    ctp->ct_handle = os_open_file(ctp->ct_file, (O_RDWR|O_CREAT), FILE_CREATE_MODE);
+    if (ctp->ct_handle == INVALID_HANDLE_VALUE) {
+	os_perror(sdp, "Failed to open trace file %s", ctp->ct_file);
+	release_cmd_trace(sdp);
+	return(FAILURE);
+    }
+    map_size = (size_t)(sizeof(*cthp) + (sdp->trace_records * sizeof(cmd_trace_record_t)) +
+			(sdp->trace_records * CMD_TRACE_PARAM_BYTES));
+    /* Truncate to zero first, so stale records are discarded. */
+    if ( (os_truncate_file(ctp->ct_handle, (Offset_t)0) < 0) ||
+	 (os_truncate_file(ctp->ct_handle, (Offset_t)map_size) < 0) ) {
+	os_perror(sdp, "Failed to size trace file %s", ctp->ct_file);
+	release_cmd_trace(sdp);
+	return(FAILURE);
+    }
+    status = map_trace_file(sdp, ctp, map_size, True);
+    if (status != SUCCESS) {
+	release_cmd_trace(sdp);
+	return(status);
+    }
+    cthp = ctp->ct_header = (cmd_trace_header_t *)ctp->ct_map;
+    ctp->ct_records = (cmd_trace_record_t *)(ctp->ct_map + sizeof(*cthp));
+    ctp->ct_params = (uint8_t *)&ctp->ct_records[sdp->trace_records];
+    memcpy(cthp->cth_magic, CMD_TRACE_MAGIC, sizeof(cthp->cth_magic));
+    cthp->cth_version = CMD_TRACE_VERSION;
+    cthp->cth_record_size = sizeof(cmd_trace_record_t);
+    cthp->cth_record_limit = sdp->trace_records;
+    cthp->cth_sequence = 0;
+    cthp->cth_start_usecs = get_usecs();
+    cthp->cth_thread_number = sdp->thread_number;
+    cthp->cth_devices = sdp->io_devices;
+    cthp->cth_param_limit = (sdp->trace_records * CMD_TRACE_PARAM_BYTES);
+    cthp->cth_param_offset = 0;
+    for (device_index = 0; (device_index < sdp->io_devices) && (device_index < CMD_TRACE_DEVICES); device_index++) {
+	char *dsf = sdp->io_params[device_index].sg.dsf;
+	if (dsf) {
+	    strncpy(cthp->cth_dsf[device_index], dsf, CMD_TRACE_DSF_SIZE - 1);
+	}
+    }
+    return(SUCCESS);
+}
+
+void
+release_cmd_trace(scsi_device_t *sdp)
+{
+    cmd_trace_t *ctp = sdp->cmd_trace;
+
+    if (ctp == NULL) return;
+    if (sdp->DebugFlag && ctp->ct_header) {
+	Printf(sdp, "Trace file %s, recorded " LUF " commands.\n",
+	       ctp->ct_file, ctp->ct_header->cth_sequence);
+    }
+    unmap_trace_file(sdp, ctp, True);
+    if (ctp->ct_file) {
+	free(ctp->ct_file);
+    }
+    Free(sdp, ctp);
+    sdp->cmd_trace = NULL;
+    return;
+}
+
+/*
+ * trace_cdb_lba() - Get the logical block address from a CDB.
+ *
+ * Note: Only media access CDB's have an LBA, but the CDB is recorded too.
+ */
+uint64_t
+trace_cdb_lba(scsi_generic_t *sgp)
+{
+    uint8_t *cdb = sgp->cdb;
+
+    switch (sgp->cdb_size) {
+	case 6:
+	    return( (uint64_t)(((cdb[1] & 0x1F) << 16) | (cdb[2] << 8) | cdb[3]) );
+	case 10:
+	case 12:
+	    return( (uint64_t)stoh(&cdb[2], sizeof(uint32_t)) );
+	case 16:
+	    return( stoh(&cdb[2], sizeof(uint64_t)) );
+	case SOPC_VARIABLE_LENGTH_CDB_SIZE:
+	    return( stoh(&cdb[12], sizeof(uint64_t)) );
+	default:
+	    return(0);
+    }
+}
+
+/*
+ * record_cmd_trace() - Record a command in the trace ring.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	iop = The I/O parameters (for the device index).
+ *	sgp = The SCSI generic information.
+ *	start_usecs = The command start time.
+ *	error = The system call status.
+ */
+void
+record_cmd_trace(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp,
+		 uint64_t start_usecs, int error)
+{
+    cmd_trace_t *ctp = sdp->cmd_trace;
+    cmd_trace_header_t *cthp = ctp->ct_header;
+    cmd_trace_record_t *ctrp;
+    uint8_t cdb_size = min(sgp->cdb_size, CMD_TRACE_CDB_SIZE);
+
+    ctrp = &ctp->ct_records[cthp->cth_sequence % cthp->cth_record_limit];
+    ctrp->ctr_timestamp = start_usecs;
+    ctrp->ctr_lba = trace_cdb_lba(sgp);
+    ctrp->ctr_length = sgp->data_length;
+    ctrp->ctr_resid = sgp->data_resid;
+    ctrp->ctr_latency = (uint32_t)min(iop->cmd_latency, UINT32_MAX);
+    ctrp->ctr_thread = (uint16_t)sdp->thread_number;
+    ctrp->ctr_device = (uint8_t)(iop - sdp->io_params);
+    ctrp->ctr_cdb_size = cdb_size;
+    ctrp->ctr_data_dir = (uint8_t)sgp->data_dir;
+    ctrp->ctr_scsi_status = (uint8_t)sgp->scsi_status;
+    ctrp->ctr_flags = 0;
+    ctrp->ctr_sense_key = ctrp->ctr_asc = ctrp->ctr_ascq = 0;
+    if (error == FAILURE) {
+	ctrp->ctr_flags |= CTR_FLAG_OS_ERROR;
+    } else if (sgp->error == True) {
+	ctrp->ctr_flags |= CTR_FLAG_SCSI_ERROR;
+	GetSenseErrors(sgp->sense_data, &ctrp->ctr_sense_key, &ctrp->ctr_asc, &ctrp->ctr_ascq);
+    }
+    ctrp->ctr_retries = (uint16_t)sgp->recovery_retries;
+    ctrp->ctr_host_status = (uint16_t)sgp->host_status;
+    ctrp->ctr_driver_status = (uint16_t)sgp->driver_status;
+    ctrp->ctr_os_error = sgp->os_error;
+    memcpy(ctrp->ctr_cdb, sgp->cdb, cdb_size);
+    if (cdb_size < CMD_TRACE_CDB_SIZE) {
+	memset(&ctrp->ctr_cdb[cdb_size], '\0', (CMD_TRACE_CDB_SIZE - cdb_size));
+    }
+    ctrp->ctr_param_offset = 0;
+    ctrp->ctr_param_length = 0;
+    if ( (sgp->data_dir == scsi_data_write) && sgp->data_buffer && sgp->data_length &&
+	 (sgp->data_length <= CMD_TRACE_PARAM_MAX) &&
+	 (sgp->data_length <= cthp->cth_param_limit) && (is_media_write(sgp->cdb) == False) ) {
+	ctrp->ctr_flags |= CTR_FLAG_PARAM_DATA;
+	ctrp->ctr_param_offset = cthp->cth_param_offset;
+	ctrp->ctr_param_length = sgp->data_length;
+	copy_trace_params(ctp, cthp->cth_param_offset, sgp->data_buffer, sgp->data_length, True);
+	cthp->cth_param_offset += sgp->data_length;
+    }
+    cthp->cth_sequence++;
+    return;
+}
+
+/* ======================================================================== */
+
+/*
+ * open_cmd_trace() - Open and map a trace file for reading.
+ *
+ * Description:
+ *	The trace file is mapped read-only. When the ring has wrapped, the
+ * oldest record is first, so records are processed in time order.
+ *
+ * Return Value:
+ *	The trace or NULL if the open failed.
+ */
+cmd_trace_t *
+open_cmd_trace(scsi_device_t *sdp, char *trace_file)
+{
+    cmd_trace_t *ctp;
+    cmd_trace_header_t *cthp;
+    Offset_t file_size;
+    size_t map_size;
+
+    ctp = Malloc(sdp, sizeof(*ctp));
+    if (ctp == NULL) return(NULL);
+    ctp->ct_file = strdup(trace_file);
+    ctp->ct_handle = os_open_file(ctp->ct_file, O_RDONLY, 0);
+    if (ctp->ct_handle == INVALID_HANDLE_VALUE) {
+	os_perror(sdp, "Failed to open trace file %s", ctp->ct_file);
+	close_cmd_trace(sdp, ctp);
+	return(NULL);
+    }
+    file_size = os_seek_file(ctp->ct_handle, (Offset_t)0, SEEK_END);
+    if (file_size == (Offset_t)-1) {
+	os_perror(sdp, "Failed to seek trace file %s", ctp->ct_file);
+	close_cmd_trace(sdp, ctp);
+	return(NULL);
+    }
+    if ((size_t)file_size < sizeof(*cthp)) {
+	Eprintf(sdp, "The trace file %s is too small, size " LUF " bytes!\n",
+		ctp->ct_file, (uint64_t)file_size);
+	close_cmd_trace(sdp, ctp);
+	return(NULL);
+    }
+    if (map_trace_file(sdp, ctp, (size_t)file_size, False) != SUCCESS) {
+	close_cmd_trace(sdp, ctp);
+	return(NULL);
+    }
+    cthp = ctp->ct_header = (cmd_trace_header_t *)ctp->ct_map;
+    ctp->ct_records = (cmd_trace_record_t *)(ctp->ct_map + sizeof(*cthp));
+    map_size = (size_t)(sizeof(*cthp) + (cthp->cth_record_limit * sizeof(cmd_trace_record_t)) +
+			cthp->cth_param_limit);
+    if ( (memcmp(cthp->cth_magic, CMD_TRACE_MAGIC, sizeof(cthp->cth_magic)) != 0) ||
+	 (cthp->cth_version != CMD_TRACE_VERSION) ||
+	 (cthp->cth_record_size != sizeof(cmd_trace_record_t)) ||
+	 (cthp->cth_record_limit == 0) || ((size_t)file_size < map_size) ) {
+	Eprintf(sdp, "The file %s is NOT a valid spt trace file!\n", ctp->ct_file);
+	close_cmd_trace(sdp, ctp);
+	return(NULL);
+    }
+    ctp->ct_params = (uint8_t *)&ctp->ct_records[cthp->cth_record_limit];
+    if (cthp->cth_sequence > cthp->cth_record_limit) {
+	ctp->ct_first = (cthp->cth_sequence % cthp->cth_record_limit);
+	ctp->ct_count = cthp->cth_record_limit;
+    } else {
+	ctp->ct_first = 0;
+	ctp->ct_count = cthp->cth_sequence;
+    }
+    if (ctp->ct_count) {
+	ctp->ct_base_usecs = ctp->ct_records[ctp->ct_first].ctr_timestamp;
+    }
+    return(ctp);
+}
+
+void
+close_cmd_trace(scsi_device_t *sdp, cmd_trace_t *ctp)
+{
+    unmap_trace_file(sdp, ctp, False);
+    if (ctp->ct_buffer) {
+	free_palign(sdp, ctp->ct_buffer);
+    }
+    if (ctp->ct_file) {
+	free(ctp->ct_file);
+    }
+    Free(sdp, ctp);
+    return;
+}
+
+/*
+ * get_replay_base() - Get the first record timestamp of all threads' traces.
+ *
+ * Description:
+ *	Each thread replays its' own trace file, so all threads use the
+ * earliest first record timestamp as their base, to keep the timing of
+ * commands between threads. Each thread computes the same base, so no
+ * shared state is required.
+ */
+static uint64_t
+get_replay_base(scsi_device_t *sdp, uint64_t base_usecs)
+{
+    cmd_trace_t *ctp;
+    char *trace_file;
+    int thread_number = sdp->thread_number;
+    int thread;
+
+    for (thread = 1; (thread <= sdp->threads); thread++) {
+	if (thread == thread_number) continue;
+	sdp->thread_number = thread;
+	trace_file = make_trace_file_name(sdp, sdp->replay_file);
+	sdp->thread_number = thread_number;
+	ctp = (os_file_exists(trace_file) == True) ? open_cmd_trace(sdp, trace_file) : NULL;
+	free(trace_file);
+	if (ctp == NULL) continue;
+	if (ctp->ct_count && (ctp->ct_base_usecs < base_usecs)) {
+	    base_usecs = ctp->ct_base_usecs;
+	}
+	close_cmd_trace(sdp, ctp);
+    }
+    return(base_usecs);
+}
+
+/*
+ * create_cmd_replay() - Open this threads' trace file for replay.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE
+ */
+int
+create_cmd_replay(scsi_device_t *sdp)
+{
+    cmd_trace_t *ctp;
+    char *trace_file;
+
+    trace_file = make_trace_file_name(sdp, sdp->replay_file);
+    ctp = open_cmd_trace(sdp, trace_file);
+    free(trace_file);
+    if (ctp == NULL) return(FAILURE);
+    sdp->cmd_replay = ctp;
+    if (ctp->ct_count == 0) {
+	Eprintf(sdp, "The trace file %s has no records to replay!\n", ctp->ct_file);
+	return(FAILURE);
+    }
+    if (sdp->threads > 1) {
+	ctp->ct_base_usecs = get_replay_base(sdp, ctp->ct_base_usecs);
+    }
+    ctp->ct_start_usecs = get_usecs();
+    return(SUCCESS);
+}
+
+static void
+report_cmd_replay(scsi_device_t *sdp, cmd_trace_t *ctp)
+{
+    double secs = ((double)(get_usecs() - ctp->ct_start_usecs) / 1000000.0);
+    char buffer[LARGE_BUFFER_SIZE];
+
+    PrintHeader(sdp, "Trace Replay Information");
+    PrintAscii(sdp, "Trace File", ctp->ct_file, PNL);
+    PrintLongDec(sdp, "Trace Records", ctp->ct_count, PNL);
+    PrintDecimal(sdp, "Replay Timing Scale", sdp->replay_scale, DNL);
+    Print(sdp, "%%\n");
+    PrintLongDec(sdp, "Commands Replayed", ctp->ct_replayed, PNL);
+    PrintLongDec(sdp, "Commands Skipped", ctp->ct_skipped, DNL);
+    Print(sdp, " (parameter data not traced)\n");
+    PrintLongDec(sdp, "Commands Failed", ctp->ct_errors, PNL);
+    if (sdp->replay_scale) {
+	PrintLongDec(sdp, "Commands Issued Late", ctp->ct_late, DNL);
+	Print(sdp, " (> %u usecs)\n", REPLAY_LATE_USECS);
+	PrintLongDec(sdp, "Maximum Lateness (usecs)", ctp->ct_max_late_usecs, PNL);
+    }
+    if (secs > 0.0) {
+	(void)sprintf(buffer, "%.3f IOPS, %.3f Mbytes/sec",
+		      ((double)ctp->ct_replayed / secs),
+		      (((double)ctp->ct_bytes / (double)MBYTE_SIZE) / secs));
+	PrintAscii(sdp, "Replay Performance", buffer, PNL);
+    }
+    Printf(sdp, "\n");
+    return;
+}
+
+void
+release_cmd_replay(scsi_device_t *sdp)
+{
+    cmd_trace_t *ctp = sdp->cmd_replay;
+
+    if (ctp == NULL) return;
+    if (ctp->ct_replayed || ctp->ct_errors) {
+	report_cmd_replay(sdp, ctp);
+    }
+    close_cmd_trace(sdp, ctp);
+    sdp->cmd_replay = NULL;
+    return;
+}
+
+/*
+ * is_replayable() - Determine if a trace record can be replayed.
+ *
+ * Description:
+ *	Media writes use the data pattern, and other data out CDB's (e.g.
+ * Unmap, Extended Copy, Compare and Write) use their traced parameter data.
+ * These are skipped if their parameter data was too large to trace, or was
+ * overwritten when the parameter ring wrapped.
+ */
+static hbool_t
+is_replayable(cmd_trace_t *ctp, cmd_trace_record_t *ctrp)
+{
+    cmd_trace_header_t *cthp = ctp->ct_header;
+
+    if ( (ctrp->ctr_data_dir != scsi_data_write) || is_media_write(ctrp->ctr_cdb) ) {
+	return(True);
+    }
+    if ( (ctrp->ctr_flags & CTR_FLAG_PARAM_DATA) &&
+	 (ctrp->ctr_param_length == ctrp->ctr_length) &&
+	 ((ctrp->ctr_param_offset + ctrp->ctr_param_length) <= cthp->cth_param_offset) &&
+	 ((cthp->cth_param_offset - ctrp->ctr_param_offset) <= cthp->cth_param_limit) ) {
+	return(True);
+    }
+    return(False);
+}
+
+/*
+ * replay_record() - Replay one trace record.
+ *
+ * Note: libExecuteCdb() calls our ExecuteCdb() via the tool specific hook.
+ */
+static int
+replay_record(scsi_device_t *sdp, cmd_trace_t *ctp, cmd_trace_record_t *ctrp)
+{
+    int device_index = (ctrp->ctr_device < sdp->io_devices) ? ctrp->ctr_device : IO_INDEX_BASE;
+    io_params_t *iop = &sdp->io_params[device_index];
+    scsi_generic_t *sgp = &iop->sg;
+    void *saved_buffer = sgp->data_buffer;
+    unsigned int saved_length = sgp->data_length;
+    scsi_data_dir_t saved_dir = sgp->data_dir;
+    scsi_opcode_t *sop;
+    int status;
+
+    if ( (ctrp->ctr_data_dir != scsi_data_none) && (ctrp->ctr_length > ctp->ct_buffer_size) ) {
+	if (ctp->ct_buffer) free_palign(sdp, ctp->ct_buffer);
+	ctp->ct_buffer = malloc_palign(sdp, ctrp->ctr_length, 0);
+	if (ctp->ct_buffer == NULL) {
+	    ctp->ct_buffer_size = 0;
+	    return(FAILURE);
+	}
+	ctp->ct_buffer_size = ctrp->ctr_length;
+    }
+    /* Reads and parameter data overwrite the buffer, so set it each write. */
+    if (ctrp->ctr_flags & CTR_FLAG_PARAM_DATA) {
+	copy_trace_params(ctp, ctrp->ctr_param_offset, ctp->ct_buffer, ctrp->ctr_param_length, False);
+    } else if (ctrp->ctr_data_dir == scsi_data_write) {
+	InitBuffer(ctp->ct_buffer, (size_t)ctrp->ctr_length, sdp->pattern);
+    }
+    memset(sgp->cdb, '\0', sizeof(sgp->cdb));
+    memcpy(sgp->cdb, ctrp->ctr_cdb, ctrp->ctr_cdb_size);
+    sgp->cdb_size = ctrp->ctr_cdb_size;
+    sgp->data_dir = (scsi_data_dir_t)ctrp->ctr_data_dir;
+    sgp->data_length = (sgp->data_dir == scsi_data_none) ? 0 : ctrp->ctr_length;
+    sgp->data_buffer = (sgp->data_length) ? ctp->ct_buffer : NULL;
+    sop = ScsiOpcodeEntry(sgp->cdb, iop->device_type);
+    sgp->cdb_name = (sop && sop->opname) ? sop->opname : "Replay";
+
+    status = libExecuteCdb(sgp);
+
+    if (status == SUCCESS) {
+	ctp->ct_bytes += (sgp->data_length - sgp->data_resid);
+    }
+    sgp->data_buffer = saved_buffer;
+    sgp->data_length = saved_length;
+    sgp->data_dir = saved_dir;
+    return(status);
+}
+
+/*
+ * replay_cmd_trace() - Replay the next record of the trace.
+ *
+ * Description:
+ *	Each record is issued at its' original offset from the first record
+ * (scaled by replay_scale= percentage, where 0 is as fast as possible).
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE, or END_OF_DATA at the end of each pass.
+ */
+int
+replay_cmd_trace(scsi_device_t *sdp)
+{
+    cmd_trace_t *ctp = sdp->cmd_replay;
+    cmd_trace_record_t *ctrp;
+    uint64_t target_usecs, now_usecs;
+    int status;
+
+    do {
+	if (ctp->ct_next == ctp->ct_count) {
+	    ctp->ct_next = 0;
+	    return(END_OF_DATA);
+	}
+	if (ctp->ct_next == 0) {
+	    ctp->ct_pass_usecs = get_usecs();
+	}
+	ctrp = &ctp->ct_records[(ctp->ct_first + ctp->ct_next++) % ctp->ct_header->cth_record_limit];
+	if (is_replayable(ctp, ctrp) == False) {
+	    ctp->ct_skipped++;
+	    ctrp = NULL;
+	}
+    } while (ctrp == NULL);
+
+    if (sdp->replay_scale && (ctrp->ctr_timestamp > ctp->ct_base_usecs)) {
+	target_usecs = ctp->ct_pass_usecs +
+	    (((ctrp->ctr_timestamp - ctp->ct_base_usecs) * sdp->replay_scale) / 100);
+	now_usecs = get_usecs();
+	if (target_usecs > now_usecs) {
+	    os_usleep(target_usecs - now_usecs);
+	} else if ((now_usecs - target_usecs) > REPLAY_LATE_USECS) {
+	    ctp->ct_late++;
+	    ctp->ct_max_late_usecs = max(ctp->ct_max_late_usecs, (now_usecs - target_usecs));
+	}
+    }
+    status = replay_record(sdp, ctp, ctrp);
+    if (status == SUCCESS) {
+	ctp->ct_replayed++;
+    } else if (status == FAILURE) {
+	ctp->ct_errors++;
+    }
+    return(status);
+}
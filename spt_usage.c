@@ -82,6 +82,7 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\n    Where options are:\n");
     P (sdp, "\tdsf=device            The device special file.\n");
     P (sdp, "\tdsf1=device           The 2nd device special file.\n");
+    P (sdp, "\tdsf=emu:[options]     An emulated disk (size=value,bs=value,latency=usecs,file=path).\n");
     P (sdp, "\tdin=filename          Data (in) file for reading.\n");
     P (sdp, "\tdout=filename         Data (out) file for writing.\n");
     
@@ -110,6 +111,7 @@ void Help(scsi_device_t *sdp)
 
     P (sdp, "\tcdb='hh hh ...'       The SCSI CDB to execute.\n");
     P (sdp, "\tcdbsize=value         The CDB size (overrides auto set).\n");
+    P (sdp, "\tcaw_locks=value       Number of CAW locks for contention testing.\n");
     P (sdp, "\tcapacity=value        Set the device capacity in bytes.\n");
     P (sdp, "\tcapacityp=value       Set capacity by percentage (range: 0-100).\n");
     P (sdp, "\tdir=direction         Data direction {none|read|write}.\n");
@@ -130,7 +132,10 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\tretry=value           The number of times to retry a cmd.\n");
     P (sdp, "\truntime=time          The number of seconds to execute.\n");
     P (sdp, "\tscript=filename       The script file name to execute.\n");
+    P (sdp, "\tworkload=file         The JSON workload file to execute.\n");
     P (sdp, "\treport-format=string  The report format: brief or full. (or rfmt=)\n");
+    P (sdp, "\tanalyze trace=file,... Analyze binary command trace files.\n");
+    P (sdp, "\tbench [options]       Benchmark spt's own overhead (emulated device).\n");
     P (sdp, "\tshow devices [filters] Show SCSI devices (see filters below).\n");
     P (sdp, "\tshow scsi [filters]   Show SCSI sense errors (see filters below).\n");
     P (sdp, "\tsname=string          The SCSI opcode name (for errors).\n");
@@ -144,6 +149,12 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\tdisable=flag          Disable one or more flags (see below).\n");
     P (sdp, "\tiotpass=value         Set the IOT pattern for specified pass.\n");
     P (sdp, "\tiotseed=value         Set the IOT pattern block seed value.\n");
+    P (sdp, "\tcompress=value        The compressible percentage (or ratio N:1).\n");
+    P (sdp, "\tdedupe=value          The duplicate block percentage.\n");
+    P (sdp, "\tdedupe_unit=value     The dedupe unit size. (Default: %u)\n", DR_DEDUPE_UNIT);
+    P (sdp, "\tdrseed=value          Set the data reduction pattern seed.\n");
+    P (sdp, "\trndpass=value         Set the random pattern pass number.\n");
+    P (sdp, "\trndseed=value         Set the random pattern seed value.\n");
     P (sdp, "\thelp                  Display this help text.\n");
     P (sdp, "\teval EXPR             Evaluate expression, show values.\n");
     P (sdp, "\tsystem CMD            Execute a system command.\n");
@@ -173,8 +184,10 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\trtpg                  Report target port groups.\n");
     P (sdp, "\tread10                Read media (10 byte CDB).\n");
     P (sdp, "\tread16                Read media (16 byte CDB).\n");
+    P (sdp, "\tread32                Read media (32 byte CDB).\n");
     P (sdp, "\twrite10               Write media (10 byte CDB).\n");
     P (sdp, "\twrite16               Write media (16 byte CDB).\n");
+    P (sdp, "\twrite32               Write media (32 byte CDB).\n");
     P (sdp, "\tverify10              Verify media (10 byte CDB).\n");
     P (sdp, "\tverify16              Verify media (16 byte CDB).\n");
     P (sdp, "\twritesame10           Write same (10 byte CDB).\n");
@@ -249,13 +262,32 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\tbs=value              The number of bytes per request.\n");
     P (sdp, "\tblocks=value          The number of blocks per request.\n");
     P (sdp, "\tlimit=value           The data limit to transfer (bytes).\n");
-    P (sdp, "\tptype=string          The pattern type (only 'iot' now).\n");
+    P (sdp, "\tptype=string          The pattern type ('iot', 'random', or 'reduce').\n");
     P (sdp, "\tending=value          The ending logical block address.\n");
     P (sdp, "\tstarting=value        The starting logical block address.\n");
     P (sdp, "\tslice=value           The specific slice to operate upon.\n");
     P (sdp, "\tslices=value          The slices to divide capacity between.\n");
+    P (sdp, "\tlbamap=file           The Get LBA Status run-length map file.\n");
+    P (sdp, "\tmanifest=file         The per-block CRC32C manifest file.\n");
+    P (sdp, "\ttrace=file            The per-thread binary command trace file.\n");
+    P (sdp, "\ttrace_records=value   The trace ring size (in records). (Default: %u)\n", CMD_TRACE_RECORDS);
+    P (sdp, "\treplay=file           The binary command trace file to replay.\n");
+    P (sdp, "\treplay_scale=value    The replay timing percentage (0 = no delays). (Default: 100)\n");
+    P (sdp, "\tbench_file=file       The benchmark results file to save (JSON).\n");
+    P (sdp, "\tbaseline=file         The benchmark baseline file to compare.\n");
+    P (sdp, "\tbench_threshold=value The benchmark regression percentage. (Default: %u%%)\n", BENCH_THRESHOLD_DEFAULT);
     P (sdp, "\tstep=value            The bytes to step after each request.\n");
 
+    P (sdp, "\n    Protection Information Options:\n");
+    P (sdp, "\trdprotect=value       The read protect field (0-7). (Default: 0)\n");
+    P (sdp, "\twrprotect=value       The write protect field (0-7). (Default: 0)\n");
+    P (sdp, "\tpitype=value          The protection type (1-3). (Default: 1)\n");
+    P (sdp, "\tapptag=value          The application tag. (Default: none)\n");
+    P (sdp, "\tappmask=value         The application tag mask. (Default: 0xFFFF)\n");
+    P (sdp, "\treftag={lba|none|value} The reference tag policy. (Default: lba)\n");
+    P (sdp, "\n");
+    P (sdp, "    Note: When a protect field is set, PI is interleaved with the data.\n");
+
     P (sdp, "\n    I/O Range Options:\n");
     P (sdp, "\tmin=value             Set the minumum size to transfer.\n");
     P (sdp, "\tmax=value             Set the maximum size to transfer.\n");
@@ -274,6 +306,16 @@ void Help(scsi_device_t *sdp)
     P (sdp, "    Errors retried are OS specific, plus SCSI Busy and Unit Attention\n");
     P (sdp, "    Note: Errors are NOT automatically retried, use enable=recovery required.\n");
 
+    P (sdp, "\n    Fault and Latency Injection Options:\n");
+    P (sdp, "\tinject=fault[:percent][@lba[-lba]]  Inject a fault, at a rate and/or LBA range.\n");
+    P (sdp, "\t    Faults: busy, qfull, ua, notready, medium, transport, timeout (Max: %d)\n",
+       INJECT_MAX_RULES);
+    P (sdp, "\tinject_latency=type:usecs[:percent] Inject latency before each command.\n");
+    P (sdp, "\t    Types: fixed:usecs, uniform:min-max, exp:mean (exponential)\n");
+    P (sdp, "\n");
+    P (sdp, "    Note: The percent defaults to 100, and may be fractional (e.g. 0.1).\n");
+    P (sdp, "          Timeouts wait for the command timeout (see timeout=).\n");
+
     P (sdp, "\n    Extended Copy Options:\n");
     P (sdp, "\tsrc=device            The source special file.\n");
     P (sdp, "\tdst=device            The destination special file.\n");
@@ -301,9 +343,16 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\trevision=string       The revision level. (or rev=)\n");
     P (sdp, "\tfw_version=string     The firmware version. (or fwver=)\n");
     P (sdp, "\tserial=string         The serial number.\n");
+    P (sdp, "\tshow-cache=file       Show devices inventory cache. (or scache=).\n");
     P (sdp, "\tshow-fields=string    Show devices brief fields. (or sflds=).\n");
     P (sdp, "\tshow-format=string    Show devices format control. (or sfmt=).\n");
+    P (sdp, "\tshow-mode=string      Show devices discovery mode. (or smode=).\n");
+    P (sdp, "\t                      Valid modes: scsi or sysfs (Linux only).\n");
     P (sdp, "\tshow-path=string,...  Show devices using path. (or spath=).\n");
+    P (sdp, "\tshow-refresh          Show devices cache refresh. (or srefresh).\n");
+    P (sdp, "\tshow-threads=value    Show devices discovery threads. (or sthreads=).\n");
+    P (sdp, "\tshow-timeout=value    Show devices per device deadline. (or stimeout=).\n");
+    P (sdp, "\tshow-ttl=time         Show devices cache time to live. (or sttl=).\n");
 
     P (sdp, "\n    Examples:\n");
     P (sdp, "\tshow devices dtypes=direct,enclosure vid=HGST\n");
@@ -380,6 +429,8 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\tasync            Execute asynchronously.    (Default: %s)\n", disabled_str);
     P (sdp, "\tbypass           Bypass sanity checks.      (Default: %s)\n",
                                 (sdp->bypass) ? enabled_str : disabled_str);
+    P (sdp, "\tbytchk           Verify(16) target compare. (Default: %s)\n",
+				(sdp->verify_offload) ? enabled_str : disabled_str);
     P (sdp, "\tcompare          Data comparison.           (Default: %s)\n",
                                 (sdp->compare_data) ? enabled_str : disabled_str);
     P (sdp, "\tdebug            The SCSI debug flag.       (Default: %s)\n",
@@ -396,6 +447,8 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\tencode           Encode control flag.       (Default: %s)\n", disabled_str);
     P (sdp, "\terrors           Report errors flag.        (Default: %s)\n",
                                 (sgp->errlog) ? enabled_str : disabled_str);
+    P (sdp, "\tfirstwrite       Thin first write latency.  (Default: %s)\n",
+				(sdp->first_write_flag) ? enabled_str : disabled_str);
     P (sdp, "\tgenspt           Generate spt command.      (Default: %s)\n",
                                 (sdp->genspt_flag) ? enabled_str : disabled_str);
     P (sdp, "\theader           Log header control flag.   (Default: %s)\n",
@@ -426,6 +479,8 @@ void Help(scsi_device_t *sdp)
                                 (sdp->show_caching_flag) ? enabled_str : disabled_str);
     P (sdp, "\tshow_header      Show devices header flag.  (Default: %s)\n",
 			 	(sdp->show_header_flag) ? enabled_str : disabled_str);
+    P (sdp, "\tsparse           Sparse copy/verify flag.   (Default: %s)\n",
+			 	(sdp->sparse_flag) ? enabled_str : disabled_str);
     P (sdp, "\tunique           Unique pattern flag.       (Default: %s)\n",
 			 	(sdp->unique_pattern) ? enabled_str : disabled_str);
     P (sdp, "\tverbose          Verbose output flag.       (Default: %s)\n",
@@ -721,6 +776,12 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\t# spt cdb=88 dir=read length=32k enable=compare,recovery,sense starting=0 ptype=iot\n");
     P (sdp, "    Write and Read/Compare IOT Pattern w/immediate Read-After-Write: (64k, 1g data)\n");
     P (sdp, "\t# spt cdb=8a starting=0 bs=64k limit=1g ptype=iot enable=raw emit=default\n");
+    P (sdp, "    Write and Read/Compare Random Pattern: (verified by recomputing, no pattern buffer)\n");
+    P (sdp, "\t# spt cdb=8a dir=write length=64k starting=0 limit=10g ptype=random enable=recovery,sense\n");
+    P (sdp, "\t# spt cdb=88 dir=read length=64k starting=0 limit=10g ptype=random enable=recovery,sense\n");
+    P (sdp, "    Write and Read/Compare Data Reduction Pattern: (3:1 compression, 25%% duplicate blocks)\n");
+    P (sdp, "\t# spt cdb=8a dir=write length=64k starting=0 limit=10g compress=3:1 dedupe=25 enable=recovery,sense\n");
+    P (sdp, "\t# spt cdb=88 dir=read length=64k starting=0 limit=10g compress=3:1 dedupe=25 enable=recovery,sense\n");
     P (sdp, "    Write Same: (all blocks)\n");
     P (sdp, "\t# spt cdb='93' starting=0 dir=write length=4k blocks=4m/b\n");
     P (sdp, "    Write Same w/Unmap: (all blocks)\n");
@@ -729,6 +790,8 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\t# spt cdb=42 starting=0 ranges=64 min=8 max=128 incr=8\n");
     P (sdp, "    Get LBA Status: (reports mapped/deallocated blocks)\n");
     P (sdp, "\t# spt cdb='9e 12' starting=0\n");
+    P (sdp, "    Get LBA Status: (8 threads scanning slices, writes an extent map)\n");
+    P (sdp, "\t# spt getlbastatus starting=0 threads=8 lbamap=lbamap.dat\n");
     P (sdp, "    Extended Copy Operation: (non-token LID1 xcopy, used by VMware)\n");
     P (sdp, "\t# spt cdb=83 src=${SRC} starting=0 dst=${DST} starting=0 enable=compare,recovery,sense\n");
     P (sdp, "    Extended Copy Operation: (ROD token xcopy, used by Microsoft, aka ODX)\n");
@@ -739,6 +802,36 @@ void Help(scsi_device_t *sdp)
     P (sdp, "\t# spt cdb='83 11' dsf=${DST} starting=0 enable=zerorod slices=10 enable=recovery,sense\n");
     P (sdp, "    Copy/Verify Source to Destination Device: (uses read/write operations)\n");
     P (sdp, "\t# spt iomode=copy length=32k dsf=${SRC} starting=0 dsf1=${DST} starting=0 enable=compare,recovery,sense\n");
+    P (sdp, "    Sparse Copy Source to Destination Device: (skips deallocated source extents, unmaps destination)\n");
+    P (sdp, "\t# spt iomode=copy length=1m dsf=${SRC} starting=0 dsf1=${DST} starting=0 enable=sparse,recovery,sense\n");
+    P (sdp, "    Thin Provisioning First Write Latency: (fresh allocation vs. overwrite, then after unmap)\n");
+    P (sdp, "\t# spt cdb=8a dir=write length=64k starting=0 limit=1g enable=firstwrite,recovery,sense\n");
+    P (sdp, "    Compare and Write Lock Contention: (16 threads across two paths, rerun with more threads to sweep)\n");
+    P (sdp, "\t# spt cdb=89 dsf=${PATH1} dsf1=${PATH2} starting=0 caw_locks=4 threads=16 runtime=60 enable=sense\n");
+    P (sdp, "    Record Block CRC's, then Verify Later: (verify uses range written, with 8 slices)\n");
+    P (sdp, "\t# spt cdb=8a dir=write length=1m starting=0 limit=10g manifest=crc.manifest\n");
+    P (sdp, "\t# spt cdb=88 dir=read length=1m manifest=crc.manifest slices=8\n");
+    P (sdp, "    Write and Read with Protection Information: (Type 2 requires 32 byte CDBs)\n");
+    P (sdp, "\t# spt write32 length=64k starting=0 limit=1g wrprotect=1 pitype=2 apptag=0x1234 enable=sense\n");
+    P (sdp, "\t# spt read32 length=64k starting=0 limit=1g rdprotect=1 pitype=2 apptag=0x1234 enable=sense\n");
+    P (sdp, "    Record Binary Command Trace: (ring of 1m records per thread, for later analysis)\n");
+    P (sdp, "\t# spt cdb=88 dir=read length=64k starting=0 limit=10g slices=8 trace=spt.trace trace_records=1m\n");
+    P (sdp, "    Write and Read Emulated Device: (1g RAM disk, 4k blocks, 50us latency)\n");
+    P (sdp, "\t# spt dsf=emu:size=1g,bs=4k,latency=50 cdb=8a dir=write length=64k starting=0 ptype=random\n");
+    P (sdp, "    ODX Copy Between Sparse File Backed Emulated Devices: (4t thin LUNs, copy_file_range)\n");
+    P (sdp, "\t# spt src=emu:size=4t,file=src.img starting=0 dst=emu:size=4t,file=dst.img starting=0 cdb='83 11' limit=1g enable=compare\n");
+    P (sdp, "    Execute JSON Workload: (thread groups and phases, see spt_workload.c for format)\n");
+    P (sdp, "\t# spt workload=mixed.json enable=scriptverify\n");
+    P (sdp, "    Analyze Binary Command Traces: (latency percentiles, heatmap, and errors, as JSON)\n");
+    P (sdp, "\t# spt analyze trace=spt.trace-j1t1,spt.trace-j1t2 output-format=json\n");
+    P (sdp, "    Benchmark spt Overhead: (compare with saved results, failing on 25%% regressions)\n");
+    P (sdp, "\t# spt bench bench_file=new.json baseline=old.json threads=8\n");
+    P (sdp, "    Replay Binary Command Trace: (same threads for original concurrency, at 2x speed)\n");
+    P (sdp, "\t# spt dsf=${DEV} replay=spt.trace threads=8 replay_scale=50 enable=recovery,sense\n");
+    P (sdp, "    Measure Error Recovery Cost: (5%% Busy, 1%% Unit Attention, and exponential latency)\n");
+    P (sdp, "\t# spt dsf=emu:size=1g cdb=88 dir=read length=64k starting=0 limit=1g threads=4 enable=recovery recovery_delay=0 inject=busy:5 inject=ua:1 inject_latency=exp:200\n");
+    P (sdp, "    Verify Destination with Verify(16) Byte Check: (source data is compared by the target)\n");
+    P (sdp, "\t# spt iomode=verify length=1m dsf=${SRC} starting=0 dsf1=${DST} starting=0 enable=bytchk,recovery,sense\n");
     P (sdp, "    Write Source and Verify with Mirror Device: (10 threads for higher performance)\n");
     P (sdp, "\t# spt iomode=mirror length=32k dsf=${SRC} starting=0 dsf1=${DST} starting=0 enable=compare slices=10\n");
 
@@ -31,6 +31,10 @@
  * 
  * Modification History:
  * 
+ * October 18th, 2026 by Robin T. Miller
+ * 	Add pthread_once() using InitOnceExecuteOnce(), for one time table
+ * initialization from multiple threads.
+ * 
  * April 6th, 2015 by Robin T. Miller
  * 	In os_rename_file(), do not delete the newpath unless the oldpath
  * exists. Depending on the test, we can delete files that should remain,
@@ -314,6 +318,25 @@ pthread_kill(pthread_t thread, int sig)
     return;
 }
 
+static BOOL CALLBACK
+pthread_once_callback(PINIT_ONCE once_control, PVOID parameter, PVOID *context)
+{
+    void (*init_routine)(void) = (void (*)(void))parameter;
+
+    (*init_routine)();
+    return(TRUE);
+}
+
+int
+pthread_once(pthread_once_t *once_control, void (*init_routine)(void))
+{
+    if (InitOnceExecuteOnce(once_control, pthread_once_callback,
+			    (PVOID)init_routine, NULL) == FALSE) {
+	return (int)GetLastError();
+    }
+    return(PTHREAD_NORMAL_EXIT);
+}
+
 int
 pthread_mutex_init(pthread_mutex_t *lock, void *attr)
 {
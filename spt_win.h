@@ -116,6 +116,9 @@ typedef unsigned long pthread_attr_t;
 typedef HANDLE pthread_mutex_t;
 /* For mutex attributes. */
 typedef unsigned long pthread_mutexattr_t;
+/* For one time initialization. */
+typedef INIT_ONCE pthread_once_t;
+#define PTHREAD_ONCE_INIT	INIT_ONCE_STATIC_INIT
 
 /* 
  * Windows CreateThread() returns a HANDLE (PVOID), and also supports
@@ -170,6 +173,7 @@ extern int pthread_mutex_destroy(pthread_mutex_t *mutex);
 extern int pthread_mutex_trylock(pthread_mutex_t *lock);
 extern int pthread_mutex_lock(pthread_mutex_t *lock);
 extern int pthread_mutex_unlock(pthread_mutex_t *lock);
+extern int pthread_once(pthread_once_t *once_control, void (*init_routine)(void));
 extern int pthread_cond_init(pthread_cond_t *cv, const void *dummy);
 extern int pthread_cond_broadcast(pthread_cond_t *cv);
 extern int pthread_cond_signal(pthread_cond_t *cv);
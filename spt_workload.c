@@ -0,0 +1,560 @@
+/****************************************************************************
+ *									    *
+ *			  COPYRIGHT (c) 1988 - 2026			    *
+ *			   This Software Provided			    *
+ *				     By					    *
+ *			  Robin's Nest Software Inc.			    *
+ *									    *
+ * Permission to use, copy, modify, distribute and sell this software and   *
+ * its documentation for any purpose and without fee is hereby granted,	    *
+ * provided that the above copyright notice appear in all copies and that   *
+ * both that copyright notice and this permission notice appear in the	    *
+ * supporting documentation, and that the name of the author not be used    *
+ * in advertising or publicity pertaining to distribution of the software   *
+ * without specific, written prior permission.				    *
+ *									    *
+ * THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE, 	    *
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN	    *
+ * NO EVENT SHALL HE BE LIABLE FOR ANY SPECIAL, INDIRECT OR CONSEQUENTIAL   *
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR    *
+ * PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS  *
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF   *
+ * THIS SOFTWARE.							    *
+ *									    *
+ ****************************************************************************/
+/*
+ * Module:	spt_workload.c
+ * Author:	Robin T. Miller
+ * Date:	October 18th, 2026
+ *
+ * Description:
+ *	JSON workload files (workload=file), describing concurrent thread
+ * groups and a sequence of phases. For example:
+ *
+ *	{
+ *	  "name": "mixed",
+ *	  "options": "enable=recovery,sense",
+ *	  "groups": [
+ *	    { "name": "reads", "threads": 8, "options": "dsf=/dev/sdb cdb=28 length=4k slices=8" },
+ *	    { "name": "writes", "threads": 2, "options": "dsf=/dev/sdc cdb=2a length=1m" }
+ *	  ],
+ *	  "phases": [
+ *	    { "name": "warmup", "runtime": "30", "groups": [ "writes" ] },
+ *	    { "name": "steady", "runtime": "5m" }
+ *	  ]
+ *	}
+ *
+ *	Each phase starts its' groups as background jobs (tagged phase:group),
+ * then waits for all of them, so phase boundaries are synchronized. The
+ * commands are fed through the script file logic, so everything runs in
+ * this process. Each thread keeps its' own statistics, merged per group as
+ * threads finish, then reported per phase and for the whole workload.
+ *
+ * Modification History:
+ */
+#include "spt.h"
+#include "parson.h"
+
+static workload_t *workload = NULL;	/* The active workload.		*/
+
+static void
+free_workload(workload_t *wlp)
+{
+    int index;
+
+    for (index = 0; (index < wlp->wl_group_count); index++) {
+	free(wlp->wl_groups[index].wg_name);
+	free(wlp->wl_groups[index].wg_options);
+    }
+    for (index = 0; (index < wlp->wl_phase_count); index++) {
+	free(wlp->wl_phases[index].wp_name);
+	free(wlp->wl_phases[index].wp_runtime);
+	free(wlp->wl_phases[index].wp_groups);
+    }
+    free(wlp->wl_groups);
+    free(wlp->wl_phases);
+    free(wlp->wl_file);
+    free(wlp->wl_name);
+    free(wlp->wl_options);
+    (void)pthread_mutex_destroy(&wlp->wl_lock);
+    free(wlp);
+    return;
+}
+
+static void
+init_workload_stats(workload_stats_t *wsp, int group)
+{
+    memset(wsp, '\0', sizeof(*wsp));
+    init_latency_stats(&wsp->ws_latency);
+    wsp->ws_group = group;
+    return;
+}
+
+static void
+merge_workload_stats(workload_stats_t *wsp, workload_stats_t *swsp)
+{
+    merge_latency_stats(&wsp->ws_latency, &swsp->ws_latency);
+    wsp->ws_errors += swsp->ws_errors;
+    wsp->ws_threads += swsp->ws_threads;
+    if ( swsp->ws_start_usecs &&
+	 ((wsp->ws_start_usecs == 0) || (swsp->ws_start_usecs < wsp->ws_start_usecs)) ) {
+	wsp->ws_start_usecs = swsp->ws_start_usecs;
+    }
+    return;
+}
+
+static char *
+make_workload_tag(char *buffer, workload_t *wlp, int phase, int group)
+{
+    (void)sprintf(buffer, "%s:%s", wlp->wl_phases[phase].wp_name, wlp->wl_groups[group].wg_name);
+    return(buffer);
+}
+
+/*
+ * get_json_string() - Get a copy of a required string.
+ *
+ * Note: Names and times become part of command lines and job tags,
+ * so must be a single word.
+ */
+static char *
+get_json_string(scsi_device_t *sdp, JSON_Object *object, char *name, char *what, hbool_t single_word)
+{
+    const char *string = json_object_get_string(object, name);
+
+    if (string == NULL) {
+	Eprintf(sdp, "The %s is missing the \"%s\" string!\n", what, name);
+	return(NULL);
+    }
+    if ( (single_word == True) && (strpbrk(string, " \t:") || (*string == '\0')) ) {
+	Eprintf(sdp, "The %s %s '%s' cannot be empty or contain spaces or colons!\n", what, name, string);
+	return(NULL);
+    }
+    return( strdup(string) );
+}
+
+static int
+find_workload_group(workload_t *wlp, const char *name)
+{
+    int group;
+
+    for (group = 0; (group < wlp->wl_group_count); group++) {
+	if (strcmp(wlp->wl_groups[group].wg_name, name) == 0) {
+	    return(group);
+	}
+    }
+    return(-1);
+}
+
+static int
+parse_workload_groups(scsi_device_t *sdp, workload_t *wlp, JSON_Array *groups)
+{
+    workload_group_t *wgp;
+    JSON_Object *object;
+    int group;
+
+    wlp->wl_group_count = (int)json_array_get_count(groups);
+    if (wlp->wl_group_count == 0) {
+	Eprintf(sdp, "The workload must define at least one thread group!\n");
+	return(FAILURE);
+    }
+    wlp->wl_groups = Malloc(sdp, (sizeof(*wgp) * wlp->wl_group_count));
+    if (wlp->wl_groups == NULL) return(FAILURE);
+    for (group = 0; (group < wlp->wl_group_count); group++) {
+	wgp = &wlp->wl_groups[group];
+	object = json_array_get_object(groups, group);
+	if (object == NULL) {
+	    Eprintf(sdp, "Workload group %d is not a JSON object!\n", group + 1);
+	    return(FAILURE);
+	}
+	wgp->wg_name = get_json_string(sdp, object, "name", "workload group", True);
+	if (wgp->wg_name == NULL) return(FAILURE);
+	if (find_workload_group(wlp, wgp->wg_name) != group) {
+	    Eprintf(sdp, "The workload group name '%s' is duplicated!\n", wgp->wg_name);
+	    return(FAILURE);
+	}
+	wgp->wg_options = get_json_string(sdp, object, "options", "workload group", False);
+	if (wgp->wg_options == NULL) return(FAILURE);
+	if (json_object_has_value_of_type(object, "threads", JSONNumber)) {
+	    wgp->wg_threads = (int)json_object_get_number(object, "threads");
+	    if (wgp->wg_threads <= 0) {
+		Eprintf(sdp, "The workload group '%s' threads must be greater than zero!\n", wgp->wg_name);
+		return(FAILURE);
+	    }
+	}
+	init_workload_stats(&wgp->wg_stats, group);
+    }
+    return(SUCCESS);
+}
+
+static int
+parse_workload_phase(scsi_device_t *sdp, workload_t *wlp, workload_phase_t *wpp, JSON_Object *object)
+{
+    JSON_Array *groups;
+    char text[SMALL_BUFFER_SIZE];
+    int index, group;
+
+    /* Without a phase object, this is the implied phase for all groups. */
+    if (object == NULL) {
+	wpp->wp_name = strdup("main");
+	groups = NULL;
+    } else {
+	wpp->wp_name = get_json_string(sdp, object, "name", "workload phase", True);
+	if (wpp->wp_name == NULL) return(FAILURE);
+	if (json_object_has_value_of_type(object, "runtime", JSONNumber)) {
+	    (void)sprintf(text, "%u", (unsigned int)json_object_get_number(object, "runtime"));
+	    wpp->wp_runtime = strdup(text);
+	} else if (json_object_has_value(object, "runtime")) {
+	    wpp->wp_runtime = get_json_string(sdp, object, "runtime", "workload phase", True);
+	    if (wpp->wp_runtime == NULL) return(FAILURE);
+	}
+	groups = json_object_get_array(object, "groups");
+    }
+    wpp->wp_group_count = (groups) ? (int)json_array_get_count(groups) : wlp->wl_group_count;
+    if (wpp->wp_group_count == 0) {
+	Eprintf(sdp, "The workload phase '%s' has no groups to run!\n", wpp->wp_name);
+	return(FAILURE);
+    }
+    wpp->wp_groups = Malloc(sdp, (sizeof(*wpp->wp_groups) * wpp->wp_group_count));
+    if (wpp->wp_groups == NULL) return(FAILURE);
+    for (index = 0; (index < wpp->wp_group_count); index++) {
+	if (groups == NULL) {
+	    wpp->wp_groups[index] = index;
+	    continue;
+	}
+	group = -1;
+	if (json_array_get_string(groups, index)) {
+	    group = find_workload_group(wlp, json_array_get_string(groups, index));
+	}
+	if (group < 0) {
+	    Eprintf(sdp, "The workload phase '%s' group %d is not a defined group name!\n",
+		    wpp->wp_name, index + 1);
+	    return(FAILURE);
+	}
+	wpp->wp_groups[index] = group;
+    }
+    return(SUCCESS);
+}
+
+static int
+parse_workload(scsi_device_t *sdp, workload_t *wlp, JSON_Value *root_value)
+{
+    JSON_Object *root_object = json_value_get_object(root_value);
+    JSON_Array *groups, *phases;
+    JSON_Object *object;
+    workload_phase_t *wpp;
+    int phase, status;
+
+    if (root_object == NULL) {
+	Eprintf(sdp, "The workload file %s is not a JSON object!\n", wlp->wl_file);
+	return(FAILURE);
+    }
+    if (json_object_has_value(root_object, "name")) {
+	wlp->wl_name = get_json_string(sdp, root_object, "name", "workload", True);
+	if (wlp->wl_name == NULL) return(FAILURE);
+    } else {
+	wlp->wl_name = strdup("workload");
+    }
+    if (json_object_has_value(root_object, "options")) {
+	wlp->wl_options = get_json_string(sdp, root_object, "options", "workload", False);
+	if (wlp->wl_options == NULL) return(FAILURE);
+    }
+    groups = json_object_get_array(root_object, "groups");
+    if (groups == NULL) {
+	Eprintf(sdp, "The workload file %s is missing the \"groups\" array!\n", wlp->wl_file);
+	return(FAILURE);
+    }
+    status = parse_workload_groups(sdp, wlp, groups);
+    if (status != SUCCESS) return(status);
+
+    /* Without phases, all groups run once, as a single phase. */
+    phases = json_object_get_array(root_object, "phases");
+    wlp->wl_phase_count = (phases) ? (int)json_array_get_count(phases) : 1;
+    if (wlp->wl_phase_count == 0) {
+	Eprintf(sdp, "The workload must define at least one phase!\n");
+	return(FAILURE);
+    }
+    wlp->wl_phases = Malloc(sdp, (sizeof(*wpp) * wlp->wl_phase_count));
+    if (wlp->wl_phases == NULL) return(FAILURE);
+    for (phase = 0; (phase < wlp->wl_phase_count); phase++) {
+	wpp = &wlp->wl_phases[phase];
+	if (phases == NULL) {
+	    status = parse_workload_phase(sdp, wlp, wpp, NULL);
+	} else if ( (object = json_array_get_object(phases, phase)) ) {
+	    status = parse_workload_phase(sdp, wlp, wpp, object);
+	} else {
+	    Eprintf(sdp, "Workload phase %d is not a JSON object!\n", phase + 1);
+	    status = FAILURE;
+	}
+	if (status != SUCCESS) return(status);
+    }
+    return(SUCCESS);
+}
+
+/*
+ * write_workload_commands() - Write the spt commands for each phase.
+ *
+ * Each group is started in the background, tagged with phase:group, then
+ * we wait for each tag, so the next phase starts after this phase is done.
+ */
+static int
+write_workload_commands(scsi_device_t *sdp, workload_t *wlp, FILE *fp)
+{
+    workload_phase_t *wpp;
+    workload_group_t *wgp;
+    char tag[STRING_BUFFER_SIZE];
+    int phase, index;
+
+    for (phase = 0; (phase < wlp->wl_phase_count); phase++) {
+	wpp = &wlp->wl_phases[phase];
+	for (index = 0; (index < wpp->wp_group_count); index++) {
+	    wgp = &wlp->wl_groups[wpp->wp_groups[index]];
+	    (void)fprintf(fp, "%s %s", (wlp->wl_options) ? wlp->wl_options : "", wgp->wg_options);
+	    if (wgp->wg_threads) {
+		(void)fprintf(fp, " threads=%d", wgp->wg_threads);
+	    }
+	    if (wpp->wp_runtime) {
+		(void)fprintf(fp, " runtime=%s", wpp->wp_runtime);
+	    }
+	    (void)fprintf(fp, " tag=%s bg\n", make_workload_tag(tag, wlp, phase, wpp->wp_groups[index]));
+	}
+	for (index = 0; (index < wpp->wp_group_count); index++) {
+	    (void)fprintf(fp, "wait tag=%s\n", make_workload_tag(tag, wlp, phase, wpp->wp_groups[index]));
+	}
+    }
+    if ( (fflush(fp) != SUCCESS) || ferror(fp) ) {
+	Perror(sdp, "Failed writing workload commands");
+	return(FAILURE);
+    }
+    rewind(fp);
+    return(SUCCESS);
+}
+
+/*
+ * load_workload() - Load a JSON workload file, and queue its' commands.
+ *
+ * Inputs:
+ *	sdp = The device information.
+ *	workload_file = The JSON workload file.
+ *
+ * Return Value:
+ *	SUCCESS / FAILURE
+ */
+int
+load_workload(scsi_device_t *sdp, char *workload_file)
+{
+    workload_t *wlp;
+    JSON_Value *root_value;
+    FILE *fp = NULL;
+    int level = sdp->script_level;
+    int status;
+
+    if ( (level + 1) > ScriptLevels) {
+	Eprintf(sdp, "The maximum script level is %d!\n", ScriptLevels);
+	return(FAILURE);
+    }
+    root_value = json_parse_file_with_comments(workload_file);
+    if (root_value == NULL) {
+	Eprintf(sdp, "Unable to parse JSON workload file %s!\n", workload_file);
+	return(FAILURE);
+    }
+    wlp = Malloc(sdp, sizeof(*wlp));
+    if (wlp == NULL) {
+	json_value_free(root_value);
+	return(FAILURE);
+    }
+    (void)pthread_mutex_init(&wlp->wl_lock, NULL);
+    wlp->wl_file = strdup(workload_file);
+    init_workload_stats(&wlp->wl_total, -1);
+    status = parse_workload(sdp, wlp, root_value);
+    json_value_free(root_value);
+    if (status == SUCCESS) {
+	if ( (fp = tmpfile()) == NULL) {
+	    Perror(sdp, "Unable to create temporary workload file");
+	    status = FAILURE;
+	} else {
+	    status = write_workload_commands(sdp, wlp, fp);
+	}
+    }
+    if (status != SUCCESS) {
+	if (fp) (void)fclose(fp);
+	free_workload(wlp);
+	return(status);
+    }
+    /* Replace any previous workload, which was aborted. */
+    if (workload) {
+	free_workload(workload);
+    }
+    workload = wlp;
+    if (sdp->verbose) {
+	Printf(sdp, "Starting workload '%s' with %d thread group%s and %d phase%s...\n",
+	       wlp->wl_name, wlp->wl_group_count, (wlp->wl_group_count > 1) ? "s" : "",
+	       wlp->wl_phase_count, (wlp->wl_phase_count > 1) ? "s" : "");
+    }
+    /* The commands are executed as a script, so errors are handled likewise. */
+    sdp->sfp[level] = fp;
+    sdp->script_name[level] = strdup(workload_file);
+    sdp->script_lineno[level] = 0;
+    sdp->script_level++;
+    return(SUCCESS);
+}
+
+/*
+ * create_workload_stats() - Create the per thread workload statistics.
+ *
+ * Note: Threads are matched to their group by the phase:group job tag.
+ */
+int
+create_workload_stats(scsi_device_t *sdp)
+{
+    workload_t *wlp = workload;
+    workload_phase_t *wpp;
+    workload_stats_t *wsp;
+    char tag[STRING_BUFFER_SIZE];
+    int index;
+
+    if ( (wlp == NULL) || (sdp->job_tag == NULL) ||
+	 (wlp->wl_phase >= wlp->wl_phase_count) ) {
+	return(SUCCESS);
+    }
+    wpp = &wlp->wl_phases[wlp->wl_phase];
+    for (index = 0; (index < wpp->wp_group_count); index++) {
+	if (strcmp(sdp->job_tag, make_workload_tag(tag, wlp, wlp->wl_phase, wpp->wp_groups[index])) == 0) {
+	    break;
+	}
+    }
+    if (index == wpp->wp_group_count) return(SUCCESS);
+    wsp = Malloc(sdp, sizeof(*wsp));
+    if (wsp == NULL) return(FAILURE);
+    init_workload_stats(wsp, wpp->wp_groups[index]);
+    wsp->ws_threads = 1;
+    wsp->ws_start_usecs = get_usecs();
+    sdp->workload_stats = wsp;
+    return(SUCCESS);
+}
+
+void
+record_workload_stats(scsi_device_t *sdp, io_params_t *iop, scsi_generic_t *sgp, int error)
+{
+    workload_stats_t *wsp = sdp->workload_stats;
+    uint64_t bytes = 0;
+
+    if ( (error == FAILURE) || (sgp->error == True) ) {
+	wsp->ws_errors++;
+    } else if (sgp->data_dir != scsi_data_none) {
+	bytes = (sgp->data_length - sgp->data_resid);
+    }
+    record_latency(&wsp->ws_latency, iop->cmd_latency, bytes);
+    return;
+}
+
+/*
+ * release_workload_stats() - Merge this threads' statistics into its' group.
+ */
+void
+release_workload_stats(scsi_device_t *sdp)
+{
+    workload_stats_t *wsp = sdp->workload_stats;
+    workload_t *wlp = workload;
+
+    if (wsp == NULL) return;
+    sdp->workload_stats = NULL;
+    if (wlp) {
+	(void)pthread_mutex_lock(&wlp->wl_lock);
+	merge_workload_stats(&wlp->wl_groups[wsp->ws_group].wg_stats, wsp);
+	(void)pthread_mutex_unlock(&wlp->wl_lock);
+    }
+    Free(sdp, wsp);
+    return;
+}
+
+static void
+report_workload_stats(scsi_device_t *sdp, char *header, workload_stats_t *wsp, uint64_t end_usecs)
+{
+    latency_stats_t *lsp = &wsp->ws_latency;
+    char buffer[LARGE_BUFFER_SIZE];
+    double secs = 0.0;
+
+    if (wsp->ws_start_usecs && (end_usecs > wsp->ws_start_usecs)) {
+	secs = ((double)(end_usecs - wsp->ws_start_usecs) / 1000000.0);
+    }
+    PrintHeader(sdp, header);
+    PrintDecimal(sdp, "Number of Threads", wsp->ws_threads, PNL);
+    PrintLongDec(sdp, "Command Errors", wsp->ws_errors, PNL);
+    (void)FormatElapstedTime(buffer, (clock_t)(secs * hertz));
+    PrintAscii(sdp, "Elapsed Time", buffer, PNL);
+    if (secs > 0.0) {
+	(void)sprintf(buffer, "%.3f Mbytes/sec, %.3f IOPS",
+		      (((double)lsp->ls_bytes / (double)MBYTE_SIZE) / secs),
+		      ((double)lsp->ls_count / secs));
+	PrintAscii(sdp, "Total Throughput", buffer, PNL);
+    }
+    Printf(sdp, "\n");
+    (void)sprintf(buffer, "%s Latency", header);
+    report_latency_stats(sdp, buffer, lsp);
+    return;
+}
+
+static void
+report_workload_phase(scsi_device_t *sdp, workload_t *wlp, int phase, uint64_t end_usecs)
+{
+    workload_phase_t *wpp = &wlp->wl_phases[phase];
+    workload_stats_t phase_stats;
+    workload_group_t *wgp;
+    char header[STRING_BUFFER_SIZE];
+    int index, threads;
+
+    init_workload_stats(&phase_stats, -1);
+    for (index = 0; (index < wpp->wp_group_count); index++) {
+	wgp = &wlp->wl_groups[wpp->wp_groups[index]];
+	(void)sprintf(header, "Workload %s Phase %s Group %s", wlp->wl_name, wpp->wp_name, wgp->wg_name);
+	report_workload_stats(sdp, header, &wgp->wg_stats, end_usecs);
+	merge_workload_stats(&phase_stats, &wgp->wg_stats);
+	init_workload_stats(&wgp->wg_stats, wpp->wp_groups[index]);
+    }
+    if (wpp->wp_group_count > 1) {
+	(void)sprintf(header, "Workload %s Phase %s Total", wlp->wl_name, wpp->wp_name);
+	report_workload_stats(sdp, header, &phase_stats, end_usecs);
+    }
+    /* The workload threads are the most threads of any phase. */
+    threads = max(wlp->wl_total.ws_threads, phase_stats.ws_threads);
+    merge_workload_stats(&wlp->wl_total, &phase_stats);
+    wlp->wl_total.ws_threads = threads;
+    return;
+}
+
+/*
+ * workload_jobs_finished() - Called after waiting for jobs by tag.
+ *
+ * When the last group of the current phase is waited for, the phase
+ * is complete, so report the phase, and after the last phase the workload.
+ */
+void
+workload_jobs_finished(scsi_device_t *sdp, char *job_tag)
+{
+    workload_t *wlp = workload;
+    workload_phase_t *wpp;
+    char tag[STRING_BUFFER_SIZE];
+    char header[STRING_BUFFER_SIZE];
+    uint64_t end_usecs;
+
+    if ( (wlp == NULL) || (job_tag == NULL) || (wlp->wl_phase >= wlp->wl_phase_count) ) {
+	return;
+    }
+    wpp = &wlp->wl_phases[wlp->wl_phase];
+    if (strcmp(job_tag, make_workload_tag(tag, wlp, wlp->wl_phase, wpp->wp_groups[wpp->wp_group_count - 1])) != 0) {
+	return;
+    }
+    end_usecs = get_usecs();
+    (void)pthread_mutex_lock(&wlp->wl_lock);
+    report_workload_phase(sdp, wlp, wlp->wl_phase, end_usecs);
+    (void)pthread_mutex_unlock(&wlp->wl_lock);
+    if (++wlp->wl_phase < wlp->wl_phase_count) return;
+
+    if (wlp->wl_phase_count > 1) {
+	(void)sprintf(header, "Workload %s Total", wlp->wl_name);
+	report_workload_stats(sdp, header, &wlp->wl_total, end_usecs);
+    }
+    workload = NULL;
+    free_workload(wlp);
+    return;
+}